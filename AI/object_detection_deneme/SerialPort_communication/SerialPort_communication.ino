@@ -5,11 +5,20 @@
  * - Immediate and gradual stop options
  * - Gradual speed increase
  * - Reverse direction control
+ * - Ultrasonic distance telemetry with configurable sampling interval
+ * - Firmware hash announced at boot (READY:<hash>) and on VERSION, so the
+ *   edge only reflashes when the sketch changed
  * - Serial communication with Raspberry Pi
  */
 
 #include <Servo.h>
 
+// The edge passes a hash of this file when it flashes (-DFIRMWARE_HASH=0x...);
+// a build without one reports 0 and is always reflashed
+#ifndef FIRMWARE_HASH
+#define FIRMWARE_HASH 0UL
+#endif
+
 Servo ServoMotor;
 
 // BTS7960 Motor Controller Pins
@@ -28,6 +37,9 @@ int rampRate = 5;
 unsigned long lastRampTime = 0;
 const int rampInterval = 50;
 
+// Ultrasonic sampling period, adjustable at runtime with DINT:<ms>
+unsigned long distanceInterval = 500;
+
 String inputString = "";
 boolean stringComplete = false;
 
@@ -50,6 +62,10 @@ void setup()
 
   analogWrite(RPWM, 0);
   analogWrite(LPWM, 0);
+
+  // readiness probe for the edge, instead of a fixed sleep after opening the port
+  Serial.print("READY:");
+  Serial.println((unsigned long)FIRMWARE_HASH, HEX);
 }
 
 void loop()
@@ -68,7 +84,6 @@ void loop()
   }
 
   static unsigned long lastDistanceTime = 0;
-  const unsigned long distanceInterval = 500;
 
   if (millis() - lastDistanceTime > distanceInterval)
   {
@@ -134,9 +149,6 @@ void processCommand(String command)
     cmd = command.substring(0, colonIndex);
     valueStr = command.substring(colonIndex + 1);
     valueStr.trim();
-    Serial.print("→ valueStr before toInt: '");
-    Serial.print(valueStr);
-    Serial.println("'");
     value = valueStr.toInt();
   }
   else
@@ -212,6 +224,24 @@ void processCommand(String command)
       Serial.println(value);
     }
   }
+  else if (cmd == "DINT")
+  {
+    if (value >= 20 && value <= 5000)
+    {
+      distanceInterval = value;
+      Serial.print("OK:DINT:");
+      Serial.println(value);
+    }
+    else
+    {
+      Serial.println("ERR:Invalid distance interval. Use 20-5000 ms");
+    }
+  }
+  else if (cmd == "VERSION")
+  {
+    Serial.print("VERSION:");
+    Serial.println((unsigned long)FIRMWARE_HASH, HEX);
+  }
   else if(cmd == "REV")
   {
     currentDirection *= -1;
@@ -3,6 +3,7 @@
 
 #include <opencv2/core.hpp>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 /**
@@ -22,6 +23,13 @@ public:
     inline static const std::string BACKEND_SCANS_POINT {"/api/v1/scans"};
 	inline static const std::string BACKEND_SYSTEMINFO_POINT = "/api/v1/system/info";
 	inline static const std::string BACKEND_SYSTEMMESSAGE_POINT = "/api/v1/system/logs";
+    inline static const std::string CALIBRATION_FILE {"../calibration.txt"};   // Platt A/B per product, optional
+    inline static const std::string ARCHIVE_DIR {"photos"};
+    inline static const std::string PREVIEW_MULTICAST_GROUP {""};   // e.g. "239.255.42.1"; empty = unicast to DESKTOP_IP_UDP
+    inline static const std::string JOURNAL_DIR {"journal"};
+    inline static const std::string BACKEND_WS_POINT {"/websocket"};
+    inline static const std::string THERMAL_ZONE_PATH {"/sys/class/thermal/thermal_zone0/temp"};
+    inline static const std::string HISTORY_FILE {"history.tsdb"};
     inline static constexpr int  BACKEND_PORT = 6060;
     inline static constexpr int UDP_COMMS_PORT = 5000;
     
@@ -37,7 +45,134 @@ public:
 	inline static constexpr double 	   THRESHOLD_DIFFERENCE_2 = 5;
 
 	inline static constexpr double     CENTER_POINT_RATIO	= 0.30;
- 	inline static constexpr int STARTUP_DELAY_SECONDS = 3;   // Seko başlangıç delay
+
+    /* --- ultrasonic pre-trigger -------------------------------------------- */
+    inline static constexpr bool DISTANCE_GATING_ENABLED = true;  // arm camera gating only when the sensor sees an object
+    inline static constexpr int  DISTANCE_INTERVAL_MS    = 100;   // firmware sampling period (DINT command)
+    inline static constexpr int  BELT_EMPTY_DISTANCE_CM  = 20;    // readings below this mean something is on the belt
+    inline static constexpr int  DISTANCE_ARM_HOLD_MS    = 3000;  // keep gating armed while the product travels to the cameras
+    inline static constexpr int  DISTANCE_STALE_MS       = 1000;  // no fresh reading -> fail open (always armed)
+    inline static constexpr int  CAPTURE_FPS             = 30;
+    inline static constexpr int  IDLE_FPS                = 5;     // camera rate while the belt is empty
+
+    /* --- closed-loop belt speed controller --------------------------------- */
+    inline static constexpr bool   SPEED_CONTROLLER_ENABLED  = false; // start in auto mode (toggle via POST /controller)
+    inline static constexpr int    SPEED_MIN_PERCENT         = 20;
+    inline static constexpr int    SPEED_MAX_PERCENT         = 80;
+    inline static constexpr int    SPEED_START_PERCENT       = 40;
+    inline static constexpr int    SPEED_STEP_UP_PERCENT     = 2;
+    inline static constexpr int    SPEED_STEP_DOWN_PERCENT   = 10;
+    inline static constexpr int    SPEED_CONTROL_PERIOD_MS   = 1000;
+    inline static constexpr size_t SPEED_BACKLOG_HIGH        = 6;     // frames queued in preprocessed + results
+    inline static constexpr size_t SPEED_BACKLOG_LOW         = 1;
+    inline static constexpr double SPEED_LATENCY_HIGH_MS     = 80;
+    inline static constexpr double SPEED_LATENCY_LOW_MS      = 40;
+    inline static constexpr int    SPEED_HEALTHY_TICKS       = 5;
+    inline static constexpr int    DECISION_DEADLINE_MS      = 1500;  // trigger -> servo budget when belt speed is unknown
+
+    /* --- deadline-aware scheduling ----------------------------------------- */
+    inline static constexpr double CAMERA_TO_DIVERTER_CM     = 35.0;  // belt distance from the gating line to the servo gate
+    inline static constexpr double BELT_MAX_SPEED_CM_S       = 25.0;  // belt speed at PCT:100
+    inline static constexpr int    ACTUATION_MARGIN_MS       = 150;   // servo travel time, reserved out of every deadline
+
+    /* --- annotated image archive ------------------------------------------- */
+    inline static constexpr bool     ARCHIVE_ENABLED         = true;
+    inline static constexpr size_t   ARCHIVE_QUEUE_SIZE      = 16;    // frames waiting for the encoders, more are dropped
+    inline static constexpr int      ARCHIVE_WORKERS         = 2;
+    inline static constexpr unsigned ARCHIVE_HEALTHY_EVERY   = 10;    // rotten frames are always kept
+    inline static constexpr unsigned ARCHIVE_EMPTY_EVERY     = 0;     // frames without detections (0 = never)
+    inline static constexpr unsigned long long ARCHIVE_QUOTA_BYTES = 512ULL * 1024 * 1024;
+    inline static constexpr int      ARCHIVE_JPEG_QUALITY    = 85;
+
+    /* --- desktop live preview ---------------------------------------------- */
+    inline static constexpr int      PREVIEW_JPEG_QUALITY    = 80;    // upper bound, lowered on viewer loss
+    inline static constexpr int      PREVIEW_MIN_JPEG_QUALITY = 40;
+    inline static constexpr int      PREVIEW_MAX_FPS         = 30;    // per camera, newer frames replace unsent ones
+    inline static constexpr int      PREVIEW_MIN_FPS         = 2;
+    inline static constexpr int      PREVIEW_FEEDBACK_PORT   = 5001;  // desktop Receiver reports here
+    inline static constexpr int      PREVIEW_SUBSCRIBER_TIMEOUT_MS = 3000;   // then stop encoding
+    inline static constexpr int      PREVIEW_MULTICAST_TTL   = 1;     // stay on the plant LAN
+
+    /* --- scan journal (store-and-forward to the backend) ------------------- */
+    inline static constexpr size_t   JOURNAL_SEGMENT_RECORDS = 16384; // 64 bytes each -> 1 MiB segment files
+    inline static constexpr size_t   JOURNAL_MAX_SEGMENTS    = 64;    // disk bound, oldest unshipped segment dropped beyond it
+    inline static constexpr int      JOURNAL_FLUSH_INTERVAL_MS = 200; // one msync per interval, not per scan
+    inline static constexpr size_t   JOURNAL_SHIP_BATCH      = 16;    // products shipped per wake-up, one POST each
+    inline static constexpr int      JOURNAL_SHIP_INTERVAL_MS = 500;
+    inline static constexpr int      JOURNAL_RETRY_MAX_MS    = 30000; // backoff ceiling while the backend is down
+    inline static constexpr bool     JOURNAL_CBOR_UPLOADS    = true;  // application/cbor batches, JSON once the backend answers 415
+
+    /* --- backend WebSocket channel ----------------------------------------- */
+    inline static constexpr size_t   WS_WINDOW               = 32;    // unacknowledged frames in flight
+    inline static constexpr size_t   WS_QUEUE_CAPACITY       = 1024;
+    inline static constexpr int      WS_RECONNECT_MIN_MS     = 500;
+    inline static constexpr int      WS_RECONNECT_MAX_MS     = 30000;
+    inline static constexpr int      WS_PING_INTERVAL_MS     = 5000;
+    inline static constexpr int      WS_ACK_TIMEOUT_MS       = 2000;  // per product; unsent ones go by HTTP POST, sent ones are asked again later
+
+    /* --- system sampler ---------------------------------------------------- */
+    inline static constexpr int      SYSTEM_SAMPLE_INTERVAL_MS = 1000; // CPU deltas are taken over one interval
+    inline static constexpr int      SYSTEM_STATUS_EVERY     = 5;     // samples per status upload to the backend
+
+    /* --- cold start -------------------------------------------------------- */
+    inline static constexpr int      ARDUINO_READY_TIMEOUT_MS = 2500; // reset by the port open, bootloader, then setup()
+    inline static constexpr int      CAMERA_SETTLE_FRAMES    = 5;     // frames after the background before a camera is ready
+    inline static constexpr int      STARTUP_READY_TIMEOUT_MS = 5000; // sorting starts even if a camera never settles
+
+    /* --- on-device history ------------------------------------------------- */
+    inline static constexpr uint32_t HISTORY_SECOND_SLOTS    = 3600;  // 1 h at 1 s
+    inline static constexpr uint32_t HISTORY_MINUTE_SLOTS    = 1440;  // 24 h at 1 min
+    inline static constexpr uint32_t HISTORY_HOUR_SLOTS      = 720;   // 30 days at 1 h; ~500 KiB file in total
+
+    /* --- thermal load shedding --------------------------------------------- */
+    inline static constexpr double   SHED_PREVIEW_AT_C       = 70.0;  // preview held at min fps and quality
+    inline static constexpr double   SHED_ARCHIVE_AT_C       = 74.0;  // only rotten frames are archived
+    inline static constexpr double   SHED_GATE_AT_C          = 78.0;  // motion gate on a smaller image; the Pi throttles at 80-85
+    inline static constexpr double   SHED_HYSTERESIS_C       = 4.0;
+    inline static constexpr float    SHED_CPU_HIGH_PERCENT   = 90.0f; // sheds one more level per interval
+    inline static constexpr float    SHED_CPU_LOW_PERCENT    = 70.0f;
+    inline static constexpr int      SHED_INTERVAL_MS        = 2000;
+    inline static constexpr int      SHED_RELEASE_HOLD_MS    = 30000; // cool this long before each step back
+    inline static constexpr double   SHED_GATE_SCALE         = 0.5;   // gate analysis size while shedding
+
+    /* --- actuator command queue -------------------------------------------- */
+    inline static constexpr size_t   ACTUATOR_QUEUE_CAPACITY = 32;    // operator commands waiting; 503 beyond it (stops always fit)
+    inline static constexpr size_t   ACTUATOR_HISTORY        = 256;   // commands kept for GET /commands/{id}
+    inline static constexpr int      ACTUATOR_WAIT_MS        = 2000;  // speed controller waits this long for its command's reply
+
+    /* --- decision fusion --------------------------------------------------- */
+    inline static constexpr double HEALTH_THRESHOLD_PERCENT  = 70;    // initial per-product threshold (POST /threshold)
+    inline static constexpr double UNCERTAIN_BAND_PERCENT    = 20;    // just below the threshold -> Uncertain, reject lane
+    inline static constexpr double ROTTEN_VETO               = 0.8;   // one camera this sure of rot decides alone
+    inline static constexpr double MIN_PRODUCT_AGREEMENT     = 0.75;  // cameras must agree on the product type
+    inline static constexpr int    SERVO_OPEN_ANGLE          = 30;    // diverter lets a healthy product through
+    inline static constexpr int    SERVO_REJECT_ANGLE        = 150;   // diverter pushes to the reject lane
+
+    /* --- multi-frame burst per trigger ------------------------------------- */
+    inline static constexpr bool   BURST_ENABLED             = true;  // send the sharpest frames of the transit, not just the trigger frame
+    inline static constexpr int    BURST_WINDOW_FRAMES       = 6;     // frames scored after the trigger (~200 ms at 30 fps)
+    inline static constexpr int    BURST_SIZE                = 3;     // sharpest frames kept and sent to the detector
+    inline static constexpr int    SHARPNESS_ANALYSIS_WIDTH  = 160;   // ROI is downscaled to this width before scoring
+
+    /* --- stage-one product gate -------------------------------------------- */
+    inline static constexpr bool   GATE_ENABLED              = true;  // reject empty-belt frames before the detector
+    inline static constexpr double GATE_RECALL_TARGET        = 0.99;  // share of real products that must still pass
+    inline static constexpr size_t GATE_MIN_CALIBRATION      = 50;    // confirmed products before anything is rejected
+    inline static constexpr size_t GATE_CALIBRATION_WINDOW   = 500;
+    inline static constexpr unsigned GATE_AUDIT_EVERY        = 20;    // let 1 in N rejects through to measure misses
+    inline static constexpr int    GATE_SATURATION_MIN       = 60;
+    inline static constexpr int    GATE_VALUE_MIN            = 40;
+    inline static constexpr double GATE_EDGE_WEIGHT          = 0.3;
+    inline static constexpr double GATE_MAX_THRESHOLD        = 0.5;
+    inline static constexpr int    GATE_ANALYSIS_WIDTH       = 96;
+
+    /* --- accelerator model scheduler --------------------------------------- */
+    // HailoRT priorities run 0..31, 16 is normal. The classifier finishes products
+    // already in flight, so it outranks the detector taking in new ones.
+    inline static constexpr uint16_t DETECTOR_BATCH_SIZE          = 1;
+    inline static constexpr uint8_t  DETECTOR_SCHEDULER_PRIORITY  = 16;
+    inline static constexpr uint16_t CLASSIFIER_BATCH_SIZE        = 4;   // crops of one frame go out together
+    inline static constexpr uint8_t  CLASSIFIER_SCHEDULER_PRIORITY = 20;
 
     /* --- colour-tolerance parameters --------------------------------------- */
     // Per-channel (R,G,B) tolerance in percent, expressed as a Vec3d
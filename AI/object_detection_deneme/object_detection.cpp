@@ -1,12 +1,15 @@
 #include "scan_request_dto.h"
 #include "http_client.h"
-#include "async_inference.hpp"
+#include "inference_backend.hpp"
+#include "crop_classifier.hpp"
+#include "burst_evidence.hpp"
 #include "utils.hpp"
 #include <thread>
 #include <algorithm>
 #include <mutex>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <unordered_map>
 #include <unistd.h>
 #include <vector>
@@ -18,15 +21,29 @@
 
 #include <vector>
 #include "image_interface.h"
-#include "udp_sender.hpp"
+#include "preview_sender.hpp"
 #include "Object_info.hpp"
 #include "system_status_dto.h"
 #include "system_messages_dto.h"
 #include "HttpServerHandler.hpp"
+#include "BeltSpeedController.h"
+#include "ProductClassifier.h"
+#include "FusionEngine.h"
+#include "ImageArchiver.h"
+#include "ScanJournal.h"
+#include "BackendChannel.h"
+#include "Metrics.h"
+#include "ActuatorQueue.h"
+#include "SystemSampler.h"
+#include "TimeSeriesStore.h"
+#include "ThermalGovernor.h"
+#include "StartupGraph.h"
+#include "thread_name.hpp"
 
 // mert arduino flush variables başlangıç
 inline static const std::string InoFilePath = "../SerialPort_communication/SerialPort_communication.ino";
 inline static const std::string ARDUINO_PORT {"/dev/ttyUSB0"};
+inline static const std::string ARDUINO_FQBN {"arduino:avr:uno"};
 // mert arduino flush variables bitiş
 
 pthread_barrier_t sync_barrier;
@@ -41,15 +58,35 @@ std::atomic_bool keep_logging{true};
 constexpr size_t MAX_QUEUE_SIZE = ImageInterface::QUEUE_SIZE;
 /////////////////////////////////
 
-std::shared_ptr<BoundedTSQueue<PreprocessedFrameItem>> preprocessed_queue =
-    std::make_shared<BoundedTSQueue<PreprocessedFrameItem>>(MAX_QUEUE_SIZE);
+std::shared_ptr<DeadlineTSQueue<PreprocessedFrameItem>> preprocessed_queue =
+    std::make_shared<DeadlineTSQueue<PreprocessedFrameItem>>(MAX_QUEUE_SIZE);
 
-std::shared_ptr<BoundedTSQueue<InferenceOutputItem>>   results_queue =
-    std::make_shared<BoundedTSQueue<InferenceOutputItem>>(MAX_QUEUE_SIZE);
+std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>>   results_queue =
+    std::make_shared<DeadlineTSQueue<InferenceOutputItem>>(MAX_QUEUE_SIZE);
+
+// results with their defect scores, filled by the crop-classify stage when a classifier is loaded
+std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>>   classified_queue =
+    std::make_shared<DeadlineTSQueue<InferenceOutputItem>>(MAX_QUEUE_SIZE);
+
+std::atomic<size_t> expired_decisions{0};   // products decided after they passed the diverter
     
 std::shared_ptr<BoundedTSQueue<SystemLogMessageDTO>>   system_message_queue =
     std::make_shared<BoundedTSQueue<SystemLogMessageDTO>>(MAX_QUEUE_SIZE);
 
+std::unique_ptr<BeltSpeedController> speed_controller;
+std::unique_ptr<ProductClassifier> product_classifier;   // stage-one empty-belt gate
+std::unique_ptr<CropClassifier> crop_classifier;         // second-stage defect model on detected boxes
+std::unique_ptr<FusionEngine> fusion_engine;
+std::unique_ptr<ImageArchiver> image_archiver;           // annotated frames, written off the decision path
+std::unique_ptr<PreviewSender> preview_sender;           // live JPEG preview to the desktop viewer
+std::unique_ptr<ScanJournal> scan_journal;               // scans survive backend outages and restarts
+std::unique_ptr<BackendChannel> backend_channel;         // persistent WebSocket to the backend, HTTP is the fallback
+std::unique_ptr<ActuatorQueue> actuator_queue;           // every write to the Arduino goes through here
+std::unique_ptr<SystemSampler> system_sampler;           // CPU, memory, temperature and per-thread load
+std::unique_ptr<TimeSeriesStore> history_store;          // 1 s / 1 min / 1 h history that outlives restarts
+std::unique_ptr<ThermalGovernor> thermal_governor;       // sheds preview, archive, gate resolution when hot
+std::atomic<bool> gate_shedding{false};                  // motion gate runs on a downscaled image
+
 
 
 std::atomic<bool> camera0_active{true};
@@ -60,93 +97,82 @@ std::atomic<bool> camera2_active{true};
 #define CAMERAS ImageInterface::CAMERA_NUMBER
 
 std::atomic_int active_cameras(CAMERAS); 
+std::atomic_int cameras_settling(CAMERAS);                         // grab threads without steady frames yet
+std::unique_ptr<cv::VideoCapture> opened_cameras[CAMERAS];        // opened during startup, taken by grabLoop
 
-double threshold(70);
 
 std::atomic_bool system_ready(false); // Seko delay için flag
 
 std::atomic_bool all_cameras_done(false);
 
+std::atomic_bool belt_armed(true); // ultrasonic pre-trigger: something is on the belt
+
 int count = ImageInterface::SAVE_NUMBER;
 
 int num_camera = ImageInterface::CAMERA_NUMBER;
 
 
 
+struct BurstFrame {
+    cv::Mat frame;
+    double sharpness;
+};
+
 typedef struct CamBuf{
     int camId;
     cv::Mat frame;
     std::mutex m;
     bool object_detection = false;
     std::atomic_bool camera = false;
+    std::chrono::steady_clock::time_point trigger_time;
+    unsigned long long trigger_id = 0;
+    std::vector<BurstFrame> burst;     // sharpest frames of the last trigger, sharpest first
+    bool burst_ready = false;          // cleared only by the consumer, unlike object_detection
 }CamBuf;
 
 
 
 
 static std::unordered_map<int, std::chrono::steady_clock::time_point> last_capture_ts;
+static std::atomic<unsigned long long> next_trigger_id{1};     // 0 marks frames that no trigger produced
 
 
 constexpr auto CAPTURE_COOLDOWN = std::chrono::seconds(ImageInterface::COOLDOWN_SECONDS);
 
 
-struct CpuTimes { long long user, nice, system, idle; };
-
-
-double get_cpu_temp() {
-    std::ifstream t("/sys/class/thermal/thermal_zone0/temp");
-    double millideg;
-    if (t >> millideg) 
-		return millideg / 1000.0;   // °C
-	
-	SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "get_cpu_temp failed");
-	system_message_queue->push(msg);
-    
-    throw std::runtime_error("temp read failed");
-}
-
-
-
-CpuTimes read_proc_stat() {
-    std::ifstream f("/proc/stat");
-    std::string cpu;
-    CpuTimes ct{};
-    f >> cpu >> ct.user >> ct.nice >> ct.system >> ct.idle;
-    return ct;
-}
-
-double get_cpu_usage(int ms = 500) {
-    auto a = read_proc_stat();
-    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-    auto b = read_proc_stat();
+// Arms camera gating while the ultrasonic sensor reports an object on the belt.
+// Missing or stale readings keep gating armed so a sensor fault never blinds the line.
+void monitor_belt_distance(ArduinoSerial &arduino)
+{
+    set_thread_name("distance");
+    const auto stale = std::chrono::milliseconds(ImageInterface::DISTANCE_STALE_MS);
+    const auto hold  = std::chrono::milliseconds(ImageInterface::DISTANCE_ARM_HOLD_MS);
+    auto last_presence = std::chrono::steady_clock::now();
 
-    long long idle   = b.idle  - a.idle;
-    long long totalA = a.user + a.nice + a.system + a.idle;
-    long long totalB = b.user + b.nice + b.system + b.idle;
-    long long total  = totalB - totalA;
+    while (keep_logging)
+    {
+        int cm = arduino.getLatestDistanceCm(stale);
+        auto now = std::chrono::steady_clock::now();
 
-    return 100.0 * (total - idle) / total;  // %
-}
+        if (cm < 0) {
+            belt_armed = true;
+        }
+        else if (cm < ImageInterface::BELT_EMPTY_DISTANCE_CM) {
+            last_presence = now;
+            belt_armed = true;
+        }
+        else {
+            belt_armed = (now - last_presence) < hold;
+        }
 
-struct MemInfo { long long free, total; };
-
-MemInfo get_mem() {
-    std::ifstream f("/proc/meminfo");
-    std::string key, unit;
-    long long val;
-    MemInfo m{};
-    while (f >> key >> val >> unit) {
-        if (key == "MemTotal:") m.total = val;
-        if (key == "MemAvailable:") m.free = val;
-        if (m.free && m.total) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(ImageInterface::DISTANCE_INTERVAL_MS / 2));
     }
-    // kB → MiB
-    m.total /= 1024; m.free /= 1024;
-    return m;
+    belt_armed = true;
 }
 
 void log_system_messages()
 {
+    set_thread_name("log-upload");
     // Initialize HTTP client
     HttpClient client;
     if (!client.initialize()) {
@@ -169,8 +195,8 @@ void log_system_messages()
         if (!hasLog) 
             continue;
         
-        // Send system message to server
-        bool success = client.sendSystemMessage(host, port, path, logMessage);
+        // Send system message to server, over the WebSocket while it is up
+        bool success = backend_channel->sendLog(logMessage) || client.sendSystemMessage(host, port, path, logMessage);
         
         if (success) 
         {
@@ -193,6 +219,7 @@ void log_system_messages()
 
 void log_system_stats()
 {
+    set_thread_name("stats-upload");
     // Initialize HTTP client
     HttpClient client;
     if (!client.initialize()) {
@@ -209,21 +236,21 @@ void log_system_stats()
 
     while (keep_logging) 
     {
-        /*  --- gather data --- */
-        double temp   = get_cpu_temp();
-        double cpuPct = get_cpu_usage();
-        MemInfo mem   = get_mem();
+        /*  --- latest sample, taken by the sampler thread --- */
+        SystemSampler::Snapshot sample = system_sampler->snapshot();
+        double temp   = sample.temperatureC;
+        double cpuPct = sample.cpuPercent;
 
         // Format memory usage as string
         std::ostringstream memStream;
-        memStream << mem.free << "/" << mem.total << " MiB";
+        memStream << sample.memAvailableMiB << "/" << sample.memTotalMiB << " MiB";
         std::string memoryUsage = memStream.str();
         
         // Create SystemStatusDTO with current timestamp
         SystemStatusDTO systemStatus(std::chrono::system_clock::now(), temp, cpuPct, memoryUsage);
         
-        // Send system status to server
-        bool success = client.sendSystemStatus(host, port, path, systemStatus);
+        // Send system status to server, over the WebSocket while it is up
+        bool success = backend_channel->sendStatus(systemStatus) || client.sendSystemStatus(host, port, path, systemStatus);
         
         if (success) {
             std::cout << "System status sent: " << temp << "°C, " << cpuPct << "%, " << memoryUsage << std::endl;
@@ -234,8 +261,8 @@ void log_system_stats()
 			system_message_queue->push(msg);
         }
 
-        // Wait 5 seconds (same as original timing)
-        for (int i = 0; i < 50 && keep_logging; ++i)    
+        // one upload every few samples
+        for (int i = 0; i < ImageInterface::SYSTEM_STATUS_EVERY * ImageInterface::SYSTEM_SAMPLE_INTERVAL_MS / 100 && keep_logging; ++i)    
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 }
@@ -301,6 +328,7 @@ void release_resources(cv::VideoCapture &capture, cv::VideoWriter &video, InputT
     }
     preprocessed_queue->stop();
     results_queue->stop();
+    classified_queue->stop();
 }
 
 // seko deneme 
@@ -338,70 +366,97 @@ void mekanik_kol(std::string::res){
     }
 }
 */
-std::vector<ScanRequestDTO> scans;
-
-bool isProductHealthy(const std::vector<ScanRequestDTO>& scans)
- {
-    double score = 0.0;
-    int numberOfScans = scans.size();
-    std::unordered_map<std::string, double> productConfidenceMap;
-	int count = 0;
-	bool flag1 = false, flag2 = false;
-    for (const auto& scan : scans) {
-        double confidence = scan.confidence();
-        std::string productResult = scan.productResult();
-
-        std::string productId, result;
-        std::istringstream iss(productResult);
-        std::getline(iss, productId, '_');
-        std::getline(iss, result);
-
-        bool isSuccess = (result == "Healthy");
-        if(isSuccess)
-			count++;
-        double health = isSuccess ? confidence : -1 * confidence;
-
-        score += health / numberOfScans;
-
-        // Sum health per product ID
-        productConfidenceMap[productId] += health;
+std::map<int, CameraScore> product_scans;               // the product being decided, one score per camera
+std::chrono::steady_clock::time_point scans_deadline;   // earliest deadline of the product being decided
+
+// Latest moment a frame triggered at `trigger` is still worth a servo command:
+// the product's travel time to the diverter at the current belt speed, minus servo travel.
+std::chrono::steady_clock::time_point decision_deadline(std::chrono::steady_clock::time_point trigger,
+                                                        const ArduinoSerial &arduino)
+{
+    int percent = arduino.getSpeedPercent();
+    if (percent == 0)
+        return std::chrono::steady_clock::time_point::max();   // belt stopped, product waits
+
+    double budget_ms = ImageInterface::DECISION_DEADLINE_MS;
+    if (percent > 0) {
+        double cm_per_s = ImageInterface::BELT_MAX_SPEED_CM_S * percent / 100.0;
+        budget_ms = ImageInterface::CAMERA_TO_DIVERTER_CM / cm_per_s * 1000.0;
     }
-	std::cout << "Health score is: " << score << "threshold is: " << threshold << std::endl;
-	if(count == numberOfScans)
-		flag1 = true;
-	if(score >= threshold)
-		flag2 = true;
-		
-	if(flag1 == true && flag2 == true) // tüm isimler "Healthy" ve score >= threshold
-		return true;
-	else if(flag1 == true && flag2 == false) // tüm isimler "Healthy" ama !(score >= threshold)
-		return false; // muallakta kalındı
-	else if(flag1 == false && flag2 == true) // tüm isimler "Healthy" degil(Rotten) ama score >= threshold
-		return false;
-	else if(flag1 == false && flag2 == false) // tüm isimler "Healthy" degil (Rotten) ve !(score >= threshold)
-		return false;
-	return false; // buraya gelmemesi bekleniyor
+    budget_ms -= ImageInterface::ACTUATION_MARGIN_MS;
+
+    return trigger + std::chrono::milliseconds(static_cast<long long>(std::max(0.0, budget_ms)));
 }
 
-bool send_to_server(HttpClient& client, std::string& host,int& port, std::string& path){
-	bool success = client.sendScans(host, port, path, scans);
-    
-		if (success) {
-			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "Scans successfully sent to server");
-			system_message_queue->push(msg);
-			std::cout << "Scans successfully sent to server" << std::endl;
-		} 
-		else {
-			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Failed to send scans to server");
-			system_message_queue->push(msg);
-			std::cerr << "Failed to send scans to server" << std::endl;
-		}
-		
-		return isProductHealthy(scans);
+std::string pipeline_drops_json()
+{
+    auto stage = [](const char *name, const auto &queue) {
+        return std::string("\"") + name + "\":{"
+            + "\"depth\":" + std::to_string(queue->size())
+            + ",\"expiredOnPush\":" + std::to_string(queue->expired_on_push())
+            + ",\"expiredOnPop\":" + std::to_string(queue->expired_on_pop())
+            + ",\"overflow\":" + std::to_string(queue->overflow()) + "}";
+    };
+    return "{" + stage("preprocess", preprocessed_queue)
+         + "," + stage("results", results_queue)
+         + "," + stage("classified", classified_queue)
+         + ",\"decision\":{\"expired\":" + std::to_string(expired_decisions.load()) + "}}";
 }
- 
 
+// GET /history?res=1s|1m|1h&from=<unix s>&to=<unix s>&series=cpuPercent,temperatureC
+std::string history_json(const httplib::Request &req)
+{
+    TimeSeriesStore::Resolution resolution = TimeSeriesStore::Minute;
+    if (req.has_param("res") && !TimeSeriesStore::resolutionFromName(req.get_param_value("res"), resolution))
+        throw std::invalid_argument("res must be 1s, 1m or 1h");
+
+    const long long now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const long long to = req.has_param("to") ? std::stoll(req.get_param_value("to")) : now;
+    const long long from = req.has_param("from") ? std::stoll(req.get_param_value("from")) : 0;
+
+    unsigned mask = ~0u;
+    if (req.has_param("series")) {
+        mask = 0;
+        std::stringstream names(req.get_param_value("series"));
+        std::string name;
+        while (std::getline(names, name, ',')) {
+            TimeSeriesStore::Series series;
+            if (!TimeSeriesStore::seriesFromName(name, series))
+                throw std::invalid_argument("unknown series " + name);
+            mask |= 1u << series;
+        }
+    }
+    return history_store->rangeJson(resolution, from, to, mask);
+}
 
+// Runs the defect model on the detector's boxes while post-process decides the previous frame
+void run_crop_classify(size_t class_count)
+{
+    set_thread_name("crop-classify");
+    Histogram &nms_seconds = Metrics::global().histogram("sdbelt_nms_parse_seconds", "Time spent parsing the NMS output of one frame",
+        {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01});
+
+    InferenceOutputItem item;
+    while (results_queue->pop(item)) {
+        auto nms_start = std::chrono::steady_clock::now();
+        item.bboxes = parse_nms_data(item.output_data_and_infos[0].first, class_count);
+        nms_seconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - nms_start).count());
+        try {
+            if (!item.bboxes.empty())
+                item.defect_scores = crop_classifier->classify(item.org_frame, item.bboxes);
+        }
+        catch (const std::exception &e) {
+            // the detector's classes still stand; an exception here would end the whole pipeline
+            SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, std::string("Defect classifier failed: ") + e.what());
+            system_message_queue->push(msg);
+        }
+        item.classified = true;
+        classified_queue->push(std::move(item));
+        item = InferenceOutputItem();
+    }
+    classified_queue->stop();
+}
 
 hailo_status run_post_process(
     InputType &input_type,
@@ -410,10 +465,10 @@ hailo_status run_post_process(
     int org_width,
     size_t frame_count,
     cv::VideoCapture &capture,
-    ArduinoSerial &arduino,
     size_t class_count = 80,
     double fps = 30) 
     {
+    set_thread_name("postprocess");
 
     cv::VideoWriter video;
     if (input_type.is_video || (input_type.is_camera && args.save)) {    
@@ -421,52 +476,81 @@ hailo_status run_post_process(
     }
     int i = 0;
     
-    /* Htpp Client */
-        HttpClient client;
-    if (!client.initialize()) {
-        SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Failed to initialize HTTP CLient");
-		system_message_queue->push(msg);
-        std::cerr << "Failed to initialize HTTP client" << std::endl;
-    }
-     std::string host = ImageInterface::SERVER_IP;  // Change to your server's hostname or IP
-    int port = ImageInterface::BACKEND_PORT;
-    std::string path = ImageInterface::BACKEND_SCANS_POINT;
+    BurstEvidence burst_evidence;
+
+    Metrics &metrics = Metrics::global();
+    Histogram &inference_seconds = metrics.histogram("sdbelt_inference_seconds", "Time from inference submit to output",
+        {0.005, 0.01, 0.02, 0.04, 0.08, 0.16, 0.32, 0.64});
+    Histogram &nms_seconds = metrics.histogram("sdbelt_nms_parse_seconds", "Time spent parsing the NMS output of one frame",
+        {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01});
+    Counter &servo_open = metrics.counter("sdbelt_servo_commands_total", "Servo moves issued by the decision loop", "position=\"open\"");
+    Counter &servo_reject = metrics.counter("sdbelt_servo_commands_total", "Servo moves issued by the decision loop", "position=\"reject\"");
     
+    // with a defect classifier the crop-classify stage sits between inference and here
+    auto decision_queue = crop_classifier ? classified_queue : results_queue;
+
     while (all_cameras_done != true) {
         show_progress(input_type, i, frame_count);
         InferenceOutputItem output_item;
-        if (!results_queue->pop(output_item)) {
+        if (!decision_queue->pop(output_item)) {
 			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Something went wrong in post_process while loop");
 			system_message_queue->push(msg);
             continue;
         }
+        if (output_item.infer_done > output_item.infer_start) {
+            std::chrono::duration<double, std::milli> latency = output_item.infer_done - output_item.infer_start;
+            inference_seconds.observe(latency.count() / 1000.0);
+            if (speed_controller)
+                speed_controller->reportInferenceLatency(latency.count());
+        }
+
+        // a product whose deadline passed can no longer be sorted: forget its partial scans
+        if (!product_scans.empty() && std::chrono::steady_clock::now() > scans_deadline) {
+            ++expired_decisions;
+            if (speed_controller)
+                speed_controller->reportDecision(true);
+            SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING, "Product passed the diverter before all cameras reported; scans dropped");
+            system_message_queue->push(msg);
+            product_scans.clear();
+        }
+        burst_evidence.drop_expired(std::chrono::steady_clock::now());
+
         auto& frame_to_draw = output_item.org_frame;
-        auto bboxes = parse_nms_data(output_item.output_data_and_infos[0].first, class_count);
+        if (!output_item.classified) {
+            auto nms_start = std::chrono::steady_clock::now();
+            output_item.bboxes = parse_nms_data(output_item.output_data_and_infos[0].first, class_count);
+            nms_seconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - nms_start).count());
+        }
+        auto &bboxes = output_item.bboxes;
+        if (product_classifier)
+            product_classifier->reportDetection(output_item.trigger_id, !bboxes.empty());
+
+        // healthy/rotten from the defect model on each crop, detector class kept for the product
+        const std::vector<float> &defect_scores = output_item.defect_scores;
          
         bool should_door_open = false;
         
 		double max_x = 0.0 , max_y = 0.0;
-         // ====== DEBUG CODE START ======
-		std::cout << "======== FRAME " << i << " DETECTIONS ========\n";
-	
 		std::string max_class_name;
 		float max = -1.f;
 		
 		if (bboxes.empty()) {
 			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "No objects detected in this frame");
 			system_message_queue->push(msg);
-			std::cout << "No objects detected in this frame.\n";
 		} 
 		else {
 			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "Object detected");
 			system_message_queue->push(msg);
-			std::cout << "Detected " << bboxes.size() << " objects:\n";
-			
-			
+
 			for (size_t j = 0; j < bboxes.size(); ++j) {
 				const auto &bbox = bboxes[j];
 				std::string class_name = get_coco_name_from_int(static_cast<int>(bbox.class_id));
 				float confidence = bbox.bbox.score * 100.f;
+				if (j < defect_scores.size() && defect_scores[j] >= 0.f) {
+					float verdict_confidence = 0.f;
+					class_name = refine_class_name(class_name, defect_scores[j], verdict_confidence);
+					confidence = std::min(confidence, verdict_confidence);   // sure only if both stages are
+				}
 
 				if (confidence > max) { 
 					max = confidence; 
@@ -474,39 +558,101 @@ hailo_status run_post_process(
 					max_x = bbox.bbox.x_max;
 					max_y = bbox.bbox.y_max;
 				}
+			}
+		}
+
+		// one score per camera: the frame itself, or its burst fused once complete
+		std::vector<CameraScore> camera_scores;
+		if (output_item.burst_size > 1) {
+			FrameEvidence evidence;
+			evidence.cam_id = output_item.cam_id;
+			evidence.trigger_id = output_item.trigger_id;
+			evidence.trigger_time = output_item.trigger_time;
+			evidence.deadline = output_item.deadline;
+			evidence.burst_size = output_item.burst_size;
+			evidence.sharpness = output_item.sharpness;
+			evidence.detected = !bboxes.empty();
+			evidence.class_name = max_class_name;
+			evidence.confidence = max;
+			evidence.x = max_x;
+			evidence.y = max_y;
+			camera_scores = burst_evidence.add(evidence);
+		}
+		else if (!bboxes.empty()) {
+			CameraScore single;
+			single.cam_id = output_item.cam_id;
+			single.trigger_id = output_item.trigger_id;
+			single.trigger_time = output_item.trigger_time;
+			single.deadline = output_item.deadline;
+			single.class_name = max_class_name;
+			single.confidence = max;
+			single.x = max_x;
+			single.y = max_y;
+			single.frames = single.detected_frames = 1;
+			camera_scores.push_back(single);
+		}
 
-				std::cout << j + 1 << ". Class: " << class_name
-						  << " (ID: " << bbox.class_id << ")"
-						  << " Confidence: " << std::fixed << std::setprecision(2) << confidence << "%"
-						  << " Position: [" << bbox.bbox.x_min << ", " << bbox.bbox.y_min << ", "
-						  << bbox.bbox.x_max << ", " << bbox.bbox.y_max << "]\n";
+		for (const auto &camera_score : camera_scores) {
+			// a camera reporting twice means the others missed the earlier product; it cannot be completed
+			if (product_scans.count(camera_score.cam_id)) {
+				SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING,
+					"Camera " + std::to_string(camera_score.cam_id) + " saw the next product before all cameras reported; scans dropped");
+				system_message_queue->push(msg);
+				product_scans.clear();
 			}
-			
-			scans.push_back(ScanRequestDTO(max_class_name, max, max_y, max_x));
-			
-			std::cout << "Top-confidence: " << max_class_name << " (" 
-					  << std::fixed << std::setprecision(2) << max << "%)\n";
-			
-			if(scans.size() == num_camera){
-					should_door_open = send_to_server(client, host, port, path);
-					std::cout << "Should door open: " << should_door_open<< "\n";
-					if(should_door_open){
-						arduino.setServoAngle(30);
-						std::cout << "hayrullah kutuk nere" << std::endl;
-						SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "Servo Angle is set to 45");
+			if (product_scans.empty() || camera_score.deadline < scans_deadline)
+				scans_deadline = camera_score.deadline;
+			product_scans[camera_score.cam_id] = camera_score;
+		}
+
+		if (!camera_scores.empty()) {
+			if(static_cast<int>(product_scans.size()) == num_camera){
+					std::vector<ScanRequestDTO> scans;
+					std::vector<Detection> detections;   // typed twin of scans, what the fusion engine decides on
+					for (const auto &[cam_id, camera_score] : product_scans) {
+						scans.push_back(ScanRequestDTO(camera_score.class_name, camera_score.confidence, camera_score.y, camera_score.x));
+						Detection detection;
+						if (FusionEngine::parseLabel(camera_score.class_name, detection.product, detection.condition)) {
+							detection.confidence = camera_score.confidence / 100.f;
+							detection.camId = cam_id;
+							detections.push_back(detection);
+						}
+					}
+					scan_journal->append(scans);    // shipped to the backend by the journal, never from here
+					FusionEngine::Decision decision = fusion_engine->decide(detections);
+					should_door_open = decision.outcome == FusionOutcome::Healthy;
+					if (decision.outcome == FusionOutcome::Uncertain) {
+						// unsure products are not let through; they go to the reject lane for a second look
+						SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING, "Uncertain product sent to the reject lane");
+						system_message_queue->push(msg);
+					}
+					bool deadline_missed = std::chrono::steady_clock::now() > scans_deadline;
+					if (speed_controller)
+						speed_controller->reportDecision(deadline_missed);
+					if (deadline_missed) {
+						// the product is already past the gate; moving the servo now would sort the next one
+						++expired_decisions;
+						SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING, "Decision missed its deadline, servo not moved");
 						system_message_queue->push(msg);
 					}
 					else{
-						arduino.setServoAngle(150);
-						SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "Servo Angle is set to 135");
+						const int angle = should_door_open ? ImageInterface::SERVO_OPEN_ANGLE : ImageInterface::SERVO_REJECT_ANGLE;
+						// queued, not sent from here: the serial port belongs to the actuator worker
+						if (actuator_queue->submit("servo=" + std::to_string(angle), ActuatorQueue::Priority::Sort, scans_deadline) == 0) {
+							SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Actuator queue full, servo not moved");
+							system_message_queue->push(msg);
+						}
+						(should_door_open ? servo_open : servo_reject).inc();
+						SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO,
+							std::string(FusionEngine::productName(decision.product)) + " scored " + std::to_string(decision.score)
+							+ " (threshold " + std::to_string(decision.threshold) + "), servo angle set to " + std::to_string(angle));
 						system_message_queue->push(msg);
 					}
-					scans.clear();
+					product_scans.clear();
 			}
 		}
 		
 		
-		std::cout << "Sending " << scans.size() << " scans to server..." << std::endl;
     
 		/*
 		bool success = client.sendScans(host, port, path, scans);
@@ -520,27 +666,6 @@ hailo_status run_post_process(
 		scans.clear();
 		*/
 
-		// ====== DEBUG CODE END ======
-
-
-		// ========== OBJECT_INFO ==========
-		{
-			
-			auto [base_name, healthy] = parse_class_string(max_class_name);
-
-			object_info info(base_name,                 // sınıf
-							 static_cast<double>(max), // güven
-							 0,     //x
-							 0,    // y
-							 healthy);                  // is_healthy
-
-			std::cout << "[object_info] "
-					  << info.get_class() << ", conf "
-					  << info.get_confidence() << "%, ("
-					  << info.get_x() << ',' << info.get_y() << "), healthy="
-					  << std::boolalpha << info.get_is_healthy() << '\n';
-		}
-		// =================================
 
 
 
@@ -559,11 +684,12 @@ hailo_status run_post_process(
         
         
         // opencv rframe jpg formatında sıkıştırman gerekiyor
-        draw_bounding_boxes(frame_to_draw, bboxes);
-        
-        std::filesystem::create_directories("photos");          // photos yoksa aç
-        std::string filename = "photos/deneme_" + std::to_string(i) + ".jpg";
-		cv::imwrite(filename, frame_to_draw);
+        // boxes are drawn and the JPEG written by the archiver's workers
+        if (image_archiver) {
+            ArchiveKind kind = bboxes.empty() ? ArchiveKind::Empty
+                             : (max_class_name.find("Rotten") != std::string::npos ? ArchiveKind::Rotten : ArchiveKind::Healthy);
+            image_archiver->submit(frame_to_draw, std::move(bboxes), kind);
+        }
 		i++;
     }
     release_resources(capture, video, input_type);
@@ -945,10 +1071,49 @@ inline bool isCenterBetweenPoints(const cv::Point2d& p1,
 
 
 
+// Variance of the Laplacian: high for crisp edges, low for motion blur or defocus
+double frame_sharpness(const cv::Mat &roi)
+{
+    cv::Mat small, gray, lap;
+    double scale = std::min(1.0, static_cast<double>(ImageInterface::SHARPNESS_ANALYSIS_WIDTH) / roi.cols);
+    cv::resize(roi, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+    cv::Laplacian(gray, lap, CV_32F);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(lap, mean, stddev);
+    return stddev[0] * stddev[0];
+}
+
+// Motion-gate input; downscaled while the thermal governor sheds gate resolution
+cv::Mat gate_view(const cv::Mat &image, double scale)
+{
+    if (scale >= 1.0)
+        return image;
+    cv::Mat small;
+    cv::resize(image, small, cv::Size(), scale, scale, cv::INTER_AREA);
+    return small;
+}
+
+// Inserts frame into burst (sharpest first) and keeps at most keep entries
+void keep_sharpest(std::vector<BurstFrame> &burst, const cv::Mat &frame, int keep)
+{
+    BurstFrame candidate{frame, frame_sharpness(frame)};
+    auto pos = std::find_if(burst.begin(), burst.end(),
+                            [&](const BurstFrame &b) { return b.sharpness < candidate.sharpness; });
+    burst.insert(pos, candidate);
+    if (static_cast<int>(burst.size()) > keep)
+        burst.pop_back();
+}
+
 void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
-              uint32_t width, uint32_t height, UdpSender udp)
+              uint32_t width, uint32_t height, PreviewSender &preview)
 {
-    cv::VideoCapture cap(camId, cv::CAP_V4L2);
+    set_thread_name(("grab-cam" + std::to_string(camId)).c_str());
+    // opened by the startup graph while the model was loading; open it here if that did not run
+    std::unique_ptr<cv::VideoCapture> opened = std::move(opened_cameras[buf.camId]);
+    if (!opened)
+        opened = std::make_unique<cv::VideoCapture>(camId, cv::CAP_V4L2);
+    cv::VideoCapture &cap = *opened;
     
     
     if (!cap.isOpened()) {
@@ -962,6 +1127,7 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 		else if (buf.camId == 2) camera2_active = false;
 		
 		--active_cameras;
+		--cameras_settling;
 		num_camera--;
 		
 		pthread_barrier_wait(&sync_barrier);
@@ -972,7 +1138,12 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
     
     cap.set(cv::CAP_PROP_FRAME_WIDTH,  width);
     cap.set(cv::CAP_PROP_FRAME_HEIGHT, height);
-    cap.set(cv::CAP_PROP_FPS,          30);
+    cap.set(cv::CAP_PROP_FPS,          ImageInterface::CAPTURE_FPS);
+
+    // capture fps is rate() of the frame counter on the scraper side
+    const std::string camera_label = "camera=\"" + std::to_string(buf.camId) + "\"";
+    Counter &frames_captured = Metrics::global().counter("sdbelt_frames_captured_total", "Frames read from the camera", camera_label);
+    Counter &gate_triggers = Metrics::global().counter("sdbelt_gate_triggers_total", "Products seen crossing the camera's ROI", camera_label);
 
     // — 1) Arka‑plan karesi + dikey çizgi koordinatları —
     cv::Mat background;
@@ -1035,6 +1206,17 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
         
     // — 2) Sürekli okuma, kırpma ve paylaşılan arabellek —
     
+    // — burst: keep the sharpest frames while the product crosses the ROI —
+    std::vector<BurstFrame> burst;
+    int burst_remaining = 0;
+
+    bool settled = false;
+    int settle_frames = 0;
+    bool armed = true;
+    bool idle_fps_applied = false;
+    int idle_skip = 0;
+    const int idle_stride = std::max(1, ImageInterface::CAPTURE_FPS / ImageInterface::IDLE_FPS);
+
     while (run) {
         cv::Mat frame;
         // frame is a cv::Mat that already contains your BGR pixels
@@ -1044,6 +1226,41 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 			system_message_queue->push(msg);
 			break; 
 		}
+        frames_captured.inc();
+        if (!settled && ++settle_frames >= ImageInterface::CAMERA_SETTLE_FRAMES) {
+            settled = true;     // background taken and exposure steady: this camera is ready
+            --cameras_settling;
+        }
+
+        // — Ultrasonic pre-trigger: belt empty -> low-cost idle mode —
+        bool now_armed = belt_armed.load();
+        if (now_armed != armed) {
+            armed = now_armed;
+            if (armed) {
+                if (idle_fps_applied)
+                    cap.set(cv::CAP_PROP_FPS, ImageInterface::CAPTURE_FPS);
+                idle_fps_applied = false;
+                previous_difference = cv::Point2d(-1, -1);
+            }
+            else {
+                idle_fps_applied = cap.set(cv::CAP_PROP_FPS, ImageInterface::IDLE_FPS);
+                burst_remaining = 0;
+                burst.clear();
+            }
+            idle_skip = 0;
+        }
+
+        if (!armed) {
+            buf.object_detection = false;
+            // driver ignored the fps request: thin the frames ourselves
+            if (!idle_fps_applied && (idle_skip++ % idle_stride) != 0)
+                continue;
+
+            std::lock_guard<std::mutex> lk(buf.m);
+            buf.frame = cropBetweenXs(frame, leftX, rightX);
+            preview.submit(buf.camId, frame);
+            continue;
+        }
         
         // size_t rawBytes = frame.total() * frame.elemSize();   // rows*cols*channels
 		
@@ -1051,19 +1268,22 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
         
         Test = detectFirstVerticalLinesFromCenter(background); // çizgileri görmek için kullanıyoruz
         cv::Mat cropped = cropBetweenXs(frame, leftX, rightX);
+        // thresholds are percentages, so a smaller gate image only moves the centroid's scale;
+        // the frame that switches size compares against a mismatched previous_frame and never triggers
+        const double gate_scale = gate_shedding.load(std::memory_order_relaxed) ? ImageInterface::SHED_GATE_SCALE : 1.0;
 
 
             if(buf.camId == 0 && camera0_active == true){
-                mean_frame = whiteOutSameTone(cropped, mean_rgb, ImageInterface::LUMIN_TOL_PERCENT, ImageInterface::COLOR_TOL_PERCENT_RGB);
+                mean_frame = whiteOutSameTone(gate_view(cropped, gate_scale), mean_rgb, ImageInterface::LUMIN_TOL_PERCENT, ImageInterface::COLOR_TOL_PERCENT_RGB);
                 // detection = framesDifferAboveTol(mean_frame, mean_bg_frame, 15);
             }
             else if(buf.camId == 1 && camera1_active == true){
-                mean_frame = whiteOutSameTone(cropped, mean_rgb, ImageInterface::LUMIN_TOL_PERCENT, ImageInterface::COLOR_TOL_PERCENT_RGB);
+                mean_frame = whiteOutSameTone(gate_view(cropped, gate_scale), mean_rgb, ImageInterface::LUMIN_TOL_PERCENT, ImageInterface::COLOR_TOL_PERCENT_RGB);
                 // detection = framesDifferAboveTol(mean_frame, mean_bg_frame, 15);
             }
             
             else if(buf.camId == 2 && camera2_active == true){
-                mean_frame = whiteOutSameTone(frame, mean_rgb, ImageInterface::LUMIN_TOL_PERCENT, ImageInterface::COLOR_TOL_PERCENT_RGB);
+                mean_frame = whiteOutSameTone(gate_view(frame, gate_scale), mean_rgb, ImageInterface::LUMIN_TOL_PERCENT, ImageInterface::COLOR_TOL_PERCENT_RGB);
                 // detection = framesDifferAboveTol(mean_frame, mean_bg_frame, 15);
             }
             
@@ -1090,6 +1310,8 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
             else if(buf.camId == 2 && camera2_active == true){
                 difference =  diffCentroidTol(mean_frame, previous_frame, ImageInterface::THRESHOLD_DIFFERENCE_2);
             }
+            if (gate_scale < 1.0 && difference.x >= 0)
+                difference *= 1.0 / gate_scale;     // back to full-frame pixels for the centre test
                     
             
             
@@ -1115,9 +1337,19 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 
                 if (can_capture) {
                     last_capture_ts[camId] = now; // yeni zaman damgası
+                    gate_triggers.inc();
 
                     /* — buraya ESAS tetikleme işleminiz — */
-                    buf.object_detection = true;          // kuyruğa itmek için bayrak
+                    std::lock_guard<std::mutex> lk(buf.m);   // run_preprocess reads both under the lock
+                    buf.trigger_time = now;
+                    buf.trigger_id = next_trigger_id++;
+                    if (ImageInterface::BURST_ENABLED) {
+                        burst.clear();
+                        burst_remaining = ImageInterface::BURST_WINDOW_FRAMES;
+                    }
+                    else {
+                        buf.object_detection = true;          // kuyruğa itmek için bayrak
+                    }
                     
                     
                     
@@ -1147,12 +1379,24 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 
             }
             else{
+                std::lock_guard<std::mutex> lk(buf.m);
                 buf.object_detection = false;
             }
             
             
             
             
+ 
+            if (burst_remaining > 0) {
+                keep_sharpest(burst, cropped, ImageInterface::BURST_SIZE);
+                if (--burst_remaining == 0) {
+                    std::lock_guard<std::mutex> lk(buf.m);
+                    buf.burst = std::move(burst);
+                    buf.burst_ready = true;
+                    burst.clear();
+                }
+            }
+
             previous_difference = difference;
             
 			/*
@@ -1171,7 +1415,7 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 				 buf.frame = std::move(cropped);
 
 				
-				udp.send(buf.camId, frame);
+				preview.submit(buf.camId, frame);
 			}
             else if(buf.camId == 1 && camera1_active == true){
 				std::lock_guard<std::mutex> lk(buf.m);
@@ -1179,7 +1423,7 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 				 buf.frame = std::move(cropped);
 
 				
-				udp.send(buf.camId, frame);
+				preview.submit(buf.camId, frame);
 			}
             
             else if(buf.camId == 2 && camera2_active == true) {
@@ -1188,13 +1432,15 @@ void grabLoop(int camId, CamBuf &buf, std::atomic<bool> &run,
 				buf.frame = std::move(cropped);
 				// buf.frame = mean_frame.clone();
 				
-				udp.send(buf.camId, frame);
+				preview.submit(buf.camId, frame);
 			}
         
     }
     
     
 
+    if (!settled)
+        --cameras_settling;     // stopped before it settled; don't hold up readiness
     if (--active_cameras == 0){
         SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "number of active cameras is 0, cameras will be closed.");
 		system_message_queue->push(msg);
@@ -1230,13 +1476,40 @@ void preprocess_directory_of_images(const std::string &input_path,
     }
 }
 
-hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model, 
-                            InputType &input_type, cv::VideoCapture &capture) {
+// Queues a finished burst; the stage-one gate looks at its sharpest frame only. Caller holds buf.m.
+void push_burst(CamBuf &buf, uint32_t width, uint32_t height, const ArduinoSerial &arduino)
+{
+    buf.burst_ready = false;
+    std::vector<BurstFrame> burst = std::move(buf.burst);
+    buf.burst.clear();
+    if (burst.empty())
+        return;
+    if (product_classifier && !product_classifier->accept(burst.front().frame, buf.trigger_id, static_cast<int>(burst.size())))
+        return;
+
+    auto deadline = decision_deadline(buf.trigger_time, arduino);
+    for (const auto &b : burst) {
+        auto item = create_preprocessed_frame_item(b.frame, width, height);
+        item.trigger_time = buf.trigger_time;
+        item.trigger_id = buf.trigger_id;
+        item.deadline = deadline;
+        item.cam_id = buf.camId;
+        item.sharpness = b.sharpness;
+        item.burst_size = static_cast<int>(burst.size());
+        preprocessed_queue->push(item);
+    }
+}
 
-    auto model_input_shape = model.get_infer_model()->hef().get_input_vstream_infos().release()[0].shape;
+hailo_status run_preprocess(CommandLineArgs args, InferenceBackend &model, 
+                            InputType &input_type, cv::VideoCapture &capture,
+                            ArduinoSerial &arduino) {
+    set_thread_name("preprocess");
+
+    auto model_input_shape = model.input_infos()[0];
     uint32_t target_height = model_input_shape.height;
     uint32_t target_width = model_input_shape.width;
-    print_net_banner(get_hef_name(args.detection_hef), std::ref(model.get_inputs()), std::ref(model.get_outputs()));
+    std::string model_path = model.name() == "cpu" ? args.onnx_path : args.detection_hef;
+    print_net_banner(get_hef_name(model_path) + " (" + model.name() + ")", model.input_infos(), model.output_infos());
 
 
     std::atomic<bool> running(true);
@@ -1254,14 +1527,13 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
 	std::thread t1;
 	std::thread t2;
 	
-	UdpSender udp0(ImageInterface::DESKTOP_IP_UDP,ImageInterface::UDP_COMMS_PORT); 
 	
 		try {
 			t0 = std::thread(grabLoop, 0,
 							 std::ref(buffer0),
 							 std::ref(running),
 							 target_width, target_height,
-							 std::cref(udp0));
+							 std::ref(*preview_sender));
 		}
 		catch (const std::system_error& e) {    // creation failed
 			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Thread 0 couldn't be started");
@@ -1278,20 +1550,19 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
 		/*
 		 * not controlling the thread operation part
 	 std::thread t0(grabLoop, 0, std::ref(buffer0), std::ref(running),
-				target_width, target_height, std::cref(udp0));  
+				target_width, target_height, std::ref(*preview_sender));  
 		*/
 		
 	
 	
 	
-	UdpSender udp1(ImageInterface::DESKTOP_IP_UDP, ImageInterface::UDP_COMMS_PORT);
 	
 		try {
 			t1 = std::thread(grabLoop, 2,
 							 std::ref(buffer1),
 							 std::ref(running),
 							 target_width, target_height,
-							 std::cref(udp1));
+							 std::ref(*preview_sender));
 		}
 		catch (const std::system_error& e) {    // creation failed
 			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Thread 1 couldn't be started");
@@ -1309,20 +1580,19 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
 	
 	/*
     std::thread t1(grabLoop, 2, std::ref(buffer1), std::ref(running),
-				target_width, target_height, std::cref(udp1));
+				target_width, target_height, std::ref(*preview_sender));
 	* */
 				
 				
 				    
     
-	UdpSender udp2(ImageInterface::DESKTOP_IP_UDP, ImageInterface::UDP_COMMS_PORT);  
 	
 		try {
 			t2 = std::thread(grabLoop, 4,
 							 std::ref(buffer2),
 							 std::ref(running),
 							 target_width, target_height,
-							 std::cref(udp2));
+							 std::ref(*preview_sender));
 		}
 		catch (const std::system_error& e) {    // creation failed
 			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Thread 2 couldn't be started");
@@ -1338,7 +1608,7 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
 	
 	/* 
     std::thread t2(grabLoop, 4, std::ref(buffer2), std::ref(running),
-				target_width, target_height, std::cref(udp2));  
+				target_width, target_height, std::ref(*preview_sender));  
 	*/
     
     
@@ -1369,11 +1639,19 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
                 cv::imshow("Cam0", buffer0.frame);
             
             if (system_ready.load() && buffer0.object_detection == true) { // seko system_ready.load() attı başlangıç delayı için
-				auto preprocessed_frame_item = create_preprocessed_frame_item(buffer0.frame, target_width, target_height);
-				preprocessed_queue->push(preprocessed_frame_item);
-				std::cout << "Frame alındı ve queue'ya eklendi.0" << std::endl;
+				if (!product_classifier || product_classifier->accept(buffer0.frame, buffer0.trigger_id)) {
+					auto preprocessed_frame_item = create_preprocessed_frame_item(buffer0.frame, target_width, target_height);
+					preprocessed_frame_item.trigger_time = buffer0.trigger_time;
+					preprocessed_frame_item.trigger_id = buffer0.trigger_id;
+					preprocessed_frame_item.deadline = decision_deadline(buffer0.trigger_time, arduino);
+					preprocessed_frame_item.cam_id = buffer0.camId;
+					preprocessed_queue->push(preprocessed_frame_item);
+					std::cout << "Frame alındı ve queue'ya eklendi.0" << std::endl;
+				}
 				buffer0.object_detection = false;
             } 
+            if (system_ready.load() && buffer0.burst_ready)
+				push_burst(buffer0, target_width, target_height, arduino);
             
         }
         if(camera1_active == true)
@@ -1383,11 +1661,19 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
                 cv::imshow("Cam1", buffer1.frame);
             
             if (system_ready.load() && buffer1.object_detection == true){ // seko system_ready.load() attı başlangıç delayı için
-				auto preprocessed_frame_item = create_preprocessed_frame_item(buffer1.frame, target_width, target_height);
-				preprocessed_queue->push(preprocessed_frame_item);
-				std::cout << "Frame alındı ve queue'ya eklendi.1" << std::endl;
+				if (!product_classifier || product_classifier->accept(buffer1.frame, buffer1.trigger_id)) {
+					auto preprocessed_frame_item = create_preprocessed_frame_item(buffer1.frame, target_width, target_height);
+					preprocessed_frame_item.trigger_time = buffer1.trigger_time;
+					preprocessed_frame_item.trigger_id = buffer1.trigger_id;
+					preprocessed_frame_item.deadline = decision_deadline(buffer1.trigger_time, arduino);
+					preprocessed_frame_item.cam_id = buffer1.camId;
+					preprocessed_queue->push(preprocessed_frame_item);
+					std::cout << "Frame alındı ve queue'ya eklendi.1" << std::endl;
+				}
 				buffer1.object_detection = false;
             } 
+            if (system_ready.load() && buffer1.burst_ready)
+				push_burst(buffer1, target_width, target_height, arduino);
             
         }
         if(camera2_active == true)
@@ -1397,11 +1683,19 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
                 cv::imshow("Cam2", buffer2.frame);
             
             if (system_ready.load() && buffer2.object_detection == true){ // seko system_ready.load() attı başlangıç delayı için
-				auto preprocessed_frame_item = create_preprocessed_frame_item(buffer2.frame, target_width, target_height);
-				preprocessed_queue->push(preprocessed_frame_item);
-				std::cout << "Frame alındı ve queue'ya eklendi.2" << std::endl;
+				if (!product_classifier || product_classifier->accept(buffer2.frame, buffer2.trigger_id)) {
+					auto preprocessed_frame_item = create_preprocessed_frame_item(buffer2.frame, target_width, target_height);
+					preprocessed_frame_item.trigger_time = buffer2.trigger_time;
+					preprocessed_frame_item.trigger_id = buffer2.trigger_id;
+					preprocessed_frame_item.deadline = decision_deadline(buffer2.trigger_time, arduino);
+					preprocessed_frame_item.cam_id = buffer2.camId;
+					preprocessed_queue->push(preprocessed_frame_item);
+					std::cout << "Frame alındı ve queue'ya eklendi.2" << std::endl;
+				}
 				buffer2.object_detection = false;
             } 
+            if (system_ready.load() && buffer2.burst_ready)
+				push_burst(buffer2, target_width, target_height, arduino);
             
         }
         
@@ -1430,8 +1724,9 @@ hailo_status run_preprocess(CommandLineArgs args, AsyncModelInfer &model,
     return HAILO_SUCCESS;
 }
 
-hailo_status run_inference_async(AsyncModelInfer& model,
+hailo_status run_inference_async(InferenceBackend& model,
                             std::chrono::duration<double>& inference_time) {
+    set_thread_name("inference");
     
     auto start_time = std::chrono::high_resolution_clock::now();
     while (all_cameras_done != true) {
@@ -1439,8 +1734,9 @@ hailo_status run_inference_async(AsyncModelInfer& model,
         if (!preprocessed_queue->pop(item)) {
             continue;
         }
-        model.infer(std::make_shared<cv::Mat>(item.resized_for_infer), item.org_frame);
+        model.infer(item);
     }
+    model.shutdown();
     model.get_queue()->stop();
     auto end_time = std::chrono::high_resolution_clock::now();
 
@@ -1451,28 +1747,131 @@ hailo_status run_inference_async(AsyncModelInfer& model,
 
 // mert istek fonksiyon baslangic
 
+// FNV-1a over the board type and the sketch source; changes whenever either does.
+// False if the sketch cannot be read: there is nothing to compare the board with, let alone flash.
+bool firmware_hash(const std::string &path, unsigned long &out)
+{
+    std::ifstream sketch(path, std::ios::binary);
+    if (!sketch)
+        return false;
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](unsigned char c) { hash ^= c; hash *= 16777619u; };
+    for (char c : ARDUINO_FQBN)
+        mix(static_cast<unsigned char>(c));
+    char c;
+    while (sketch.get(c))
+        mix(static_cast<unsigned char>(c));
+    if (sketch.bad())
+        return false;
+    out = hash == 0 ? 1 : hash;    // the board reports 0 for "built without a hash"
+    return true;
+}
+
 // FLASH ARDUINO
-bool UploadArduino()
+bool UploadArduino(unsigned long hash)
 {
-	std::string command = "~/bin/arduino-cli compile --fqbn arduino:avr:uno " + InoFilePath + 
-                         " && ~/bin/arduino-cli upload -p " + ARDUINO_PORT + " --fqbn arduino:avr:uno " + InoFilePath;
+	// the hash is compiled in, so the sketch can report what it was built from
+	char hash_define[64];
+	std::snprintf(hash_define, sizeof(hash_define), "build.extra_flags=-DFIRMWARE_HASH=0x%lXUL", hash);
+	std::string command = "~/bin/arduino-cli compile --fqbn " + ARDUINO_FQBN + " --build-property " + hash_define + " " + InoFilePath + 
+                         " && ~/bin/arduino-cli upload -p " + ARDUINO_PORT + " --fqbn " + ARDUINO_FQBN + " " + InoFilePath;
     
     int result = system(command.c_str());
     return (result == 0);
 }
 
+// Flashes only when the board's firmware hash differs from the sketch's, then waits until it answers
+bool prepare_arduino(ArduinoSerial &arduino)
+{
+	const auto ready_timeout = std::chrono::milliseconds(ImageInterface::ARDUINO_READY_TIMEOUT_MS);
+	unsigned long wanted = 0;
+	if (!firmware_hash(InoFilePath, wanted))
+	{
+		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Cannot read Arduino sketch " + InoFilePath);
+		system_message_queue->push(msg);
+		std::cerr << "Cannot read Arduino sketch " << InoFilePath << std::endl;
+		return false;
+	}
+	unsigned long running = 0;
+	if (arduino.waitReady(ready_timeout, running) && running == wanted)
+	{
+		std::cout << "Arduino firmware " << std::hex << running << std::dec << " is current, not flashing" << std::endl;
+		return true;
+	}
+
+	std::cout << "Arduino firmware " << std::hex << running << " differs from sketch " << wanted << std::dec << ", flashing" << std::endl;
+	arduino.close();    // the uploader needs the port to itself
+	if (!UploadArduino(wanted))
+	{
+		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Failed to flash arduino");
+		system_message_queue->push(msg);
+		return false;
+	}
+	arduino.open();
+	if (!arduino.waitReady(ready_timeout, running) || running != wanted)
+	{
+		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING, "Arduino did not confirm the flashed firmware");
+		system_message_queue->push(msg);
+	}
+	return true;
+}
+
+// Opens the cameras side by side while the model loads; grabLoop takes them over
+void open_cameras()
+{
+	const int devices[CAMERAS] = {0, 2, 4};     // the ids run_preprocess hands to grabLoop
+	std::vector<std::thread> openers;
+	for (int i = 0; i < CAMERAS; i++) {
+		openers.emplace_back([i, &devices]() {
+			opened_cameras[i] = std::make_unique<cv::VideoCapture>(devices[i], cv::CAP_V4L2);
+		});
+	}
+	for (auto &opener : openers)
+		opener.join();
+}
+
+// Stops whatever the startup phases brought up, in dependency order, skipping phases that never ran.
+// Also drops the objects holding references into main's frame, so no global destructor reaches them.
+void stop_services()
+{
+    if (speed_controller)
+        speed_controller->stop();
+    crop_classifier.reset();   // releases its share of the VDevice before the detector goes
+    if (image_archiver)
+        image_archiver->stop();    // flush queued images
+    if (scan_journal)
+        scan_journal->stop();      // unshipped scans stay on disk for the next start
+    if (backend_channel)
+        backend_channel->stop();
+    if (actuator_queue)
+        actuator_queue->stop();
+    actuator_queue.reset();        // runs its commands through main's server handler and Arduino
+    if (preview_sender)
+        preview_sender->stop();
+
+    if (thermal_governor)
+        thermal_governor->stop();  // reads the sampler too
+    if (history_store)
+        history_store->stop();     // samples the sampler, so it goes first
+    if (system_sampler)
+        system_sampler->stop();
+}
+
 // mert istek fonksiyon bitis
 
 
 int main(int argc, char** argv)
 {
-	if(!UploadArduino())
-	{
-		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Failed to flash arduino");
-		system_message_queue->push(msg);
-		return 0;
+	CommandLineArgs args;
+	try {
+		args = parse_command_line_arguments(argc, argv);
 	}
-	
+	catch (const std::invalid_argument &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	// Opening the port resets the board; its boot overlaps with the rest of the startup
 	ArduinoSerial arduino(ImageInterface::ARDUINO_PORT);
 	if (!arduino.isConnected())
 	{
@@ -1481,22 +1880,313 @@ int main(int argc, char** argv)
 		std::cerr << "Failed to connect to Arduino on " << ImageInterface::ARDUINO_PORT << std::endl;
 		// return 1;
 	}
-	
+
+	size_t class_count = 6; // 80 classes in COCO dataset
+	std::unique_ptr<InferenceBackend> model;
+
+	// Independent steps run side by side; each waits only for the phases it names
+	StartupGraph startup;
+	startup.add("firmware", {}, [&arduino]() { return prepare_arduino(arduino); });
+	startup.add("model", {}, [&args, &model, class_count]() {
+		try {
+			model = create_inference_backend(args, results_queue, class_count);
+		}
+		catch (const std::exception &e) {
+			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, std::string("Failed to create inference backend: ") + e.what());
+			system_message_queue->push(msg);
+			std::cerr << "Failed to create inference backend: " << e.what() << std::endl;
+			return false;
+		}
+		return true;
+	});
+
+	startup.add("classifier", {"model"}, [&args, &model]() {
+		try {
+			crop_classifier = create_crop_classifier(args, model.get());
+			if (crop_classifier)
+				std::cout << "Defect classifier: " << crop_classifier->name() << std::endl;
+		}
+		catch (const std::exception &e) {
+			SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING, std::string("Defect classifier disabled: ") + e.what());
+			system_message_queue->push(msg);
+			std::cerr << "Defect classifier disabled: " << e.what() << std::endl;
+			return false;
+		}
+		return true;
+	}, false);
+
+	startup.add("cameras", {}, []() { open_cameras(); return true; }, false);
+
+	startup.add("fusion", {}, []() {
+		FusionEngine::Settings fusion_settings{};
+		std::fill(std::begin(fusion_settings.productThreshold), std::end(fusion_settings.productThreshold), ImageInterface::HEALTH_THRESHOLD_PERCENT);
+		std::fill(std::begin(fusion_settings.cameraWeight), std::end(fusion_settings.cameraWeight), 1.0);
+		fusion_settings.uncertainBand = ImageInterface::UNCERTAIN_BAND_PERCENT;
+		fusion_settings.rottenVeto = ImageInterface::ROTTEN_VETO;
+		fusion_settings.minProductAgreement = ImageInterface::MIN_PRODUCT_AGREEMENT;
+		fusion_engine = std::make_unique<FusionEngine>(fusion_settings);
+		if (!fusion_engine->loadCalibration(ImageInterface::CALIBRATION_FILE))
+			std::cout << "No calibration file at " << ImageInterface::CALIBRATION_FILE << ", using raw confidences" << std::endl;
+		return true;
+	});
+
+	startup.add("archive", {}, []() {
+		if (ImageInterface::ARCHIVE_ENABLED) {
+			ImageArchiver::Config archive_config{
+				ImageInterface::ARCHIVE_DIR,
+				ImageInterface::ARCHIVE_QUEUE_SIZE,
+				ImageInterface::ARCHIVE_WORKERS,
+				ImageInterface::ARCHIVE_HEALTHY_EVERY,
+				ImageInterface::ARCHIVE_EMPTY_EVERY,
+				ImageInterface::ARCHIVE_QUOTA_BYTES,
+				ImageInterface::ARCHIVE_JPEG_QUALITY
+			};
+			image_archiver = std::make_unique<ImageArchiver>(archive_config);
+		}
+		return true;
+	});
+
+	startup.add("channel", {}, []() {
+		BackendChannel::Config channel_config{
+			ImageInterface::SERVER_IP,
+			ImageInterface::BACKEND_PORT,
+			ImageInterface::BACKEND_WS_POINT,
+			ImageInterface::WS_WINDOW,
+			ImageInterface::WS_QUEUE_CAPACITY,
+			ImageInterface::WS_RECONNECT_MIN_MS,
+			ImageInterface::WS_RECONNECT_MAX_MS,
+			ImageInterface::WS_PING_INTERVAL_MS
+		};
+		backend_channel = std::make_unique<BackendChannel>(channel_config);
+		return true;
+	});
+
+	startup.add("journal", {"channel"}, []() {
+		HttpClient::setPreferredEncoding(ImageInterface::JOURNAL_CBOR_UPLOADS ? HttpClient::Encoding::Cbor : HttpClient::Encoding::Json);
+		ScanJournal::Config journal_config{
+			ImageInterface::JOURNAL_DIR,
+			ImageInterface::JOURNAL_SEGMENT_RECORDS,
+			ImageInterface::JOURNAL_MAX_SEGMENTS,
+			ImageInterface::JOURNAL_FLUSH_INTERVAL_MS,
+			ImageInterface::JOURNAL_SHIP_BATCH,
+			ImageInterface::JOURNAL_SHIP_INTERVAL_MS,
+			ImageInterface::JOURNAL_RETRY_MAX_MS,
+			ImageInterface::SERVER_IP,
+			ImageInterface::BACKEND_PORT,
+			ImageInterface::BACKEND_SCANS_POINT,
+			[](uint64_t productId, const std::vector<ScanRequestDTO> &batch) {
+				switch (backend_channel->sendScans(productId, batch, ImageInterface::WS_ACK_TIMEOUT_MS))
+				{
+				case BackendChannel::SendResult::Stored: return ScanJournal::Delivery::Stored;
+				case BackendChannel::SendResult::Unknown: return ScanJournal::Delivery::InFlight;
+				default: return ScanJournal::Delivery::NotSent;
+				}
+			}
+		};
+		scan_journal = std::make_unique<ScanJournal>(journal_config);
+		return true;
+	});
+
+	startup.add("sampler", {}, []() {
+		system_sampler = std::make_unique<SystemSampler>(SystemSampler::Config{
+			ImageInterface::THERMAL_ZONE_PATH,
+			ImageInterface::SYSTEM_SAMPLE_INTERVAL_MS
+		});
+		return true;
+	});
+
+	startup.add("history", {"sampler"}, []() {
+		TimeSeriesStore::Config history_config{
+			ImageInterface::HISTORY_FILE,
+			{ImageInterface::HISTORY_SECOND_SLOTS, ImageInterface::HISTORY_MINUTE_SLOTS, ImageInterface::HISTORY_HOUR_SLOTS},
+			[frames = uint64_t{0}, products = uint64_t{0}, inferences = uint64_t{0}, inference_sum = 0.0]
+			(float (&values)[TimeSeriesStore::SERIES]) mutable {
+				SystemSampler::Snapshot sample = system_sampler->snapshot();
+				values[TimeSeriesStore::TemperatureC] = static_cast<float>(sample.temperatureC);
+				values[TimeSeriesStore::CpuPercent] = sample.cpuPercent;
+				values[TimeSeriesStore::MemAvailableMiB] = static_cast<float>(sample.memAvailableMiB);
+
+				// the metrics are cumulative; one call per second makes the difference a rate
+				Metrics &metrics = Metrics::global();
+				uint64_t frames_now = metrics.counterTotal("sdbelt_frames_captured_total");
+				uint64_t products_now = metrics.counterTotal("sdbelt_servo_commands_total");
+				values[TimeSeriesStore::FramesPerSecond] = static_cast<float>(frames_now - frames);
+				values[TimeSeriesStore::ProductsPerSecond] = static_cast<float>(products_now - products);
+				frames = frames_now;
+				products = products_now;
+
+				uint64_t inferences_now;
+				double inference_sum_now;
+				metrics.histogramTotal("sdbelt_inference_seconds", inferences_now, inference_sum_now);
+				values[TimeSeriesStore::InferenceMs] = inferences_now > inferences
+					? static_cast<float>((inference_sum_now - inference_sum) * 1000.0 / (inferences_now - inferences))
+					: NAN;
+				inferences = inferences_now;
+				inference_sum = inference_sum_now;
+			}
+		};
+		history_store = std::make_unique<TimeSeriesStore>(history_config);
+		return true;
+	});
+
+	startup.add("preview", {}, []() {
+		PreviewSender::Config preview_config{
+			ImageInterface::DESKTOP_IP_UDP,
+			ImageInterface::UDP_COMMS_PORT,
+			ImageInterface::PREVIEW_FEEDBACK_PORT,
+			ImageInterface::PREVIEW_JPEG_QUALITY,
+			ImageInterface::PREVIEW_MIN_JPEG_QUALITY,
+			ImageInterface::PREVIEW_MAX_FPS,
+			ImageInterface::PREVIEW_MIN_FPS,
+			ImageInterface::PREVIEW_SUBSCRIBER_TIMEOUT_MS,
+			ImageInterface::PREVIEW_MULTICAST_GROUP,
+			ImageInterface::PREVIEW_MULTICAST_TTL
+		};
+		preview_sender = std::make_unique<PreviewSender>(preview_config);
+		return true;
+	});
+
+	startup.add("governor", {"sampler", "preview", "archive"}, []() {
+		// Optional work goes first when the enclosure heats up; inference and actuation are never shed
+		ThermalGovernor::Config governor_config{
+			{ImageInterface::SHED_PREVIEW_AT_C, ImageInterface::SHED_ARCHIVE_AT_C, ImageInterface::SHED_GATE_AT_C},
+			ImageInterface::SHED_HYSTERESIS_C,
+			ImageInterface::SHED_CPU_HIGH_PERCENT,
+			ImageInterface::SHED_CPU_LOW_PERCENT,
+			ImageInterface::SHED_INTERVAL_MS,
+			ImageInterface::SHED_RELEASE_HOLD_MS
+		};
+		thermal_governor = std::make_unique<ThermalGovernor>(governor_config, *system_sampler,
+			[](ThermalGovernor::Level level, double temperature_c, float cpu_percent) {
+				preview_sender->set_shedding(level >= ThermalGovernor::Level::Preview);
+				if (image_archiver)
+					image_archiver->setShedding(level >= ThermalGovernor::Level::Archive);
+				gate_shedding = level >= ThermalGovernor::Level::Gate;
+
+				SystemLogMessageDTO msg = SystemLogMessageDTO(
+					level == ThermalGovernor::Level::None ? SystemLogMessageDTO::LogLevel::INFO : SystemLogMessageDTO::LogLevel::WARNING,
+					std::string("Thermal shed level: ") + ThermalGovernor::levelName(level) + " at "
+						+ (std::isnan(temperature_c) ? std::string("unknown") : std::to_string(temperature_c)) + " C, "
+						+ std::to_string(cpu_percent) + " % CPU");
+				system_message_queue->push(msg);
+			});
+		return true;
+	});
+
+	startup.add("speed", {"firmware"}, []() {
+		BeltSpeedController::Config speed_config{
+			ImageInterface::SPEED_MIN_PERCENT,
+			ImageInterface::SPEED_MAX_PERCENT,
+			ImageInterface::SPEED_START_PERCENT,
+			ImageInterface::SPEED_STEP_UP_PERCENT,
+			ImageInterface::SPEED_STEP_DOWN_PERCENT,
+			ImageInterface::SPEED_CONTROL_PERIOD_MS,
+			ImageInterface::SPEED_BACKLOG_HIGH,
+			ImageInterface::SPEED_BACKLOG_LOW,
+			ImageInterface::SPEED_LATENCY_HIGH_MS,
+			ImageInterface::SPEED_LATENCY_LOW_MS,
+			ImageInterface::SPEED_HEALTHY_TICKS
+		};
+		speed_controller = std::make_unique<BeltSpeedController>(
+			[](const std::string &cmd) {
+				return actuator_queue->submitAndWait(cmd, ActuatorQueue::Priority::Auto,
+					std::chrono::milliseconds(ImageInterface::ACTUATOR_WAIT_MS));
+			},
+			[]() { return preprocessed_queue->size() + results_queue->size() + classified_queue->size(); },
+			speed_config);
+		speed_controller->setEnabled(ImageInterface::SPEED_CONTROLLER_ENABLED);
+		return true;    // started once the actuator queue exists
+	});
+
+	startup.add("gate", {}, []() {
+		ProductClassifier::Config gate_config{
+			ImageInterface::GATE_RECALL_TARGET,
+			ImageInterface::GATE_MIN_CALIBRATION,
+			ImageInterface::GATE_CALIBRATION_WINDOW,
+			ImageInterface::GATE_AUDIT_EVERY,
+			ImageInterface::GATE_SATURATION_MIN,
+			ImageInterface::GATE_VALUE_MIN,
+			ImageInterface::GATE_EDGE_WEIGHT,
+			ImageInterface::GATE_MAX_THRESHOLD,
+			ImageInterface::GATE_ANALYSIS_WIDTH
+		};
+		product_classifier = std::make_unique<ProductClassifier>(gate_config);
+		product_classifier->setEnabled(ImageInterface::GATE_ENABLED);
+		return true;
+	});
+
+	if (!startup.run())
+	{
+		std::cerr << "Startup failed:\n" << startup.summary();
+		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Startup failed: " + startup.timingsJson());
+		system_message_queue->push(msg);
+		stop_services();    // the phases that did succeed left threads running
+		return 1;
+	}
+	std::cout << "Startup phases:\n" << startup.summary();
+	startup.publishMetrics();
+
 	HttpServerHandler serverHandler(&arduino);
+	serverHandler.SetSpeedController(speed_controller.get());
+	serverHandler.SetFusionEngine(fusion_engine.get());
+	actuator_queue = std::make_unique<ActuatorQueue>(
+		ActuatorQueue::Config{ImageInterface::ACTUATOR_QUEUE_CAPACITY, ImageInterface::ACTUATOR_HISTORY},
+		[&serverHandler](const std::string &cmd, ActuatorQueue::Priority priority) { return serverHandler.HandleCommand(cmd, priority); },
+		[&arduino]() { arduino.interrupt(); });
+	serverHandler.SetActuatorQueue(actuator_queue.get());
+	speed_controller->start();
 	serverHandler.Init();
+	serverHandler.AddJsonEndpoint("/pipeline/drops", pipeline_drops_json);
+	serverHandler.AddJsonEndpoint("/pipeline/gate", []() { return product_classifier->stateJson(); });
+	serverHandler.AddJsonEndpoint("/archive", []() { return image_archiver ? image_archiver->stateJson() : std::string("{\"enabled\":false}"); });
+	serverHandler.AddJsonEndpoint("/preview", []() { return preview_sender->stats_json(); });
+	serverHandler.AddJsonEndpoint("/journal", []() { return scan_journal->stateJson(); });
+	serverHandler.AddJsonEndpoint("/channel", []() { return backend_channel->stateJson(); });
+	serverHandler.AddJsonEndpoint("/system", []() { return system_sampler->stateJson(); });
+	serverHandler.AddJsonEndpoint("/history/store", []() { return history_store->stateJson(); });
+	serverHandler.AddJsonEndpoint("/thermal", []() { return thermal_governor->stateJson(); });
+	serverHandler.AddJsonEndpoint("/startup", [&startup]() { return startup.timingsJson(); });
+	serverHandler.AddJsonQueryEndpoint("/history", history_json);
+
+	Metrics::global().gauge("sdbelt_queue_depth", "Items waiting in a pipeline queue",
+		[]() { return static_cast<double>(preprocessed_queue->size()); }, "queue=\"preprocessed\"");
+	Metrics::global().gauge("sdbelt_queue_depth", "Items waiting in a pipeline queue",
+		[]() { return static_cast<double>(results_queue->size()); }, "queue=\"results\"");
+	Metrics::global().gauge("sdbelt_queue_depth", "Items waiting in a pipeline queue",
+		[]() { return static_cast<double>(classified_queue->size()); }, "queue=\"classified\"");
+	Metrics::global().gauge("sdbelt_queue_depth", "Items waiting in a pipeline queue",
+		[]() { return static_cast<double>(system_message_queue->size()); }, "queue=\"system_message\"");
+	Metrics::global().gauge("sdbelt_cpu_percent", "CPU busy over the last sample interval, all cores",
+		[]() { return static_cast<double>(system_sampler->snapshot().cpuPercent); });
+	Metrics::global().gauge("sdbelt_temperature_celsius", "SoC temperature, NaN if the thermal zone is unreadable",
+		[]() { return system_sampler->snapshot().temperatureC; });
+	Metrics::global().gauge("sdbelt_shed_level", "Thermal shed level: 0 none, 1 preview, 2 +archive, 3 +gate resolution",
+		[]() { return static_cast<double>(thermal_governor->level()); });
 	
 	if (!serverHandler.Bind())
 	{
 		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "Failed to bind server to port 8080");
 		system_message_queue->push(msg);
 		std::cerr << "Failed to bind server to port 8080\n";
+		stop_services();
 		return 1;
 	}
 	
 	std::thread serverThread([&serverHandler]()
-							 { serverHandler.Start(); });
+							 { set_thread_name("http-listen"); serverHandler.Start(); });
+	backend_channel->setCommandHandler([&serverHandler](const std::string &cmd) {
+		// never block the socket pump on the serial port
+		uint64_t id = serverHandler.SubmitCommand(cmd);
+		return id ? "QUEUED:" + std::to_string(id) : std::string("ERR: Actuator queue full");
+	});
+
+	std::thread distance_thread;
+	if (ImageInterface::DISTANCE_GATING_ENABLED && arduino.isConnected())
+	{
+		actuator_queue->submit("dint=" + std::to_string(ImageInterface::DISTANCE_INTERVAL_MS), ActuatorQueue::Priority::Normal);
+		distance_thread = std::thread(monitor_belt_distance, std::ref(arduino));
+	}
 	
-    size_t class_count = 6; // 80 classes in COCO dataset
     double fps = 30;
     
     std::chrono::duration<double> inference_time;
@@ -1509,22 +2199,25 @@ int main(int argc, char** argv)
      std::thread logger_thread(log_system_stats);
      std::thread message_thread(log_system_messages);
 
-    CommandLineArgs args = parse_command_line_arguments(argc, argv);
-    AsyncModelInfer model(args.detection_hef, results_queue);
     input_type = determine_input_type(args.input_path, std::ref(capture), org_height, org_width, frame_count);
 
     auto preprocess_thread = std::async(run_preprocess,
                                         args,
-                                        std::ref(model),
+                                        std::ref(*model),
                                         std::ref(input_type),
-                                        std::ref(capture));
+                                        std::ref(capture),
+                                        std::ref(arduino));
 
 
 
     auto inference_thread = std::async(run_inference_async,
-                                    std::ref(model),
+                                    std::ref(*model),
                                     std::ref(inference_time));
 
+    std::thread crop_classify_thread;
+    if (crop_classifier)
+        crop_classify_thread = std::thread(run_crop_classify, class_count);
+
     auto output_parser_thread = std::async(run_post_process,
                                 std::ref(input_type),
                                 args,
@@ -1532,14 +2225,20 @@ int main(int argc, char** argv)
                                 org_width,
                                 frame_count,
                                 std::ref(capture),
-                                std::ref(arduino),
                                 class_count,
                                 fps);
                                 
-	// Seko delay baslangic
-	std::this_thread::sleep_for(std::chrono::seconds(ImageInterface::STARTUP_DELAY_SECONDS));
-	system_ready = true;   
-	// Seko delay sonu
+	// Ready once every camera delivers steady frames rather than after a fixed delay
+	const auto ready_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ImageInterface::STARTUP_READY_TIMEOUT_MS);
+	while (cameras_settling.load() > 0 && std::chrono::steady_clock::now() < ready_deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	system_ready = true;
+	startup.markReady();
+	std::cout << "Ready to sort:\n" << startup.summary();
+	{
+		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "Startup timings: " + startup.timingsJson());
+		system_message_queue->push(msg);
+	}
 	
 	
 	
@@ -1557,12 +2256,19 @@ int main(int argc, char** argv)
 		logger_thread.join();
 	}
     
+    if (distance_thread.joinable())
+		distance_thread.join();
+
     if (message_thread.joinable()){
 		SystemLogMessageDTO msg = SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, "Message_thread is joinable. message_thread.join() is called");
 		system_message_queue->push(msg); 
 		message_thread.join();
 	}
     
+    if (crop_classify_thread.joinable())
+        crop_classify_thread.join();    // ends once inference has stopped the results queue
+
+    // the server goes first: its routes read the services stopped below
     std::cout << "Stopping server...\n";
 	serverHandler.Stop();
 
@@ -1571,6 +2277,7 @@ int main(int argc, char** argv)
 		system_message_queue->push(msg); 
 		serverThread.join();
 	}
+    stop_services();
 
 	std::cout << "System shut down gracefully." << std::endl;
     
@@ -0,0 +1,224 @@
+/**
+ * actuator_queue_test.cpp
+ *
+ * A stop preempts and cancels what is ahead of it, interrupts the wire on
+ * every submission, and latches: automatic commands are refused until a
+ * start succeeds. The servo overtakes queued commands and is dropped once
+ * its deadline has passed.
+ */
+
+#include "ActuatorQueue.h"
+#include "check.h"
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+using Priority = ActuatorQueue::Priority;
+using Status = ActuatorQueue::Status;
+
+// Stands in for the Arduino: one command can be made to hang until interrupted
+struct FakeArduino
+{
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<std::pair<std::string, Priority>> executed;
+	std::string hangOn;
+	int releaseAt = 0;
+	bool hanging = false;
+	bool failStart = false;
+	int interrupts = 0;
+
+	std::string execute(const std::string &command, Priority priority)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		executed.emplace_back(command, priority);
+		if (command == hangOn)
+		{
+			// counted, not edge-triggered: a stop's own interrupt may come before or after it starts
+			const int until = releaseAt;
+			hanging = true;
+			changed.notify_all();
+			changed.wait(lock, [&]() { return interrupts >= until; });
+			hanging = false;
+			return "Error: Interrupted by stop";
+		}
+		if (command == "start" && failStart)
+			return "ERR: motor fault";
+		return "OK:" + command;
+	}
+
+	void interrupt()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++interrupts;
+		changed.notify_all();
+	}
+
+	// Hang on command until `interruptsToRelease` more interrupts have arrived
+	void hang(const std::string &command, int interruptsToRelease = 1)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		hangOn = command;
+		releaseAt = interrupts + interruptsToRelease;
+	}
+
+	void waitHanging()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [&]() { return hanging; });
+	}
+
+	int interruptCount()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return interrupts;
+	}
+};
+
+struct Fixture
+{
+	FakeArduino arduino;
+	ActuatorQueue queue{ActuatorQueue::Config{8, 64},
+		[this](const std::string &command, Priority priority) { return arduino.execute(command, priority); },
+		[this]() { arduino.interrupt(); }};
+
+	// Finished status of a command, waiting for the worker if needed
+	Status finish(uint64_t id)
+	{
+		ActuatorQueue::Command command;
+		for (int i = 0; i < 1000; i++)
+		{
+			CHECK(queue.lookup(id, command));
+			if (command.status != Status::Queued && command.status != Status::Running)
+				return command.status;
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+		CHECK(false);
+		return command.status;
+	}
+};
+
+const std::chrono::milliseconds WAIT{2000};
+
+void stopPreemptsAndCancels()
+{
+	Fixture f;
+	f.arduino.hang("speed=40");
+	const uint64_t running = f.queue.submit("speed=40", Priority::Normal);
+	f.arduino.waitHanging();
+	const uint64_t queued = f.queue.submit("speed=50", Priority::Normal);
+	const uint64_t stop = f.queue.submit("stop", Priority::Stop);
+
+	CHECK(f.finish(running) == Status::Failed);
+	CHECK(f.finish(queued) == Status::Cancelled);
+	CHECK(f.finish(stop) == Status::Done);
+	CHECK(f.arduino.interruptCount() == 1);
+
+	ActuatorQueue::Stats stats = f.queue.getStats();
+	CHECK(stats.preempted == 1);
+	CHECK(stats.cancelled == 1);
+	CHECK(f.arduino.executed.size() == 2);
+	CHECK(f.arduino.executed[1].first == "stop");
+}
+
+void everyStopInterrupts()
+{
+	Fixture f;
+	// nothing running: still interrupted, a reply wait may be in flight outside the worker's view
+	CHECK(f.finish(f.queue.submit("stop", Priority::Stop)) == Status::Done);
+	CHECK(f.arduino.interruptCount() == 1);
+
+	f.arduino.hang("stop", 2);    // its own interrupt does not release it, the next stop's does
+	const uint64_t first = f.queue.submit("stop", Priority::Stop);
+	f.arduino.waitHanging();
+	f.arduino.hang("");
+	const uint64_t second = f.queue.submit("stop", Priority::Stop);    // a stop running, not waiting: queued anew
+	CHECK(second != first);
+	CHECK(f.finish(first) == Status::Failed);
+	CHECK(f.finish(second) == Status::Done);
+	CHECK(f.arduino.interruptCount() == 3);
+}
+
+void stopLatchesUntilStart()
+{
+	Fixture f;
+	CHECK(!f.queue.stopLatched());
+	CHECK(f.queue.submitAndWait("speed=30", Priority::Auto, WAIT) == "OK:speed=30");
+	CHECK(f.arduino.executed.back().second == Priority::Auto);
+
+	CHECK(f.finish(f.queue.submit("stop", Priority::Stop)) == Status::Done);
+	CHECK(f.queue.stopLatched());
+	CHECK(f.queue.submit("speed=30", Priority::Auto) == 0);
+	CHECK(f.queue.submitAndWait("speed=30", Priority::Auto, WAIT).rfind("ERR", 0) == 0);
+	CHECK(f.queue.getStats().refusedStopped == 2);
+
+	// operator commands other than start still run and do not release the latch
+	CHECK(f.queue.submitAndWait("servo=30", Priority::Normal, WAIT) == "OK:servo=30");
+	CHECK(f.queue.stopLatched());
+
+	f.arduino.failStart = true;    // the worker only reads it while the queue is idle
+	CHECK(f.queue.submitAndWait("start", Priority::Normal, WAIT) == "ERR: motor fault");
+	CHECK(f.queue.stopLatched());
+
+	f.arduino.failStart = false;
+	CHECK(f.queue.submitAndWait("start", Priority::Normal, WAIT) == "OK:start");
+	CHECK(!f.queue.stopLatched());
+	CHECK(f.queue.submitAndWait("speed=35", Priority::Auto, WAIT) == "OK:speed=35");
+}
+
+void autoQueuedBeforeStopNeverRuns()
+{
+	Fixture f;
+	f.arduino.hang("servo=150");
+	f.queue.submit("servo=150", Priority::Normal);
+	f.arduino.waitHanging();
+	const uint64_t autoSpeed = f.queue.submit("speed=60", Priority::Auto);
+	CHECK(autoSpeed != 0);
+	f.queue.submit("stop", Priority::Stop);
+	CHECK(f.finish(autoSpeed) == Status::Cancelled);
+	for (const auto &executed : f.arduino.executed)
+		CHECK(executed.first != "speed=60");
+}
+
+void sortOvertakesAndExpires()
+{
+	Fixture f;
+	f.arduino.hang("speed=40");
+	const uint64_t running = f.queue.submit("speed=40", Priority::Normal);
+	f.arduino.waitHanging();
+	const uint64_t queued = f.queue.submit("speed=50", Priority::Normal);
+	const auto now = std::chrono::steady_clock::now();
+	const uint64_t late = f.queue.submit("servo=150", Priority::Sort, now - std::chrono::milliseconds(1));
+	const uint64_t servo = f.queue.submit("servo=30", Priority::Sort, now + std::chrono::seconds(10));
+
+	f.arduino.hang("");
+	f.arduino.interrupt();    // release the hung command; the worker picks the next one
+	CHECK(f.finish(running) == Status::Failed);
+	CHECK(f.finish(late) == Status::Cancelled);
+	CHECK(f.finish(servo) == Status::Done);
+	CHECK(f.finish(queued) == Status::Done);
+
+	ActuatorQueue::Command command;
+	CHECK(f.queue.lookup(late, command) && command.response == "ERR: Deadline passed");
+	CHECK(f.queue.getStats().expired == 1);
+	CHECK(f.arduino.executed.size() == 3);
+	CHECK(f.arduino.executed[1].first == "servo=30");    // ahead of the speed queued before it
+	CHECK(f.arduino.executed[1].second == Priority::Sort);
+	CHECK(f.arduino.executed[2].first == "speed=50");
+}
+
+}
+
+int main()
+{
+	stopPreemptsAndCancels();
+	everyStopInterrupts();
+	stopLatchesUntilStart();
+	autoQueuedBeforeStopNeverRuns();
+	sortOvertakesAndExpires();
+	return 0;
+}
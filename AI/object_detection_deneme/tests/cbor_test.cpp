@@ -0,0 +1,191 @@
+/**
+ * cbor_test.cpp
+ *
+ * Every telemetry DTO's CBOR form decodes to exactly its JSON form: same
+ * keys in the same order, same values. The decoder below re-emits CBOR
+ * through JsonWriter, so any drift between toJson() and toCbor() fails.
+ */
+
+#include "check.h"
+#include "cbor.h"
+#include "iso_timestamp.h"
+#include "json_writer.h"
+#include "scan_request_dto.h"
+#include "system_messages_dto.h"
+#include "system_status_dto.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+// Decodes the subset CborWriter emits: unsigned ints, text, arrays, maps and float32
+struct CborToJson
+{
+	const std::string &in;
+	size_t pos = 0;
+
+	uint8_t byte()
+	{
+		CHECK(pos < in.size());
+		return static_cast<uint8_t>(in[pos++]);
+	}
+
+	uint64_t argument(uint8_t info, bool shortest = true)
+	{
+		if (info < 24)
+			return info;
+		const int bytes = info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : info == 27 ? 8 : 0;
+		CHECK(bytes != 0);
+		uint64_t value = 0;
+		for (int i = 0; i < bytes; i++)
+			value = (value << 8) | byte();
+		// lengths and counts always use the shortest form
+		CHECK(!shortest || (bytes == 1 ? value >= 24 : value >= (1ull << (bytes * 4))));
+		return value;
+	}
+
+	std::string text(uint64_t size)
+	{
+		CHECK(pos + size <= in.size());
+		std::string out = in.substr(pos, size);
+		pos += size;
+		return out;
+	}
+
+	void item(JsonWriter &json)
+	{
+		const uint8_t initial = byte();
+		const uint8_t major = initial >> 5;
+		const uint8_t info = initial & 0x1F;
+		if (initial == 0xFA)
+		{
+			uint32_t bits = static_cast<uint32_t>(argument(26, false));
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			json.number(value);
+			return;
+		}
+
+		const uint64_t value = argument(info);
+		switch (major)
+		{
+		case 0:
+			json.integer(static_cast<int64_t>(value));
+			break;
+		case 3:
+			json.string(text(value));
+			break;
+		case 4:
+			json.beginArray();
+			for (uint64_t i = 0; i < value; i++)
+				item(json);
+			json.endArray();
+			break;
+		case 5:
+			json.beginObject();
+			for (uint64_t i = 0; i < value; i++)
+			{
+				CHECK((static_cast<uint8_t>(in[pos]) >> 5) == 3);    // keys are text
+				const std::string key = text(argument(byte() & 0x1F));
+				json.key(key.c_str());
+				item(json);
+			}
+			json.endObject();
+			break;
+		default:
+			CHECK(false);
+		}
+	}
+};
+
+std::string decode(const std::string &cbor)
+{
+	std::string out;
+	JsonWriter json(out);
+	CborToJson decoder{cbor};
+	decoder.item(json);
+	CHECK(decoder.pos == cbor.size());
+	return out;
+}
+
+template <typename Dto>
+void checkRoundTrip(const Dto &dto)
+{
+	std::string cbor;
+	CborWriter writer(cbor);
+	dto.toCbor(writer);
+	CHECK(decode(cbor) == dto.toJson());
+}
+
+void scans()
+{
+	// values exact in float32, so the float32 CBOR reals print like the JSON doubles
+	std::vector<ScanRequestDTO> batch{
+		ScanRequestDTO("Apple_Healthy", 87.5, 120.25, 64),
+		ScanRequestDTO("Banana_Rotten", 0, -3.5, 1e6),
+	};
+	checkRoundTrip(batch[0]);
+	checkRoundTrip(batch[1]);
+
+	std::string cbor, json;
+	CborWriter cborWriter(cbor);
+	JsonWriter jsonWriter(json);
+	cborWriter.array(batch.size());
+	jsonWriter.beginArray();
+	for (const auto &scan : batch)
+	{
+		scan.toCbor(cborWriter);
+		scan.toJson(jsonWriter);
+	}
+	jsonWriter.endArray();
+	CHECK(decode(cbor) == json);
+
+	// reals are float32 on the wire: close, not exact
+	ScanRequestDTO inexact("Apple_Healthy", 0.1, 1.0 / 3, 2.0 / 3);
+	std::string single;
+	CborWriter singleWriter(single);
+	inexact.toCbor(singleWriter);
+	const std::string decoded = decode(single);
+	CHECK(decoded != inexact.toJson());
+	const size_t at = decoded.find("\"confidence\":");
+	CHECK(at != std::string::npos);
+	CHECK(static_cast<float>(std::strtod(decoded.c_str() + at + 13, nullptr)) == 0.1f);
+}
+
+void status()
+{
+	const auto at = std::chrono::system_clock::time_point(std::chrono::seconds(1714564800));
+	checkRoundTrip(SystemStatusDTO(at, 61.5, 37.25, "1536/3840 MiB"));
+	CHECK(SystemStatusDTO(at, 0, 0, "").toJson().find("\"timestamp\":\"2024-05-01T12:00:00Z\"") != std::string::npos);
+}
+
+void logs()
+{
+	const auto at = std::chrono::system_clock::time_point(std::chrono::seconds(0));
+	checkRoundTrip(SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::ERROR, "camera 2 \"lost\"\n\tretrying", at));
+	// long enough for one- and two-byte length heads
+	checkRoundTrip(SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::WARNING, std::string(200, 'x'), at));
+	checkRoundTrip(SystemLogMessageDTO(SystemLogMessageDTO::LogLevel::INFO, std::string(70000, 'y'), at));
+}
+
+void timestamps()
+{
+	char buffer[24];
+	size_t length = formatIsoTimestamp(std::chrono::system_clock::time_point(), buffer);
+	CHECK(std::string(buffer, length) == "1970-01-01T00:00:00Z");
+	length = formatIsoTimestamp(std::chrono::system_clock::time_point(std::chrono::milliseconds(951782399999)), buffer);
+	CHECK(std::string(buffer, length) == "2000-02-28T23:59:59Z");
+}
+
+}
+
+int main()
+{
+	scans();
+	status();
+	logs();
+	timestamps();
+	return 0;
+}
@@ -0,0 +1,18 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// Like assert, but also checked in release builds
+#define CHECK(condition)                                                                    \
+	do                                                                                      \
+	{                                                                                       \
+		if (!(condition))                                                                   \
+		{                                                                                   \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+			std::exit(1);                                                                   \
+		}                                                                                   \
+	} while (0)
+
+#endif // TESTS_CHECK_H
@@ -0,0 +1,95 @@
+/**
+ * deadline_queue_test.cpp
+ *
+ * Items with a deadline are shed, least urgent first, when the queue is full;
+ * items without one (video and image input) wait for space and are never lost.
+ */
+
+#include "ts_queue.hpp"
+#include "check.h"
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Item
+{
+	int id = 0;
+	Clock::time_point deadline = Clock::time_point::max();
+};
+
+void undeadlinedPushWaitsForSpace()
+{
+	DeadlineTSQueue<Item> queue(2);
+	const int total = 50;
+	std::thread producer([&]() {
+		for (int i = 0; i < total; i++)
+			queue.push(Item{i});
+	});
+
+	for (int i = 0; i < total; i++)
+	{
+		Item item;
+		CHECK(queue.pop(item));
+		CHECK(item.id == i);
+		CHECK(queue.size() <= 2);
+		if (i % 10 == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));    // let the producer hit the limit
+	}
+	producer.join();
+	CHECK(queue.overflow() == 0);
+}
+
+void deadlinedPushShedsLeastUrgent()
+{
+	DeadlineTSQueue<Item> queue(2);
+	const Clock::time_point now = Clock::now();
+	queue.push(Item{1, now + std::chrono::seconds(10)});
+	queue.push(Item{2, now + std::chrono::seconds(30)});
+	queue.push(Item{3, now + std::chrono::seconds(20)});    // evicts 2
+	queue.push(Item{4, now + std::chrono::seconds(40)});    // least urgent, refused
+	CHECK(queue.overflow() == 2);
+
+	Item item;
+	CHECK(queue.pop(item) && item.id == 1);
+	CHECK(queue.pop(item) && item.id == 3);
+	CHECK(queue.empty());
+}
+
+void deadlinedPushNeverEvictsUndeadlined()
+{
+	DeadlineTSQueue<Item> queue(2);
+	queue.push(Item{1});
+	queue.push(Item{2});
+	queue.push(Item{3, Clock::now() + std::chrono::seconds(10)});    // full of work that must not be lost
+	CHECK(queue.overflow() == 1);
+
+	Item item;
+	CHECK(queue.pop(item) && item.id == 1);
+	CHECK(queue.pop(item) && item.id == 2);
+	CHECK(queue.empty());
+}
+
+void stopReleasesWaitingPush()
+{
+	DeadlineTSQueue<Item> queue(1);
+	queue.push(Item{1});
+	std::thread producer([&]() { queue.push(Item{2}); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	queue.stop();
+	producer.join();
+	CHECK(queue.size() == 1);
+}
+
+}
+
+int main()
+{
+	undeadlinedPushWaitsForSpace();
+	deadlinedPushShedsLeastUrgent();
+	deadlinedPushNeverEvictsUndeadlined();
+	stopReleasesWaitingPush();
+	return 0;
+}
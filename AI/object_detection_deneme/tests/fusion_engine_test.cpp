@@ -0,0 +1,71 @@
+/**
+ * fusion_engine_test.cpp
+ *
+ * Thresholds outside 0-100 and negative weights are refused, and so are
+ * NaN and infinities, which a plain range check lets through; a refused
+ * value leaves the settings as they were.
+ */
+
+#include "FusionEngine.h"
+#include "check.h"
+#include <limits>
+
+namespace
+{
+
+FusionEngine::Settings initial()
+{
+	FusionEngine::Settings s{};
+	for (double &threshold : s.productThreshold)
+		threshold = 70.0;
+	for (double &weight : s.cameraWeight)
+		weight = 1.0;
+	s.uncertainBand = 10.0;
+	s.rottenVeto = 0.9;
+	s.minProductAgreement = 0.5;
+	return s;
+}
+
+void thresholdsStayInRange()
+{
+	FusionEngine engine(initial());
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	const double inf = std::numeric_limits<double>::infinity();
+	for (double bad : {nan, inf, -inf, -0.5, 100.5})
+	{
+		CHECK(!engine.setThreshold(bad));
+		CHECK(!engine.setThreshold(Produce::Apple, bad));
+	}
+	for (double threshold : engine.getSettings().productThreshold)
+		CHECK(threshold == 70.0);
+
+	CHECK(engine.setThreshold(0.0));
+	CHECK(engine.setThreshold(Produce::Orange, 100.0));
+	FusionEngine::Settings s = engine.getSettings();
+	CHECK(s.productThreshold[static_cast<size_t>(Produce::Apple)] == 0.0);
+	CHECK(s.productThreshold[static_cast<size_t>(Produce::Orange)] == 100.0);
+}
+
+void weightsAreFiniteAndNonNegative()
+{
+	FusionEngine engine(initial());
+	CHECK(!engine.setCameraWeight(0, std::numeric_limits<double>::quiet_NaN()));
+	CHECK(!engine.setCameraWeight(0, std::numeric_limits<double>::infinity()));
+	CHECK(!engine.setCameraWeight(0, -1.0));
+	CHECK(!engine.setCameraWeight(FusionEngine::MAX_CAMERAS, 1.0));
+	CHECK(engine.getSettings().cameraWeight[0] == 1.0);
+
+	CHECK(engine.setCameraWeight(0, 0.0));    // mutes the camera
+	CHECK(engine.setCameraWeight(1, 2.5));
+	CHECK(engine.getSettings().cameraWeight[0] == 0.0);
+	CHECK(engine.getSettings().cameraWeight[1] == 2.5);
+}
+
+}
+
+int main()
+{
+	thresholdsStayInRange();
+	weightsAreFiniteAndNonNegative();
+	return 0;
+}
@@ -0,0 +1,109 @@
+/**
+ * recall_calibrator_test.cpp
+ *
+ * Fed products with a known score distribution, the gate threshold settles
+ * at the (1 - recall) quantile of that distribution and keeps the recall
+ * target, instead of ratcheting up on the scores it already let through.
+ */
+
+#include "RecallCalibrator.h"
+#include "check.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+
+const RecallCalibrator::Config CONFIG{
+	0.90,     // recall target
+	100,      // min calibration
+	1000,     // window
+	10,       // audit every
+	0.95      // max threshold
+};
+
+struct Run
+{
+	double meanThreshold = 0.0;
+	double passedShare = 0.0;     // regular passes, audits not counted
+};
+
+// Every frame shows a product; scores uniform on [low, high)
+Run feed(RecallCalibrator &calibrator, std::mt19937 &rng, double low, double high, int frames)
+{
+	std::uniform_real_distribution<double> scores(low, high);
+	static unsigned long long triggerId = 0;
+	double thresholdSum = 0.0;
+	int thresholdSamples = 0;
+	int passed = 0;
+	for (int i = 0; i < frames; i++)
+	{
+		const double before = calibrator.getState().threshold;
+		const double score = scores(rng);
+		if (calibrator.admit(score, ++triggerId))
+		{
+			if (score >= before)
+				passed++;
+			calibrator.reportDetection(triggerId, true);
+		}
+		if (i >= frames / 2 && i % 50 == 0)    // settled by then
+		{
+			thresholdSum += calibrator.getState().threshold;
+			thresholdSamples++;
+		}
+	}
+	return Run{thresholdSum / thresholdSamples, static_cast<double>(passed) / frames};
+}
+
+bool near(double value, double expected, double tolerance)
+{
+	if (std::fabs(value - expected) <= tolerance)
+		return true;
+	std::cerr << value << " is not within " << tolerance << " of " << expected << "\n";
+	return false;
+}
+
+void settlesAtTargetQuantile()
+{
+	RecallCalibrator calibrator(CONFIG);
+	std::mt19937 rng(1);
+	const Run run = feed(calibrator, rng, 0.0, 1.0, 16000);
+
+	CHECK(near(run.meanThreshold, 0.10, 0.02));
+	CHECK(near(run.passedShare, 0.90, 0.02));
+	CHECK(near(calibrator.getState().estimatedRecall, 0.90, 0.02));
+}
+
+void followsDistributionDown()
+{
+	RecallCalibrator calibrator(CONFIG);
+	std::mt19937 rng(2);
+	CHECK(near(feed(calibrator, rng, 0.4, 1.0, 8000).meanThreshold, 0.46, 0.02));
+	// products got duller: the audits find the misses and the threshold comes down
+	CHECK(near(feed(calibrator, rng, 0.0, 1.0, 16000).meanThreshold, 0.10, 0.02));
+}
+
+void emptyBeltDoesNotCalibrate()
+{
+	RecallCalibrator calibrator(CONFIG);
+	for (unsigned long long id = 1; id <= 1000; id++)
+	{
+		CHECK(calibrator.admit(0.5, id));
+		calibrator.reportDetection(id, false);
+	}
+	const RecallCalibrator::State state = calibrator.getState();
+	CHECK(!state.calibrated);
+	CHECK(state.threshold == 0.0);
+	CHECK(state.emptyPasses == 1000);
+}
+
+}
+
+int main()
+{
+	settlesAtTargetQuantile();
+	followsDistributionDown();
+	emptyBeltDoesNotCalibrate();
+	return 0;
+}
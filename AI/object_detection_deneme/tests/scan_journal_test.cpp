@@ -0,0 +1,204 @@
+/**
+ * scan_journal_test.cpp
+ *
+ * One product per shipped request, no drops while rotating through tiny
+ * segments, recovery of a journal whose newest segment is full, and no
+ * HTTP fallback for a product the stream sent but has not confirmed.
+ */
+
+#include "ScanJournal.h"
+#include "check.h"
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+
+// Captures what the journal ships; refuses everything while offline and leaves
+// the first `unanswered` attempts in flight
+struct Backend
+{
+	std::mutex mutex;
+	std::vector<std::vector<ScanRequestDTO>> products;
+	std::vector<uint64_t> attempts;
+	bool online = true;
+	int unanswered = 0;
+
+	ScanJournal::Delivery receive(uint64_t productId, const std::vector<ScanRequestDTO> &scans)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		attempts.push_back(productId);
+		if (!online)
+			return ScanJournal::Delivery::NotSent;
+		if (unanswered > 0)
+		{
+			unanswered--;
+			return ScanJournal::Delivery::InFlight;
+		}
+		products.push_back(scans);
+		return ScanJournal::Delivery::Stored;
+	}
+
+	size_t count()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return products.size();
+	}
+};
+
+ScanJournal::Config config(const std::string &directory, size_t segmentRecords, Backend &backend)
+{
+	ScanJournal::Config cfg;
+	cfg.directory = directory;
+	cfg.segmentRecords = segmentRecords;
+	cfg.maxSegments = 1000;
+	cfg.flushIntervalMs = 20;
+	cfg.shipBatch = 16;
+	cfg.shipIntervalMs = 5;
+	cfg.retryMaxMs = 20;
+	cfg.host = "127.0.0.1";
+	cfg.port = 1;               // nothing listens; the HTTP fallback fails at once
+	cfg.path = "/api/scans";
+	cfg.stream = [&backend](uint64_t productId, const std::vector<ScanRequestDTO> &scans) {
+		return backend.receive(productId, scans);
+	};
+	return cfg;
+}
+
+std::vector<ScanRequestDTO> product(int id, int scans)
+{
+	std::vector<ScanRequestDTO> out;
+	for (int i = 0; i < scans; i++)
+		out.emplace_back("P" + std::to_string(id), 0.5, id, i);
+	return out;
+}
+
+bool waitFor(Backend &backend, size_t products)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (backend.count() < products && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	return backend.count() == products;
+}
+
+std::string freshDirectory(const std::string &name)
+{
+	std::string directory = (std::filesystem::temp_directory_path() /
+		("scan_journal_test_" + std::to_string(::getpid()) + "_" + name)).string();
+	std::filesystem::remove_all(directory);
+	return directory;
+}
+
+void checkProduct(const std::vector<ScanRequestDTO> &shipped, int id, int scans)
+{
+	CHECK(shipped.size() == static_cast<size_t>(scans));
+	for (int i = 0; i < scans; i++)
+	{
+		CHECK(shipped[i].productResult() == "P" + std::to_string(id));
+		CHECK(shipped[i].x() == id);
+		CHECK(shipped[i].y() == i);
+	}
+}
+
+void oneProductPerRequest()
+{
+	const std::string directory = freshDirectory("products");
+	Backend backend;
+	{
+		ScanJournal journal(config(directory, 1024, backend));
+		CHECK(journal.append(product(1, 3)));
+		CHECK(journal.append(product(2, 2)));
+		CHECK(journal.append(product(3, 1)[0]));
+		CHECK(waitFor(backend, 3));
+	}
+	checkProduct(backend.products[0], 1, 3);
+	checkProduct(backend.products[1], 2, 2);
+	checkProduct(backend.products[2], 3, 1);
+	std::filesystem::remove_all(directory);
+}
+
+void rotationNeverDrops()
+{
+	// Segments smaller than a product and a flusher too slow to prepare the spare
+	const std::string directory = freshDirectory("rotation");
+	Backend backend;
+	ScanJournal::Config cfg = config(directory, 2, backend);
+	cfg.flushIntervalMs = 60000;
+	{
+		ScanJournal journal(cfg);
+		for (int id = 1; id <= 50; id++)
+			CHECK(journal.append(product(id, 3)));
+		CHECK(waitFor(backend, 50));
+		ScanJournal::Stats stats = journal.getStats();
+		CHECK(stats.appended == 150);
+		CHECK(stats.dropped == 0);
+		CHECK(stats.corrupt == 0);
+	}
+	for (int id = 1; id <= 50; id++)
+		checkProduct(backend.products[id - 1], id, 3);
+	std::filesystem::remove_all(directory);
+}
+
+void recoverFullNewestSegment()
+{
+	const std::string directory = freshDirectory("recover");
+	Backend backend;
+	backend.online = false;
+	{
+		// Two products fill the only segment exactly
+		ScanJournal journal(config(directory, 4, backend));
+		CHECK(journal.append(product(1, 2)));
+		CHECK(journal.append(product(2, 2)));
+	}
+
+	backend.online = true;
+	{
+		ScanJournal journal(config(directory, 4, backend));
+		CHECK(journal.append(product(3, 2)));
+		CHECK(waitFor(backend, 3));
+		ScanJournal::Stats stats = journal.getStats();
+		CHECK(stats.corrupt == 0);
+		CHECK(stats.lastSequence == 6);
+	}
+	checkProduct(backend.products[0], 1, 2);
+	checkProduct(backend.products[1], 2, 2);
+	checkProduct(backend.products[2], 3, 2);
+	std::filesystem::remove_all(directory);
+}
+
+void unconfirmedIsAskedAgain()
+{
+	const std::string directory = freshDirectory("unconfirmed");
+	Backend backend;
+	backend.unanswered = 3;
+	{
+		ScanJournal journal(config(directory, 1024, backend));
+		CHECK(journal.append(product(1, 2)));
+		CHECK(journal.append(product(2, 1)));
+		CHECK(waitFor(backend, 2));
+		ScanJournal::Stats stats = journal.getStats();
+		CHECK(stats.unconfirmed == 3);
+		CHECK(stats.shipFailures == 0);    // the POST was never tried
+	}
+	// every retry names the same product, the one the stream is still answering for
+	CHECK(backend.attempts.size() == 5);
+	CHECK(backend.attempts[0] == 1 && backend.attempts[3] == 1);
+	CHECK(backend.attempts[4] == 3);
+	checkProduct(backend.products[0], 1, 2);
+	checkProduct(backend.products[1], 2, 1);
+	std::filesystem::remove_all(directory);
+}
+
+}
+
+int main()
+{
+	oneProductPerRequest();
+	rotationNeverDrops();
+	recoverFullNewestSegment();
+	unconfirmedIsAskedAgain();
+	return 0;
+}
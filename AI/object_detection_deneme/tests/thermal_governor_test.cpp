@@ -0,0 +1,121 @@
+/**
+ * thermal_governor_test.cpp
+ *
+ * Heat sheds at once, CPU pressure one level per evaluation, and a level is
+ * only given back below its threshold minus the hysteresis, one step at a
+ * time, after a calm hold that any warm or busy evaluation restarts.
+ */
+
+#include "ThermalGovernor.h"
+#include "check.h"
+#include <cmath>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+const ThermalGovernor::Config CONFIG{
+	{70.0, 75.0, 80.0},    // preview, archive, gate
+	3.0,                   // hysteresis
+	90.0f,                 // CPU high
+	60.0f,                 // CPU low
+	1000,
+	10000                  // release hold
+};
+
+// Drives decide() like the governor thread does, with a clock the test moves
+struct Governor
+{
+	int level = 0;
+	Clock::time_point start = Clock::now();
+	Clock::time_point calmSince = start;
+
+	int at(int seconds, double temperatureC, float cpuPercent = 10.0f)
+	{
+		level = ThermalGovernor::decide(CONFIG, level, temperatureC, cpuPercent, start + std::chrono::seconds(seconds), calmSince);
+		return level;
+	}
+};
+
+void heatShedsAtOnce()
+{
+	Governor governor;
+	CHECK(governor.at(0, 69.9) == 0);
+	CHECK(governor.at(1, 76.0) == 2);    // straight past preview to archive
+	CHECK(governor.at(2, 85.0) == 3);
+	CHECK(governor.at(3, 120.0) == 3);
+}
+
+void releaseNeedsHysteresis()
+{
+	Governor governor;
+	CHECK(governor.at(0, 76.0) == 2);
+	// below the archive threshold but within the hysteresis: never released
+	for (int s = 1; s <= 60; s++)
+		CHECK(governor.at(s, 72.5) == 2);
+	// below 75 - 3: released once the hold has passed since the last warm reading
+	CHECK(governor.at(61, 71.9) == 2);
+	CHECK(governor.at(69, 71.9) == 2);
+	CHECK(governor.at(70, 71.9) == 1);
+}
+
+void releaseOneStepPerHold()
+{
+	Governor governor;
+	CHECK(governor.at(0, 85.0) == 3);
+	CHECK(governor.at(1, 50.0) == 3);
+	CHECK(governor.at(11, 50.0) == 2);
+	CHECK(governor.at(12, 50.0) == 2);    // the next release needs its own hold
+	CHECK(governor.at(20, 50.0) == 2);
+	CHECK(governor.at(21, 50.0) == 1);
+	CHECK(governor.at(31, 50.0) == 0);
+	CHECK(governor.at(100, 50.0) == 0);
+}
+
+void warmSpellRestartsHold()
+{
+	Governor governor;
+	CHECK(governor.at(0, 71.0) == 1);
+	CHECK(governor.at(1, 60.0) == 1);
+	CHECK(governor.at(8, 68.0) == 1);     // 70 - 3 <= 68: not calm, hold starts over
+	CHECK(governor.at(9, 60.0) == 1);
+	CHECK(governor.at(17, 60.0) == 1);
+	CHECK(governor.at(18, 60.0) == 0);
+}
+
+void cpuShedsOneStepAndBlocksRelease()
+{
+	Governor governor;
+	CHECK(governor.at(0, 50.0, 95.0f) == 1);
+	CHECK(governor.at(1, 50.0, 95.0f) == 2);
+	CHECK(governor.at(2, 50.0, 95.0f) == 3);
+	CHECK(governor.at(3, 50.0, 95.0f) == 3);
+	// cool, but the CPU is between low and high: nothing is given back
+	for (int s = 4; s <= 60; s++)
+		CHECK(governor.at(s, 50.0, 75.0f) == 3);
+	CHECK(governor.at(61, 50.0, 30.0f) == 3);
+	CHECK(governor.at(71, 50.0, 30.0f) == 2);
+}
+
+void unknownTemperatureFollowsCpu()
+{
+	Governor governor;
+	CHECK(governor.at(0, NAN, 50.0f) == 0);
+	CHECK(governor.at(1, NAN, 95.0f) == 1);
+	CHECK(governor.at(2, NAN, 30.0f) == 1);
+	CHECK(governor.at(12, NAN, 30.0f) == 0);
+}
+
+}
+
+int main()
+{
+	heatShedsAtOnce();
+	releaseNeedsHysteresis();
+	releaseOneStepPerHold();
+	warmSpellRestartsHold();
+	cpuShedsOneStepAndBlocksRelease();
+	unknownTemperatureFollowsCpu();
+	return 0;
+}
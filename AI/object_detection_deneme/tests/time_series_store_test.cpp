@@ -0,0 +1,142 @@
+/**
+ * time_series_store_test.cpp
+ *
+ * Seconds roll up into minutes and minutes into hours with sample-weighted
+ * means, missing values left out, and the hour closed as soon as the clock
+ * leaves it. A restart picks up the minute it was building.
+ */
+
+#include "TimeSeriesStore.h"
+#include "check.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace
+{
+
+constexpr int64_t HOUR_START = 1699999200;    // whole hour, so also a whole minute
+
+const unsigned MASK = (1u << TimeSeriesStore::TemperatureC) | (1u << TimeSeriesStore::CpuPercent)
+	| (1u << TimeSeriesStore::MemAvailableMiB);
+
+std::string freshPath(const std::string &name)
+{
+	std::string path = (std::filesystem::temp_directory_path() /
+		("time_series_store_test_" + std::to_string(::getpid()) + "_" + name)).string();
+	std::filesystem::remove(path);
+	return path;
+}
+
+// No sampler, so no recorder thread: the test decides what each second holds
+TimeSeriesStore::Config config(const std::string &path)
+{
+	TimeSeriesStore::Config cfg{};
+	cfg.path = path;
+	cfg.slots[TimeSeriesStore::Second] = 120;
+	cfg.slots[TimeSeriesStore::Minute] = 10;
+	cfg.slots[TimeSeriesStore::Hour] = 4;
+	return cfg;
+}
+
+void record(TimeSeriesStore &store, int64_t second, float temperatureC, float cpuPercent = NAN)
+{
+	float values[TimeSeriesStore::SERIES];
+	std::fill(std::begin(values), std::end(values), NAN);
+	values[TimeSeriesStore::TemperatureC] = temperatureC;
+	values[TimeSeriesStore::CpuPercent] = cpuPercent;
+	store.record(second, values);
+}
+
+bool contains(const std::string &haystack, const std::string &needle)
+{
+	if (haystack.find(needle) != std::string::npos)
+		return true;
+	std::cerr << "missing " << needle << " in " << haystack << "\n";
+	return false;
+}
+
+void minuteRollup()
+{
+	const std::string path = freshPath("minute");
+	{
+		TimeSeriesStore store(config(path));
+		for (int i = 0; i < 60; i++)
+			record(store, HOUR_START + i, static_cast<float>(i), i % 2 ? NAN : 50.0f);
+
+		// the minute is only closed by the first sample of the next one
+		CHECK(contains(store.rangeJson(TimeSeriesStore::Minute, HOUR_START, HOUR_START + 3600, MASK), "\"count\":0"));
+		record(store, HOUR_START + 60, 0.0f);
+
+		const std::string json = store.rangeJson(TimeSeriesStore::Minute, HOUR_START, HOUR_START + 3600, MASK);
+		CHECK(contains(json, "\"count\":1"));
+		CHECK(contains(json, "\"t0\":" + std::to_string(HOUR_START)));
+		CHECK(contains(json, "\"samples\":[60]"));
+		CHECK(contains(json, "\"temperatureC\":{\"mean\":[29.5],\"min\":[0],\"max\":[59]}"));
+		// half the seconds had no CPU reading; they do not pull the mean down
+		CHECK(contains(json, "\"cpuPercent\":{\"mean\":[50],\"min\":[50],\"max\":[50]}"));
+		CHECK(contains(json, "\"memAvailableMiB\":{\"mean\":[null],\"min\":[null],\"max\":[null]}"));
+	}
+	std::filesystem::remove(path);
+}
+
+void hourRollupWeightsBySamples()
+{
+	const std::string path = freshPath("hour");
+	{
+		TimeSeriesStore store(config(path));
+		for (int i = 0; i < 60; i++)
+			record(store, HOUR_START + i, 10.0f);
+		for (int i = 60; i < 90; i++)    // the line went quiet half way through the second minute
+			record(store, HOUR_START + i, 40.0f);
+
+		CHECK(contains(store.rangeJson(TimeSeriesStore::Hour, HOUR_START, HOUR_START, MASK), "\"count\":0"));
+		record(store, HOUR_START + 3600, 0.0f);
+
+		const std::string minutes = store.rangeJson(TimeSeriesStore::Minute, HOUR_START, HOUR_START + 3600, MASK);
+		CHECK(contains(minutes, "\"dt\":[0,60]"));
+		CHECK(contains(minutes, "\"samples\":[60,30]"));
+
+		// closed on the first second of the next hour; (60*10 + 30*40) / 90, not (10 + 40) / 2
+		const std::string hours = store.rangeJson(TimeSeriesStore::Hour, HOUR_START, HOUR_START, MASK);
+		CHECK(contains(hours, "\"count\":1"));
+		CHECK(contains(hours, "\"samples\":[90]"));
+		CHECK(contains(hours, "\"temperatureC\":{\"mean\":[20],\"min\":[10],\"max\":[40]}"));
+		CHECK(contains(hours, "\"cpuPercent\":{\"mean\":[null],\"min\":[null],\"max\":[null]}"));
+	}
+	std::filesystem::remove(path);
+}
+
+void restartResumesMinute()
+{
+	const std::string path = freshPath("restart");
+	{
+		TimeSeriesStore store(config(path));
+		for (int i = 0; i < 30; i++)
+			record(store, HOUR_START + i, 1.0f);
+	}
+	{
+		TimeSeriesStore store(config(path));
+		for (int i = 30; i < 60; i++)
+			record(store, HOUR_START + i, 3.0f);
+		record(store, HOUR_START + 60, 0.0f);
+
+		CHECK(contains(store.rangeJson(TimeSeriesStore::Second, HOUR_START, HOUR_START + 60, MASK), "\"count\":61"));
+		const std::string json = store.rangeJson(TimeSeriesStore::Minute, HOUR_START, HOUR_START, MASK);
+		CHECK(contains(json, "\"samples\":[60]"));
+		CHECK(contains(json, "\"temperatureC\":{\"mean\":[2],\"min\":[1],\"max\":[3]}"));
+	}
+	std::filesystem::remove(path);
+}
+
+}
+
+int main()
+{
+	minuteRollup();
+	hourRollupWeightsBySamples();
+	restartResumesMinute();
+	return 0;
+}
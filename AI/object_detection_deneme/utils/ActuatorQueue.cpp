@@ -0,0 +1,340 @@
+/**
+ * ActuatorQueue.cpp
+ *
+ * Implementation of the prioritized Arduino command queue.
+ */
+
+#include "ActuatorQueue.h"
+#include "Metrics.h"
+#include "json_writer.h"
+#include "thread_name.hpp"
+#include <sstream>
+
+// Replies from ArduinoSerial and HttpServerHandler that mean the command did not take effect
+static bool isFailure(const std::string &response)
+{
+	return response.rfind("ERR", 0) == 0
+		|| response.rfind("Error", 0) == 0
+		|| response == "Arduino not connected.";
+}
+
+ActuatorQueue::ActuatorQueue(const Config &config, std::function<std::string(const std::string &, Priority)> execute,
+							 std::function<void()> interrupt)
+	: config(config), execute(std::move(execute)), interrupt(std::move(interrupt))
+{
+	worker = std::thread(&ActuatorQueue::workLoop, this);
+}
+
+ActuatorQueue::~ActuatorQueue()
+{
+	stop();
+}
+
+void ActuatorQueue::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (worker.joinable())
+		worker.join();
+	finished.notify_all();
+}
+
+uint64_t ActuatorQueue::submit(const std::string &command, Priority priority, std::chrono::steady_clock::time_point deadline)
+{
+	uint64_t id = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping)
+			return 0;
+
+		if (priority == Priority::Auto && latched)
+		{
+			stats.refusedStopped++;
+			return 0;
+		}
+
+		if (priority == Priority::Stop && !stops.empty())
+		{
+			id = stops.back();    // a stop is already waiting, it does the same thing
+		}
+		else
+		{
+			if (priority == Priority::Stop)
+			{
+				// nothing queued before a stop may run after it and restart the belt
+				const auto now = std::chrono::steady_clock::now();
+				for (std::deque<uint64_t> *waitingIds : {&sorts, &pending})
+				{
+					for (uint64_t waitingId : *waitingIds)
+					{
+						Command *waiting = find(waitingId);
+						if (waiting && waiting->status == Status::Queued)
+							cancel(*waiting, "ERR: Superseded by stop", now);
+					}
+					waitingIds->clear();
+				}
+				if (runningId != 0 && !runningStop)
+					stats.preempted++;
+			}
+			else if ((priority == Priority::Sort ? sorts : pending).size() >= config.capacity)
+			{
+				stats.rejected++;
+				return 0;
+			}
+
+			Command entry;
+			entry.id = id = nextId++;
+			entry.command = command;
+			entry.priority = priority;
+			entry.deadline = deadline;
+			entry.queuedAt = std::chrono::steady_clock::now();
+			commands.push_back(std::move(entry));
+			(priority == Priority::Stop ? stops : priority == Priority::Sort ? sorts : pending).push_back(id);
+			stats.submitted++;
+		}
+		if (priority == Priority::Stop)
+			latched = true;
+	}
+	wake.notify_one();
+	if (priority == Priority::Stop)
+		finished.notify_all();    // waiters on the commands it cancelled
+
+	// Whatever is on the wire, the stop does not need its reply
+	if (priority == Priority::Stop && interrupt)
+		interrupt();
+	return id;
+}
+
+std::string ActuatorQueue::submitAndWait(const std::string &command, Priority priority, std::chrono::milliseconds timeout)
+{
+	const uint64_t id = submit(command, priority);
+	if (id == 0)
+		return stopLatched() ? "ERR: Belt stopped, waiting for start" : "ERR: Actuator queue full";
+
+	std::unique_lock<std::mutex> lock(mutex);
+	Command *done = nullptr;
+	finished.wait_for(lock, timeout, [&]() {
+		done = find(id);
+		return stopping || !done || (done->status != Status::Queued && done->status != Status::Running);
+	});
+	if (!done)
+		return "ERR: Command aged out";
+	if (done->status == Status::Queued || done->status == Status::Running)
+		return "ERR: Timed out in actuator queue";
+	return done->response;
+}
+
+bool ActuatorQueue::stopLatched() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return latched;
+}
+
+void ActuatorQueue::workLoop()
+{
+	set_thread_name("actuator");
+	static Histogram &stopWait = Metrics::global().histogram("sdbelt_actuator_wait_seconds",
+		"Time a command waited in the actuator queue", {0.001, 0.005, 0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5}, "priority=\"stop\"");
+	static Histogram &sortWait = Metrics::global().histogram("sdbelt_actuator_wait_seconds",
+		"Time a command waited in the actuator queue", {0.001, 0.005, 0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5}, "priority=\"sort\"");
+	static Histogram &normalWait = Metrics::global().histogram("sdbelt_actuator_wait_seconds",
+		"Time a command waited in the actuator queue", {0.001, 0.005, 0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5}, "priority=\"normal\"");
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wake.wait(lock, [this]() { return stopping || !stops.empty() || !sorts.empty() || !pending.empty(); });
+		if (stopping)
+			break;
+
+		std::deque<uint64_t> &source = !stops.empty() ? stops : !sorts.empty() ? sorts : pending;
+		const uint64_t id = source.front();
+		source.pop_front();
+
+		Command *next = find(id);
+		if (!next || next->status != Status::Queued)
+			continue;
+		if (next->priority == Priority::Auto && latched)
+		{
+			// a stop came in after it was queued and the belt must stay stopped
+			cancel(*next, "ERR: Belt stopped, waiting for start", std::chrono::steady_clock::now());
+			finished.notify_all();
+			continue;
+		}
+		const auto now = std::chrono::steady_clock::now();
+		if (now > next->deadline)
+		{
+			// the product is already past the gate; moving the servo now would sort the next one
+			cancel(*next, "ERR: Deadline passed", now);
+			stats.expired++;
+			finished.notify_all();
+			continue;
+		}
+
+		next->status = Status::Running;
+		next->startedAt = now;
+		runningId = id;
+		runningStop = next->priority == Priority::Stop;
+		(runningStop ? stopWait : next->priority == Priority::Sort ? sortWait : normalWait).observe(
+			std::chrono::duration<double>(next->startedAt - next->queuedAt).count());
+		const std::string command = next->command;
+		const Priority priority = next->priority;
+
+		lock.unlock();
+		std::string response = execute(command, priority);
+		lock.lock();
+
+		runningId = 0;
+		runningStop = false;
+		Command *done = find(id);
+		if (done)
+		{
+			done->status = isFailure(response) ? Status::Failed : Status::Done;
+			done->response = std::move(response);
+			done->finishedAt = std::chrono::steady_clock::now();
+			if (done->status == Status::Failed)
+				stats.failed++;
+			// only a start that took effect releases the latch; a stop queued meanwhile keeps it
+			if (done->status == Status::Done && command == "start" && stops.empty())
+				latched = false;
+		}
+		trimHistory();
+		finished.notify_all();
+	}
+
+	// shutting down: nothing queued will run
+	const auto now = std::chrono::steady_clock::now();
+	for (Command &left : commands)
+	{
+		if (left.status == Status::Queued)
+			cancel(left, "ERR: Shutting down", now);
+	}
+	stops.clear();
+	sorts.clear();
+	pending.clear();
+	finished.notify_all();
+}
+
+// Ids are handed out consecutively and kept in order, so the offset finds them
+ActuatorQueue::Command *ActuatorQueue::find(uint64_t id)
+{
+	if (commands.empty() || id < commands.front().id)
+		return nullptr;
+	const uint64_t index = id - commands.front().id;
+	return index < commands.size() ? &commands[index] : nullptr;
+}
+
+// Caller holds mutex
+void ActuatorQueue::cancel(Command &command, const char *reason, std::chrono::steady_clock::time_point now)
+{
+	command.status = Status::Cancelled;
+	command.response = reason;
+	command.finishedAt = now;
+	stats.cancelled++;
+}
+
+void ActuatorQueue::trimHistory()
+{
+	while (commands.size() > config.history
+		   && commands.front().status != Status::Queued
+		   && commands.front().status != Status::Running)
+		commands.pop_front();
+}
+
+bool ActuatorQueue::lookup(uint64_t id, Command &out) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Command *found = const_cast<ActuatorQueue *>(this)->find(id);
+	if (!found)
+		return false;
+	out = *found;
+	return true;
+}
+
+const char *ActuatorQueue::statusName(Status status)
+{
+	switch (status)
+	{
+		case Status::Queued: return "queued";
+		case Status::Running: return "running";
+		case Status::Done: return "done";
+		case Status::Failed: return "failed";
+		case Status::Cancelled: return "cancelled";
+	}
+	return "unknown";
+}
+
+std::string ActuatorQueue::commandJson(const Command &command)
+{
+	auto ms = [](std::chrono::steady_clock::duration d) {
+		return std::chrono::duration<double, std::milli>(d).count();
+	};
+	const bool started = command.startedAt != std::chrono::steady_clock::time_point{};
+	const bool finished = command.finishedAt != std::chrono::steady_clock::time_point{};
+
+	std::string out;
+	JsonWriter json(out);
+	json.beginObject();
+	json.key("id");
+	json.integer(static_cast<int64_t>(command.id));
+	json.key("command");
+	json.string(command.command);
+	json.key("priority");
+	json.string(command.priority == Priority::Stop ? "stop" : command.priority == Priority::Sort ? "sort"
+		: command.priority == Priority::Auto ? "auto" : "normal");
+	json.key("status");
+	json.string(statusName(command.status));
+	if (finished)
+	{
+		json.key("response");
+		json.string(command.response);
+	}
+	if (started)
+	{
+		json.key("queuedMs");
+		json.number(ms(command.startedAt - command.queuedAt));
+	}
+	if (started && finished)
+	{
+		json.key("runMs");
+		json.number(ms(command.finishedAt - command.startedAt));
+	}
+	json.endObject();
+	return out;
+}
+
+ActuatorQueue::Stats ActuatorQueue::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats copy = stats;
+	copy.queued = stops.size() + sorts.size() + pending.size();
+	copy.stopLatched = latched;
+	return copy;
+}
+
+std::string ActuatorQueue::stateJson() const
+{
+	Stats s = getStats();
+	uint64_t running;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = runningId;
+	}
+
+	std::ostringstream json;
+	json << "{\"capacity\":" << config.capacity
+		 << ",\"queued\":" << s.queued
+		 << ",\"running\":" << running
+		 << ",\"submitted\":" << s.submitted
+		 << ",\"rejected\":" << s.rejected
+		 << ",\"cancelled\":" << s.cancelled
+		 << ",\"expired\":" << s.expired
+		 << ",\"preempted\":" << s.preempted
+		 << ",\"failed\":" << s.failed
+		 << ",\"stopLatched\":" << (s.stopLatched ? "true" : "false")
+		 << ",\"refusedStopped\":" << s.refusedStopped << "}";
+	return json.str();
+}
@@ -0,0 +1,168 @@
+/**
+ * ActuatorQueue.h
+ *
+ * Single prioritized queue in front of the Arduino. Every actuator write
+ * goes through it: operator commands, the sorting servo, the speed
+ * controller and firmware settings. Callers enqueue a command and get its
+ * id back; one worker thread talks to the serial port, so commands never
+ * race on the fd and no HTTP or WebSocket thread blocks on a reply. A stop
+ * jumps the queue, cancels everything still waiting behind it and
+ * interrupts the command on the wire, so its latency does not depend on
+ * what else is in flight. It also latches: automatic commands are refused
+ * until an operator start succeeds, so nothing restarts a stopped belt on
+ * its own. The sorting servo comes next after stops and carries the
+ * product's deadline; once the product is past the gate it is dropped
+ * unsent. Finished commands are kept for a while so callers can poll
+ * their result by id.
+ */
+
+#ifndef ACTUATOR_QUEUE_H
+#define ACTUATOR_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class ActuatorQueue
+{
+public:
+	// Sort: the servo, served before Normal; Auto: queued like Normal, but refused while a stop is latched
+	enum class Priority { Stop, Sort, Normal, Auto };
+	enum class Status { Queued, Running, Done, Failed, Cancelled };
+
+	struct Config
+	{
+		size_t capacity;             // normal commands waiting, and separately sort commands; more are rejected
+		size_t history;              // finished commands kept for lookup
+	};
+
+	struct Command
+	{
+		uint64_t id = 0;
+		std::string command;
+		Priority priority = Priority::Normal;
+		Status status = Status::Queued;
+		std::string response;
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+		std::chrono::steady_clock::time_point queuedAt;
+		std::chrono::steady_clock::time_point startedAt;
+		std::chrono::steady_clock::time_point finishedAt;
+	};
+
+	struct Stats
+	{
+		unsigned long long submitted = 0;
+		unsigned long long rejected = 0;
+		unsigned long long cancelled = 0;
+		unsigned long long expired = 0;          // deadline passed before the worker got to it
+		unsigned long long preempted = 0;
+		unsigned long long failed = 0;
+		unsigned long long refusedStopped = 0;   // automatic commands refused while a stop was latched
+		size_t queued = 0;
+		bool stopLatched = false;
+	};
+
+	/**
+	 * Constructor - starts the worker thread
+	 *
+	 * @param config Queue limits
+	 * @param execute Runs one command against the Arduino and returns its reply
+	 * @param interrupt Releases the command currently waiting for a reply; called on every stop
+	 */
+	ActuatorQueue(const Config &config, std::function<std::string(const std::string &, Priority)> execute,
+				  std::function<void()> interrupt);
+
+	/**
+	 * Destructor - stops the worker
+	 */
+	~ActuatorQueue();
+
+	/**
+	 * Queue a command without waiting for it
+	 *
+	 * A stop is always accepted, coalesces with a stop already waiting,
+	 * cancels the commands queued before it and latches until a "start"
+	 * succeeds.
+	 *
+	 * @param command Command in the HttpServerHandler syntax ("stop", "speed=40", ...)
+	 * @param priority Priority::Stop for emergency stops, Priority::Sort for the servo,
+	 *                 Priority::Auto for automatic commands
+	 * @param deadline Cancelled instead of run if the worker only gets to it after this
+	 * @return Command id, or 0 if the queue is full or an automatic command met a latched stop
+	 */
+	uint64_t submit(const std::string &command, Priority priority,
+					std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+	/**
+	 * Queue a command and wait until it finished
+	 *
+	 * @param command Command in the HttpServerHandler syntax
+	 * @param priority As for submit()
+	 * @param timeout How long to wait; the command stays queued after it
+	 * @return The reply, or an "ERR: ..." text if it was refused or did not finish in time
+	 */
+	std::string submitAndWait(const std::string &command, Priority priority, std::chrono::milliseconds timeout);
+
+	/**
+	 * Whether a stop is latched, i.e. no start succeeded since the last stop
+	 */
+	bool stopLatched() const;
+
+	/**
+	 * Look up a command that is queued, running or recently finished
+	 *
+	 * @return false if the id is unknown or already aged out
+	 */
+	bool lookup(uint64_t id, Command &out) const;
+
+	/**
+	 * One command as JSON, for /commands/{id}
+	 */
+	static std::string commandJson(const Command &command);
+
+	Stats getStats() const;
+
+	/**
+	 * Queue state and counters as JSON
+	 */
+	std::string stateJson() const;
+
+	/**
+	 * Stop the worker; commands still queued are cancelled
+	 */
+	void stop();
+
+	static const char *statusName(Status status);
+
+private:
+	Config config;
+	std::function<std::string(const std::string &, Priority)> execute;
+	std::function<void()> interrupt;
+
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	std::deque<Command> commands;           // ordered by id: finished history, then running and queued
+	std::deque<uint64_t> stops;             // ids waiting, served first
+	std::deque<uint64_t> sorts;             // then these
+	std::deque<uint64_t> pending;
+	uint64_t nextId = 1;
+	uint64_t runningId = 0;
+	bool runningStop = false;
+	bool latched = false;
+	bool stopping = false;
+	Stats stats;
+	std::thread worker;
+
+	void workLoop();
+	Command *find(uint64_t id);
+	void trimHistory();
+	void cancel(Command &command, const char *reason, std::chrono::steady_clock::time_point now);
+};
+
+#endif // ACTUATOR_QUEUE_H
@@ -6,6 +6,8 @@
  */
 
 #include "ArduinoSerial.h"
+#include "Metrics.h"
+#include "thread_name.hpp"
 #include <iostream>
 #include <fcntl.h>
 #include <unistd.h>
@@ -14,26 +16,42 @@
 #include <chrono>
 #include <algorithm>
 #include <mutex>
+#include <cstdlib>
 
 // Constructor
 ArduinoSerial::ArduinoSerial(const std::string &portName)
+	: portName(portName)
 {
+	open();
+}
+
+// Destructor
+ArduinoSerial::~ArduinoSerial()
+{
+	close();
+}
+
+bool ArduinoSerial::open()
+{
+	if (serialPort >= 0)
+		return true;
+
 	// Open the serial port
-	serialPort = open(portName.c_str(), O_RDWR);
+	serialPort = ::open(portName.c_str(), O_RDWR);
 
 	if (serialPort < 0)
 	{
 		std::cerr << "Error opening serial port: " << strerror(errno) << std::endl;
-		return;
+		return false;
 	}
 
 	// Get current serial port settings
 	if (tcgetattr(serialPort, &tty) != 0)
 	{
 		std::cerr << "Error getting serial port attributes: " << strerror(errno) << std::endl;
-		close(serialPort);
+		::close(serialPort);
 		serialPort = -1;
-		return;
+		return false;
 	}
 
 	// Set Baud Rate
@@ -68,22 +86,25 @@ ArduinoSerial::ArduinoSerial(const std::string &portName)
 	if (tcsetattr(serialPort, TCSANOW, &tty) != 0)
 	{
 		std::cerr << "Error setting serial port attributes: " << strerror(errno) << std::endl;
-		close(serialPort);
+		::close(serialPort);
 		serialPort = -1;
-		return;
+		return false;
 	}
-
-	// Give Arduino time to reset
-	std::this_thread::sleep_for(std::chrono::seconds(2));
 	std::cout << "Serial port initialized" << std::endl;
 
-	// Start background reading
+	{
+		std::lock_guard<std::mutex> lock(replyMutex);
+		bootLine.clear();
+		replies.clear();
+	}
+
+	// Start background reading; the board is still resetting, waitReady() tells when it is up
 	keepReading = true;
 	readerThread = std::thread(&ArduinoSerial::readLoop, this);
+	return true;
 }
 
-// Destructor
-ArduinoSerial::~ArduinoSerial()
+void ArduinoSerial::close()
 {
 	// Stop background thread
 	keepReading = false;
@@ -92,40 +113,120 @@ ArduinoSerial::~ArduinoSerial()
 
 	if (serialPort >= 0)
 	{
-		close(serialPort);
+		::close(serialPort);
+		serialPort = -1;
 		std::cout << "Serial port closed" << std::endl;
 	}
 }
 
-// Background thread to read data from Arduino
+bool ArduinoSerial::waitReady(std::chrono::milliseconds timeout, unsigned long &firmwareHash)
+{
+	firmwareHash = 0;
+	if (serialPort < 0)
+		return false;
+
+	{
+		std::unique_lock<std::mutex> lock(replyMutex);
+		if (replyReady.wait_for(lock, timeout, [this]() { return !bootLine.empty(); }))
+		{
+			firmwareHash = std::strtoul(bootLine.c_str() + 6, nullptr, 16);
+			return true;
+		}
+	}
+
+	// no announcement: not reset by the open, or a sketch from before the handshake
+	std::string reply = sendCommand("VERSION");
+	if (reply.rfind("VERSION:", 0) == 0)
+	{
+		firmwareHash = std::strtoul(reply.c_str() + 8, nullptr, 16);
+		return true;
+	}
+	return reply.rfind("ERR:", 0) == 0;    // alive, but does not know the command
+}
+
+// Background thread to read data from Arduino, the only reader of the port
 void ArduinoSerial::readLoop()
 {
+	set_thread_name("serial-rx");
 	char buffer[256];
+	std::string partial;
 
 	while (keepReading)
 	{
-		memset(buffer, 0, sizeof(buffer));
-		ssize_t bytesRead = read(serialPort, buffer, sizeof(buffer) - 1);
+		// VTIME makes this block up to 1 s, so replies are picked up as soon as they arrive
+		ssize_t bytesRead = read(serialPort, buffer, sizeof(buffer));
 		if (bytesRead > 0)
 		{
-			std::string line(buffer);
-			line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-			line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
-
-			if (line.find("DISTANCE:") != std::string::npos)
+			partial.append(buffer, bytesRead);
+			size_t newline;
+			while ((newline = partial.find('\n')) != std::string::npos)
 			{
-				std::lock_guard<std::mutex> lock(dataMutex);
-				latestDistance = line;
-				std::cout << "↪️ Incoming: " << line << std::endl;
+				std::string line = partial.substr(0, newline);
+				partial.erase(0, newline + 1);
+				line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+				if (!line.empty())
+					handleLine(line);
 			}
+			if (partial.size() > sizeof(buffer))
+				partial.clear();    // no newline in sight, resynchronise on the next one
 		}
-		else
+		else if (bytesRead < 0)
 		{
 			std::this_thread::sleep_for(std::chrono::milliseconds(100));
 		}
 	}
 }
 
+// Distance reports are unsolicited; every other line answers a command
+void ArduinoSerial::handleLine(const std::string &line)
+{
+	size_t pos = line.rfind("DISTANCE:");
+	if (pos != std::string::npos)
+	{
+		char *end = nullptr;
+		long cm = std::strtol(line.c_str() + pos + 9, &end, 10);
+		if (end != line.c_str() + pos + 9)
+		{
+			auto now = std::chrono::steady_clock::now().time_since_epoch();
+			latestDistanceCm = static_cast<int>(cm);
+			latestDistanceMs = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+		}
+
+		std::lock_guard<std::mutex> lock(dataMutex);
+		latestDistance = line;
+		return;
+	}
+
+	if (line.rfind("READY:", 0) == 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(replyMutex);
+			bootLine = line;
+		}
+		replyReady.notify_all();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(replyMutex);
+		if (replies.size() >= 8)
+			replies.pop_front();
+		replies.push_back(line);
+	}
+	replyReady.notify_all();
+}
+
+// "OK:PCT:40%" answers "PCT:40"; a late reply to an interrupted command must not answer the next one
+bool ArduinoSerial::replyMatches(const std::string &command, const std::string &reply)
+{
+	std::string verb = command.substr(0, command.find(':'));
+	if (verb == "REV")
+		verb = "DIR";
+	return reply.rfind("ERR:", 0) == 0
+		|| reply.rfind("OK:" + verb, 0) == 0
+		|| reply.rfind(verb + ":", 0) == 0;
+}
+
 // Send a command to Arduino and wait for a response
 std::string ArduinoSerial::sendCommand(const std::string &command)
 {
@@ -134,9 +235,21 @@ std::string ArduinoSerial::sendCommand(const std::string &command)
 		return "Error: Serial port not open";
 	}
 
+	static Histogram &roundTrip = Metrics::global().histogram("sdbelt_serial_round_trip_seconds",
+		"Time from writing a command to the Arduino's reply line", {0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.25, 0.5});
+	static Counter &timeouts = Metrics::global().counter("sdbelt_serial_timeouts_total", "Arduino commands that got no reply");
+
+	std::lock_guard<std::mutex> commandLock(commandMutex);
 	std::cout << "Sending command: " << command << std::endl;
 
 	std::string fullCommand = command + "\n";
+	unsigned long long generation;
+	{
+		std::lock_guard<std::mutex> lock(replyMutex);
+		replies.clear();    // anything left over belongs to an earlier command
+		generation = interruptGeneration;
+	}
+	auto sent = std::chrono::steady_clock::now();
 
 	ssize_t bytesWritten = write(serialPort, fullCommand.c_str(), fullCommand.length());
 	if (bytesWritten < 0)
@@ -144,37 +257,54 @@ std::string ArduinoSerial::sendCommand(const std::string &command)
 		return "Error writing to serial port: " + std::string(strerror(errno));
 	}
 
-	// Read loop until newline or timeout
 	std::string response;
-	char ch;
-	auto start = std::chrono::steady_clock::now();
-
-	while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500))
+	bool interrupted = false;
 	{
-		ssize_t result = read(serialPort, &ch, 1);
-		if (result > 0)
+		std::unique_lock<std::mutex> lock(replyMutex);
+		auto deadline = sent + std::chrono::milliseconds(500);
+		while (response.empty())
 		{
-			if (ch == '\n')
+			if (interruptGeneration != generation)
 			{
+				interrupted = true;
 				break;
 			}
-			response += ch;
-		}
-		else
-		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			while (!replies.empty() && response.empty())
+			{
+				if (replyMatches(command, replies.front()))
+					response = replies.front();
+				replies.pop_front();
+			}
+			if (response.empty() && replyReady.wait_until(lock, deadline) == std::cv_status::timeout)
+				break;
 		}
 	}
 
+	if (interrupted)
+	{
+		return "Error: Interrupted by stop";
+	}
 	if (response.empty())
 	{
+		timeouts.inc();
 		return "Error: No response or timeout";
 	}
+	roundTrip.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - sent).count());
 
 	std::cout << "Response: " << response << std::endl;
 	return response;
 }
 
+// Release whoever is waiting for a reply
+void ArduinoSerial::interrupt()
+{
+	{
+		std::lock_guard<std::mutex> lock(replyMutex);
+		++interruptGeneration;
+	}
+	replyReady.notify_all();
+}
+
 // Check if the serial connection is valid
 bool ArduinoSerial::isConnected() const
 {
@@ -194,13 +324,25 @@ std::string ArduinoSerial::setSpeed(int percent)
 	{
 		return "Error: Speed percentage must be between 0 and 100";
 	}
-	return sendCommand("PCT:" + std::to_string(percent));
+	std::string response = sendCommand("PCT:" + std::to_string(percent));
+	if (response.rfind("OK:PCT", 0) == 0)
+		commandedSpeed = percent;
+	return response;
+}
+
+// Last acknowledged speed percentage
+int ArduinoSerial::getSpeedPercent() const
+{
+	return commandedSpeed;
 }
 
 // Immediate stop of the motor
 std::string ArduinoSerial::stopImmediate()
 {
-	return sendCommand("STOP:0");
+	std::string response = sendCommand("STOP:0");
+	if (response.rfind("OK:STOP", 0) == 0)
+		commandedSpeed = 0;
+	return response;
 }
 
 // Gradual stop of the motor
@@ -269,3 +411,28 @@ std::string ArduinoSerial::getLatestDistance()
 	std::lock_guard<std::mutex> lock(dataMutex);
 	return latestDistance;
 }
+
+// Return the most recent distance in cm, or -1 if it is older than maxAge
+int ArduinoSerial::getLatestDistanceCm(std::chrono::milliseconds maxAge)
+{
+	long long stamp = latestDistanceMs;
+	if (stamp == 0)
+		return -1;
+
+	auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	if (now - stamp > maxAge.count())
+		return -1;
+
+	return latestDistanceCm;
+}
+
+// Set the ultrasonic sampling interval (20–5000 ms)
+std::string ArduinoSerial::setDistanceInterval(int intervalMs)
+{
+	if (intervalMs < 20 || intervalMs > 5000)
+	{
+		return "Error: Distance interval must be between 20 and 5000 ms";
+	}
+	return sendCommand("DINT:" + std::to_string(intervalMs));
+}
@@ -11,6 +11,9 @@
 #include <string>
 #include <termios.h>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
 
@@ -18,19 +21,36 @@ class ArduinoSerial
 {
 
 private:
-	int serialPort;
+	std::string portName;
+	int serialPort = -1;
 	struct termios tty;
 
 	std::thread readerThread;
 	std::atomic<bool> keepReading;
 	std::mutex dataMutex;
 	std::string latestDistance;
+	std::atomic<int> latestDistanceCm{-1};
+	std::atomic<long long> latestDistanceMs{0}; // steady_clock time of last reading
+	std::atomic<int> commandedSpeed{-1};        // last acknowledged PCT value, -1 if unknown
+
+	// The reader thread owns the fd for reading; command replies are handed over here
+	std::mutex commandMutex;                    // one command on the wire at a time
+	std::mutex replyMutex;
+	std::condition_variable replyReady;
+	std::deque<std::string> replies;
+	unsigned long long interruptGeneration = 0; // bumped by interrupt(), guarded by replyMutex
+	std::string bootLine;                       // "READY:<hash>" printed by setup(), guarded by replyMutex
+
 	void readLoop(); // Background reader thread
+	void handleLine(const std::string &line);
+	static bool replyMatches(const std::string &command, const std::string &reply);
 
 public:
 	/**
 	 * Constructor - initializes the serial connection
 	 *
+	 * Opening the port resets the board; waitReady() tells when it is up.
+	 *
 	 * @param portName The serial port to connect to (e.g., "/dev/ttyACM0")
 	 */
 	ArduinoSerial(const std::string &portName);
@@ -40,6 +60,31 @@ public:
 	 */
 	~ArduinoSerial();
 
+	/**
+	 * Open the port again after close(), e.g. once the board has been flashed
+	 *
+	 * @return true if the port could be opened
+	 */
+	bool open();
+
+	/**
+	 * Stop the reader and release the port, so a flasher can use it
+	 */
+	void close();
+
+	/**
+	 * Wait until the sketch answers after a reset and read its firmware hash
+	 *
+	 * setup() announces "READY:<hash>". A board that was not reset, or runs a
+	 * sketch from before the handshake, is asked with VERSION once the wait
+	 * is over.
+	 *
+	 * @param timeout Longest wait for the announcement
+	 * @param firmwareHash Hash the sketch was built with, 0 if it does not know
+	 * @return true if the sketch answered at all
+	 */
+	bool waitReady(std::chrono::milliseconds timeout, unsigned long &firmwareHash);
+
 	/**
 	 * Send a command to the Arduino and get the response
 	 *
@@ -48,6 +93,15 @@ public:
 	 */
 	std::string sendCommand(const std::string &command);
 
+	/**
+	 * Stop waiting for the reply of the command currently on the wire
+	 *
+	 * The command itself has already been written and will still run on the
+	 * Arduino; only its caller is released, so an emergency stop queued
+	 * behind it does not wait out the reply timeout.
+	 */
+	void interrupt();
+
 	/**
 	 * Check if the serial connection is valid
 	 *
@@ -70,6 +124,13 @@ public:
 	 */
 	std::string setSpeed(int percent);
 
+	/**
+	 * Get the last speed acknowledged by the Arduino
+	 *
+	 * @return Speed percentage, or -1 if it has not been set yet
+	 */
+	int getSpeedPercent() const;
+
 	/**
 	 * Immediate stop of the motor
 	 *
@@ -116,6 +177,22 @@ public:
 	 */
 	std::string getLatestDistance();
 
+	/**
+	 * Get the latest distance reading as a number
+	 *
+	 * @param maxAge Readings older than this are treated as missing
+	 * @return Distance in cm, or -1 if no fresh reading is available
+	 */
+	int getLatestDistanceCm(std::chrono::milliseconds maxAge);
+
+	/**
+	 * Set how often the Arduino samples the ultrasonic sensor
+	 *
+	 * @param intervalMs Sampling period in milliseconds (20-5000)
+	 * @return The response from Arduino
+	 */
+	std::string setDistanceInterval(int intervalMs);
+
 	/**
 	 * Reverse current direction of Arduino motor 
 	 *
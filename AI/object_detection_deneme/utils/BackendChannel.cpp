@@ -0,0 +1,742 @@
+/**
+ * BackendChannel.cpp
+ *
+ * Implementation of the backend WebSocket channel.
+ */
+
+#include "BackendChannel.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char *WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static constexpr int IO_TIMEOUT_MS = 2000;           // connect, handshake and blocking sends
+static constexpr size_t MAX_MESSAGE_BYTES = 1 << 20;
+
+enum Opcode : uint8_t
+{
+	OP_CONTINUATION = 0x0,
+	OP_TEXT = 0x1,
+	OP_BINARY = 0x2,
+	OP_CLOSE = 0x8,
+	OP_PING = 0x9,
+	OP_PONG = 0xA
+};
+
+static std::string base64(const unsigned char *data, size_t size)
+{
+	static const char *table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string out;
+	out.reserve((size + 2) / 3 * 4);
+	for (size_t i = 0; i < size; i += 3)
+	{
+		uint32_t chunk = data[i] << 16;
+		if (i + 1 < size) chunk |= data[i + 1] << 8;
+		if (i + 2 < size) chunk |= data[i + 2];
+		out += table[(chunk >> 18) & 0x3F];
+		out += table[(chunk >> 12) & 0x3F];
+		out += i + 1 < size ? table[(chunk >> 6) & 0x3F] : '=';
+		out += i + 2 < size ? table[chunk & 0x3F] : '=';
+	}
+	return out;
+}
+
+// SHA-1 is only used to verify Sec-WebSocket-Accept, a few bytes once per connect
+static std::string sha1Base64(const std::string &text)
+{
+	uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+	std::string msg = text;
+	const uint64_t bits = static_cast<uint64_t>(text.size()) * 8;
+	msg += static_cast<char>(0x80);
+	while (msg.size() % 64 != 56)
+		msg += '\0';
+	for (int i = 7; i >= 0; i--)
+		msg += static_cast<char>((bits >> (i * 8)) & 0xFF);
+
+	auto rotl = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+	for (size_t block = 0; block < msg.size(); block += 64)
+	{
+		uint32_t w[80];
+		for (int i = 0; i < 16; i++)
+		{
+			const unsigned char *p = reinterpret_cast<const unsigned char *>(msg.data() + block + i * 4);
+			w[i] = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+		}
+		for (int i = 16; i < 80; i++)
+			w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+		uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+		for (int i = 0; i < 80; i++)
+		{
+			uint32_t f, k;
+			if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+			else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+			else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+			else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+			uint32_t t = rotl(a, 5) + f + e + k + w[i];
+			e = d; d = c; c = rotl(b, 30); b = a; a = t;
+		}
+		h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+	}
+
+	unsigned char digest[20];
+	for (int i = 0; i < 5; i++)
+		for (int j = 0; j < 4; j++)
+			digest[i * 4 + j] = (h[i] >> (24 - j * 8)) & 0xFF;
+	return base64(digest, sizeof(digest));
+}
+
+// Constructor
+BackendChannel::BackendChannel(const Config &cfg)
+	: config(cfg), rng(std::random_device{}())
+{
+	config.window = std::max<size_t>(config.window, 1);
+	config.pingIntervalMs = std::max(config.pingIntervalMs, 100);
+	wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	channelThread = std::thread(&BackendChannel::channelLoop, this);
+}
+
+// Destructor
+BackendChannel::~BackendChannel()
+{
+	stop();
+	if (wakeFd >= 0)
+		::close(wakeFd);
+}
+
+void BackendChannel::stop()
+{
+	stopping = true;
+	wakeUp();
+	if (channelThread.joinable())
+		channelThread.join();
+	ackCond.notify_all();
+}
+
+void BackendChannel::setCommandHandler(CommandHandler handler)
+{
+	std::lock_guard<std::mutex> lock(commandMutex);
+	commandHandler = std::move(handler);
+}
+
+void BackendChannel::wakeUp()
+{
+	uint64_t one = 1;
+	if (wakeFd >= 0)
+		(void)::write(wakeFd, &one, sizeof(one));
+}
+
+void BackendChannel::channelLoop()
+{
+	set_thread_name("ws-channel");
+	int delayMs = config.reconnectMinMs;
+	while (!stopping)
+	{
+		if (connectSocket() && handshake())
+		{
+			++connects;
+			isConnected = true;
+			reconnectDelayMs = 0;
+			delayMs = config.reconnectMinMs;
+			std::cout << "Backend channel connected to ws://" << config.host << ":" << config.port << config.path << std::endl;
+
+			while (!stopping && pump())
+				;
+			if (stopping)
+			{
+				const char normalClosure[2] = {0x03, static_cast<char>(0xE8)};    // 1000
+				sendFrame(OP_CLOSE, normalClosure, sizeof(normalClosure));
+			}
+		}
+		disconnect();
+		if (stopping)
+			break;
+
+		// Exponential backoff with jitter so a restarted backend is not hit by every edge at once
+		reconnectDelayMs = delayMs;
+		pollfd pfd{wakeFd, POLLIN, 0};
+		::poll(&pfd, 1, delayMs);
+		uint64_t drained;
+		(void)::read(wakeFd, &drained, sizeof(drained));
+		std::uniform_int_distribution<int> jitter(0, std::max(1, delayMs / 4));
+		delayMs = std::min(config.reconnectMaxMs, delayMs * 2 + jitter(rng));
+	}
+}
+
+bool BackendChannel::connectSocket()
+{
+	addrinfo hints{};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo *result = nullptr;
+	if (::getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &result) != 0 || !result)
+		return false;
+
+	sock = ::socket(result->ai_family, result->ai_socktype | SOCK_CLOEXEC, result->ai_protocol);
+	if (sock < 0)
+	{
+		::freeaddrinfo(result);
+		return false;
+	}
+
+	// Non-blocking connect so an unreachable backend costs IO_TIMEOUT_MS, not the kernel's minutes
+	int flags = ::fcntl(sock, F_GETFL, 0);
+	::fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+	int rc = ::connect(sock, result->ai_addr, result->ai_addrlen);
+	::freeaddrinfo(result);
+	if (rc != 0 && errno != EINPROGRESS)
+		return false;
+	if (rc != 0)
+	{
+		pollfd pfd{sock, POLLOUT, 0};
+		int error = 0;
+		socklen_t len = sizeof(error);
+		if (::poll(&pfd, 1, IO_TIMEOUT_MS) != 1 || ::getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0)
+			return false;
+	}
+	::fcntl(sock, F_SETFL, flags);
+
+	int one = 1;
+	::setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	::setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+	timeval tv{IO_TIMEOUT_MS / 1000, (IO_TIMEOUT_MS % 1000) * 1000};
+	::setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	return true;
+}
+
+bool BackendChannel::handshake()
+{
+	unsigned char nonce[16];
+	for (unsigned char &b : nonce)
+		b = static_cast<unsigned char>(rng());
+	const std::string key = base64(nonce, sizeof(nonce));
+
+	std::ostringstream request;
+	request << "GET " << config.path << " HTTP/1.1\r\n"
+			<< "Host: " << config.host << ":" << config.port << "\r\n"
+			<< "Upgrade: websocket\r\n"
+			<< "Connection: Upgrade\r\n"
+			<< "Sec-WebSocket-Key: " << key << "\r\n"
+			<< "Sec-WebSocket-Version: 13\r\n\r\n";
+	const std::string text = request.str();
+	if (!sendAll(text.data(), text.size()))
+		return false;
+
+	std::string response;
+	size_t headerEnd;
+	char chunk[1024];
+	while ((headerEnd = response.find("\r\n\r\n")) == std::string::npos)
+	{
+		pollfd pfd{sock, POLLIN, 0};
+		if (response.size() > 8192 || ::poll(&pfd, 1, IO_TIMEOUT_MS) != 1)
+			return false;
+		ssize_t n = ::recv(sock, chunk, sizeof(chunk), 0);
+		if (n <= 0)
+			return false;
+		response.append(chunk, n);
+	}
+
+	std::string header = response.substr(0, headerEnd);
+	std::transform(header.begin(), header.end(), header.begin(), [](unsigned char c) { return std::tolower(c); });
+	const std::string expected = sha1Base64(key + WS_GUID);
+	std::string expectedLower = expected;
+	std::transform(expectedLower.begin(), expectedLower.end(), expectedLower.begin(), [](unsigned char c) { return std::tolower(c); });
+
+	if (header.compare(0, 12, "http/1.1 101") != 0 || header.find("sec-websocket-accept: " + expectedLower) == std::string::npos)
+	{
+		std::cerr << "Backend channel: WebSocket upgrade refused: " << response.substr(0, response.find("\r\n")) << std::endl;
+		return false;
+	}
+
+	rxBuffer = response.substr(headerEnd + 4);
+	rxMessage.clear();
+	lastReceive = Clock::now();
+	pingSent = lastReceive;
+	pingPending = false;
+	return true;
+}
+
+void BackendChannel::disconnect()
+{
+	if (sock >= 0)
+	{
+		::close(sock);
+		sock = -1;
+	}
+	if (isConnected.exchange(false))
+		++disconnects;
+	rxBuffer.clear();
+	rxMessage.clear();
+
+	// Nothing in flight was acknowledged; send it again, in order, after the reconnect
+	std::lock_guard<std::mutex> lock(queueMutex);
+	resent += inFlight.size();
+	while (!inFlight.empty())
+	{
+		queue.push_front(std::move(inFlight.back()));
+		inFlight.pop_back();
+	}
+	ackCond.notify_all();
+}
+
+// One round of the connected state: fill the window, keep the link alive, read what arrived
+bool BackendChannel::pump()
+{
+	for (;;)
+	{
+		Message message;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (queue.empty() || inFlight.size() >= config.window)
+				break;
+			inFlight.push_back(queue.front());
+			queue.pop_front();
+			message = inFlight.back();
+			sentSeq = std::max(sentSeq, message.seq);    // counts as out even if the send below fails
+		}
+		if (!sendFrame(OP_TEXT, message.json.data(), message.json.size()))
+			return false;
+		++sent;
+	}
+
+	const auto now = Clock::now();
+	const auto interval = std::chrono::milliseconds(config.pingIntervalMs);
+	if (now - lastReceive > 3 * interval)
+	{
+		std::cerr << "Backend channel: no traffic for " << 3 * config.pingIntervalMs << " ms, reconnecting" << std::endl;
+		return false;
+	}
+	if (now - pingSent >= interval)
+	{
+		if (!sendFrame(OP_PING, nullptr, 0))
+			return false;
+		pingSent = now;
+		pingPending = true;
+	}
+
+	pollfd fds[2] = {{sock, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+	int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(pingSent + interval - now).count());
+	if (::poll(fds, 2, std::max(timeout, 1)) < 0 && errno != EINTR)
+		return false;
+	if (fds[1].revents & POLLIN)
+	{
+		uint64_t drained;
+		(void)::read(wakeFd, &drained, sizeof(drained));
+	}
+	if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+		return readFrames();
+	return true;
+}
+
+bool BackendChannel::sendAll(const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = ::send(sock, data, size, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		size -= n;
+		bytesOut += n;
+	}
+	return true;
+}
+
+// Client frames are always masked (RFC 6455 5.3); header, mask and payload go out in one send
+bool BackendChannel::sendFrame(uint8_t opcode, const char *data, size_t size)
+{
+	txBuffer.clear();
+	txBuffer += static_cast<char>(0x80 | opcode);
+	if (size < 126)
+	{
+		txBuffer += static_cast<char>(0x80 | size);
+	}
+	else if (size <= 0xFFFF)
+	{
+		txBuffer += static_cast<char>(0x80 | 126);
+		txBuffer += static_cast<char>(size >> 8);
+		txBuffer += static_cast<char>(size & 0xFF);
+	}
+	else
+	{
+		txBuffer += static_cast<char>(0x80 | 127);
+		for (int i = 7; i >= 0; i--)
+			txBuffer += static_cast<char>((static_cast<uint64_t>(size) >> (i * 8)) & 0xFF);
+	}
+
+	const uint32_t maskKey = rng();
+	char mask[4];
+	std::memcpy(mask, &maskKey, sizeof(mask));
+	txBuffer.append(mask, sizeof(mask));
+
+	const size_t payloadStart = txBuffer.size();
+	txBuffer.append(data, size);
+	for (size_t i = 0; i < size; i++)
+		txBuffer[payloadStart + i] ^= mask[i & 3];
+
+	return sendAll(txBuffer.data(), txBuffer.size());
+}
+
+bool BackendChannel::readFrames()
+{
+	char chunk[16384];
+	for (;;)
+	{
+		ssize_t n = ::recv(sock, chunk, sizeof(chunk), MSG_DONTWAIT);
+		if (n > 0)
+		{
+			rxBuffer.append(chunk, n);
+			bytesIn += n;
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n < 0 && errno == EINTR)
+			continue;
+		return false;    // closed by the backend or a socket error
+	}
+	lastReceive = Clock::now();
+
+	size_t pos = 0;
+	while (rxBuffer.size() - pos >= 2)
+	{
+		const uint8_t b0 = rxBuffer[pos];
+		const uint8_t b1 = rxBuffer[pos + 1];
+		const bool fin = b0 & 0x80;
+		const uint8_t opcode = b0 & 0x0F;
+		const bool masked = b1 & 0x80;
+		uint64_t length = b1 & 0x7F;
+		size_t header = 2;
+
+		if (length == 126)
+		{
+			if (rxBuffer.size() - pos < 4)
+				break;
+			length = (static_cast<uint8_t>(rxBuffer[pos + 2]) << 8) | static_cast<uint8_t>(rxBuffer[pos + 3]);
+			header = 4;
+		}
+		else if (length == 127)
+		{
+			if (rxBuffer.size() - pos < 10)
+				break;
+			length = 0;
+			for (int i = 0; i < 8; i++)
+				length = (length << 8) | static_cast<uint8_t>(rxBuffer[pos + 2 + i]);
+			header = 10;
+		}
+		if (length > MAX_MESSAGE_BYTES)
+			return false;
+		const size_t maskAt = pos + header;
+		if (masked)
+			header += 4;
+		if (rxBuffer.size() - pos < header + length)
+			break;
+
+		std::string payload = rxBuffer.substr(pos + header, length);
+		if (masked)
+			for (size_t i = 0; i < payload.size(); i++)
+				payload[i] ^= rxBuffer[maskAt + (i & 3)];
+		pos += header + length;
+
+		switch (opcode)
+		{
+		case OP_CONTINUATION:
+			rxMessage += payload;
+			if (rxMessage.size() > MAX_MESSAGE_BYTES)
+				return false;
+			if (fin)
+			{
+				handleText(rxMessage);
+				rxMessage.clear();
+			}
+			break;
+		case OP_TEXT:
+			if (fin)
+				handleText(payload);
+			else
+				rxMessage = payload;
+			break;
+		case OP_CLOSE:
+			sendFrame(OP_CLOSE, payload.data(), std::min<size_t>(payload.size(), 2));
+			return false;
+		case OP_PING:
+			if (!sendFrame(OP_PONG, payload.data(), payload.size()))
+				return false;
+			break;
+		case OP_PONG:
+			if (pingPending)
+			{
+				rttMs = std::chrono::duration<double, std::milli>(Clock::now() - pingSent).count();
+				pingPending = false;
+			}
+			break;
+		default:
+			break;    // binary frames are not part of the protocol
+		}
+	}
+	rxBuffer.erase(0, pos);
+	return true;
+}
+
+// {"ack":N} or {"nack":N} come first; the backend then echoes "Server received: <our frame>"
+// for every frame, handled or not, so an echo for a frame still in flight is a nack
+void BackendChannel::handleText(const std::string &text)
+{
+	static const std::string echo = "Server received: ";
+	if (text.compare(0, echo.size(), echo) == 0)
+	{
+		const size_t seqAt = text.find("\"seq\":");
+		if (seqAt != std::string::npos)
+			handleAck(std::strtoull(text.c_str() + seqAt + 6, nullptr, 10), false);
+		return;
+	}
+	const size_t nackAt = text.find("\"nack\":");
+	if (nackAt != std::string::npos)
+	{
+		std::cerr << "Backend channel: backend refused " << text.substr(0, 200) << std::endl;
+		handleAck(std::strtoull(text.c_str() + nackAt + 7, nullptr, 10), false);
+		return;
+	}
+	const size_t ackAt = text.find("\"ack\":");
+	if (ackAt != std::string::npos)
+	{
+		handleAck(std::strtoull(text.c_str() + ackAt + 6, nullptr, 10), true);
+		return;
+	}
+	handleCommand(text);
+}
+
+// Resolves one frame; the socket keeps our frames in order, so everything before it was answered too
+void BackendChannel::handleAck(uint64_t seq, bool stored)
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (seq <= resolvedSeq)
+		return;    // the echo after an ack or nack
+	while (!inFlight.empty() && inFlight.front().seq <= seq)
+	{
+		// a product is remembered until sendScans collects it, so a retry never resends it
+		if (inFlight.front().key != 0)
+			resolvedKeys.emplace_back(inFlight.front().key, inFlight.front().seq != seq || stored);
+		inFlight.pop_front();
+	}
+	while (resolvedKeys.size() > config.queueCapacity + config.window)
+		resolvedKeys.pop_front();
+	resolvedSeq = seq;
+	if (stored)
+		++acked;
+	else
+		++nacked;
+	ackCond.notify_all();
+}
+
+// Commands use the backend's CommandType names; SPEED_COMMAND carries the percentage
+void BackendChannel::handleCommand(const std::string &text)
+{
+	static const std::pair<const char *, const char *> names[] = {
+		{"STOP_SYSTEM_COMMAND", "stop"},
+		{"SHUTDOWN_SYSTEM_COMMAND", "stop"},
+		{"START_SYSTEM_COMMAND", "start"},
+		{"REVERSE_BELT_COMMAND", "reverse"},
+	};
+
+	std::string command;
+	for (const auto &name : names)
+		if (text.find(name.first) != std::string::npos)
+			command = name.second;
+
+	if (command.empty() && text.find("SPEED_COMMAND") != std::string::npos)
+	{
+		size_t at = text.find("\"speed\":");
+		if (at == std::string::npos)
+			at = text.find("\"data\":");
+		if (at != std::string::npos)
+		{
+			at = text.find(':', at) + 1;
+			command = "speed=" + std::to_string(std::atoi(text.c_str() + at));
+		}
+	}
+
+	if (command.empty())
+	{
+		std::cerr << "Backend channel: ignored message " << text.substr(0, 120) << std::endl;
+		return;
+	}
+
+	++commands;
+	std::lock_guard<std::mutex> lock(commandMutex);
+	const std::string response = commandHandler ? commandHandler(command) : std::string("ERR: no command handler");
+	if (response.compare(0, 4, "ERR:") == 0)
+		std::cerr << "Backend channel: " << command << " failed: " << response << std::endl;
+}
+
+uint64_t BackendChannel::enqueue(const char *type, uint64_t key, const std::function<void(JsonWriter &)> &writeData)
+{
+	const long long timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	uint64_t seq;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (queue.size() >= config.queueCapacity)
+		{
+			++refused;
+			return 0;
+		}
+		// seq first: it is what we look for in the echo; formatted under the lock so seq order is queue order
+		seq = nextSeq++;
+		Message message{seq, key, std::string()};
+		message.json.reserve(256);
+		JsonWriter json(message.json);
+		json.beginObject();
+		json.key("seq");
+		json.integer(static_cast<int64_t>(message.seq));
+		json.key("type");
+		json.string(type, std::strlen(type));
+		json.key("event");
+		json.beginObject();
+		json.key("data");
+		writeData(json);
+		json.key("timestamp");
+		json.integer(timestampMs);
+		json.endObject();
+		json.endObject();
+		queue.push_back(std::move(message));
+	}
+	wakeUp();
+	return seq;
+}
+
+// Caller holds queueMutex
+bool BackendChannel::takeResolved(uint64_t key, bool &stored)
+{
+	auto it = std::find_if(resolvedKeys.begin(), resolvedKeys.end(),
+						   [key](const std::pair<uint64_t, bool> &resolved) { return resolved.first == key; });
+	if (it == resolvedKeys.end())
+		return false;
+	stored = it->second;
+	resolvedKeys.erase(it);
+	return true;
+}
+
+// One frame per product: the backend turns the list into one product record, like the POST
+BackendChannel::SendResult BackendChannel::sendScans(uint64_t key, const std::vector<ScanRequestDTO> &scans, int timeoutMs)
+{
+	if (scans.empty())
+		return SendResult::Failed;
+
+	uint64_t seq = 0;
+	{
+		// A retry after an Unknown: wait on the frame that already carries it
+		std::lock_guard<std::mutex> lock(queueMutex);
+		bool stored;
+		if (takeResolved(key, stored))
+			return stored ? SendResult::Stored : SendResult::Failed;
+		for (const std::deque<Message> *messages : {&inFlight, &queue})
+			for (const Message &message : *messages)
+				if (message.key == key)
+					seq = message.seq;
+	}
+
+	if (seq == 0)
+	{
+		if (!isConnected)
+			return SendResult::Failed;
+		seq = enqueue("NEW_PRODUCT_SCANS_EVENT", key, [&scans](JsonWriter &json) {
+			json.beginArray();
+			for (const auto &scan : scans)
+				scan.toJson(json);
+			json.endArray();
+		});
+		if (seq == 0)
+			return SendResult::Failed;
+	}
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	ackCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() { return resolvedSeq >= seq || stopping; });
+	if (resolvedSeq >= seq)
+	{
+		bool stored = true;
+		takeResolved(key, stored);
+		return stored ? SendResult::Stored : SendResult::Failed;
+	}
+	if (seq > sentSeq)
+	{
+		// Never went out: withdraw it so the caller's fallback does not duplicate it
+		queue.erase(std::remove_if(queue.begin(), queue.end(), [seq](const Message &m) { return m.seq == seq; }),
+					queue.end());
+		return SendResult::Failed;
+	}
+	// The backend may have stored it; the frame stays queued and is resent on this socket
+	return SendResult::Unknown;
+}
+
+bool BackendChannel::sendStatus(const SystemStatusDTO &status)
+{
+	return isConnected && enqueue("STATUS_EVENT", 0, [&status](JsonWriter &json) { status.toJson(json); }) != 0;
+}
+
+bool BackendChannel::sendLog(const SystemLogMessageDTO &message)
+{
+	return isConnected && enqueue("LOG_EVENT", 0, [&message](JsonWriter &json) { message.toJson(json); }) != 0;
+}
+
+BackendChannel::Stats BackendChannel::getStats() const
+{
+	Stats s;
+	s.connected = isConnected;
+	s.connects = connects.load();
+	s.disconnects = disconnects.load();
+	s.sent = sent.load();
+	s.acked = acked.load();
+	s.nacked = nacked.load();
+	s.resent = resent.load();
+	s.refused = refused.load();
+	s.commands = commands.load();
+	s.bytesOut = bytesOut.load();
+	s.bytesIn = bytesIn.load();
+	s.rttMs = rttMs.load();
+	s.reconnectDelayMs = reconnectDelayMs.load();
+
+	std::lock_guard<std::mutex> lock(queueMutex);
+	s.queued = queue.size();
+	s.inFlight = inFlight.size();
+	return s;
+}
+
+std::string BackendChannel::stateJson() const
+{
+	Stats s = getStats();
+
+	std::ostringstream json;
+	json << "{\"connected\":" << (s.connected ? "true" : "false")
+		 << ",\"url\":\"ws://" << config.host << ":" << config.port << config.path << "\""
+		 << ",\"connects\":" << s.connects
+		 << ",\"disconnects\":" << s.disconnects
+		 << ",\"reconnectDelayMs\":" << s.reconnectDelayMs
+		 << ",\"queued\":" << s.queued
+		 << ",\"inFlight\":" << s.inFlight
+		 << ",\"window\":" << config.window
+		 << ",\"sent\":" << s.sent
+		 << ",\"acked\":" << s.acked
+		 << ",\"nacked\":" << s.nacked
+		 << ",\"resent\":" << s.resent
+		 << ",\"refused\":" << s.refused
+		 << ",\"commands\":" << s.commands
+		 << ",\"bytesOut\":" << s.bytesOut
+		 << ",\"bytesIn\":" << s.bytesIn
+		 << ",\"rttMs\":" << s.rttMs << "}";
+	return json.str();
+}
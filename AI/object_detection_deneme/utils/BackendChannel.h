@@ -0,0 +1,219 @@
+/**
+ * BackendChannel.h
+ *
+ * One long-lived WebSocket (RFC 6455) connection to the backend's
+ * /websocket endpoint. Each decided product is queued as a
+ * NEW_PRODUCT_SCANS_EVENT RawEvent text frame ({"seq":N, "type":..., "event":...})
+ * and streamed over it instead of one TCP handshake per POST; at most
+ * `window` of them are unacknowledged at a time. The backend answers
+ * {"ack":N} once its handler stored the product and {"nack":N} when it
+ * could not; a bare "Server received" echo without either means no handler
+ * confirmed it and counts as a nack, so the caller falls back to the POST.
+ * Frames still in flight when the connection drops are resent after the
+ * reconnect, so a product that went out unanswered is reported as unknown
+ * rather than failed: posting it as well could store it twice. System
+ * status (STATUS_EVENT) and log messages (LOG_EVENT) use the same socket
+ * without waiting for the ack. Commands pushed by the backend (stop, start,
+ * reverse, speed) arrive on it too and are handed to the command handler.
+ */
+
+#ifndef BACKEND_CHANNEL_H
+#define BACKEND_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "scan_request_dto.h"
+#include "system_messages_dto.h"
+#include "system_status_dto.h"
+#include "json_writer.h"
+
+class BackendChannel
+{
+public:
+	struct Config
+	{
+		std::string host;
+		int port;
+		std::string path;
+		size_t window;               // unacknowledged frames in flight
+		size_t queueCapacity;        // queued frames; more are refused
+		int reconnectMinMs;
+		int reconnectMaxMs;
+		int pingIntervalMs;          // silence for three intervals drops the connection
+	};
+
+	struct Stats
+	{
+		bool connected = false;
+		unsigned long long connects = 0;
+		unsigned long long disconnects = 0;
+		unsigned long long sent = 0;
+		unsigned long long acked = 0;
+		unsigned long long nacked = 0;       // refused or not handled by the backend
+		unsigned long long resent = 0;
+		unsigned long long refused = 0;      // queue full
+		unsigned long long commands = 0;
+		unsigned long long bytesOut = 0;
+		unsigned long long bytesIn = 0;
+		size_t queued = 0;
+		size_t inFlight = 0;
+		double rttMs = 0;                    // last ping/pong round trip
+		int reconnectDelayMs = 0;
+	};
+
+	enum class SendResult
+	{
+		Stored,      // acknowledged by the backend
+		Failed,      // never went out, or refused; safe to send another way
+		Unknown      // went out unanswered; stays queued and is resent after a reconnect
+	};
+
+	// Command name ("stop", "start", "reverse", "speed=NN") -> response text
+	using CommandHandler = std::function<std::string(const std::string &)>;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Message
+	{
+		uint64_t seq;
+		uint64_t key;                // caller's product id, 0 for status and logs
+		std::string json;
+	};
+
+	Config config;
+
+	mutable std::mutex queueMutex;
+	std::condition_variable ackCond;
+	std::deque<Message> queue;       // not sent yet
+	std::deque<Message> inFlight;    // sent, waiting for the ack or nack
+	uint64_t nextSeq = 1;
+	uint64_t resolvedSeq = 0;        // acked or nacked up to here
+	uint64_t sentSeq = 0;            // written to a socket at least once up to here
+	std::deque<std::pair<uint64_t, bool>> resolvedKeys;    // recent products: key, stored
+
+	CommandHandler commandHandler;   // set before the first connect
+	std::mutex commandMutex;
+
+	int sock = -1;                   // owned by the channel thread
+	int wakeFd = -1;                 // eventfd, producers kick the channel thread
+	std::string rxBuffer;
+	std::string rxMessage;           // text message being reassembled from continuation frames
+	std::string txBuffer;
+	std::mt19937 rng;
+	Clock::time_point lastReceive;
+	Clock::time_point pingSent;
+	bool pingPending = false;
+
+	std::thread channelThread;
+	std::atomic<bool> stopping{false};
+	std::atomic<bool> isConnected{false};
+
+	std::atomic<unsigned long long> connects{0};
+	std::atomic<unsigned long long> disconnects{0};
+	std::atomic<unsigned long long> sent{0};
+	std::atomic<unsigned long long> acked{0};
+	std::atomic<unsigned long long> nacked{0};
+	std::atomic<unsigned long long> resent{0};
+	std::atomic<unsigned long long> refused{0};
+	std::atomic<unsigned long long> commands{0};
+	std::atomic<unsigned long long> bytesOut{0};
+	std::atomic<unsigned long long> bytesIn{0};
+	std::atomic<double> rttMs{0};
+	std::atomic<int> reconnectDelayMs{0};
+
+	void channelLoop();
+	bool connectSocket();
+	bool handshake();
+	void disconnect();
+	bool pump();
+	bool sendFrame(uint8_t opcode, const char *data, size_t size);
+	bool sendAll(const char *data, size_t size);
+	bool readFrames();
+	void handleText(const std::string &text);
+	void handleAck(uint64_t seq, bool stored);
+	void handleCommand(const std::string &text);
+	uint64_t enqueue(const char *type, uint64_t key, const std::function<void(JsonWriter &)> &writeData);
+	bool takeResolved(uint64_t key, bool &stored);
+	void wakeUp();
+
+public:
+	/**
+	 * Constructor - starts the channel thread, which connects and reconnects on its own
+	 *
+	 * @param cfg Backend endpoint, window, queue and reconnect settings
+	 */
+	explicit BackendChannel(const Config &cfg);
+
+	/**
+	 * Destructor - closes the connection and stops the thread
+	 */
+	~BackendChannel();
+
+	BackendChannel(const BackendChannel&) = delete;
+	BackendChannel& operator=(const BackendChannel&) = delete;
+
+	/**
+	 * Set who executes commands pushed by the backend
+	 */
+	void setCommandHandler(CommandHandler handler);
+
+	/**
+	 * Stream the scans of one product and wait until the backend stored it
+	 *
+	 * A product whose earlier frame is still queued or was already answered is
+	 * settled from that frame instead of being sent again.
+	 *
+	 * @param key Stable id of the product, the same on every retry
+	 * @param scans Scans of one product
+	 * @param timeoutMs How long to wait for the ack
+	 * @return Failed if not connected, nacked, or withdrawn unsent at the timeout;
+	 *         Unknown if it went out and is still unanswered
+	 */
+	SendResult sendScans(uint64_t key, const std::vector<ScanRequestDTO> &scans, int timeoutMs);
+
+	/**
+	 * Queue a system status sample as a STATUS_EVENT, without waiting for the ack
+	 *
+	 * @return false if not connected or the queue is full
+	 */
+	bool sendStatus(const SystemStatusDTO &status);
+
+	/**
+	 * Queue a log message as a LOG_EVENT, without waiting for the ack
+	 *
+	 * @return false if not connected or the queue is full
+	 */
+	bool sendLog(const SystemLogMessageDTO &message);
+
+	/**
+	 * Whether the WebSocket is currently open
+	 */
+	bool connected() const { return isConnected; }
+
+	/**
+	 * Close the connection and stop the thread
+	 */
+	void stop();
+
+	/**
+	 * Get a copy of the counters
+	 */
+	Stats getStats() const;
+
+	/**
+	 * Get the counters as a JSON object
+	 */
+	std::string stateJson() const;
+};
+
+#endif // BACKEND_CHANNEL_H
@@ -0,0 +1,233 @@
+/**
+ * BeltSpeedController.cpp
+ *
+ * Implementation of the closed-loop belt speed controller.
+ */
+
+#include "BeltSpeedController.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Constructor
+BeltSpeedController::BeltSpeedController(std::function<std::string(const std::string &)> command, std::function<size_t()> backlog,
+										 const Config &cfg)
+	: sendCommand(std::move(command)), backlogProbe(std::move(backlog)), config(cfg)
+{
+	state.speedPercent = config.startPercent;
+}
+
+// Destructor
+BeltSpeedController::~BeltSpeedController()
+{
+	stop();
+}
+
+void BeltSpeedController::start()
+{
+	if (running.exchange(true))
+		return;
+	controlThread = std::thread(&BeltSpeedController::controlLoop, this);
+}
+
+void BeltSpeedController::stop()
+{
+	running = false;
+	if (controlThread.joinable())
+		controlThread.join();
+}
+
+void BeltSpeedController::setEnabled(bool on)
+{
+	if (enabled.exchange(on) == on)
+		return;
+
+	// Drop whatever accumulated while we were not in charge
+	latencySumUs = 0;
+	latencyCount = 0;
+	windowMisses = 0;
+
+	std::lock_guard<std::mutex> lock(stateMutex);
+	state.enabled = on;
+	state.healthyStreak = 0;
+	state.lastAction = on ? "enabled" : "disabled";
+	if (on)
+		state.speedPercent = std::clamp(state.speedPercent, config.minPercent, config.maxPercent);
+}
+
+bool BeltSpeedController::isEnabled() const
+{
+	return enabled;
+}
+
+void BeltSpeedController::noteManualOverride(const std::string &command)
+{
+	setEnabled(false);
+
+	std::lock_guard<std::mutex> lock(stateMutex);
+	state.lastAction = "manual " + command;
+}
+
+void BeltSpeedController::noteManualSpeed(int percent)
+{
+	noteManualOverride("speed");
+
+	std::lock_guard<std::mutex> lock(stateMutex);
+	state.speedPercent = percent;
+}
+
+void BeltSpeedController::reportInferenceLatency(double latencyMs)
+{
+	latencySumUs += static_cast<unsigned long long>(std::max(0.0, latencyMs) * 1000.0);
+	++latencyCount;
+}
+
+void BeltSpeedController::reportDecision(bool deadlineMissed)
+{
+	++decisions;
+	if (deadlineMissed)
+	{
+		++windowMisses;
+		++totalMisses;
+	}
+}
+
+// Background thread: one control tick per period
+void BeltSpeedController::controlLoop()
+{
+	set_thread_name("speed-ctl");
+	bool applied = false;
+	while (running)
+	{
+		for (int waited = 0; waited < config.periodMs && running; waited += 50)
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		if (!running)
+			break;
+
+		if (!enabled)
+		{
+			applied = false;
+			continue;
+		}
+
+		// First tick after switching on: move to the clamped start speed
+		if (!applied)
+		{
+			int percent;
+			{
+				std::lock_guard<std::mutex> lock(stateMutex);
+				percent = state.speedPercent;
+			}
+			applied = applySpeed(percent, "engage");
+			continue;
+		}
+
+		tick();
+	}
+}
+
+// One control step with hysteresis: back off fast, speed up slowly
+void BeltSpeedController::tick()
+{
+	size_t backlog = backlogProbe ? backlogProbe() : 0;
+	unsigned count = latencyCount.exchange(0);
+	unsigned long long sumUs = latencySumUs.exchange(0);
+	unsigned misses = windowMisses.exchange(0);
+	double meanMs = count ? (sumUs / 1000.0) / count : 0.0;
+
+	bool pressure = misses > 0 || backlog >= config.backlogHigh || meanMs >= config.latencyHighMs;
+	bool healthy = misses == 0 && backlog <= config.backlogLow && meanMs <= config.latencyLowMs;
+
+	int target;
+	std::string action;
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		state.backlog = backlog;
+		state.meanLatencyMs = meanMs;
+		state.windowMisses = misses;
+		state.totalMisses = totalMisses;
+		state.decisions = decisions;
+
+		target = state.speedPercent;
+		if (pressure)
+		{
+			state.healthyStreak = 0;
+			target = std::max(config.minPercent, state.speedPercent - config.stepDownPercent);
+			action = "back-off";
+		}
+		else if (healthy)
+		{
+			if (++state.healthyStreak >= config.healthyTicks)
+			{
+				state.healthyStreak = 0;
+				target = std::min(config.maxPercent, state.speedPercent + config.stepUpPercent);
+				action = "speed-up";
+			}
+		}
+		else
+		{
+			// inside the hysteresis band: hold speed, restart the healthy streak
+			state.healthyStreak = 0;
+		}
+
+		if (target == state.speedPercent)
+		{
+			state.lastAction = action.empty() ? "hold" : action + " (at limit)";
+			return;
+		}
+	}
+
+	applySpeed(target, action);
+}
+
+bool BeltSpeedController::applySpeed(int percent, const std::string &action)
+{
+	std::string response = sendCommand ? sendCommand("speed=" + std::to_string(percent)) : "Arduino not connected.";
+
+	std::cout << "[speed-controller] " << action << " -> " << percent << "% (" << response << ")" << std::endl;
+
+	// Without the acknowledgement the belt is still at the old speed; the next tick tries again
+	std::lock_guard<std::mutex> lock(stateMutex);
+	if (response.rfind("OK:PCT", 0) != 0)
+	{
+		state.lastAction = action + " (failed)";
+		return false;
+	}
+	state.speedPercent = percent;
+	state.lastAction = action;
+	return true;
+}
+
+BeltSpeedController::State BeltSpeedController::getState() const
+{
+	std::lock_guard<std::mutex> lock(stateMutex);
+	State copy = state;
+	copy.enabled = enabled;
+	copy.totalMisses = totalMisses;
+	copy.decisions = decisions;
+	return copy;
+}
+
+std::string BeltSpeedController::stateJson() const
+{
+	State s = getState();
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(2);
+	json << "{\"enabled\":" << (s.enabled ? "true" : "false")
+		 << ",\"speedPercent\":" << s.speedPercent
+		 << ",\"minPercent\":" << config.minPercent
+		 << ",\"maxPercent\":" << config.maxPercent
+		 << ",\"backlog\":" << s.backlog
+		 << ",\"meanInferenceLatencyMs\":" << s.meanLatencyMs
+		 << ",\"windowDeadlineMisses\":" << s.windowMisses
+		 << ",\"totalDeadlineMisses\":" << s.totalMisses
+		 << ",\"decisions\":" << s.decisions
+		 << ",\"healthyStreak\":" << s.healthyStreak
+		 << ",\"lastAction\":\"" << s.lastAction << "\"}";
+	return json.str();
+}
@@ -0,0 +1,151 @@
+/**
+ * BeltSpeedController.h
+ *
+ * Closed-loop belt speed controller. Watches the pipeline backlog,
+ * inference latency and decision deadline misses, and drives the belt
+ * to the fastest speed the pipeline sustains. Speed changes go through
+ * the actuator queue like every other Arduino write, so they are refused
+ * while an operator stop is latched.
+ */
+
+#ifndef BELT_SPEED_CONTROLLER_H
+#define BELT_SPEED_CONTROLLER_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class BeltSpeedController
+{
+public:
+	struct Config
+	{
+		int minPercent;          // safety floor, never go slower while in auto mode
+		int maxPercent;          // safety ceiling
+		int startPercent;        // assumed belt speed until a manual or automatic change
+		int stepUpPercent;       // gentle increase after a healthy streak
+		int stepDownPercent;     // fast back-off under pressure
+		int periodMs;            // control tick
+		size_t backlogHigh;      // queued frames that count as pressure
+		size_t backlogLow;       // queued frames that count as healthy
+		double latencyHighMs;    // mean inference latency that counts as pressure
+		double latencyLowMs;     // mean inference latency that counts as healthy
+		int healthyTicks;        // consecutive healthy ticks before speeding up
+	};
+
+	struct State
+	{
+		bool enabled = false;
+		int speedPercent = 0;
+		size_t backlog = 0;
+		double meanLatencyMs = 0.0;
+		unsigned windowMisses = 0;
+		unsigned long long totalMisses = 0;
+		unsigned long long decisions = 0;
+		int healthyStreak = 0;
+		std::string lastAction = "idle";
+	};
+
+private:
+	std::function<std::string(const std::string &)> sendCommand;
+	std::function<size_t()> backlogProbe;
+	Config config;
+
+	std::thread controlThread;
+	std::atomic<bool> running{false};
+	std::atomic<bool> enabled{false};
+
+	// Per-window samples, written by pipeline threads and drained each tick
+	std::atomic<unsigned long long> latencySumUs{0};
+	std::atomic<unsigned> latencyCount{0};
+	std::atomic<unsigned> windowMisses{0};
+	std::atomic<unsigned long long> totalMisses{0};
+	std::atomic<unsigned long long> decisions{0};
+
+	mutable std::mutex stateMutex;
+	State state;
+
+	void controlLoop();
+	void tick();
+	bool applySpeed(int percent, const std::string &action);   // false if the Arduino did not acknowledge
+
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param command Runs one command ("speed=NN") through the actuator queue and returns the reply
+	 * @param backlog Returns the number of frames waiting in the pipeline
+	 * @param cfg Limits and hysteresis bands
+	 */
+	BeltSpeedController(std::function<std::string(const std::string &)> command, std::function<size_t()> backlog,
+						const Config &cfg);
+
+	/**
+	 * Destructor - stops the control thread
+	 */
+	~BeltSpeedController();
+
+	/**
+	 * Start the control thread (auto mode stays as configured)
+	 */
+	void start();
+
+	/**
+	 * Stop the control thread
+	 */
+	void stop();
+
+	/**
+	 * Switch automatic speed control on or off
+	 *
+	 * @param on true to let the controller drive the belt
+	 */
+	void setEnabled(bool on);
+
+	/**
+	 * Check whether automatic speed control is active
+	 */
+	bool isEnabled() const;
+
+	/**
+	 * Record a manual motion command (stop, start, reverse, direction); takes the belt out of auto mode
+	 *
+	 * @param command Command sent by the operator
+	 */
+	void noteManualOverride(const std::string &command);
+
+	/**
+	 * Record a manual speed change; takes the belt out of auto mode
+	 *
+	 * @param percent Speed set by the operator
+	 */
+	void noteManualSpeed(int percent);
+
+	/**
+	 * Record the accelerator latency of one frame (thread-safe)
+	 *
+	 * @param latencyMs Time between infer submission and completion
+	 */
+	void reportInferenceLatency(double latencyMs);
+
+	/**
+	 * Record a sorting decision (thread-safe)
+	 *
+	 * @param deadlineMissed true if the servo command came too late
+	 */
+	void reportDecision(bool deadlineMissed);
+
+	/**
+	 * Get a copy of the controller state
+	 */
+	State getState() const;
+
+	/**
+	 * Get the controller state as a JSON object
+	 */
+	std::string stateJson() const;
+};
+
+#endif // BELT_SPEED_CONTROLLER_H
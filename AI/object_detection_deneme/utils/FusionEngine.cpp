@@ -0,0 +1,236 @@
+/**
+ * FusionEngine.cpp
+ *
+ * Implementation of the per-product confidence fusion.
+ */
+
+#include "FusionEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const char *PRODUCT_NAMES[FusionEngine::PRODUCT_COUNT] = {"Apple", "Potato", "Orange"};
+
+// Constructor
+FusionEngine::FusionEngine(const Settings &initial)
+	: settings(initial)
+{
+}
+
+bool FusionEngine::parseLabel(const std::string &label, Produce &product, Condition &condition)
+{
+	size_t sep = label.find('_');
+	if (sep == std::string::npos)
+		return false;
+
+	bool found = false;
+	for (size_t i = 0; i < PRODUCT_COUNT; i++)
+	{
+		if (label.compare(0, sep, PRODUCT_NAMES[i]) == 0)
+		{
+			product = static_cast<Produce>(i);
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+		return false;
+
+	if (label.compare(sep + 1, std::string::npos, "Healthy") == 0)
+		condition = Condition::Healthy;
+	else if (label.compare(sep + 1, std::string::npos, "Rotten") == 0)
+		condition = Condition::Rotten;
+	else
+		return false;
+	return true;
+}
+
+const char *FusionEngine::productName(Produce product)
+{
+	return PRODUCT_NAMES[static_cast<size_t>(product)];
+}
+
+bool FusionEngine::productFromName(const std::string &name, Produce &product)
+{
+	for (size_t i = 0; i < PRODUCT_COUNT; i++)
+	{
+		if (name == PRODUCT_NAMES[i])
+		{
+			product = static_cast<Produce>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FusionEngine::loadCalibration(const std::string &path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+		return false;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		std::string name;
+		double a, b;
+		Produce product;
+		if (!(fields >> name >> a >> b) || !productFromName(name, product))
+		{
+			std::cerr << "Ignoring calibration line: " << line << std::endl;
+			continue;
+		}
+		platt[static_cast<size_t>(product)] = Platt{a, b, true};
+		std::cout << "Calibration for " << name << ": A=" << a << " B=" << b << std::endl;
+	}
+	return true;
+}
+
+double FusionEngine::calibrate(Produce product, float confidence) const
+{
+	const Platt &p = platt[static_cast<size_t>(product)];
+	if (!p.enabled)
+		return confidence;
+	return 1.0 / (1.0 + std::exp(p.a * confidence + p.b));
+}
+
+FusionEngine::Decision FusionEngine::decide(const std::vector<Detection> &detections)
+{
+	Settings s = settings.load();
+	Decision decision;
+
+	auto weightOf = [&s](int camId) {
+		return (camId >= 0 && static_cast<size_t>(camId) < MAX_CAMERAS) ? s.cameraWeight[camId] : 1.0;
+	};
+
+	// Which product is on the belt: weighted, calibrated vote
+	double productVote[PRODUCT_COUNT] = {};
+	double totalVote = 0.0;
+	for (const auto &d : detections)
+	{
+		double vote = weightOf(d.camId) * calibrate(d.product, d.confidence);
+		productVote[static_cast<size_t>(d.product)] += vote;
+		totalVote += vote;
+	}
+	size_t winner = std::max_element(productVote, productVote + PRODUCT_COUNT) - productVote;
+	decision.product = static_cast<Produce>(winner);
+	decision.threshold = s.productThreshold[winner];
+
+	if (totalVote <= 0.0 || productVote[winner] < s.minProductAgreement * totalVote)
+	{
+		// nothing usable, or the cameras disagree on what the product is
+		++uncertainCount;
+		return decision;
+	}
+
+	// Health of the winning product: +p for Healthy views, -p for Rotten ones
+	double weighted = 0.0, weights = 0.0;
+	bool vetoed = false;
+	for (const auto &d : detections)
+	{
+		if (d.product != decision.product)
+			continue;
+		double w = weightOf(d.camId);
+		double p = calibrate(d.product, d.confidence);
+		if (d.condition == Condition::Rotten && p >= s.rottenVeto && w > 0.0)
+			vetoed = true;
+		weighted += w * (d.condition == Condition::Healthy ? p : -p);
+		weights += w;
+	}
+	decision.score = weights > 0.0 ? 100.0 * weighted / weights : 0.0;
+
+	if (vetoed)
+		decision.outcome = FusionOutcome::Rotten;
+	else if (decision.score >= decision.threshold)
+		decision.outcome = FusionOutcome::Healthy;
+	else if (decision.score >= decision.threshold - s.uncertainBand)
+		decision.outcome = FusionOutcome::Uncertain;
+	else
+		decision.outcome = FusionOutcome::Rotten;
+
+	switch (decision.outcome)
+	{
+	case FusionOutcome::Healthy: ++healthyCount; break;
+	case FusionOutcome::Rotten: ++rottenCount; break;
+	case FusionOutcome::Uncertain: ++uncertainCount; break;
+	}
+	return decision;
+}
+
+// NaN compares false both ways, so it would pass a plain range check and then fail every product
+static bool validThreshold(double percent)
+{
+	return std::isfinite(percent) && percent >= 0.0 && percent <= 100.0;
+}
+
+bool FusionEngine::setThreshold(double percent)
+{
+	if (!validThreshold(percent))
+		return false;
+	settings.update([percent](Settings &s) {
+		std::fill(s.productThreshold, s.productThreshold + PRODUCT_COUNT, percent);
+	});
+	return true;
+}
+
+bool FusionEngine::setThreshold(Produce product, double percent)
+{
+	if (!validThreshold(percent))
+		return false;
+	settings.update([product, percent](Settings &s) {
+		s.productThreshold[static_cast<size_t>(product)] = percent;
+	});
+	return true;
+}
+
+bool FusionEngine::setCameraWeight(int camId, double weight)
+{
+	if (camId < 0 || static_cast<size_t>(camId) >= MAX_CAMERAS || !std::isfinite(weight) || weight < 0.0)
+		return false;
+	settings.update([camId, weight](Settings &s) {
+		s.cameraWeight[camId] = weight;
+	});
+	return true;
+}
+
+FusionEngine::Settings FusionEngine::getSettings() const
+{
+	return settings.load();
+}
+
+std::string FusionEngine::stateJson() const
+{
+	Settings s = settings.load();
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(2);
+	json << "{\"thresholds\":{";
+	for (size_t i = 0; i < PRODUCT_COUNT; i++)
+		json << (i ? "," : "") << "\"" << PRODUCT_NAMES[i] << "\":" << s.productThreshold[i];
+	json << "},\"cameraWeights\":[";
+	for (size_t i = 0; i < MAX_CAMERAS; i++)
+		json << (i ? "," : "") << s.cameraWeight[i];
+	json << "],\"calibrated\":[";
+	bool first = true;
+	for (size_t i = 0; i < PRODUCT_COUNT; i++)
+	{
+		if (!platt[i].enabled)
+			continue;
+		json << (first ? "" : ",") << "\"" << PRODUCT_NAMES[i] << "\"";
+		first = false;
+	}
+	json << "],\"uncertainBand\":" << s.uncertainBand
+		 << ",\"rottenVeto\":" << s.rottenVeto
+		 << ",\"minProductAgreement\":" << s.minProductAgreement
+		 << ",\"healthy\":" << healthyCount.load()
+		 << ",\"rotten\":" << rottenCount.load()
+		 << ",\"uncertain\":" << uncertainCount.load() << "}";
+	return json.str();
+}
@@ -0,0 +1,145 @@
+/**
+ * FusionEngine.h
+ *
+ * Turns the per-camera detections of one product into a sorting decision.
+ * Detections are typed (product, condition, confidence) instead of
+ * "Apple_Rotten" strings; confidences are calibrated per product (Platt
+ * scaling), weighted per camera and compared against a per-product
+ * threshold. Products the cameras cannot agree on go to the reject lane as
+ * Uncertain. Thresholds and weights live in a SeqLock snapshot so the
+ * HTTP handlers can change them while post-process reads them lock-free.
+ */
+
+#ifndef FUSION_ENGINE_H
+#define FUSION_ENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "seqlock.hpp"
+
+enum class Produce : uint8_t { Apple = 0, Potato = 1, Orange = 2 };
+enum class Condition : uint8_t { Healthy = 0, Rotten = 1 };
+enum class FusionOutcome : uint8_t { Healthy, Rotten, Uncertain };
+
+struct Detection
+{
+	Produce product;
+	Condition condition;
+	float confidence;      // detector/classifier confidence, 0..1
+	int camId;
+};
+
+class FusionEngine
+{
+public:
+	static constexpr size_t PRODUCT_COUNT = 3;
+	static constexpr size_t MAX_CAMERAS = 8;
+
+	struct Settings
+	{
+		double productThreshold[PRODUCT_COUNT];   // fused health score (percent) needed to accept
+		double cameraWeight[MAX_CAMERAS];         // per camera id, 0 mutes a camera
+		double uncertainBand;                     // percent below the threshold that is Uncertain, not Rotten
+		double rottenVeto;                        // calibrated probability at which one Rotten view decides
+		double minProductAgreement;               // share of the vote the winning product needs
+	};
+
+	struct Decision
+	{
+		FusionOutcome outcome = FusionOutcome::Uncertain;
+		Produce product = Produce::Apple;
+		double score = 0.0;        // -100 (surely rotten) .. 100 (surely healthy)
+		double threshold = 0.0;
+	};
+
+private:
+	struct Platt
+	{
+		double a = 0.0;
+		double b = 0.0;
+		bool enabled = false;
+	};
+
+	SeqLock<Settings> settings;
+	Platt platt[PRODUCT_COUNT];     // written once by loadCalibration, before decisions start
+
+	std::atomic<unsigned long long> healthyCount{0};
+	std::atomic<unsigned long long> rottenCount{0};
+	std::atomic<unsigned long long> uncertainCount{0};
+
+	double calibrate(Produce product, float confidence) const;
+
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param initial Thresholds, camera weights and bands to start with
+	 */
+	explicit FusionEngine(const Settings &initial);
+
+	/**
+	 * Map a detector label such as "Apple_Rotten" to its typed form
+	 *
+	 * @return false for labels that are not a known product/condition
+	 */
+	static bool parseLabel(const std::string &label, Produce &product, Condition &condition);
+
+	/**
+	 * Name of a product as used in labels, thresholds and the calibration file
+	 */
+	static const char *productName(Produce product);
+
+	/**
+	 * Look up a product by name (case sensitive, "Apple")
+	 */
+	static bool productFromName(const std::string &name, Produce &product);
+
+	/**
+	 * Load Platt scaling parameters, one "<Product> <A> <B>" line per product;
+	 * calibrated = 1 / (1 + exp(A * confidence + B)). Call before decisions start.
+	 * Products without a line keep the raw confidence.
+	 *
+	 * @return false if the file could not be opened
+	 */
+	bool loadCalibration(const std::string &path);
+
+	/**
+	 * Fuse the detections of one product (one per camera)
+	 */
+	Decision decide(const std::vector<Detection> &detections);
+
+	/**
+	 * Set the acceptance threshold of every product (percent)
+	 *
+	 * @return false if percent is not a finite value in [0, 100]; nothing is changed then
+	 */
+	bool setThreshold(double percent);
+
+	/**
+	 * Set the acceptance threshold of one product (percent)
+	 *
+	 * @return false if percent is not a finite value in [0, 100]; nothing is changed then
+	 */
+	bool setThreshold(Produce product, double percent);
+
+	/**
+	 * Set the weight of one camera
+	 *
+	 * @return false if camId is out of range or weight is negative or not finite
+	 */
+	bool setCameraWeight(int camId, double weight);
+
+	/**
+	 * Get the current settings snapshot
+	 */
+	Settings getSettings() const;
+
+	/**
+	 * Get settings and outcome counters as a JSON object
+	 */
+	std::string stateJson() const;
+};
+
+#endif // FUSION_ENGINE_H
@@ -1,8 +1,9 @@
 #include "HttpServerHandler.hpp"
+#include "Metrics.h"
+#include <algorithm>
+#include <cctype>
 
 
-extern double threshold;
-
 HttpServerHandler::HttpServerHandler(ArduinoSerial *arduinoPtr)
     : arduino(arduinoPtr) {}
 
@@ -10,6 +11,10 @@ void HttpServerHandler::Init()
 {
     server.set_logger([](const httplib::Request &req, const httplib::Response &res)
     {
+        // Scrapers poll /metrics every few seconds; keep them out of the log
+        if (req.path == "/metrics" && res.status == 200)
+            return;
+
         std::cout << "[HTTP] " << req.method << " " << req.path
                   << " => " << res.status << std::endl;
 
@@ -19,18 +24,15 @@ void HttpServerHandler::Init()
         }
     });
 
+    // control routes only queue the command; poll /commands/{id} for the Arduino's reply
     server.Post("/rev", [this](const httplib::Request &, httplib::Response &res)
     {
-        std::string response = handleCommand("reverse");
-        std::cout << "[/rev] Response: " << response << std::endl;
-        res.set_content(response, "text/plain");
+        enqueueCommand("reverse", res);
     });
 
     server.Post("/stop", [this](const httplib::Request &, httplib::Response &res)
     {
-        std::string response = handleCommand("stop");
-        std::cout << "[/stop] Response: " << response << std::endl;
-        res.set_content(response, "text/plain");
+        enqueueCommand("stop", res);
     });
 
     server.Post("/speed", [this](const httplib::Request &req, httplib::Response &res)
@@ -41,9 +43,9 @@ void HttpServerHandler::Init()
         try
         {
             int percent = std::stoi(body);
-            std::string response = arduino->setSpeed(percent);
-            std::cout << "[/speed] Response: " << response << std::endl;
-            res.set_content(response, "text/plain");
+            if (percent < 0 || percent > 100)
+                throw std::out_of_range("use 0-100");
+            enqueueCommand("speed=" + std::to_string(percent), res);
         }
         catch (const std::exception &e)
         {
@@ -53,6 +55,29 @@ void HttpServerHandler::Init()
             res.status = 400;
         }
     });
+
+    server.Get(R"(/commands/(\d+))", [this](const httplib::Request &req, httplib::Response &res)
+    {
+        ActuatorQueue::Command command;
+        if (!actuatorQueue || !actuatorQueue->lookup(std::stoull(req.matches[1]), command))
+        {
+            res.set_content("ERR: Unknown command id", "text/plain");
+            res.status = 404;
+            return;
+        }
+        res.set_content(ActuatorQueue::commandJson(command), "application/json");
+    });
+
+    server.Get("/commands", [this](const httplib::Request &, httplib::Response &res)
+    {
+        if (!actuatorQueue)
+        {
+            res.set_content("ERR: Actuator queue not available", "text/plain");
+            res.status = 404;
+            return;
+        }
+        res.set_content(actuatorQueue->stateJson(), "application/json");
+    });
     
     
     server.Post("/threshold", [this](const httplib::Request &req, httplib::Response &res)
@@ -60,14 +85,35 @@ void HttpServerHandler::Init()
         std::string body = req.body;
         std::cout << "[/threshold] Received body: " << body << std::endl;
 
+        if (!fusionEngine)
+        {
+            res.set_content("ERR: Fusion engine not available", "text/plain");
+            res.status = 404;
+            return;
+        }
+
+        // "70" sets every product, "Apple=65" one product
         try
         {
-            double percent = std::stod(body);
-            threshold = percent;
+            size_t eq = body.find('=');
+            bool accepted;
+            if (eq == std::string::npos)
+            {
+                accepted = fusionEngine->setThreshold(std::stod(body));
+            }
+            else
+            {
+                Produce product;
+                if (!FusionEngine::productFromName(body.substr(0, eq), product))
+                    throw std::invalid_argument("unknown product " + body.substr(0, eq));
+                accepted = fusionEngine->setThreshold(product, std::stod(body.substr(eq + 1)));
+            }
+            if (!accepted)
+                throw std::out_of_range("must be a number from 0 to 100");
             std::string response = "Threshold changed";
             std::cout << "[/threshold] Response: " << response << std::endl;
             res.set_content(response, "text/plain");
-            std::cout << "New threshold value:" << threshold << std::endl;
+            std::cout << "New thresholds: " << fusionEngine->stateJson() << std::endl;
         }
         catch (const std::exception &e)
         {
@@ -77,6 +123,183 @@ void HttpServerHandler::Init()
             res.status = 400;
         }
     });
+
+    server.Get("/fusion", [this](const httplib::Request &, httplib::Response &res)
+    {
+        if (!fusionEngine)
+        {
+            res.set_content("ERR: Fusion engine not available", "text/plain");
+            res.status = 404;
+            return;
+        }
+        res.set_content(fusionEngine->stateJson(), "application/json");
+    });
+
+    // body "<camId>=<weight>", weight 0 ignores the camera
+    server.Post("/fusion/weight", [this](const httplib::Request &req, httplib::Response &res)
+    {
+        if (!fusionEngine)
+        {
+            res.set_content("ERR: Fusion engine not available", "text/plain");
+            res.status = 404;
+            return;
+        }
+
+        try
+        {
+            size_t eq = req.body.find('=');
+            if (eq == std::string::npos)
+                throw std::invalid_argument("expected <camId>=<weight>");
+            if (!fusionEngine->setCameraWeight(std::stoi(req.body.substr(0, eq)), std::stod(req.body.substr(eq + 1))))
+                throw std::out_of_range("camera id out of range, or weight negative or not a number");
+            res.set_content(fusionEngine->stateJson(), "application/json");
+        }
+        catch (const std::exception &e)
+        {
+            res.set_content("ERR: Invalid weight - " + std::string(e.what()), "text/plain");
+            res.status = 400;
+        }
+    });
+
+    server.Get("/controller", [this](const httplib::Request &, httplib::Response &res)
+    {
+        if (!speedController)
+        {
+            res.set_content("ERR: Speed controller not available", "text/plain");
+            res.status = 404;
+            return;
+        }
+        res.set_content(speedController->stateJson(), "application/json");
+    });
+
+    server.Post("/controller", [this](const httplib::Request &req, httplib::Response &res)
+    {
+        if (!speedController)
+        {
+            res.set_content("ERR: Speed controller not available", "text/plain");
+            res.status = 404;
+            return;
+        }
+
+        std::string body = req.body;
+        body.erase(std::remove_if(body.begin(), body.end(), ::isspace), body.end());
+
+        if ((body == "on" || body == "auto") && actuatorQueue && actuatorQueue->stopLatched())
+        {
+            // auto mode would restart a belt the operator stopped
+            res.set_content("ERR: Belt stopped, send start first", "text/plain");
+            res.status = 409;
+            return;
+        }
+        if (body == "on" || body == "auto")
+            speedController->setEnabled(true);
+        else if (body == "off" || body == "manual")
+            speedController->setEnabled(false);
+        else
+        {
+            res.set_content("ERR: Use on/off", "text/plain");
+            res.status = 400;
+            return;
+        }
+        res.set_content(speedController->stateJson(), "application/json");
+    });
+
+    server.Get("/metrics", [](const httplib::Request &, httplib::Response &res)
+    {
+        res.set_content(Metrics::global().render(), Metrics::CONTENT_TYPE);
+    });
+}
+
+void HttpServerHandler::SetSpeedController(BeltSpeedController *controller)
+{
+    speedController = controller;
+}
+
+void HttpServerHandler::SetFusionEngine(FusionEngine *engine)
+{
+    fusionEngine = engine;
+}
+
+void HttpServerHandler::SetActuatorQueue(ActuatorQueue *queue)
+{
+    actuatorQueue = queue;
+}
+
+void HttpServerHandler::AddJsonEndpoint(const std::string &path, std::function<std::string()> provider)
+{
+    server.Get(path, [provider](const httplib::Request &, httplib::Response &res)
+    {
+        res.set_content(provider(), "application/json");
+    });
+}
+
+std::string HttpServerHandler::HandleCommand(const std::string &cmd, ActuatorQueue::Priority priority)
+{
+    if (priority == ActuatorQueue::Priority::Auto || priority == ActuatorQueue::Priority::Sort)
+        return handleCommand(cmd);
+
+    // Any manual motion command is an override, even if the Arduino did not confirm it,
+    // so auto mode cannot undo a stop or a direction change on its next tick
+    bool motion = cmd == "start" || cmd == "stop" || cmd == "reverse" || cmd.rfind("dir=", 0) == 0;
+    if (speedController && motion)
+        speedController->noteManualOverride(cmd);
+
+    std::string response = handleCommand(cmd);
+    if (speedController && cmd.rfind("speed=", 0) == 0)
+    {
+        if (response.rfind("OK:PCT", 0) == 0)
+            speedController->noteManualSpeed(std::stoi(cmd.substr(6)));
+        else
+            speedController->noteManualOverride(cmd);
+    }
+    else if (speedController && cmd == "stop" && response.rfind("OK:STOP", 0) == 0)
+        speedController->noteManualSpeed(0);
+    return response;
+}
+
+void HttpServerHandler::AddJsonQueryEndpoint(const std::string &path, std::function<std::string(const httplib::Request &)> provider)
+{
+    server.Get(path, [provider](const httplib::Request &req, httplib::Response &res)
+    {
+        try
+        {
+            res.set_content(provider(req), "application/json");
+        }
+        catch (const std::exception &e)
+        {
+            res.set_content("ERR: " + std::string(e.what()), "text/plain");
+            res.status = 400;
+        }
+    });
+}
+
+uint64_t HttpServerHandler::SubmitCommand(const std::string &cmd)
+{
+    if (!actuatorQueue)
+        return 0;
+    return actuatorQueue->submit(cmd, cmd == "stop" ? ActuatorQueue::Priority::Stop : ActuatorQueue::Priority::Normal);
+}
+
+// 202 with the command id, 503 when the queue is full
+void HttpServerHandler::enqueueCommand(const std::string &cmd, httplib::Response &res)
+{
+    uint64_t id = SubmitCommand(cmd);
+    if (id == 0)
+    {
+        res.set_content("ERR: Actuator queue full", "text/plain");
+        res.status = 503;
+        return;
+    }
+
+    ActuatorQueue::Command command;
+    if (!actuatorQueue->lookup(id, command))
+    {
+        command.id = id;
+        command.command = cmd;
+    }
+    res.set_header("Location", "/commands/" + std::to_string(id));
+    res.set_content(ActuatorQueue::commandJson(command), "application/json");
+    res.status = 202;
 }
 
 void HttpServerHandler::Start()
@@ -138,6 +361,11 @@ std::string HttpServerHandler::handleCommand(const std::string &cmd)
             int angle = std::stoi(cmd.substr(6));
             return arduino->setServoAngle(angle);
         }
+        if (cmd.rfind("dint=", 0) == 0)
+        {
+            int intervalMs = std::stoi(cmd.substr(5));
+            return arduino->setDistanceInterval(intervalMs);
+        }
 
         // Handle exact match commands
         auto it = commandMap.find(cmd);
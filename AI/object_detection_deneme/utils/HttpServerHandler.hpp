@@ -4,7 +4,11 @@
 #include <httplib.h>
 #include <iostream>
 #include <string>
+#include <functional>
 #include "ArduinoSerial.h" // Make sure this path is correct for your project
+#include "BeltSpeedController.h"
+#include "FusionEngine.h"
+#include "ActuatorQueue.h"
 
 class HttpServerHandler
 {
@@ -15,12 +19,24 @@ public:
     bool Bind();
     void Start();
     void Stop();
+    void SetSpeedController(BeltSpeedController* controller);
+    void SetFusionEngine(FusionEngine* engine);
+    void SetActuatorQueue(ActuatorQueue* queue);
+    void AddJsonEndpoint(const std::string& path, std::function<std::string()> provider);
+    void AddJsonQueryEndpoint(const std::string& path, std::function<std::string(const httplib::Request&)> provider);   // provider throws on bad parameters
+    // runs a command on the Arduino; the actuator queue's worker calls this. Auto commands are not operator overrides
+    std::string HandleCommand(const std::string& cmd, ActuatorQueue::Priority priority = ActuatorQueue::Priority::Normal);
+    uint64_t SubmitCommand(const std::string& cmd);      // queue a command for other transports, 0 if refused
 
 private:
     ArduinoSerial* arduino;
+    BeltSpeedController* speedController = nullptr;
+    FusionEngine* fusionEngine = nullptr;
+    ActuatorQueue* actuatorQueue = nullptr;
     httplib::Server server;
 
     std::string handleCommand(const std::string& cmd);
+    void enqueueCommand(const std::string& cmd, httplib::Response& res);
 };
 
 #endif // HTTP_SERVER_HANDLER_HPP
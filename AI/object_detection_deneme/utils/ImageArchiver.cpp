@@ -0,0 +1,246 @@
+/**
+ * ImageArchiver.cpp
+ *
+ * Implementation of the background image archiver.
+ */
+
+#include "ImageArchiver.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+// Constructor
+ImageArchiver::ImageArchiver(const Config &cfg)
+	: config(cfg), jobs(cfg.queueCapacity)
+{
+	std::filesystem::create_directories(config.directory);
+	dirFd = ::open(config.directory.c_str(), O_RDONLY | O_DIRECTORY);
+	scanExisting();
+
+	for (int i = 0; i < std::max(1, config.workers); i++)
+		workerThreads.emplace_back(&ImageArchiver::workerLoop, this);
+}
+
+// Destructor
+ImageArchiver::~ImageArchiver()
+{
+	stop();
+	if (dirFd >= 0)
+		::close(dirFd);
+}
+
+void ImageArchiver::stop()
+{
+	jobs.stop();    // workers drain what is already queued, then exit
+	for (auto &worker : workerThreads)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+	workerThreads.clear();
+}
+
+// Index images left by earlier runs so the quota covers them too
+void ImageArchiver::scanExisting()
+{
+	std::vector<StoredFile> found;
+	std::error_code ec;
+	for (const auto &entry : std::filesystem::directory_iterator(config.directory, ec))
+	{
+		if (!entry.is_regular_file())
+			continue;
+		const auto &path = entry.path();
+		if (path.extension() == ".tmp")
+		{
+			std::filesystem::remove(path, ec);     // half-written by a crash
+			continue;
+		}
+		if (path.extension() != ".jpg")
+			continue;
+		found.push_back(StoredFile{path.string(), static_cast<unsigned long long>(entry.file_size(ec))});
+	}
+
+	// Names start with a zero-padded timestamp, so name order is age order
+	std::sort(found.begin(), found.end(),
+			  [](const StoredFile &a, const StoredFile &b) { return a.path < b.path; });
+
+	std::lock_guard<std::mutex> lock(storeMutex);
+	for (auto &file : found)
+	{
+		storedBytes += file.bytes;
+		stored.push_back(std::move(file));
+	}
+}
+
+bool ImageArchiver::submit(const cv::Mat &frame, std::vector<NamedBbox> boxes, ArchiveKind kind)
+{
+	++submitted;
+
+	bool keep = true;
+	if (kind == ArchiveKind::Healthy)
+		keep = config.healthyEvery > 0 && (healthySeen++ % config.healthyEvery) == 0;
+	else if (kind == ArchiveKind::Empty)
+		keep = config.emptyEvery > 0 && (emptySeen++ % config.emptyEvery) == 0;
+
+	if (!keep)
+	{
+		++sampledOut;
+		return false;
+	}
+	if (kind != ArchiveKind::Rotten && shedding.load(std::memory_order_relaxed))
+	{
+		++shed;           // too hot: the encode and the write are the cost
+		return false;
+	}
+	if (!jobs.try_push(Job{frame, std::move(boxes), kind}))
+	{
+		++droppedBusy;    // an SD card stall must not reach the servo path
+		return false;
+	}
+	return true;
+}
+
+void ImageArchiver::workerLoop()
+{
+	set_thread_name("archive");
+	// Reused for every image this worker encodes
+	std::vector<uchar> encoded;
+	const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, config.jpegQuality};
+
+	Job job;
+	while (jobs.pop(job))
+	{
+		draw_bounding_boxes(job.frame, job.boxes);
+
+		encoded.clear();
+		if (!cv::imencode(".jpg", job.frame, encoded, params))
+		{
+			++writeErrors;
+			continue;
+		}
+
+		std::string path = config.directory + "/" + nextFileName(job.kind);
+		if (!writeAtomically(path, encoded))
+		{
+			++writeErrors;
+			continue;
+		}
+		++written;
+		enforceQuota(path, encoded.size());
+	}
+}
+
+std::string ImageArchiver::nextFileName(ArchiveKind kind)
+{
+	static const char *labels[] = {"rotten", "healthy", "empty"};
+	auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::ostringstream name;
+	name << std::setw(13) << std::setfill('0') << ms << "_"
+		 << std::setw(6) << std::setfill('0') << (sequence++ % 1000000) << "_"
+		 << labels[static_cast<int>(kind)] << ".jpg";
+	return name.str();
+}
+
+// Write to a temp file, fsync, then rename: readers never see a partial JPEG
+bool ImageArchiver::writeAtomically(const std::string &path, const std::vector<uchar> &data)
+{
+	std::string tmpPath = path + ".tmp";
+	int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+
+	size_t done = 0;
+	while (done < data.size())
+	{
+		ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			::close(fd);
+			::unlink(tmpPath.c_str());
+			return false;
+		}
+		done += static_cast<size_t>(n);
+	}
+
+	bool ok = ::fsync(fd) == 0;
+	ok = (::close(fd) == 0) && ok;
+	if (!ok || ::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		::unlink(tmpPath.c_str());
+		return false;
+	}
+	if (dirFd >= 0)
+		::fsync(dirFd);    // make the rename itself durable
+	return true;
+}
+
+void ImageArchiver::enforceQuota(const std::string &path, unsigned long long bytes)
+{
+	std::lock_guard<std::mutex> lock(storeMutex);
+	stored.push_back(StoredFile{path, bytes});
+	storedBytes += bytes;
+
+	while (storedBytes > config.quotaBytes && stored.size() > 1)
+	{
+		const StoredFile &oldest = stored.front();
+		::unlink(oldest.path.c_str());
+		storedBytes -= std::min(storedBytes, oldest.bytes);
+		stored.pop_front();
+		++evicted;
+	}
+}
+
+void ImageArchiver::setShedding(bool shed)
+{
+	shedding = shed;
+}
+
+ImageArchiver::Stats ImageArchiver::getStats() const
+{
+	Stats s;
+	s.submitted = submitted.load();
+	s.sampledOut = sampledOut.load();
+	s.shed = shed.load();
+	s.droppedBusy = droppedBusy.load();
+	s.written = written.load();
+	s.writeErrors = writeErrors.load();
+	s.evicted = evicted.load();
+
+	std::lock_guard<std::mutex> lock(storeMutex);
+	s.bytesOnDisk = storedBytes;
+	s.filesOnDisk = stored.size();
+	return s;
+}
+
+std::string ImageArchiver::stateJson() const
+{
+	Stats s = getStats();
+
+	std::ostringstream json;
+	json << "{\"directory\":\"" << config.directory << "\""
+		 << ",\"quotaBytes\":" << config.quotaBytes
+		 << ",\"bytesOnDisk\":" << s.bytesOnDisk
+		 << ",\"filesOnDisk\":" << s.filesOnDisk
+		 << ",\"queued\":" << jobs.size()
+		 << ",\"submitted\":" << s.submitted
+		 << ",\"sampledOut\":" << s.sampledOut
+		 << ",\"shedding\":" << (shedding.load() ? "true" : "false")
+		 << ",\"shed\":" << s.shed
+		 << ",\"droppedBusy\":" << s.droppedBusy
+		 << ",\"written\":" << s.written
+		 << ",\"writeErrors\":" << s.writeErrors
+		 << ",\"evicted\":" << s.evicted << "}";
+	return json.str();
+}
@@ -0,0 +1,144 @@
+/**
+ * ImageArchiver.h
+ *
+ * Background archiver for annotated result frames. Post-process only hands
+ * a frame over (never blocks, drops when busy); worker threads draw the
+ * boxes, encode the JPEG and write it atomically, while a ring-buffer quota
+ * deletes the oldest images once the archive outgrows its disk budget.
+ */
+
+#ifndef IMAGE_ARCHIVER_H
+#define IMAGE_ARCHIVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils.hpp"
+#include "ts_queue.hpp"
+
+enum class ArchiveKind : uint8_t { Rotten, Healthy, Empty };
+
+class ImageArchiver
+{
+public:
+	struct Config
+	{
+		std::string directory;
+		size_t queueCapacity;        // frames waiting for a worker; more are dropped
+		int workers;                 // encode/write threads
+		unsigned healthyEvery;       // keep 1 in N healthy frames (0 = none)
+		unsigned emptyEvery;         // keep 1 in N frames without detections (0 = none)
+		unsigned long long quotaBytes;
+		int jpegQuality;
+	};
+
+	struct Stats
+	{
+		unsigned long long submitted = 0;
+		unsigned long long sampledOut = 0;
+		unsigned long long shed = 0;
+		unsigned long long droppedBusy = 0;
+		unsigned long long written = 0;
+		unsigned long long writeErrors = 0;
+		unsigned long long evicted = 0;
+		unsigned long long bytesOnDisk = 0;
+		size_t filesOnDisk = 0;
+	};
+
+private:
+	struct Job
+	{
+		cv::Mat frame;
+		std::vector<NamedBbox> boxes;
+		ArchiveKind kind;
+	};
+
+	struct StoredFile
+	{
+		std::string path;
+		unsigned long long bytes;
+	};
+
+	Config config;
+	BoundedTSQueue<Job> jobs;
+	std::vector<std::thread> workerThreads;
+	int dirFd = -1;
+
+	std::atomic<unsigned> healthySeen{0};
+	std::atomic<unsigned> emptySeen{0};
+	std::atomic<unsigned long long> sequence{0};
+
+	std::atomic<unsigned long long> submitted{0};
+	std::atomic<unsigned long long> sampledOut{0};
+	std::atomic<unsigned long long> shed{0};
+	std::atomic<bool> shedding{false};
+	std::atomic<unsigned long long> droppedBusy{0};
+	std::atomic<unsigned long long> written{0};
+	std::atomic<unsigned long long> writeErrors{0};
+	std::atomic<unsigned long long> evicted{0};
+
+	// Oldest first; guarded by storeMutex
+	mutable std::mutex storeMutex;
+	std::deque<StoredFile> stored;
+	unsigned long long storedBytes = 0;
+
+	void workerLoop();
+	void scanExisting();
+	bool writeAtomically(const std::string &name, const std::vector<uchar> &data);
+	void enforceQuota(const std::string &path, unsigned long long bytes);
+	std::string nextFileName(ArchiveKind kind);
+
+public:
+	/**
+	 * Constructor - creates the directory, indexes existing images and starts the workers
+	 *
+	 * @param cfg Directory, pool size, sampling and quota
+	 */
+	explicit ImageArchiver(const Config &cfg);
+
+	/**
+	 * Destructor - writes what is queued, then stops the workers
+	 */
+	~ImageArchiver();
+
+	ImageArchiver(const ImageArchiver&) = delete;
+	ImageArchiver& operator=(const ImageArchiver&) = delete;
+
+	/**
+	 * Offer a result frame for archiving; never blocks
+	 *
+	 * @param frame Original frame (boxes are drawn by the worker, on this Mat)
+	 * @param boxes Detections to draw
+	 * @param kind Sampling class of the frame
+	 * @return true if the frame was queued, false if sampled out or the workers are busy
+	 */
+	bool submit(const cv::Mat &frame, std::vector<NamedBbox> boxes, ArchiveKind kind);
+
+	/**
+	 * Skip healthy and empty frames while the device sheds load; rotten frames are still kept
+	 *
+	 * @param shed true to shed, false to resume normal sampling
+	 */
+	void setShedding(bool shed);
+
+	/**
+	 * Finish queued writes and stop the workers
+	 */
+	void stop();
+
+	/**
+	 * Get a copy of the counters
+	 */
+	Stats getStats() const;
+
+	/**
+	 * Get the counters as a JSON object
+	 */
+	std::string stateJson() const;
+};
+
+#endif // IMAGE_ARCHIVER_H
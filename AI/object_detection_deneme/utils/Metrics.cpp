@@ -0,0 +1,235 @@
+/**
+ * Metrics.cpp
+ *
+ * Implementation of the process-wide metrics registry.
+ */
+
+#include "Metrics.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+static void appendNumber(std::string &out, double value)
+{
+	if (std::isnan(value))
+	{
+		out += "NaN";
+		return;
+	}
+	if (std::isinf(value))
+	{
+		out += value > 0 ? "+Inf" : "-Inf";
+		return;
+	}
+	char buffer[32];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	out.append(buffer, result.ptr);
+}
+
+static void appendInteger(std::string &out, uint64_t value)
+{
+	char buffer[24];
+	auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+	out.append(buffer, result.ptr);
+}
+
+static void appendSeries(std::string &out, const std::string &name, const std::string &labels,
+						 const std::string &extraLabel = "")
+{
+	out += name;
+	if (!labels.empty() || !extraLabel.empty())
+	{
+		out += '{';
+		out += labels;
+		if (!labels.empty() && !extraLabel.empty())
+			out += ',';
+		out += extraLabel;
+		out += '}';
+	}
+	out += ' ';
+}
+
+/* --- Counter ----------------------------------------------------------------- */
+
+unsigned Counter::shardIndex()
+{
+	static std::atomic<unsigned> nextShard{0};
+	thread_local const unsigned shard = nextShard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+	return shard;
+}
+
+uint64_t Counter::value() const
+{
+	uint64_t total = 0;
+	for (const Cell &cell : cells)
+		total += cell.value.load(std::memory_order_relaxed);
+	return total;
+}
+
+/* --- Histogram --------------------------------------------------------------- */
+
+Histogram::Histogram(std::initializer_list<double> bounds)
+	: upperBounds(bounds)
+{
+	if (upperBounds.size() > MAX_BUCKETS)
+		upperBounds.resize(MAX_BUCKETS);
+	std::sort(upperBounds.begin(), upperBounds.end());
+}
+
+void Histogram::observe(double value)
+{
+	value = std::max(0.0, value);
+	size_t bucket = 0;
+	while (bucket < upperBounds.size() && value > upperBounds[bucket])
+		bucket++;
+
+	Shard &shard = shards[Counter::shardIndex()];
+	shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+	shard.sumNanos.fetch_add(static_cast<uint64_t>(value * 1e9), std::memory_order_relaxed);
+}
+
+void Histogram::snapshot(std::vector<uint64_t> &counts, double &sum) const
+{
+	counts.assign(upperBounds.size() + 1, 0);
+	uint64_t sumNanos = 0;
+	for (const Shard &shard : shards)
+	{
+		for (size_t i = 0; i < counts.size(); i++)
+			counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+		sumNanos += shard.sumNanos.load(std::memory_order_relaxed);
+	}
+	sum = sumNanos / 1e9;
+}
+
+/* --- Registry ---------------------------------------------------------------- */
+
+Metrics &Metrics::global()
+{
+	static Metrics registry;
+	return registry;
+}
+
+Metrics::Family &Metrics::family(const std::string &name, const std::string &help, Type type)
+{
+	auto it = families.find(name);
+	if (it == families.end())
+		it = families.emplace(name, Family{type, help, {}, {}, {}}).first;
+	else if (it->second.type != type)
+		throw std::logic_error("metric " + name + " registered with two types");
+	return it->second;
+}
+
+Counter &Metrics::counter(const std::string &name, const std::string &help, const std::string &labels)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto &series = family(name, help, Type::Counter).counters[labels];
+	if (!series)
+		series = std::make_unique<Counter>();
+	return *series;
+}
+
+Histogram &Metrics::histogram(const std::string &name, const std::string &help, std::initializer_list<double> bounds,
+							  const std::string &labels)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto &series = family(name, help, Type::Histogram).histograms[labels];
+	if (!series)
+		series = std::make_unique<Histogram>(bounds);
+	return *series;
+}
+
+void Metrics::gauge(const std::string &name, const std::string &help, std::function<double()> read,
+					const std::string &labels)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	family(name, help, Type::Gauge).gauges[labels] = std::move(read);
+}
+
+uint64_t Metrics::counterTotal(const std::string &name) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = families.find(name);
+	if (it == families.end())
+		return 0;
+	uint64_t total = 0;
+	for (const auto &entry : it->second.counters)
+		total += entry.second->value();
+	return total;
+}
+
+void Metrics::histogramTotal(const std::string &name, uint64_t &count, double &sum) const
+{
+	count = 0;
+	sum = 0;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = families.find(name);
+	if (it == families.end())
+		return;
+	std::vector<uint64_t> counts;
+	for (const auto &entry : it->second.histograms)
+	{
+		double seriesSum = 0;
+		entry.second->snapshot(counts, seriesSum);
+		for (uint64_t c : counts)
+			count += c;
+		sum += seriesSum;
+	}
+}
+
+std::string Metrics::render() const
+{
+	static const char *typeNames[] = {"counter", "histogram", "gauge"};
+
+	std::string out;
+	out.reserve(8192);
+	std::vector<uint64_t> counts;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto &[name, family] : families)
+	{
+		out += "# HELP " + name + " " + family.help + "\n";
+		out += "# TYPE " + name + " " + typeNames[static_cast<int>(family.type)] + "\n";
+
+		for (const auto &[labels, counter] : family.counters)
+		{
+			appendSeries(out, name, labels);
+			appendInteger(out, counter->value());
+			out += '\n';
+		}
+
+		for (const auto &[labels, read] : family.gauges)
+		{
+			appendSeries(out, name, labels);
+			appendNumber(out, read());
+			out += '\n';
+		}
+
+		for (const auto &[labels, histogram] : family.histograms)
+		{
+			double sum = 0;
+			histogram->snapshot(counts, sum);
+			const auto &bounds = histogram->bounds();
+
+			// Prometheus buckets are cumulative
+			uint64_t cumulative = 0;
+			for (size_t i = 0; i < counts.size(); i++)
+			{
+				cumulative += counts[i];
+				std::string le = "le=\"";
+				appendNumber(le, i < bounds.size() ? bounds[i] : INFINITY);
+				le += '"';
+				appendSeries(out, name + "_bucket", labels, le);
+				appendInteger(out, cumulative);
+				out += '\n';
+			}
+			appendSeries(out, name + "_sum", labels);
+			appendNumber(out, sum);
+			out += '\n';
+			appendSeries(out, name + "_count", labels);
+			appendInteger(out, cumulative);
+			out += '\n';
+		}
+	}
+	return out;
+}
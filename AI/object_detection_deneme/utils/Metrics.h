@@ -0,0 +1,159 @@
+/**
+ * Metrics.h
+ *
+ * Process-wide counters, histograms and gauges, rendered in the Prometheus
+ * text format on GET /metrics. Counters and histograms are sharded across
+ * cache-line sized cells and every thread updates its own shard with a
+ * relaxed atomic add, so instrumenting a hot loop costs a few nanoseconds
+ * and never takes a lock. Shards are only summed when /metrics is scraped.
+ * Gauges are callbacks evaluated at scrape time (queue depths and the like).
+ *
+ * Series are registered once (typically into a function-local static) and
+ * the returned reference stays valid for the life of the process.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Counter
+{
+public:
+	static constexpr unsigned SHARDS = 16;
+
+	/**
+	 * Add to the calling thread's shard
+	 */
+	void inc(uint64_t n = 1)
+	{
+		cells[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Sum over all shards
+	 */
+	uint64_t value() const;
+
+	/**
+	 * Shard of the calling thread, fixed the first time the thread asks
+	 */
+	static unsigned shardIndex();
+
+private:
+	struct alignas(64) Cell
+	{
+		std::atomic<uint64_t> value{0};
+	};
+	Cell cells[SHARDS];
+};
+
+class Histogram
+{
+public:
+	static constexpr size_t MAX_BUCKETS = 15;
+
+	/**
+	 * Constructor
+	 *
+	 * @param bounds Ascending upper bucket bounds (at most MAX_BUCKETS); +Inf is implicit
+	 */
+	explicit Histogram(std::initializer_list<double> bounds);
+
+	/**
+	 * Record one observation into the calling thread's shard
+	 *
+	 * @param value Observation, seconds for latencies; negative values count as 0
+	 */
+	void observe(double value);
+
+	/**
+	 * Summed snapshot: per-bucket (non-cumulative) counts, +Inf last, sum of observations
+	 */
+	void snapshot(std::vector<uint64_t> &counts, double &sum) const;
+
+	const std::vector<double> &bounds() const { return upperBounds; }
+
+private:
+	struct alignas(64) Shard
+	{
+		std::atomic<uint64_t> counts[MAX_BUCKETS + 1] = {};
+		std::atomic<uint64_t> sumNanos{0};      // observations are scaled by 1e9 to stay integral
+	};
+	std::vector<double> upperBounds;
+	Shard shards[Counter::SHARDS];
+};
+
+class Metrics
+{
+public:
+	/**
+	 * The registry shared by the whole process
+	 */
+	static Metrics &global();
+
+	/**
+	 * Get or create a counter series
+	 *
+	 * @param name Metric name, ending in _total by convention
+	 * @param help One line description
+	 * @param labels Label set without braces, e.g. camera="2"; empty for none
+	 */
+	Counter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+
+	/**
+	 * Get or create a histogram series; the bounds of the first registration win
+	 */
+	Histogram &histogram(const std::string &name, const std::string &help, std::initializer_list<double> bounds,
+						 const std::string &labels = "");
+
+	/**
+	 * Register a gauge read at scrape time
+	 */
+	void gauge(const std::string &name, const std::string &help, std::function<double()> read,
+			   const std::string &labels = "");
+
+	/**
+	 * Sum over every label set of a counter, 0 if it is not registered
+	 */
+	uint64_t counterTotal(const std::string &name) const;
+
+	/**
+	 * Observation count and sum over every label set of a histogram
+	 */
+	void histogramTotal(const std::string &name, uint64_t &count, double &sum) const;
+
+	/**
+	 * Everything in the Prometheus text exposition format (version 0.0.4)
+	 */
+	std::string render() const;
+
+	static constexpr const char *CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+private:
+	enum class Type { Counter, Histogram, Gauge };
+
+	struct Family
+	{
+		Type type;
+		std::string help;
+		std::map<std::string, std::unique_ptr<Counter>> counters;
+		std::map<std::string, std::unique_ptr<Histogram>> histograms;
+		std::map<std::string, std::function<double()>> gauges;
+	};
+
+	mutable std::mutex mutex;               // registration and scrape only
+	std::map<std::string, Family> families;
+
+	Family &family(const std::string &name, const std::string &help, Type type);
+};
+
+#endif // METRICS_H
@@ -0,0 +1,101 @@
+/**
+ * ProductClassifier.cpp
+ *
+ * Implementation of the stage-one empty-belt / product gate.
+ */
+
+#include "ProductClassifier.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+// Constructor
+ProductClassifier::ProductClassifier(const Config &cfg)
+	: config(cfg),
+	  calibrator(RecallCalibrator::Config{cfg.recallTarget, cfg.minCalibration, cfg.calibrationWindow,
+										  cfg.auditEvery, cfg.maxThreshold})
+{
+}
+
+void ProductClassifier::setEnabled(bool on)
+{
+	enabled = on;
+}
+
+bool ProductClassifier::isEnabled() const
+{
+	return enabled.load();
+}
+
+double ProductClassifier::score(const cv::Mat &roi) const
+{
+	if (roi.empty())
+		return 0.0;
+
+	cv::Mat small;
+	if (roi.cols > config.analysisWidth)
+	{
+		double scale = static_cast<double>(config.analysisWidth) / roi.cols;
+		cv::resize(roi, small, cv::Size(), scale, scale, cv::INTER_AREA);
+	}
+	else
+	{
+		small = roi;
+	}
+
+	// Colour: produce is saturated, the belt and its shadows are not
+	cv::Mat hsv, coloured;
+	cv::cvtColor(small, hsv, cv::COLOR_BGR2HSV);
+	cv::inRange(hsv, cv::Scalar(0, config.saturationMin, config.valueMin), cv::Scalar(180, 255, 255), coloured);
+	double colourShare = static_cast<double>(cv::countNonZero(coloured)) / coloured.total();
+
+	// Texture: a seam is one straight edge, a product outline covers far more pixels
+	cv::Mat gray, edges;
+	cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+	cv::Canny(gray, edges, 50, 150);
+	double edgeShare = static_cast<double>(cv::countNonZero(edges)) / edges.total();
+	edgeShare = std::min(1.0, edgeShare * 10.0);   // ~10% edge pixels is already a busy frame
+
+	return (1.0 - config.edgeWeight) * colourShare + config.edgeWeight * edgeShare;
+}
+
+bool ProductClassifier::accept(const cv::Mat &roi, unsigned long long triggerId, int frames)
+{
+	if (!enabled.load())
+		return true;
+	return calibrator.admit(score(roi), triggerId, frames);
+}
+
+void ProductClassifier::reportDetection(unsigned long long triggerId, bool productFound)
+{
+	calibrator.reportDetection(triggerId, productFound);
+}
+
+ProductClassifier::State ProductClassifier::getState() const
+{
+	State s;
+	static_cast<RecallCalibrator::State &>(s) = calibrator.getState();
+	s.enabled = enabled.load();
+	return s;
+}
+
+std::string ProductClassifier::stateJson() const
+{
+	State s = getState();
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(4);
+	json << "{\"enabled\":" << (s.enabled ? "true" : "false")
+		 << ",\"calibrated\":" << (s.calibrated ? "true" : "false")
+		 << ",\"threshold\":" << s.threshold
+		 << ",\"recallTarget\":" << config.recallTarget
+		 << ",\"estimatedRecall\":" << s.estimatedRecall
+		 << ",\"evaluated\":" << s.evaluated
+		 << ",\"passed\":" << s.passed
+		 << ",\"rejected\":" << s.rejected
+		 << ",\"audited\":" << s.audited
+		 << ",\"confirmedProducts\":" << s.confirmedProducts
+		 << ",\"emptyPasses\":" << s.emptyPasses
+		 << ",\"auditMisses\":" << s.auditMisses << "}";
+	return json.str();
+}
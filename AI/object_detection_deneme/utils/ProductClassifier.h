@@ -0,0 +1,102 @@
+/**
+ * ProductClassifier.h
+ *
+ * Stage-one gate in front of the detector. Scores the cropped belt ROI
+ * with a handcrafted colour/texture model and rejects frames that look
+ * like an empty belt (shadows, seams, glare) before they reach the
+ * accelerator. The reject threshold is calibrated online from frames the
+ * detector confirmed (see RecallCalibrator), so that the configured share
+ * of real products still passes.
+ */
+
+#ifndef PRODUCT_CLASSIFIER_H
+#define PRODUCT_CLASSIFIER_H
+
+#include <atomic>
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "RecallCalibrator.h"
+
+class ProductClassifier
+{
+public:
+	struct Config
+	{
+		double recallTarget;          // share of real products that must pass, e.g. 0.99
+		size_t minCalibration;        // confirmed products needed before anything is rejected
+		size_t calibrationWindow;     // most recent confirmed scores kept for the quantile
+		unsigned auditEvery;          // pass 1 in N would-be rejects to measure misses (0 = never)
+		int saturationMin;            // HSV saturation that counts as coloured (produce, not belt)
+		int valueMin;                 // ignore dark pixels, their hue/saturation is noise
+		double edgeWeight;            // share of the score taken by edge density
+		double maxThreshold;          // never demand more than this, whatever the calibration says
+		int analysisWidth;            // ROI is downscaled to this width before scoring
+	};
+
+	struct State : RecallCalibrator::State
+	{
+		bool enabled = false;
+	};
+
+private:
+	Config config;
+	std::atomic<bool> enabled{false};
+	RecallCalibrator calibrator;
+
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param cfg Recall target, calibration and feature parameters
+	 */
+	explicit ProductClassifier(const Config &cfg);
+
+	/**
+	 * Switch the gate on or off; when off every frame passes
+	 *
+	 * @param on true to reject frames below the threshold
+	 */
+	void setEnabled(bool on);
+
+	/**
+	 * Check whether the gate is active
+	 */
+	bool isEnabled() const;
+
+	/**
+	 * Score a belt ROI, 0 = bare belt, 1 = fully covered by coloured, textured product
+	 *
+	 * @param roi Cropped BGR frame
+	 */
+	double score(const cv::Mat &roi) const;
+
+	/**
+	 * Decide whether a triggered frame goes on to the detector
+	 *
+	 * @param roi Cropped BGR frame
+	 * @param triggerId Unique id of the camera trigger, used to match the detector's verdicts later
+	 * @param frames Frames queued for this trigger; the verdict is settled once all of them report
+	 * @return true if the frame should be queued for inference
+	 */
+	bool accept(const cv::Mat &roi, unsigned long long triggerId, int frames = 1);
+
+	/**
+	 * Feed back the detector's verdict for one frame of a trigger that passed the gate
+	 *
+	 * @param triggerId Trigger id the frame was accepted with
+	 * @param productFound true if the detector returned at least one box
+	 */
+	void reportDetection(unsigned long long triggerId, bool productFound);
+
+	/**
+	 * Get a snapshot of the counters and calibration
+	 */
+	State getState() const;
+
+	/**
+	 * Get the gate state as a JSON object
+	 */
+	std::string stateJson() const;
+};
+
+#endif // PRODUCT_CLASSIFIER_H
@@ -0,0 +1,137 @@
+/**
+ * RecallCalibrator.cpp
+ *
+ * Implementation of the recall-targeted gate threshold.
+ */
+
+#include "RecallCalibrator.h"
+#include <algorithm>
+#include <vector>
+
+// Frames waiting for the detector's verdict; older ones were dropped downstream
+static constexpr size_t MAX_PENDING = 256;
+
+// Constructor
+RecallCalibrator::RecallCalibrator(const Config &cfg)
+	: config(cfg)
+{
+}
+
+bool RecallCalibrator::admit(double score, unsigned long long triggerId, int frames)
+{
+	++evaluated;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	bool pass = score >= threshold;
+	bool audit = false;
+	if (!pass && config.auditEvery > 0 && ++auditCounter >= config.auditEvery)
+	{
+		// Let a would-be reject through so misses show up in the recall estimate
+		auditCounter = 0;
+		audit = true;
+		pass = true;
+		++audited;
+	}
+
+	if (!pass)
+	{
+		++rejected;
+		return false;
+	}
+
+	++passed;
+	pending[triggerId] = Pending{score, audit, std::max(1, frames), false};
+	while (pending.size() > MAX_PENDING)
+		pending.erase(pending.begin());
+	return true;
+}
+
+void RecallCalibrator::reportDetection(unsigned long long triggerId, bool productFound)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = pending.find(triggerId);
+	if (it == pending.end())
+		return;
+
+	// A burst counts once: as a product if any of its frames showed one
+	Pending &p = it->second;
+	p.productFound = p.productFound || productFound;
+	if (--p.remaining > 0 && !p.productFound)
+		return;
+	const double score = p.score;
+	const bool audit = p.audit;
+	productFound = p.productFound;
+	pending.erase(it);
+
+	if (!productFound)
+	{
+		if (!audit)
+			++emptyPasses;
+		return;
+	}
+
+	++confirmedProducts;
+	if (audit)
+		++auditMisses;
+
+	// an audit is drawn from auditEvery rejects, so it stands for that many products
+	productScores.push_back(Sample{score, audit ? std::max(1u, config.auditEvery) : 1u});
+	while (productScores.size() > config.calibrationWindow)
+		productScores.pop_front();
+	recalibrate();
+}
+
+// Caller holds mutex
+void RecallCalibrator::recalibrate()
+{
+	if (productScores.size() < config.minCalibration)
+	{
+		threshold = 0.0;
+		return;
+	}
+
+	// Threshold at the weighted (1 - recall) quantile of confirmed product scores:
+	// the highest score with at most that share of the weight below it
+	std::vector<Sample> sorted(productScores.begin(), productScores.end());
+	std::sort(sorted.begin(), sorted.end(), [](const Sample &a, const Sample &b) { return a.score < b.score; });
+	double total = 0.0;
+	for (const Sample &sample : sorted)
+		total += sample.weight;
+
+	const double allowedBelow = (1.0 - config.recallTarget) * total;
+	double below = 0.0;
+	double quantile = sorted.front().score;
+	for (const Sample &sample : sorted)
+	{
+		if (below > allowedBelow)
+			break;
+		quantile = sample.score;
+		below += sample.weight;
+	}
+	threshold = std::min(quantile, config.maxThreshold);
+}
+
+RecallCalibrator::State RecallCalibrator::getState() const
+{
+	State s;
+	s.evaluated = evaluated.load();
+	s.passed = passed.load();
+	s.rejected = rejected.load();
+	s.audited = audited.load();
+	s.confirmedProducts = confirmedProducts.load();
+	s.emptyPasses = emptyPasses.load();
+	s.auditMisses = auditMisses.load();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		s.threshold = threshold;
+		s.calibrated = productScores.size() >= config.minCalibration;
+	}
+
+	// Each audited miss stands for auditEvery rejected products
+	double missed = static_cast<double>(s.auditMisses) * std::max(1u, config.auditEvery);
+	double caught = static_cast<double>(s.confirmedProducts - s.auditMisses);
+	if (caught + missed > 0)
+		s.estimatedRecall = caught / (caught + missed);
+	return s;
+}
@@ -0,0 +1,114 @@
+/**
+ * RecallCalibrator.h
+ *
+ * Online threshold for a reject gate that must keep a given share of real
+ * products. Frames below the threshold are rejected, except one in N that
+ * is let through as an audit. The detector's verdicts on what passed come
+ * back, and the threshold is set at the (1 - recall) quantile of confirmed
+ * product scores. Frames that passed the threshold make up most of that
+ * sample, so each audited product stands for the N rejects it was drawn
+ * from. Without that weight the low tail would be underrepresented and the
+ * threshold would only ever climb.
+ */
+
+#ifndef RECALL_CALIBRATOR_H
+#define RECALL_CALIBRATOR_H
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+
+class RecallCalibrator
+{
+public:
+	struct Config
+	{
+		double recallTarget;          // share of real products that must pass, e.g. 0.99
+		size_t minCalibration;        // confirmed products needed before anything is rejected
+		size_t calibrationWindow;     // most recent confirmed scores kept for the quantile
+		unsigned auditEvery;          // pass 1 in N would-be rejects to measure misses (0 = never)
+		double maxThreshold;          // never demand more than this, whatever the calibration says
+	};
+
+	struct State
+	{
+		bool calibrated = false;
+		double threshold = 0.0;
+		unsigned long long evaluated = 0;
+		unsigned long long passed = 0;
+		unsigned long long rejected = 0;
+		unsigned long long audited = 0;
+		unsigned long long confirmedProducts = 0;
+		unsigned long long emptyPasses = 0;     // passed, detector found nothing
+		unsigned long long auditMisses = 0;     // would have been rejected, detector found a product
+		double estimatedRecall = 1.0;
+	};
+
+	/**
+	 * Constructor
+	 *
+	 * @param cfg Recall target and calibration parameters
+	 */
+	explicit RecallCalibrator(const Config &cfg);
+
+	/**
+	 * Decide whether a scored frame passes the gate
+	 *
+	 * @param score Gate score of the frame, higher is more product-like
+	 * @param triggerId Unique id of the camera trigger, used to match the detector's verdicts later
+	 * @param frames Frames queued for this trigger; the verdict is settled once all of them report
+	 * @return true if the frame passes, as a regular pass or an audit
+	 */
+	bool admit(double score, unsigned long long triggerId, int frames = 1);
+
+	/**
+	 * Feed back the detector's verdict for one frame of a trigger that passed
+	 *
+	 * @param triggerId Trigger id the frame was admitted with
+	 * @param productFound true if the detector returned at least one box
+	 */
+	void reportDetection(unsigned long long triggerId, bool productFound);
+
+	/**
+	 * Get a snapshot of the counters and calibration
+	 */
+	State getState() const;
+
+	const Config &getConfig() const { return config; }
+
+private:
+	struct Pending
+	{
+		double score;
+		bool audit;
+		int remaining;                // detector verdicts still to come, one per burst frame
+		bool productFound;            // any verdict so far found a product
+	};
+
+	struct Sample
+	{
+		double score;
+		unsigned weight;              // products this one stands for
+	};
+
+	Config config;
+
+	std::atomic<unsigned long long> evaluated{0};
+	std::atomic<unsigned long long> passed{0};
+	std::atomic<unsigned long long> rejected{0};
+	std::atomic<unsigned long long> audited{0};
+	std::atomic<unsigned long long> confirmedProducts{0};
+	std::atomic<unsigned long long> emptyPasses{0};
+	std::atomic<unsigned long long> auditMisses{0};
+
+	mutable std::mutex mutex;
+	std::deque<Sample> productScores;
+	std::map<unsigned long long, Pending> pending;    // by trigger id, oldest first
+	double threshold = 0.0;
+	unsigned auditCounter = 0;
+
+	void recalibrate();
+};
+
+#endif // RECALL_CALIBRATOR_H
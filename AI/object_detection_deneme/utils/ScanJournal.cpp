@@ -0,0 +1,610 @@
+/**
+ * ScanJournal.cpp
+ *
+ * Implementation of the scan store-and-forward journal.
+ */
+
+#include "ScanJournal.h"
+#include "http_client.h"
+#include "Metrics.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint32_t RECORD_MAGIC = 0x324A4353;   // "SCJ2", records carry a product id
+static const char *CURSOR_FILE = "cursor";
+
+// Constructor
+ScanJournal::ScanJournal(const Config &cfg)
+	: config(cfg)
+{
+	config.segmentRecords = std::max<size_t>(config.segmentRecords, 1);
+	config.maxSegments = std::max<size_t>(config.maxSegments, 3);   // shipping, current and spare
+
+	std::filesystem::create_directories(config.directory);
+	dirFd = ::open(config.directory.c_str(), O_RDONLY | O_DIRECTORY);
+	recover();
+
+	flusherThread = std::thread(&ScanJournal::flusherLoop, this);
+	shipperThread = std::thread(&ScanJournal::shipperLoop, this);
+}
+
+// Destructor
+ScanJournal::~ScanJournal()
+{
+	stop();
+	closeSegment(current);
+	closeSegment(spare);
+	if (dirFd >= 0)
+		::close(dirFd);
+}
+
+void ScanJournal::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (flusherThread.joinable())
+		flusherThread.join();    // flushes once more on the way out
+	if (shipperThread.joinable())
+		shipperThread.join();
+}
+
+uint32_t ScanJournal::checksum(const Record &record)
+{
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&record);
+	uint32_t hash = 2166136261u;
+	for (size_t i = offsetof(Record, sequence); i < sizeof(Record); i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+std::string ScanJournal::segmentPath(uint64_t firstSeq) const
+{
+	std::ostringstream name;
+	name << config.directory << "/scans-" << std::setw(20) << std::setfill('0') << firstSeq << ".jrn";
+	return name.str();
+}
+
+// Maps a whole segment file; new segments are preallocated so appends never extend the file
+bool ScanJournal::openSegment(uint64_t firstSeq, bool create, Mapping &out)
+{
+	const std::string path = segmentPath(firstSeq);
+	const off_t bytes = static_cast<off_t>(config.segmentRecords * sizeof(Record));
+
+	int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+	if (fd < 0)
+	{
+		std::cerr << "Journal: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	struct stat st{};
+	bool sized = ::fstat(fd, &st) == 0 && st.st_size == bytes;
+	if (!sized && ::posix_fallocate(fd, 0, bytes) != 0)
+	{
+		std::cerr << "Journal: cannot allocate " << path << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	void *map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+	{
+		std::cerr << "Journal: cannot map " << path << ": " << std::strerror(errno) << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	if (create)
+	{
+		::fsync(fd);
+		if (dirFd >= 0)
+			::fsync(dirFd);    // the new name survives a power cut
+	}
+
+	out.firstSeq = firstSeq;
+	out.fd = fd;
+	out.records = static_cast<Record *>(map);
+	return true;
+}
+
+void ScanJournal::closeSegment(Mapping &mapping)
+{
+	if (mapping.records)
+	{
+		const size_t bytes = config.segmentRecords * sizeof(Record);
+		::msync(mapping.records, bytes, MS_SYNC);
+		::munmap(mapping.records, bytes);
+	}
+	if (mapping.fd >= 0)
+		::close(mapping.fd);
+	mapping = Mapping{};
+}
+
+// Reopen the newest segment where it stopped; older ones stay for the shipper
+void ScanJournal::recover()
+{
+	uint64_t acked = readCursor();
+
+	std::vector<uint64_t> found;
+	std::error_code ec;
+	for (const auto &entry : std::filesystem::directory_iterator(config.directory, ec))
+	{
+		const std::string name = entry.path().filename().string();
+		if (name.size() == 30 && name.compare(0, 6, "scans-") == 0 && name.compare(26, 4, ".jrn") == 0)
+			found.push_back(std::strtoull(name.c_str() + 6, nullptr, 10));
+	}
+	std::sort(found.begin(), found.end());
+
+	// A spare the flusher created but nobody wrote into yet is just discarded
+	while (found.size() > 1)
+	{
+		Record first{};
+		int fd = ::open(segmentPath(found.back()).c_str(), O_RDONLY | O_CLOEXEC);
+		bool empty = fd < 0 || ::pread(fd, &first, sizeof(first), 0) != static_cast<ssize_t>(sizeof(first)) ||
+					 first.magic != RECORD_MAGIC;
+		if (fd >= 0)
+			::close(fd);
+		if (!empty)
+			break;
+		::unlink(segmentPath(found.back()).c_str());
+		found.pop_back();
+	}
+
+	// Segments the backend already has are not needed any more
+	while (found.size() > 1 && found.front() + config.segmentRecords - 1 <= acked)
+	{
+		::unlink(segmentPath(found.front()).c_str());
+		found.erase(found.begin());
+	}
+
+	if (!found.empty() && openSegment(found.back(), false, current))
+	{
+		// Valid records are contiguous from the start; a torn tail ends the scan
+		while (currentCount < config.segmentRecords)
+		{
+			const Record &r = current.records[currentCount];
+			if (r.magic != RECORD_MAGIC || r.sequence != current.firstSeq + currentCount || r.checksum != checksum(r))
+				break;
+			currentCount++;
+		}
+		nextSeq = current.firstSeq + currentCount;
+		if (currentCount == config.segmentRecords)
+		{
+			// full: it stays in found for the shipper, appends go to a new segment below
+			closeSegment(current);
+			currentCount = 0;
+		}
+		else
+		{
+			segmentFirstSeqs.assign(found.begin(), found.end());
+		}
+	}
+	else
+	{
+		nextSeq = acked + 1;
+	}
+
+	if (!current.records)
+	{
+		segmentFirstSeqs.assign(found.begin(), found.end());
+		if (openSegment(nextSeq, true, current))
+			segmentFirstSeqs.push_back(current.firstSeq);
+	}
+
+	committedSeq = nextSeq - 1;
+	durableSeq = nextSeq - 1;
+	flushedCount = currentCount;
+	ackedSeq = std::min(acked, nextSeq - 1);
+
+	if (committedSeq > ackedSeq)
+		std::cout << "Journal: " << (committedSeq - ackedSeq) << " scans waiting to be shipped" << std::endl;
+}
+
+uint64_t ScanJournal::readCursor()
+{
+	std::ifstream file(config.directory + "/" + CURSOR_FILE);
+	uint64_t sequence = 0;
+	if (!(file >> sequence))
+		return 0;
+	return sequence;
+}
+
+// Same write-fsync-rename dance as the image archive: never a half-written cursor
+bool ScanJournal::writeCursor(uint64_t sequence)
+{
+	const std::string path = config.directory + "/" + CURSOR_FILE;
+	const std::string tmpPath = path + ".tmp";
+	const std::string text = std::to_string(sequence) + "\n";
+
+	int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+	bool ok = ::write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+	ok = (::fsync(fd) == 0) && ok;
+	ok = (::close(fd) == 0) && ok;
+	if (!ok || ::rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		::unlink(tmpPath.c_str());
+		return false;
+	}
+	if (dirFd >= 0)
+		::fsync(dirFd);
+	return true;
+}
+
+bool ScanJournal::append(const ScanRequestDTO &scan)
+{
+	return appendProduct(&scan, 1);
+}
+
+bool ScanJournal::append(const std::vector<ScanRequestDTO> &scans)
+{
+	return appendProduct(scans.data(), scans.size());
+}
+
+// The whole product is committed at once, so the shipper never sees part of it
+bool ScanJournal::appendProduct(const ScanRequestDTO *scans, size_t count)
+{
+	std::lock_guard<std::mutex> lock(appendMutex);
+	const uint64_t productId = nextSeq;
+	for (size_t i = 0; i < count; i++)
+	{
+		if ((!current.records || currentCount == config.segmentRecords) && !rotate())
+		{
+			dropped += count - i;
+			committedSeq.store(nextSeq - 1, std::memory_order_release);
+			return false;
+		}
+		write(scans[i], productId);
+	}
+	committedSeq.store(nextSeq - 1, std::memory_order_release);
+	return true;
+}
+
+// Caller holds appendMutex. Normally the flusher has the next segment ready; if it
+// is late, the segment is created here: a durability journal blocks, it does not drop
+bool ScanJournal::rotate()
+{
+	if (retiring.records)
+		closeSegment(retiring);    // the flusher has not msynced it yet
+	if (!spare.records)
+	{
+		if (!openSegment(nextSeq, true, spare))
+			return false;
+		std::lock_guard<std::mutex> lock(segmentMutex);
+		segmentFirstSeqs.push_back(nextSeq);
+	}
+	retiring = current;
+	current = spare;
+	spare = Mapping{};
+	currentCount = 0;
+	flushedCount = 0;
+	return true;
+}
+
+// Caller holds appendMutex and has room in the current segment
+void ScanJournal::write(const ScanRequestDTO &scan, uint64_t productId)
+{
+	Record &r = current.records[currentCount];
+	r.sequence = nextSeq;
+	r.productId = productId;
+	r.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	r.confidence = static_cast<float>(scan.confidence());
+	r.x = static_cast<float>(scan.x());
+	r.y = static_cast<float>(scan.y());
+	const std::string &product = scan.productResult();
+	const size_t length = std::min(product.size(), sizeof(r.productResult) - 1);
+	std::memcpy(r.productResult, product.data(), length);
+	std::memset(r.productResult + length, 0, sizeof(r.productResult) - length);
+	r.checksum = checksum(r);
+	r.magic = RECORD_MAGIC;
+
+	currentCount++;
+	nextSeq++;
+	++appended;
+}
+
+void ScanJournal::flusherLoop()
+{
+	set_thread_name("journal-flush");
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	while (!stopping)
+	{
+		wake.wait_for(lock, std::chrono::milliseconds(config.flushIntervalMs));
+		lock.unlock();
+		flushOnce();
+		lock.lock();
+	}
+	lock.unlock();
+	flushOnce();
+}
+
+// One batched msync for everything appended since the last one
+void ScanJournal::flushOnce()
+{
+	Mapping done, cur;
+	size_t from, to;
+	uint64_t spareSeq = 0;
+	bool needSpare;
+	{
+		std::lock_guard<std::mutex> lock(appendMutex);
+		done = retiring;
+		retiring = Mapping{};
+		cur = current;
+		from = flushedCount;
+		to = currentCount;
+		flushedCount = to;
+		needSpare = !spare.records && current.records;
+		spareSeq = current.firstSeq + config.segmentRecords;
+	}
+
+	closeSegment(done);    // msyncs the tail of the segment we just rotated out of
+
+	if (cur.records && to > from)
+	{
+		static const uintptr_t pageMask = ~static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE) - 1);
+		uintptr_t begin = reinterpret_cast<uintptr_t>(cur.records + from) & pageMask;
+		uintptr_t end = reinterpret_cast<uintptr_t>(cur.records + to);
+		if (::msync(reinterpret_cast<void *>(begin), end - begin, MS_SYNC) == 0)
+			durableSeq = cur.firstSeq + to - 1;
+	}
+	else if (done.firstSeq != 0 && to == 0)
+	{
+		durableSeq = committedSeq.load();
+	}
+
+	if (needSpare)
+	{
+		Mapping next;
+		if (openSegment(spareSeq, true, next))
+		{
+			std::lock_guard<std::mutex> lock(appendMutex);
+			// append may have rotated and created it meanwhile; then this one is already in use
+			if (!spare.records && current.firstSeq + config.segmentRecords == spareSeq)
+			{
+				spare = next;
+				std::lock_guard<std::mutex> segmentLock(segmentMutex);
+				segmentFirstSeqs.push_back(spareSeq);
+			}
+			else
+			{
+				const size_t bytes = config.segmentRecords * sizeof(Record);
+				::munmap(next.records, bytes);
+				::close(next.fd);
+			}
+		}
+	}
+}
+
+void ScanJournal::shipperLoop()
+{
+	set_thread_name("journal-ship");
+	int backoffMs = 0;
+	HttpClient client;                      // keeps its request buffers between batches
+	client.initialize();
+	std::vector<ScanRequestDTO> batch;
+	batch.reserve(config.shipBatch);
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	while (!stopping)
+	{
+		wake.wait_for(lock, std::chrono::milliseconds(backoffMs > 0 ? backoffMs : config.shipIntervalMs));
+		if (stopping)
+			break;
+		lock.unlock();
+
+		enforceDiskBound();
+		bool ok = true;
+		for (size_t n = 0; ok && n < config.shipBatch && ackedSeq < committedSeq.load(std::memory_order_acquire); n++)
+			ok = shipProduct(client, batch);
+		if (ok)
+		{
+			backoffMs = 0;
+		}
+		else
+		{
+			// backend unreachable: back off, the records are safe on disk
+			backoffMs = std::min(config.retryMaxMs, std::max(config.shipIntervalMs, backoffMs * 2));
+		}
+
+		lock.lock();
+	}
+}
+
+// Ships the oldest unacknowledged product; false if the backend rejected, was unreachable or has not answered yet
+bool ScanJournal::shipProduct(HttpClient &client, std::vector<ScanRequestDTO> &batch)
+{
+	{
+		// records evicted before they were shipped are gone, skip past them
+		std::lock_guard<std::mutex> lock(segmentMutex);
+		if (!segmentFirstSeqs.empty() && ackedSeq + 1 < segmentFirstSeqs.front())
+			ackedSeq = segmentFirstSeqs.front() - 1;
+	}
+
+	const uint64_t committed = committedSeq.load(std::memory_order_acquire);
+	uint64_t seq = ackedSeq + 1;
+	if (seq > committed)
+		return true;
+
+	// The backend folds each posted list into one product, so a request carries exactly one
+	batch.clear();
+	uint64_t last = ackedSeq;
+	uint64_t productId = 0;
+	unsigned long long skipped = 0;
+	for (; seq <= committed; seq++)
+	{
+		Record record;
+		if (!readRecord(seq, record))
+		{
+			skipped++;    // unreadable record: skip it rather than block everything behind it
+			last = seq;
+			continue;
+		}
+		if (productId == 0)
+			productId = record.productId;
+		else if (record.productId != productId)
+			break;        // first scan of the next product
+		last = seq;
+		batch.emplace_back(std::string(record.productResult, strnlen(record.productResult, sizeof(record.productResult))),
+						   record.confidence, record.x, record.y);
+	}
+
+	if (!batch.empty())
+	{
+		static Metrics &metrics = Metrics::global();
+		static Histogram &streamSeconds = metrics.histogram("sdbelt_upload_seconds", "Time to get one product's scans acknowledged by the backend",
+			{0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5}, "transport=\"websocket\"");
+		static Histogram &httpSeconds = metrics.histogram("sdbelt_upload_seconds", "Time to get one product's scans acknowledged by the backend",
+			{0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5}, "transport=\"http\"");
+		static Counter &uploadFailures = metrics.counter("sdbelt_upload_failures_total", "Products neither transport could deliver");
+
+		auto started = std::chrono::steady_clock::now();
+		const Delivery delivery = config.stream ? config.stream(productId, batch) : Delivery::NotSent;
+		if (delivery == Delivery::Stored)
+		{
+			streamSeconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+		}
+		else if (delivery == Delivery::InFlight)
+		{
+			// The backend may already have it; a POST could store it twice, so wait for the stream's answer
+			++unconfirmed;
+			return false;
+		}
+		else
+		{
+			started = std::chrono::steady_clock::now();
+			if (!client.sendScans(config.host, config.port, config.path, batch))
+			{
+				++shipFailures;
+				uploadFailures.inc();
+				return false;
+			}
+			httpSeconds.observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+		}
+		shipped += batch.size();
+	}
+
+	corrupt += skipped;
+	ackedSeq = last;
+	writeCursor(last);
+	dropShippedSegments();
+	return true;
+}
+
+bool ScanJournal::readRecord(uint64_t sequence, Record &out)
+{
+	uint64_t firstSeq = 0;
+	{
+		std::lock_guard<std::mutex> lock(segmentMutex);
+		auto it = std::upper_bound(segmentFirstSeqs.begin(), segmentFirstSeqs.end(), sequence);
+		if (it == segmentFirstSeqs.begin())
+			return false;
+		firstSeq = *(it - 1);
+	}
+	if (sequence - firstSeq >= config.segmentRecords)
+		return false;
+
+	// pread sees the writer's MAP_SHARED stores through the page cache
+	int fd = ::open(segmentPath(firstSeq).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+	ssize_t n = ::pread(fd, &out, sizeof(out), static_cast<off_t>((sequence - firstSeq) * sizeof(Record)));
+	::close(fd);
+
+	return n == static_cast<ssize_t>(sizeof(out)) && out.magic == RECORD_MAGIC &&
+		   out.sequence == sequence && out.checksum == checksum(out);
+}
+
+void ScanJournal::dropShippedSegments()
+{
+	std::lock_guard<std::mutex> lock(segmentMutex);
+	const uint64_t acked = ackedSeq;
+	// keep at least the current and the spare segment
+	while (segmentFirstSeqs.size() > 2 && segmentFirstSeqs.front() + config.segmentRecords - 1 <= acked)
+	{
+		::unlink(segmentPath(segmentFirstSeqs.front()).c_str());
+		segmentFirstSeqs.pop_front();
+	}
+}
+
+// A long outage must not fill the disk: drop the oldest segment, newest scans win
+void ScanJournal::enforceDiskBound()
+{
+	std::lock_guard<std::mutex> lock(segmentMutex);
+	while (segmentFirstSeqs.size() > config.maxSegments)
+	{
+		const uint64_t first = segmentFirstSeqs.front();
+		const uint64_t last = first + config.segmentRecords - 1;
+		if (ackedSeq < last)
+		{
+			evicted += last - std::max(ackedSeq.load(), first - 1);
+			ackedSeq = last;
+			writeCursor(last);
+		}
+		::unlink(segmentPath(first).c_str());
+		segmentFirstSeqs.pop_front();
+		std::cerr << "Journal: disk bound reached, dropped unshipped segment " << first << std::endl;
+	}
+}
+
+ScanJournal::Stats ScanJournal::getStats() const
+{
+	Stats s;
+	s.appended = appended.load();
+	s.dropped = dropped.load();
+	s.shipped = shipped.load();
+	s.shipFailures = shipFailures.load();
+	s.unconfirmed = unconfirmed.load();
+	s.evicted = evicted.load();
+	s.corrupt = corrupt.load();
+	s.lastSequence = committedSeq.load();
+	s.durableSequence = durableSeq.load();
+	s.ackedSequence = ackedSeq.load();
+	s.pending = s.lastSequence > s.ackedSequence ? s.lastSequence - s.ackedSequence : 0;
+
+	std::lock_guard<std::mutex> lock(segmentMutex);
+	s.segments = segmentFirstSeqs.size();
+	return s;
+}
+
+std::string ScanJournal::stateJson() const
+{
+	Stats s = getStats();
+
+	std::ostringstream json;
+	json << "{\"directory\":\"" << config.directory << "\""
+		 << ",\"encoding\":\"" << (HttpClient::activeEncoding() == HttpClient::Encoding::Cbor ? "cbor" : "json") << "\""
+		 << ",\"segments\":" << s.segments
+		 << ",\"lastSequence\":" << s.lastSequence
+		 << ",\"durableSequence\":" << s.durableSequence
+		 << ",\"ackedSequence\":" << s.ackedSequence
+		 << ",\"pending\":" << s.pending
+		 << ",\"appended\":" << s.appended
+		 << ",\"dropped\":" << s.dropped
+		 << ",\"shipped\":" << s.shipped
+		 << ",\"shipFailures\":" << s.shipFailures
+		 << ",\"unconfirmed\":" << s.unconfirmed
+		 << ",\"evicted\":" << s.evicted
+		 << ",\"corrupt\":" << s.corrupt << "}";
+	return json.str();
+}
@@ -0,0 +1,201 @@
+/**
+ * ScanJournal.h
+ *
+ * Store-and-forward journal for scan results. Every decided product is
+ * appended to a memory-mapped, preallocated segment file (fixed-size
+ * records, no allocation, no syscall on the decision path). A flusher
+ * thread msyncs the new records in batches and prepares the next segment
+ * ahead of time; a shipper thread replays records the backend has not
+ * acknowledged yet to the scans endpoint, one product per request (the
+ * backend turns each posted list into one product record), backing off
+ * while the backend is unreachable.
+ */
+
+#ifndef SCAN_JOURNAL_H
+#define SCAN_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "scan_request_dto.h"
+
+class HttpClient;
+
+class ScanJournal
+{
+public:
+	enum class Delivery
+	{
+		Stored,
+		NotSent,     // nothing reached the backend, post it instead
+		InFlight     // sent but unconfirmed; asked again later, never posted
+	};
+
+	struct Config
+	{
+		std::string directory;
+		size_t segmentRecords;       // records per segment file
+		size_t maxSegments;          // disk bound; the oldest unshipped segment is dropped beyond it
+		int flushIntervalMs;         // msync batching
+		size_t shipBatch;            // products shipped per wake-up, one request each
+		int shipIntervalMs;          // idle poll of the shipper
+		int retryMaxMs;              // backoff ceiling while the backend is down
+		std::string host;
+		int port;
+		std::string path;
+		// Preferred transport when set (the backend WebSocket), given the product id so a retry
+		// is matched to what it already sent; only NotSent falls back to the HTTP POST
+		std::function<Delivery(uint64_t productId, const std::vector<ScanRequestDTO> &)> stream;
+	};
+
+	struct Stats
+	{
+		unsigned long long appended = 0;
+		unsigned long long dropped = 0;      // no segment could be created to rotate into (disk error)
+		unsigned long long shipped = 0;
+		unsigned long long shipFailures = 0;
+		unsigned long long unconfirmed = 0;  // ship attempts that found the streamed product still unanswered
+		unsigned long long evicted = 0;      // unshipped records lost to the disk bound
+		unsigned long long corrupt = 0;      // records that failed validation on replay
+		unsigned long long pending = 0;
+		uint64_t lastSequence = 0;
+		uint64_t durableSequence = 0;
+		uint64_t ackedSequence = 0;
+		size_t segments = 0;
+	};
+
+	// One fixed-size record, written in place into the mapping
+	struct Record
+	{
+		uint32_t magic;
+		uint32_t checksum;           // FNV-1a over the bytes after this field
+		uint64_t sequence;
+		uint64_t productId;          // sequence of the product's first scan; a product's scans are contiguous
+		int64_t timestampMs;
+		float confidence;
+		float x;
+		float y;
+		char productResult[20];      // NUL padded, truncated if longer
+	};
+	static_assert(sizeof(Record) == 64, "journal record layout changed");
+
+private:
+	struct Mapping
+	{
+		uint64_t firstSeq = 0;
+		int fd = -1;
+		Record *records = nullptr;
+	};
+
+	Config config;
+
+	// Append side; appendMutex is only ever held for a memcpy or a pointer swap
+	std::mutex appendMutex;
+	Mapping current;
+	size_t currentCount = 0;
+	Mapping spare;                   // next segment, created by the flusher
+	Mapping retiring;                // full segment waiting for its final msync
+	uint64_t nextSeq = 1;
+	std::atomic<uint64_t> committedSeq{0};
+	std::atomic<uint64_t> durableSeq{0};
+	size_t flushedCount = 0;
+
+	// Segment files oldest first, including the current one; guarded by segmentMutex
+	mutable std::mutex segmentMutex;
+	std::deque<uint64_t> segmentFirstSeqs;
+
+	std::atomic<uint64_t> ackedSeq{0};   // written by the shipper only
+	int dirFd = -1;
+
+	std::thread flusherThread;
+	std::thread shipperThread;
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+
+	std::atomic<unsigned long long> appended{0};
+	std::atomic<unsigned long long> dropped{0};
+	std::atomic<unsigned long long> shipped{0};
+	std::atomic<unsigned long long> shipFailures{0};
+	std::atomic<unsigned long long> unconfirmed{0};
+	std::atomic<unsigned long long> evicted{0};
+	std::atomic<unsigned long long> corrupt{0};
+
+	std::string segmentPath(uint64_t firstSeq) const;
+	bool openSegment(uint64_t firstSeq, bool create, Mapping &out);
+	void closeSegment(Mapping &mapping);
+	bool rotate();
+	void write(const ScanRequestDTO &scan, uint64_t productId);
+	bool appendProduct(const ScanRequestDTO *scans, size_t count);
+	void recover();
+	uint64_t readCursor();
+	bool writeCursor(uint64_t sequence);
+
+	void flusherLoop();
+	void flushOnce();
+	void shipperLoop();
+	bool shipProduct(HttpClient &client, std::vector<ScanRequestDTO> &batch);
+	bool readRecord(uint64_t sequence, Record &out);
+	void dropShippedSegments();
+	void enforceDiskBound();
+
+	static uint32_t checksum(const Record &record);
+
+public:
+	/**
+	 * Constructor - recovers existing segments and the ack cursor, then starts the flusher and shipper
+	 *
+	 * @param cfg Directory, segment geometry, batching and backend endpoint
+	 */
+	explicit ScanJournal(const Config &cfg);
+
+	/**
+	 * Destructor - flushes and stops both threads
+	 */
+	~ScanJournal();
+
+	ScanJournal(const ScanJournal&) = delete;
+	ScanJournal& operator=(const ScanJournal&) = delete;
+
+	/**
+	 * Append a product that was decided from a single scan
+	 *
+	 * @param scan Decided scan
+	 * @return false if the record was dropped (no segment could be created)
+	 */
+	bool append(const ScanRequestDTO &scan);
+
+	/**
+	 * Append every scan of one decided product; it is shipped as one request
+	 *
+	 * Never allocates. Only blocks on I/O when the flusher has not prepared
+	 * the next segment in time, to create it instead of dropping scans.
+	 *
+	 * @param scans Scans of the product, one per camera
+	 * @return false if the product was dropped (no segment could be created)
+	 */
+	bool append(const std::vector<ScanRequestDTO> &scans);
+
+	/**
+	 * Flush what is appended and stop the threads; unshipped records wait on disk for the next start
+	 */
+	void stop();
+
+	/**
+	 * Get a copy of the counters
+	 */
+	Stats getStats() const;
+
+	/**
+	 * Get the counters as a JSON object
+	 */
+	std::string stateJson() const;
+};
+
+#endif // SCAN_JOURNAL_H
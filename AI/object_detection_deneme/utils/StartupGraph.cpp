@@ -0,0 +1,242 @@
+/**
+ * StartupGraph.cpp
+ *
+ * Implementation of the parallel startup graph.
+ */
+
+#include "StartupGraph.h"
+#include "Metrics.h"
+#include "json_writer.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+static double secondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+	return std::chrono::duration<double>(to - from).count();
+}
+
+void StartupGraph::add(const std::string &name, std::vector<std::string> after, std::function<bool()> run, bool required)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto indexOf = [this](const std::string &wanted) {
+		auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase &p) { return p.name == wanted; });
+		return static_cast<size_t>(it - phases.begin());
+	};
+	if (indexOf(name) != phases.size())
+		throw std::invalid_argument("startup phase added twice: " + name);
+
+	Phase phase;
+	phase.name = name;
+	phase.run = std::move(run);
+	phase.required = required;
+	for (const std::string &dependency : after)
+	{
+		size_t index = indexOf(dependency);
+		if (index == phases.size())
+			throw std::invalid_argument("startup phase " + name + " needs unknown phase " + dependency);
+		phase.after.push_back(index);
+	}
+	phases.push_back(std::move(phase));
+}
+
+bool StartupGraph::run()
+{
+	size_t count;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		startedAt = std::chrono::steady_clock::now();
+		count = phases.size();
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		workers.emplace_back(&StartupGraph::runPhase, this, i);
+	for (std::thread &worker : workers)
+		worker.join();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::none_of(phases.begin(), phases.end(),
+		[](const Phase &p) { return p.required && p.status != Status::Done; });
+}
+
+void StartupGraph::runPhase(size_t index)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	Phase &phase = phases[index];
+	set_thread_name(("init-" + phase.name).c_str());
+
+	changed.wait(lock, [&]() {
+		return std::all_of(phase.after.begin(), phase.after.end(), [this](size_t dependency) {
+			return phases[dependency].status != Status::Pending && phases[dependency].status != Status::Running;
+		});
+	});
+
+	for (size_t dependency : phase.after)
+	{
+		if (phases[dependency].status != Status::Done)
+		{
+			phase.status = Status::Skipped;
+			phase.error = "needs " + phases[dependency].name;
+			phase.startedAt = phase.finishedAt = std::chrono::steady_clock::now();
+			changed.notify_all();
+			return;
+		}
+	}
+
+	phase.status = Status::Running;
+	phase.startedAt = std::chrono::steady_clock::now();
+	lock.unlock();
+
+	bool ok = false;
+	std::string error;
+	try
+	{
+		ok = phase.run();
+		if (!ok)
+			error = "failed";
+	}
+	catch (const std::exception &e)
+	{
+		error = e.what();
+	}
+
+	lock.lock();
+	phase.finishedAt = std::chrono::steady_clock::now();
+	phase.status = ok ? Status::Done : Status::Failed;
+	phase.error = std::move(error);
+	changed.notify_all();
+}
+
+void StartupGraph::markReady()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	readyAt = std::chrono::steady_clock::now();
+}
+
+const char *StartupGraph::statusName(Status status)
+{
+	switch (status)
+	{
+		case Status::Pending: return "pending";
+		case Status::Running: return "running";
+		case Status::Done: return "done";
+		case Status::Failed: return "failed";
+		case Status::Skipped: return "skipped";
+	}
+	return "unknown";
+}
+
+// Caller holds the mutex
+StartupGraph::Timing StartupGraph::timingOf(const Phase &phase) const
+{
+	const auto now = std::chrono::steady_clock::now();
+	const bool started = phase.startedAt != std::chrono::steady_clock::time_point{};
+	const bool finished = phase.finishedAt != std::chrono::steady_clock::time_point{};
+
+	Timing timing;
+	timing.name = phase.name;
+	timing.status = phase.status;
+	timing.required = phase.required;
+	timing.startSeconds = started ? secondsBetween(startedAt, phase.startedAt) : 0.0;
+	timing.seconds = started ? secondsBetween(phase.startedAt, finished ? phase.finishedAt : now) : 0.0;
+	timing.error = phase.error;
+	return timing;
+}
+
+std::vector<StartupGraph::Timing> StartupGraph::timings() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<Timing> out;
+	out.reserve(phases.size());
+	for (const Phase &phase : phases)
+		out.push_back(timingOf(phase));
+	return out;
+}
+
+std::string StartupGraph::timingsJson() const
+{
+	double readySeconds = std::numeric_limits<double>::quiet_NaN();    // written as null
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (readyAt != std::chrono::steady_clock::time_point{})
+			readySeconds = secondsBetween(startedAt, readyAt);
+	}
+
+	std::string out;
+	JsonWriter json(out);
+	json.beginObject();
+	json.key("readySeconds");
+	json.number(readySeconds);
+	json.key("phases");
+	json.beginArray();
+	for (const Timing &timing : timings())
+	{
+		json.beginObject();
+		json.key("name");
+		json.string(timing.name);
+		json.key("status");
+		json.string(statusName(timing.status));
+		json.key("required");
+		json.boolean(timing.required);
+		json.key("startSeconds");
+		json.number(timing.startSeconds);
+		json.key("seconds");
+		json.number(timing.seconds);
+		if (!timing.error.empty())
+		{
+			json.key("error");
+			json.string(timing.error);
+		}
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
+	return out;
+}
+
+std::string StartupGraph::summary() const
+{
+	std::ostringstream table;
+	table << std::fixed << std::setprecision(2);
+	for (const Timing &timing : timings())
+	{
+		table << "  " << std::left << std::setw(12) << timing.name << std::setw(8) << statusName(timing.status)
+			  << std::right << std::setw(7) << timing.startSeconds << " s +" << std::setw(7) << timing.seconds << " s";
+		if (!timing.error.empty())
+			table << "  (" << timing.error << ")";
+		table << '\n';
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (readyAt != std::chrono::steady_clock::time_point{})
+		table << "  ready after " << secondsBetween(startedAt, readyAt) << " s\n";
+	return table.str();
+}
+
+void StartupGraph::publishMetrics() const
+{
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const Phase &phase : phases)
+			names.push_back(phase.name);
+	}
+
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		Metrics::global().gauge("sdbelt_startup_phase_seconds", "Duration of one cold-start phase",
+			[this, i]() { return timings()[i].seconds; }, "phase=\"" + names[i] + "\"");
+	}
+	Metrics::global().gauge("sdbelt_startup_ready_seconds", "Cold start until the line was ready to sort, NaN before that",
+		[this]() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return readyAt == std::chrono::steady_clock::time_point{}
+				? std::numeric_limits<double>::quiet_NaN() : secondsBetween(startedAt, readyAt);
+		});
+}
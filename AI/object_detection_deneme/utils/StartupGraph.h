@@ -0,0 +1,109 @@
+/**
+ * StartupGraph.h
+ *
+ * Cold-start initialization as a dependency graph. Each phase names the
+ * phases it needs and runs on its own thread as soon as they have finished,
+ * so flashing or probing the Arduino, loading the model and opening the
+ * cameras overlap instead of adding up. Every phase is timed, and the
+ * timings are reported on stdout, over HTTP and as metrics, so a slow
+ * restart points at its cause.
+ */
+
+#ifndef STARTUP_GRAPH_H
+#define STARTUP_GRAPH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class StartupGraph
+{
+public:
+	enum class Status { Pending, Running, Done, Failed, Skipped };
+
+	struct Timing
+	{
+		std::string name;
+		Status status;
+		bool required;
+		double startSeconds;         // since run() was called
+		double seconds;              // duration of the phase itself
+		std::string error;
+	};
+
+	StartupGraph() = default;
+	StartupGraph(const StartupGraph&) = delete;
+	StartupGraph& operator=(const StartupGraph&) = delete;
+
+	/**
+	 * Add a phase; its dependencies must have been added before it, which keeps the graph acyclic
+	 *
+	 * @param name Phase name, unique
+	 * @param after Phases that must be done before this one starts
+	 * @param run Work of the phase; false or an exception fails it
+	 * @param required false if startup may go on without it; its dependents are still skipped
+	 * @throws std::invalid_argument on a duplicate name or an unknown dependency
+	 */
+	void add(const std::string &name, std::vector<std::string> after, std::function<bool()> run, bool required = true);
+
+	/**
+	 * Run every phase once its dependencies are done and wait for all of them
+	 *
+	 * @return false if a required phase failed or was skipped
+	 */
+	bool run();
+
+	/**
+	 * Record that the line is ready to sort, the end of the cold start
+	 */
+	void markReady();
+
+	/**
+	 * Phase timings in the order the phases were added
+	 */
+	std::vector<Timing> timings() const;
+
+	/**
+	 * Phase timings and time to ready as JSON
+	 */
+	std::string timingsJson() const;
+
+	/**
+	 * Human-readable timing table
+	 */
+	std::string summary() const;
+
+	/**
+	 * Export the phase durations and time to ready as gauges; the graph must outlive the exporter
+	 */
+	void publishMetrics() const;
+
+	static const char *statusName(Status status);
+
+private:
+	struct Phase
+	{
+		std::string name;
+		std::vector<size_t> after;
+		std::function<bool()> run;
+		bool required;
+		Status status = Status::Pending;
+		std::chrono::steady_clock::time_point startedAt{};
+		std::chrono::steady_clock::time_point finishedAt{};
+		std::string error;
+	};
+
+	mutable std::mutex mutex;
+	std::condition_variable changed;
+	std::vector<Phase> phases;
+	std::chrono::steady_clock::time_point startedAt{};
+	std::chrono::steady_clock::time_point readyAt{};
+
+	void runPhase(size_t index);
+	Timing timingOf(const Phase &phase) const;
+};
+
+#endif // STARTUP_GRAPH_H
@@ -0,0 +1,306 @@
+/**
+ * SystemSampler.cpp
+ *
+ * Implementation of the background system sampler.
+ */
+
+#include "SystemSampler.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+static int openSource(const std::string &path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		std::cerr << "[sampler] cannot open " << path << ": " << strerror(errno) << std::endl;
+	return fd;
+}
+
+SystemSampler::SystemSampler(const Config &config)
+	: config(config)
+{
+	ticksPerSecond = sysconf(_SC_CLK_TCK);
+	if (ticksPerSecond <= 0)
+		ticksPerSecond = 100;
+
+	statFd = openSource("/proc/stat");
+	meminfoFd = openSource("/proc/meminfo");
+	thermalFd = openSource(config.thermalPath);
+	scratch.reserve(8192);
+
+	// first sample only sets the baseline for the deltas
+	sample();
+	samplerThread = std::thread(&SystemSampler::samplerLoop, this);
+}
+
+SystemSampler::~SystemSampler()
+{
+	stop();
+	for (int fd : {statFd, meminfoFd, thermalFd})
+		if (fd >= 0)
+			::close(fd);
+	for (auto &entry : tasks)
+		if (entry.second.fd >= 0)
+			::close(entry.second.fd);
+}
+
+void SystemSampler::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (samplerThread.joinable())
+		samplerThread.join();
+}
+
+void SystemSampler::samplerLoop()
+{
+	set_thread_name("sampler");
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	while (!stopping)
+	{
+		wake.wait_for(lock, std::chrono::milliseconds(config.intervalMs));
+		if (stopping)
+			break;
+		lock.unlock();
+		sample();
+		lock.lock();
+	}
+}
+
+// Whole file from offset 0, without reopening it
+bool SystemSampler::readFile(int fd, std::string &out)
+{
+	out.clear();
+	if (fd < 0)
+		return false;
+
+	size_t used = 0;
+	while (true)
+	{
+		if (out.size() < used + 4096)
+			out.resize(used + 4096);
+		ssize_t n = ::pread(fd, &out[used], out.size() - used, static_cast<off_t>(used));
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			out.clear();
+			readErrors++;
+			return false;
+		}
+		if (n == 0)
+			break;
+		used += static_cast<size_t>(n);
+	}
+	out.resize(used);
+	return used > 0;
+}
+
+void SystemSampler::sample()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const double elapsed = previousSample.time_since_epoch().count() == 0
+		? 0.0
+		: std::chrono::duration<double>(now - previousSample).count();
+	previousSample = now;
+
+	Snapshot snap;
+	snap.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	snap.temperatureC = NAN;
+
+	if (readFile(statFd, scratch))
+		sampleCpu(scratch, snap);
+
+	if (readFile(meminfoFd, scratch))
+	{
+		const char *total = std::strstr(scratch.c_str(), "MemTotal:");
+		const char *available = std::strstr(scratch.c_str(), "MemAvailable:");
+		if (total)
+			snap.memTotalMiB = std::strtoll(total + 9, nullptr, 10) / 1024;
+		if (available)
+			snap.memAvailableMiB = std::strtoll(available + 13, nullptr, 10) / 1024;
+	}
+
+	if (readFile(thermalFd, scratch))
+	{
+		char *end = nullptr;
+		double millideg = std::strtod(scratch.c_str(), &end);
+		if (end != scratch.c_str())
+			snap.temperatureC = millideg / 1000.0;
+	}
+
+	sampleThreads(elapsed, snap);
+
+	snap.samples = latest.load().samples + 1;
+	latest.store(snap);
+}
+
+// "cpu  user nice system idle iowait irq softirq steal ..." for the total, then one line per core
+void SystemSampler::sampleCpu(const std::string &stat, Snapshot &out)
+{
+	std::vector<CpuTicks> current;
+	current.reserve(MAX_CORES + 1);
+
+	const char *line = stat.c_str();
+	while (line && std::strncmp(line, "cpu", 3) == 0 && current.size() < MAX_CORES + 1)
+	{
+		const char *p = line + 3;
+		while (*p && *p != ' ')
+			p++;
+
+		unsigned long long fields[8] = {};
+		for (auto &field : fields)
+			field = std::strtoull(p, const_cast<char **>(&p), 10);
+
+		CpuTicks ticks;
+		const unsigned long long idle = fields[3] + fields[4];     // idle + iowait
+		for (auto field : fields)
+			ticks.total += field;
+		ticks.busy = ticks.total - idle;
+		current.push_back(ticks);
+
+		line = std::strchr(line, '\n');
+		if (line)
+			line++;
+	}
+
+	auto percent = [](const CpuTicks &now, const CpuTicks &before) {
+		const unsigned long long total = now.total - before.total;
+		return total == 0 ? 0.0f : static_cast<float>(100.0 * (now.busy - before.busy) / total);
+	};
+
+	if (previousCpu.size() == current.size() && !current.empty())
+	{
+		out.cpuPercent = percent(current[0], previousCpu[0]);
+		for (size_t i = 1; i < current.size(); i++)
+			out.corePercent[i - 1] = percent(current[i], previousCpu[i]);
+	}
+	out.coreCount = current.empty() ? 0 : static_cast<uint32_t>(current.size() - 1);
+	previousCpu.swap(current);
+}
+
+// utime + stime of every thread of this process, from /proc/self/task/<tid>/stat
+void SystemSampler::sampleThreads(double elapsedSeconds, Snapshot &out)
+{
+	for (auto &entry : tasks)
+		entry.second.seen = false;
+
+	std::vector<ThreadUsage> usage;
+	DIR *dir = ::opendir("/proc/self/task");
+	if (dir)
+	{
+		while (dirent *ent = ::readdir(dir))
+		{
+			if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+				continue;
+			const int tid = std::atoi(ent->d_name);
+
+			TaskSource &task = tasks[tid];
+			const bool fresh = task.fd < 0;
+			if (fresh)
+				task.fd = ::open(("/proc/self/task/" + std::string(ent->d_name) + "/stat").c_str(), O_RDONLY | O_CLOEXEC);
+			task.seen = true;
+			if (!readFile(task.fd, scratch))
+				continue;
+
+			// comm may contain spaces and parentheses: it ends at the last ')'
+			const size_t open = scratch.find('(');
+			const size_t close = scratch.rfind(')');
+			if (open == std::string::npos || close == std::string::npos || close < open)
+				continue;
+
+			// after ") " come state (field 3) ... utime (14) and stime (15)
+			const char *p = scratch.c_str() + close + 2;
+			for (int field = 3; field < 14 && *p; field++)
+			{
+				p = std::strchr(p, ' ');
+				if (!p)
+					break;
+				p++;
+			}
+			if (!p)
+				continue;
+			char *end = nullptr;
+			const unsigned long long utime = std::strtoull(p, &end, 10);
+			const unsigned long long stime = std::strtoull(end, nullptr, 10);
+			const unsigned long long ticks = utime + stime;
+
+			ThreadUsage thread{};
+			const size_t nameLength = std::min(sizeof(thread.name) - 1, close - open - 1);
+			std::memcpy(thread.name, scratch.data() + open + 1, nameLength);
+			thread.tid = tid;
+			if (!fresh && elapsedSeconds > 0)
+				thread.cpuPercent = static_cast<float>(100.0 * (ticks - task.ticks) / ticksPerSecond / elapsedSeconds);
+			task.ticks = ticks;
+			usage.push_back(thread);
+		}
+		::closedir(dir);
+	}
+
+	// threads that exited since the last sample
+	for (auto it = tasks.begin(); it != tasks.end();)
+	{
+		if (it->second.seen)
+		{
+			++it;
+			continue;
+		}
+		if (it->second.fd >= 0)
+			::close(it->second.fd);
+		it = tasks.erase(it);
+	}
+
+	std::sort(usage.begin(), usage.end(), [](const ThreadUsage &a, const ThreadUsage &b) {
+		return a.cpuPercent > b.cpuPercent;
+	});
+	out.threadCount = static_cast<uint32_t>(std::min(usage.size(), MAX_THREADS));
+	std::copy(usage.begin(), usage.begin() + out.threadCount, out.threads);
+}
+
+std::string SystemSampler::stateJson() const
+{
+	Snapshot s = snapshot();
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(1);
+	json << "{\"timestampMs\":" << s.timestampMs
+		 << ",\"samples\":" << s.samples
+		 << ",\"readErrors\":" << readErrors.load();
+	if (std::isfinite(s.temperatureC))
+		json << ",\"temperatureC\":" << s.temperatureC;
+	else
+		json << ",\"temperatureC\":null";
+	json << ",\"cpuPercent\":" << s.cpuPercent
+		 << ",\"memTotalMiB\":" << s.memTotalMiB
+		 << ",\"memAvailableMiB\":" << s.memAvailableMiB
+		 << ",\"cores\":[";
+	for (uint32_t i = 0; i < s.coreCount; i++)
+		json << (i ? "," : "") << s.corePercent[i];
+	json << "],\"threads\":[";
+	for (uint32_t i = 0; i < s.threadCount; i++)
+	{
+		// thread names are set by us, but comm is user-controlled in general
+		std::string name;
+		for (const char *c = s.threads[i].name; *c; c++)
+			if (*c != '"' && *c != '\\' && static_cast<unsigned char>(*c) >= 0x20)
+				name += *c;
+		json << (i ? "," : "") << "{\"name\":\"" << name << "\",\"tid\":" << s.threads[i].tid
+			 << ",\"cpuPercent\":" << s.threads[i].cpuPercent << "}";
+	}
+	json << "]}";
+	return json.str();
+}
@@ -0,0 +1,125 @@
+/**
+ * SystemSampler.h
+ *
+ * Background sampler for CPU, memory, temperature and per-thread CPU.
+ * The /proc and /sys files stay open and are re-read with pread, and usage
+ * is the delta against the previous sample, so nothing sleeps between two
+ * reads and a failed read only marks the value missing. Each sample is
+ * published as a SeqLock snapshot that the stats uploader, the HTTP
+ * endpoints and the metrics exporter read without blocking the sampler.
+ */
+
+#ifndef SYSTEM_SAMPLER_H
+#define SYSTEM_SAMPLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "seqlock.hpp"
+
+class SystemSampler
+{
+public:
+	static constexpr size_t MAX_CORES = 16;
+	static constexpr size_t MAX_THREADS = 48;
+
+	struct Config
+	{
+		std::string thermalPath;     // millidegrees, e.g. /sys/class/thermal/thermal_zone0/temp
+		int intervalMs;
+	};
+
+	struct ThreadUsage
+	{
+		char name[16];               // comm, as set by set_thread_name
+		int tid;
+		float cpuPercent;            // of one core
+	};
+
+	// Trivially copyable so it can sit in a SeqLock
+	struct Snapshot
+	{
+		long long timestampMs = 0;   // system_clock time of the sample
+		unsigned long long samples = 0;
+		double temperatureC = 0;     // NaN when the thermal zone could not be read
+		float cpuPercent = 0;        // all cores
+		uint32_t coreCount = 0;
+		float corePercent[MAX_CORES] = {};
+		long long memTotalMiB = 0;
+		long long memAvailableMiB = 0;
+		uint32_t threadCount = 0;    // busiest first, at most MAX_THREADS
+		ThreadUsage threads[MAX_THREADS] = {};
+	};
+
+	/**
+	 * Constructor - opens the sources and starts the sampling thread
+	 */
+	explicit SystemSampler(const Config &config);
+
+	/**
+	 * Destructor - stops the thread and closes the sources
+	 */
+	~SystemSampler();
+
+	/**
+	 * Latest published sample; never blocks
+	 */
+	Snapshot snapshot() const { return latest.load(); }
+
+	/**
+	 * Latest sample as JSON, per-core and per-thread usage included
+	 */
+	std::string stateJson() const;
+
+	/**
+	 * Stop sampling
+	 */
+	void stop();
+
+private:
+	struct CpuTicks
+	{
+		unsigned long long busy = 0;
+		unsigned long long total = 0;
+	};
+
+	struct TaskSource
+	{
+		int fd = -1;
+		unsigned long long ticks = 0;    // utime + stime at the previous sample
+		bool seen = false;               // still listed in /proc/self/task this round
+	};
+
+	Config config;
+	int statFd = -1;
+	int meminfoFd = -1;
+	int thermalFd = -1;
+	long ticksPerSecond;
+
+	std::vector<CpuTicks> previousCpu;           // [0] is the aggregate line, then cpu0..N
+	std::map<int, TaskSource> tasks;             // by tid
+	std::chrono::steady_clock::time_point previousSample;
+	std::string scratch;                         // reused read buffer
+	std::atomic<unsigned long long> readErrors{0};
+
+	SeqLock<Snapshot> latest;
+
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread samplerThread;
+
+	void samplerLoop();
+	void sample();
+	bool readFile(int fd, std::string &out);
+	void sampleCpu(const std::string &stat, Snapshot &out);
+	void sampleThreads(double elapsedSeconds, Snapshot &out);
+};
+
+#endif // SYSTEM_SAMPLER_H
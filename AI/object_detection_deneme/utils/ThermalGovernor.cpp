@@ -0,0 +1,154 @@
+/**
+ * ThermalGovernor.cpp
+ *
+ * Implementation of the thermal load-shedding governor.
+ */
+
+#include "ThermalGovernor.h"
+#include "Metrics.h"
+#include "thread_name.hpp"
+#include <cmath>
+#include <sstream>
+
+ThermalGovernor::ThermalGovernor(const Config &config, const SystemSampler &sampler,
+								 std::function<void(Level level, double temperatureC, float cpuPercent)> apply)
+	: config(config), sampler(sampler), apply(std::move(apply))
+{
+	thread = std::thread(&ThermalGovernor::loop, this);
+}
+
+ThermalGovernor::~ThermalGovernor()
+{
+	stop();
+}
+
+void ThermalGovernor::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (thread.joinable())
+		thread.join();
+}
+
+ThermalGovernor::Level ThermalGovernor::level() const
+{
+	return static_cast<Level>(current.load(std::memory_order_relaxed));
+}
+
+const char *ThermalGovernor::levelName(Level level)
+{
+	switch (level)
+	{
+		case Level::None: return "none";
+		case Level::Preview: return "preview";
+		case Level::Archive: return "archive";
+		case Level::Gate: return "gate";
+	}
+	return "unknown";
+}
+
+// Heat is answered at once, CPU pressure one step per interval, and a release only after a calm hold
+int ThermalGovernor::decide(const Config &config, int level, double temperatureC, float cpuPercent,
+							std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point &calmSince)
+{
+	// a NaN temperature compares false everywhere, leaving the decision to the CPU load
+	int byTemperature = 0;
+	while (byTemperature < MAX_LEVEL && temperatureC >= config.shedAtC[byTemperature])
+		byTemperature++;
+
+	if (byTemperature > level)
+	{
+		calmSince = now;
+		return byTemperature;
+	}
+	if (cpuPercent >= config.cpuHighPercent && level < MAX_LEVEL)
+	{
+		calmSince = now;
+		return level + 1;
+	}
+	if (level == 0)
+		return 0;
+
+	const bool calm = !(temperatureC >= config.shedAtC[level - 1] - config.hysteresisC)
+		&& cpuPercent < config.cpuLowPercent;
+	if (!calm)
+	{
+		calmSince = now;
+		return level;
+	}
+	if (now - calmSince >= std::chrono::milliseconds(config.releaseHoldMs))
+	{
+		calmSince = now;    // the next release needs its own hold
+		return level - 1;
+	}
+	return level;
+}
+
+void ThermalGovernor::loop()
+{
+	set_thread_name("thermal-gov");
+	static Counter &raises = Metrics::global().counter("sdbelt_shed_changes_total", "Thermal shed level changes", "direction=\"raise\"");
+	static Counter &releases = Metrics::global().counter("sdbelt_shed_changes_total", "Thermal shed level changes", "direction=\"release\"");
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping)
+	{
+		wake.wait_for(lock, std::chrono::milliseconds(config.intervalMs), [this]() { return stopping; });
+		if (stopping)
+			break;
+		lock.unlock();
+
+		const SystemSampler::Snapshot sample = sampler.snapshot();
+		const int level = current.load(std::memory_order_relaxed);
+		int next = level;
+		if (sample.samples > 1)    // the first sample has no CPU delta yet
+			next = decide(config, level, sample.temperatureC, sample.cpuPercent, std::chrono::steady_clock::now(), calmSince);
+
+		if (next != level)
+		{
+			current.store(next, std::memory_order_relaxed);
+			(next > level ? raises : releases).inc();
+			if (apply)
+				apply(static_cast<Level>(next), sample.temperatureC, sample.cpuPercent);
+		}
+
+		lock.lock();
+		stats.temperatureC = sample.temperatureC;
+		stats.cpuPercent = sample.cpuPercent;
+		if (next > level)
+			stats.raised++;
+		else if (next < level)
+			stats.released++;
+	}
+}
+
+ThermalGovernor::Stats ThermalGovernor::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+std::string ThermalGovernor::stateJson() const
+{
+	Stats s = getStats();
+
+	std::ostringstream json;
+	json << "{\"level\":" << current.load()
+		 << ",\"shedding\":\"" << levelName(level()) << "\""
+		 << ",\"shedAtC\":[" << config.shedAtC[0] << "," << config.shedAtC[1] << "," << config.shedAtC[2] << "]"
+		 << ",\"hysteresisC\":" << config.hysteresisC
+		 << ",\"cpuHighPercent\":" << config.cpuHighPercent
+		 << ",\"cpuLowPercent\":" << config.cpuLowPercent
+		 << ",\"temperatureC\":";
+	if (std::isnan(s.temperatureC))
+		json << "null";
+	else
+		json << s.temperatureC;
+	json << ",\"cpuPercent\":" << s.cpuPercent
+		 << ",\"raised\":" << s.raised
+		 << ",\"released\":" << s.released << "}";
+	return json.str();
+}
@@ -0,0 +1,121 @@
+/**
+ * ThermalGovernor.h
+ *
+ * Sheds optional work before the SoC throttles. When the kernel throttles,
+ * every thread slows down, inference and actuation included, and sorting
+ * deadlines are missed. The governor watches the system sampler's
+ * temperature and CPU load and sheds in a fixed order: preview frame rate
+ * and quality first, then archiving, then motion-gate resolution. It never
+ * touches inference or actuation. A level is taken as soon as it is needed
+ * and given back one step at a time, only after the device has stayed cool
+ * for a while, so the line does not oscillate around a threshold.
+ */
+
+#ifndef THERMAL_GOVERNOR_H
+#define THERMAL_GOVERNOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "SystemSampler.h"
+
+class ThermalGovernor
+{
+public:
+	// Each level keeps everything shed by the levels below it
+	enum class Level { None, Preview, Archive, Gate };
+	static constexpr int MAX_LEVEL = static_cast<int>(Level::Gate);
+
+	struct Config
+	{
+		double shedAtC[MAX_LEVEL];   // temperature that starts shedding Preview, Archive, Gate
+		double hysteresisC;          // a level is released this far below its threshold
+		float cpuHighPercent;        // whole-machine CPU that sheds one more level
+		float cpuLowPercent;         // CPU below which a level may be released
+		int intervalMs;              // evaluation period
+		int releaseHoldMs;           // calm time needed before each release
+	};
+
+	struct Stats
+	{
+		unsigned long long raised = 0;
+		unsigned long long released = 0;
+		double temperatureC = 0;
+		float cpuPercent = 0;
+	};
+
+	/**
+	 * Constructor - starts evaluating the sampler's snapshots
+	 *
+	 * @param config Thresholds and timing
+	 * @param sampler Source of temperature and CPU load; must outlive the governor
+	 * @param apply Called from the governor thread on every change with the new level and the inputs that caused it
+	 */
+	ThermalGovernor(const Config &config, const SystemSampler &sampler,
+					std::function<void(Level level, double temperatureC, float cpuPercent)> apply);
+
+	/**
+	 * Destructor - stops the thread
+	 */
+	~ThermalGovernor();
+
+	ThermalGovernor(const ThermalGovernor&) = delete;
+	ThermalGovernor& operator=(const ThermalGovernor&) = delete;
+
+	/**
+	 * Current shed level; lock-free
+	 */
+	Level level() const;
+
+	/**
+	 * Get a copy of the counters and the last inputs
+	 */
+	Stats getStats() const;
+
+	/**
+	 * Level, thresholds and counters as JSON
+	 */
+	std::string stateJson() const;
+
+	/**
+	 * Stop evaluating; the current level stays applied
+	 */
+	void stop();
+
+	static const char *levelName(Level level);
+
+	/**
+	 * One evaluation: the level to shed at next
+	 *
+	 * @param config Thresholds and timing
+	 * @param level Level currently shed, 0 to MAX_LEVEL
+	 * @param temperatureC SoC temperature, NaN if unknown
+	 * @param cpuPercent Whole-machine CPU load
+	 * @param now Time of the evaluation
+	 * @param calmSince Start of the current calm period; updated
+	 */
+	static int decide(const Config &config, int level, double temperatureC, float cpuPercent,
+					  std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point &calmSince);
+
+private:
+	Config config;
+	const SystemSampler &sampler;
+	std::function<void(Level, double, float)> apply;
+
+	std::atomic<int> current{0};
+	std::chrono::steady_clock::time_point calmSince{};
+
+	mutable std::mutex mutex;
+	Stats stats;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread thread;
+
+	void loop();
+};
+
+#endif // THERMAL_GOVERNOR_H
@@ -0,0 +1,441 @@
+/**
+ * TimeSeriesStore.cpp
+ *
+ * Implementation of the memory-mapped multi-resolution history.
+ */
+
+#include "TimeSeriesStore.h"
+#include "json_writer.h"
+#include "thread_name.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr uint32_t STORE_MAGIC = 0x31535354;    // "TSS1"
+static constexpr uint32_t STORE_VERSION = 1;
+static constexpr size_t HEADER_BYTES = 64;             // rings start cache-line aligned
+
+static int64_t floorTo(int64_t seconds, long long step)
+{
+	int64_t rem = seconds % step;
+	return seconds - (rem < 0 ? rem + step : rem);
+}
+
+/* --- Accumulator -------------------------------------------------------------- */
+
+// Means are weighted by the samples behind each finer slot; missing values do not count
+void TimeSeriesStore::Accumulator::add(const Slot &slot)
+{
+	samples += slot.samples;
+	for (int i = 0; i < SERIES; i++)
+	{
+		if (!std::isfinite(slot.mean[i]))
+			continue;
+		if (weight[i] == 0)
+		{
+			min[i] = slot.min[i];
+			max[i] = slot.max[i];
+		}
+		else
+		{
+			min[i] = std::min(min[i], slot.min[i]);
+			max[i] = std::max(max[i], slot.max[i]);
+		}
+		sum[i] += static_cast<double>(slot.mean[i]) * slot.samples;
+		weight[i] += slot.samples;
+	}
+}
+
+TimeSeriesStore::Slot TimeSeriesStore::Accumulator::finish() const
+{
+	Slot slot{};
+	slot.startSec = startSec;
+	slot.samples = samples;
+	for (int i = 0; i < SERIES; i++)
+	{
+		const bool any = weight[i] > 0;
+		slot.mean[i] = any ? static_cast<float>(sum[i] / weight[i]) : NAN;
+		slot.min[i] = any ? min[i] : NAN;
+		slot.max[i] = any ? max[i] : NAN;
+	}
+	return slot;
+}
+
+/* --- Store ------------------------------------------------------------------- */
+
+TimeSeriesStore::TimeSeriesStore(const Config &config)
+	: config(config)
+{
+	if (!map())
+	{
+		std::cerr << "History: store unavailable, nothing will be recorded" << std::endl;
+		return;
+	}
+	rebuildPending();
+	if (config.sample)
+		recorderThread = std::thread(&TimeSeriesStore::recorderLoop, this);
+}
+
+TimeSeriesStore::~TimeSeriesStore()
+{
+	stop();
+	if (header)
+		::munmap(header, mappedBytes);
+	if (fd >= 0)
+		::close(fd);
+}
+
+void TimeSeriesStore::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		if (stopping)
+			return;
+		stopping = true;
+	}
+	wake.notify_all();
+	if (recorderThread.joinable())
+		recorderThread.join();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (header)
+		::msync(header, mappedBytes, MS_SYNC);
+}
+
+// One preallocated file: header, then the rings from fine to coarse. A file
+// written with another layout is reset rather than misread.
+bool TimeSeriesStore::map()
+{
+	size_t bytes = HEADER_BYTES;
+	for (uint32_t slots : config.slots)
+		bytes += static_cast<size_t>(slots) * sizeof(Slot);
+
+	fd = ::open(config.path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		std::cerr << "History: cannot open " << config.path << ": " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	struct stat st{};
+	bool sized = ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == bytes;
+	if (!sized && (::ftruncate(fd, static_cast<off_t>(bytes)) != 0 || ::posix_fallocate(fd, 0, static_cast<off_t>(bytes)) != 0))
+	{
+		std::cerr << "History: cannot allocate " << config.path << std::endl;
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+
+	void *mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		std::cerr << "History: cannot map " << config.path << ": " << std::strerror(errno) << std::endl;
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	mappedBytes = bytes;
+	header = static_cast<Header *>(mapping);
+
+	char *cursor = static_cast<char *>(mapping) + HEADER_BYTES;
+	for (int r = 0; r < RESOLUTIONS; r++)
+	{
+		rings[r] = reinterpret_cast<Slot *>(cursor);
+		cursor += static_cast<size_t>(config.slots[r]) * sizeof(Slot);
+	}
+
+	bool valid = header->magic == STORE_MAGIC && header->version == STORE_VERSION
+		&& header->series == SERIES && header->slotBytes == sizeof(Slot);
+	for (int r = 0; r < RESOLUTIONS && valid; r++)
+		valid = header->slots[r] == config.slots[r];
+	if (!valid)
+	{
+		std::memset(mapping, 0, bytes);
+		header->magic = STORE_MAGIC;
+		header->version = STORE_VERSION;
+		header->series = SERIES;
+		header->slotBytes = sizeof(Slot);
+		for (int r = 0; r < RESOLUTIONS; r++)
+			header->slots[r] = config.slots[r];
+		::msync(mapping, bytes, MS_SYNC);
+		std::cout << "History: initialised " << config.path << " (" << bytes / 1024 << " KiB)" << std::endl;
+	}
+	return true;
+}
+
+// After a restart: roll up whatever finer slots the coarser rings have not seen yet
+void TimeSeriesStore::rebuildPending()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (int coarse = Hour; coarse > Second; coarse--)
+	{
+		const int fine = coarse - 1;
+		int64_t covered = 0;
+		const uint64_t coarseCount = std::min<uint64_t>(header->written[coarse], config.slots[coarse]);
+		for (uint64_t i = header->written[coarse] - coarseCount; i < header->written[coarse]; i++)
+			covered = std::max<int64_t>(covered, rings[coarse][i % config.slots[coarse]].startSec + STEP_SECONDS[coarse]);
+
+		std::vector<Slot> unrolled;
+		const uint64_t fineCount = std::min<uint64_t>(header->written[fine], config.slots[fine]);
+		for (uint64_t i = header->written[fine] - fineCount; i < header->written[fine]; i++)
+		{
+			const Slot &slot = rings[fine][i % config.slots[fine]];
+			if (slot.startSec != 0 && slot.startSec >= covered)
+				unrolled.push_back(slot);
+		}
+		std::sort(unrolled.begin(), unrolled.end(), [](const Slot &a, const Slot &b) { return a.startSec < b.startSec; });
+		for (const Slot &slot : unrolled)
+			feed(static_cast<Resolution>(coarse), slot);
+	}
+}
+
+// Caller holds mutex
+void TimeSeriesStore::append(Resolution resolution, const Slot &slot)
+{
+	uint64_t &written = header->written[resolution];
+	rings[resolution][written % config.slots[resolution]] = slot;
+	written++;
+}
+
+// Caller holds mutex
+void TimeSeriesStore::feed(Resolution resolution, const Slot &finer)
+{
+	Accumulator &acc = pending[resolution];
+	const int64_t start = floorTo(finer.startSec, STEP_SECONDS[resolution]);
+	if (acc.samples > 0 && acc.startSec != start)
+		flush(resolution);
+	if (acc.samples == 0)
+		acc.startSec = start;
+	acc.add(finer);
+}
+
+// Caller holds mutex
+void TimeSeriesStore::flush(Resolution resolution)
+{
+	if (pending[resolution].samples == 0)
+		return;
+	const Slot done = pending[resolution].finish();
+	pending[resolution] = Accumulator{};
+	append(resolution, done);
+	::msync(header, mappedBytes, MS_ASYNC);    // at most once a minute
+
+	if (resolution + 1 < RESOLUTIONS)
+		feed(static_cast<Resolution>(resolution + 1), done);
+}
+
+void TimeSeriesStore::record(int64_t nowSec, const float (&values)[SERIES])
+{
+	if (!header)
+		return;
+
+	Slot slot{};
+	slot.startSec = nowSec;
+	slot.samples = 1;
+	for (int i = 0; i < SERIES; i++)
+		slot.mean[i] = slot.min[i] = slot.max[i] = values[i];
+
+	std::lock_guard<std::mutex> lock(mutex);
+	append(Second, slot);
+	feed(Minute, slot);
+	// close the hour as soon as the clock leaves it, not a minute later
+	if (pending[Hour].samples > 0 && pending[Hour].startSec != floorTo(nowSec, STEP_SECONDS[Hour]))
+		flush(Hour);
+	recorded++;
+}
+
+void TimeSeriesStore::recorderLoop()
+{
+	set_thread_name("history");
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	while (!stopping)
+	{
+		// sample on whole seconds so slots line up across restarts
+		const auto now = std::chrono::system_clock::now();
+		const auto next = std::chrono::ceil<std::chrono::seconds>(now + std::chrono::milliseconds(1));
+		wake.wait_until(lock, next);
+		if (stopping)
+			break;
+		lock.unlock();
+
+		float values[SERIES];
+		std::fill(std::begin(values), std::end(values), NAN);
+		config.sample(values);
+		const int64_t nowSec = std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		record(nowSec, values);
+
+		lock.lock();
+	}
+}
+
+const char *TimeSeriesStore::seriesName(Series series)
+{
+	switch (series)
+	{
+		case TemperatureC: return "temperatureC";
+		case CpuPercent: return "cpuPercent";
+		case MemAvailableMiB: return "memAvailableMiB";
+		case FramesPerSecond: return "framesPerSecond";
+		case ProductsPerSecond: return "productsPerSecond";
+		case InferenceMs: return "inferenceMs";
+		default: return "unknown";
+	}
+}
+
+bool TimeSeriesStore::seriesFromName(const std::string &name, Series &out)
+{
+	for (int i = 0; i < SERIES; i++)
+	{
+		if (name == seriesName(static_cast<Series>(i)))
+		{
+			out = static_cast<Series>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TimeSeriesStore::resolutionFromName(const std::string &name, Resolution &out)
+{
+	if (name == "1s")
+		out = Second;
+	else if (name == "1m")
+		out = Minute;
+	else if (name == "1h")
+		out = Hour;
+	else
+		return false;
+	return true;
+}
+
+// Columnar, so gzip (when the server has it) sees long runs of similar numbers
+std::string TimeSeriesStore::rangeJson(Resolution resolution, long long fromSec, long long toSec, unsigned seriesMask) const
+{
+	static const char *resolutionNames[RESOLUTIONS] = {"1s", "1m", "1h"};
+
+	std::vector<Slot> slots;
+	if (header)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const uint64_t written = header->written[resolution];
+		const uint64_t count = std::min<uint64_t>(written, config.slots[resolution]);
+		slots.reserve(count);
+		for (uint64_t i = written - count; i < written; i++)
+		{
+			const Slot &slot = rings[resolution][i % config.slots[resolution]];
+			if (slot.startSec != 0 && slot.startSec >= fromSec && slot.startSec <= toSec)
+				slots.push_back(slot);
+		}
+	}
+	// the wall clock can step backwards (NTP after boot); serve in time order anyway
+	std::stable_sort(slots.begin(), slots.end(), [](const Slot &a, const Slot &b) { return a.startSec < b.startSec; });
+
+	// two decimals are plenty for these gauges and keep the payload short
+	auto value = [](JsonWriter &json, float v) {
+		json.number(std::isfinite(v) ? std::round(static_cast<double>(v) * 100.0) / 100.0 : NAN);
+	};
+
+	std::string out;
+	out.reserve(256 + slots.size() * 16 * SERIES);
+	JsonWriter json(out);
+	json.beginObject();
+	json.key("resolution");
+	json.string(resolutionNames[resolution]);
+	json.key("step");
+	json.integer(STEP_SECONDS[resolution]);
+	json.key("from");
+	json.integer(fromSec);
+	json.key("to");
+	json.integer(toSec);
+	json.key("count");
+	json.integer(static_cast<int64_t>(slots.size()));
+	json.key("t0");
+	json.integer(slots.empty() ? 0 : slots.front().startSec);
+
+	json.key("dt");    // seconds since the previous point, 0 for the first
+	json.beginArray();
+	int64_t previous = slots.empty() ? 0 : slots.front().startSec;
+	for (const Slot &slot : slots)
+	{
+		json.integer(slot.startSec - previous);
+		previous = slot.startSec;
+	}
+	json.endArray();
+
+	json.key("samples");
+	json.beginArray();
+	for (const Slot &slot : slots)
+		json.integer(slot.samples);
+	json.endArray();
+
+	json.key("series");
+	json.beginObject();
+	for (int i = 0; i < SERIES; i++)
+	{
+		if (!(seriesMask & (1u << i)))
+			continue;
+		json.key(seriesName(static_cast<Series>(i)));
+		json.beginObject();
+		json.key("mean");
+		json.beginArray();
+		for (const Slot &slot : slots)
+			value(json, slot.mean[i]);
+		json.endArray();
+		if (resolution != Second)    // min and max equal the mean for single samples
+		{
+			json.key("min");
+			json.beginArray();
+			for (const Slot &slot : slots)
+				value(json, slot.min[i]);
+			json.endArray();
+			json.key("max");
+			json.beginArray();
+			for (const Slot &slot : slots)
+				value(json, slot.max[i]);
+			json.endArray();
+		}
+		json.endObject();
+	}
+	json.endObject();
+	json.endObject();
+	return out;
+}
+
+std::string TimeSeriesStore::stateJson() const
+{
+	static const char *resolutionNames[RESOLUTIONS] = {"1s", "1m", "1h"};
+
+	std::ostringstream json;
+	json << "{\"path\":\"" << config.path << "\",\"available\":" << (header ? "true" : "false")
+		 << ",\"bytes\":" << mappedBytes;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	json << ",\"recorded\":" << recorded << ",\"rings\":{";
+	for (int r = 0; r < RESOLUTIONS; r++)
+	{
+		const uint64_t written = header ? header->written[r] : 0;
+		const uint64_t count = std::min<uint64_t>(written, config.slots[r]);
+		int64_t oldest = 0, newest = 0;
+		for (uint64_t i = written - count; i < written; i++)
+		{
+			const int64_t start = rings[r][i % config.slots[r]].startSec;
+			if (start == 0)
+				continue;
+			oldest = oldest == 0 ? start : std::min(oldest, start);
+			newest = std::max(newest, start);
+		}
+		json << (r ? "," : "") << "\"" << resolutionNames[r] << "\":{\"slots\":" << config.slots[r]
+			 << ",\"filled\":" << count << ",\"oldest\":" << oldest << ",\"newest\":" << newest << "}";
+	}
+	json << "}}";
+	return json.str();
+}
@@ -0,0 +1,141 @@
+/**
+ * TimeSeriesStore.h
+ *
+ * Fixed-size, memory-mapped history of the line's vital signs. Once a
+ * second a sample (temperature, CPU, memory, throughput, latency) goes
+ * into a ring of 1 s slots; each finished minute is rolled up into a ring
+ * of 1 min slots and each finished hour into a ring of 1 h slots, every
+ * slot keeping mean, min and max. The rings live in one preallocated file,
+ * so the history survives restarts and network outages without ever
+ * growing, and is served by time range over the edge HTTP server.
+ */
+
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TimeSeriesStore
+{
+public:
+	enum Series { TemperatureC, CpuPercent, MemAvailableMiB, FramesPerSecond, ProductsPerSecond, InferenceMs, SERIES };
+	enum Resolution { Second, Minute, Hour, RESOLUTIONS };
+
+	struct Config
+	{
+		std::string path;
+		uint32_t slots[RESOLUTIONS];     // ring length per resolution
+		std::function<void(float (&values)[SERIES])> sample;   // NaN marks a value as missing; empty: no recorder thread
+	};
+
+	/**
+	 * Constructor - maps the store (creating or resetting it if its layout changed) and starts recording
+	 */
+	explicit TimeSeriesStore(const Config &config);
+
+	/**
+	 * Destructor - stops recording and unmaps the file
+	 */
+	~TimeSeriesStore();
+
+	/**
+	 * Slots of one resolution that start within [fromSec, toSec], as columnar JSON
+	 *
+	 * Timestamps are delta-encoded, missing values are null.
+	 *
+	 * @param resolution Ring to read
+	 * @param fromSec Range start, Unix seconds
+	 * @param toSec Range end, Unix seconds
+	 * @param seriesMask Bit per Series to include
+	 */
+	std::string rangeJson(Resolution resolution, long long fromSec, long long toSec, unsigned seriesMask) const;
+
+	/**
+	 * Record one 1 s sample and roll up whatever it completes; the recorder thread calls this every second
+	 *
+	 * @param nowSec Start of the sample's second, Unix seconds
+	 * @param values One value per Series, NaN if missing
+	 */
+	void record(int64_t nowSec, const float (&values)[SERIES]);
+
+	/**
+	 * Store geometry and fill level as JSON
+	 */
+	std::string stateJson() const;
+
+	/**
+	 * Stop recording and flush the mapping
+	 */
+	void stop();
+
+	static const char *seriesName(Series series);
+	static bool seriesFromName(const std::string &name, Series &out);
+	static bool resolutionFromName(const std::string &name, Resolution &out);
+	static constexpr long long STEP_SECONDS[RESOLUTIONS] = {1, 60, 3600};
+
+private:
+	struct Slot
+	{
+		int64_t startSec;                // 0 = never written
+		uint32_t samples;
+		uint32_t reserved;
+		float mean[SERIES];
+		float min[SERIES];
+		float max[SERIES];
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t series;
+		uint32_t slotBytes;
+		uint32_t slots[RESOLUTIONS];
+		uint32_t reserved;
+		uint64_t written[RESOLUTIONS];   // slots ever written per ring; next index is written % slots
+	};
+
+	// Rollup of finer slots into the one being built
+	struct Accumulator
+	{
+		int64_t startSec = 0;
+		uint32_t samples = 0;
+		double sum[SERIES] = {};
+		uint32_t weight[SERIES] = {};
+		float min[SERIES] = {};
+		float max[SERIES] = {};
+
+		void add(const Slot &slot);
+		Slot finish() const;
+	};
+
+	Config config;
+	int fd = -1;
+	size_t mappedBytes = 0;
+	Header *header = nullptr;
+	Slot *rings[RESOLUTIONS] = {};
+
+	mutable std::mutex mutex;
+	Accumulator pending[RESOLUTIONS];    // slot being built per coarse ring; [Second] is unused
+	unsigned long long recorded = 0;
+
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::thread recorderThread;
+
+	bool map();
+	void rebuildPending();
+	void append(Resolution resolution, const Slot &slot);
+	void feed(Resolution resolution, const Slot &finer);
+	void flush(Resolution resolution);
+	void recorderLoop();
+};
+
+#endif // TIME_SERIES_STORE_H
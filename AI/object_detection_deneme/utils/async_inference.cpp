@@ -20,15 +20,37 @@ static std::shared_ptr<uint8_t> page_aligned_alloc(size_t size, void* buff = nul
     #endif
 }
 
-AsyncModelInfer::AsyncModelInfer(const std::string &hef_path,
-                                 std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> results_queue)
+std::shared_ptr<hailort::VDevice> create_shared_vdevice()
 {
-    auto vdevice_exp = hailort::VDevice::create();
+    hailo_vdevice_params_t params;
+    auto status = hailo_init_vdevice_params(&params);
+    if (HAILO_SUCCESS != status) {
+        std::cerr << "Failed to init VDevice params, status = " << status << std::endl;
+        throw std::runtime_error("Failed to init VDevice params");
+    }
+    params.scheduling_algorithm = HAILO_SCHEDULING_ALGORITHM_ROUND_ROBIN;
+
+    auto vdevice_exp = hailort::VDevice::create(params);
     if (!vdevice_exp) {
         std::cerr << "Failed to create VDevice, status = " << vdevice_exp.status() << std::endl;
         throw std::runtime_error("Failed to create VDevice");
     }
-    this->vdevice = std::move(vdevice_exp.value()); 
+    return std::shared_ptr<hailort::VDevice>(vdevice_exp.release());
+}
+
+AsyncModelInfer::AsyncModelInfer(const std::string &hef_path,
+                                 std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue)
+    : AsyncModelInfer(create_shared_vdevice(), hef_path, results_queue, 1, HAILO_SCHEDULER_PRIORITY_NORMAL)
+{
+}
+
+AsyncModelInfer::AsyncModelInfer(std::shared_ptr<hailort::VDevice> shared_vdevice,
+                                 const std::string &hef_path,
+                                 std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                                 uint16_t batch_size,
+                                 uint8_t scheduler_priority)
+{
+    this->vdevice = std::move(shared_vdevice);
 
     auto infer_model_exp = this->vdevice->create_infer_model(hef_path);
     if (!infer_model_exp) {
@@ -36,6 +58,7 @@ AsyncModelInfer::AsyncModelInfer(const std::string &hef_path,
         throw std::runtime_error("Failed to create infer model");
     }
     this->infer_model = infer_model_exp.release();
+    this->infer_model->set_batch_size(batch_size);
 
     this->input_buffer_guards.reserve(this->infer_model->inputs().size());
     this->output_buffer_guards.reserve(this->infer_model->outputs().size());
@@ -44,7 +67,7 @@ AsyncModelInfer::AsyncModelInfer(const std::string &hef_path,
         this->output_vstream_info_by_name[name] = output_vstream_info;
     }
 
-    configure(results_queue);
+    configure(results_queue, scheduler_priority);
 }
 
 const std::vector<hailort::InferModel::InferStream>& AsyncModelInfer::get_inputs(){
@@ -59,26 +82,53 @@ const std::shared_ptr<hailort::InferModel> AsyncModelInfer::get_infer_model(){
     return this->infer_model;
 }
 
-void AsyncModelInfer::configure(std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> output_data_queue) { 
+std::shared_ptr<hailort::VDevice> AsyncModelInfer::get_vdevice(){
+    return this->vdevice;
+}
+
+static std::vector<TensorInfo> to_tensor_infos(const std::vector<hailort::InferModel::InferStream> &streams) {
+    std::vector<TensorInfo> infos;
+    for (auto &stream : streams) {
+        auto shape = stream.shape();
+        infos.push_back({stream.name(), shape.height, shape.width, shape.features});
+    }
+    return infos;
+}
+
+std::vector<TensorInfo> AsyncModelInfer::input_infos(){
+    return to_tensor_infos(this->infer_model->inputs());
+}
+
+std::vector<TensorInfo> AsyncModelInfer::output_infos(){
+    return to_tensor_infos(this->infer_model->outputs());
+}
+
+void AsyncModelInfer::configure(std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> output_data_queue,
+                                uint8_t scheduler_priority) { 
 
     this->configured_infer_model = this->infer_model->configure().expect("Failed to create configured infer model");
+    auto status = this->configured_infer_model.set_scheduler_priority(scheduler_priority);
+    if (HAILO_SUCCESS != status) {
+        std::cerr << "Failed to set scheduler priority, status = " << status << std::endl;
+    }
     this->bindings = configured_infer_model.create_bindings().expect("Failed to create infer bindings");
     this->output_data_queue = std::move(output_data_queue);
 }
 
-std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> AsyncModelInfer::get_queue(){
+std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> AsyncModelInfer::get_queue(){
     return output_data_queue;
 }
 
-void AsyncModelInfer::infer(std::shared_ptr<cv::Mat> input_data, cv::Mat org_frame) 
+void AsyncModelInfer::infer(const PreprocessedFrameItem &frame) 
 {
-    set_input_buffers(input_data);
+    set_input_buffers(std::make_shared<cv::Mat>(frame.resized_for_infer));
     auto output_data_and_infos = prepare_output_buffers();
-    wait_and_run_async(org_frame, output_data_and_infos);
+    wait_and_run_async(frame, output_data_and_infos);
 }
 
 void AsyncModelInfer::set_input_buffers(const std::shared_ptr<cv::Mat> &input_data)
 {
+    input_buffer_guards.clear();   // previous job holds its own copy
     for (const auto &input_name : infer_model->get_input_names()) {
         size_t frame_size = infer_model->input(input_name)->get_frame_size();
         auto status = bindings.input(input_name)->set_buffer(MemoryView(input_data->data, frame_size));
@@ -92,6 +142,7 @@ void AsyncModelInfer::set_input_buffers(const std::shared_ptr<cv::Mat> &input_da
 std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> AsyncModelInfer::prepare_output_buffers()
 {
     std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> result;
+    output_buffer_guards.clear();  // previous job holds its own copy
     for (const auto &output_name : infer_model->get_output_names()) {
         size_t frame_size = infer_model->output(output_name)->get_frame_size();
         output_data_holder = page_aligned_alloc(frame_size);
@@ -108,22 +159,24 @@ std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> AsyncModelInfer::prepare_
     return result;
 }
 
-void AsyncModelInfer::wait_and_run_async(cv::Mat org_frame,
+void AsyncModelInfer::wait_and_run_async(const PreprocessedFrameItem &frame,
     const std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> &output_data_and_infos)
 {
     auto status = configured_infer_model.wait_for_async_ready(std::chrono::milliseconds(1000));
     if (HAILO_SUCCESS != status) {
         std::cerr << "Failed wait_for_async_ready, status = " << status << std::endl;
     }
-    InferenceOutputItem item;
-    item.org_frame = org_frame;
+    InferenceOutputItem item = create_output_item(frame);
     item.output_data_and_infos = output_data_and_infos;
+    item.infer_start = std::chrono::steady_clock::now();
+    item.output_guards = output_buffer_guards;
 
     auto job = configured_infer_model.run_async(
         bindings,
-        [this, item](const hailort::AsyncInferCompletionInfo& info)
+        [this, item, inputs = input_buffer_guards](const hailort::AsyncInferCompletionInfo& info) mutable
         {
-            get_queue()->push(item);
+            item.infer_done = std::chrono::steady_clock::now();
+            get_queue()->push(item);    // refused if the product already passed the diverter
         }
     );
     if (!job) {
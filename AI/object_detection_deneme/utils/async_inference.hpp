@@ -3,6 +3,8 @@
 
 #include "hailo/hailort.hpp"
 #include "utils.hpp"
+#include "ts_queue.hpp"
+#include "inference_backend.hpp"
 
 #include <iostream>
 #include <opencv2/opencv.hpp>
@@ -10,71 +12,20 @@
 #include <opencv2/core/matx.hpp>
 #include <opencv2/imgcodecs.hpp>
 
-#include <mutex>
-#include <condition_variable>
-#include <queue>
-#include <atomic>
+#include <map>
 
 using namespace hailort;
 
-template<typename T>
-class BoundedTSQueue {
-private:
-    std::queue<T> m_queue;
-    std::mutex m_mutex;
-    std::condition_variable m_cond_not_empty;
-    std::condition_variable m_cond_not_full;
-    const size_t m_max_size;
-    bool m_stopped;
+/**
+ * Creates the VDevice every model of the pipeline shares. The HailoRT model
+ * scheduler switches between the configured models (detector, defect
+ * classifier) on demand, honouring each model's priority and batch size.
+ */
+std::shared_ptr<hailort::VDevice> create_shared_vdevice();
 
-public:
-    explicit BoundedTSQueue(size_t max_size) : m_max_size(max_size), m_stopped(false) {}
-    ~BoundedTSQueue() { stop(); }
-
-    BoundedTSQueue(const BoundedTSQueue&) = delete;
-    BoundedTSQueue& operator=(const BoundedTSQueue&) = delete;
-
-    void push(T item) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_cond_not_full.wait(lock, [this] { return m_queue.size() < m_max_size || m_stopped; });
-        if (m_stopped) return;
-
-        m_queue.push(std::move(item));
-        m_cond_not_empty.notify_one();
-    }
-
-    bool pop(T &out_item) {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_cond_not_empty.wait(lock, [this] { return !m_queue.empty() || m_stopped; });
-        if (m_stopped && m_queue.empty()) {
-            return false;
-        }
-
-        out_item = std::move(m_queue.front());
-        m_queue.pop();
-        m_cond_not_full.notify_one();
-        return true;
-    }
-
-    void stop() {
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_stopped = true;
-        }
-        m_cond_not_empty.notify_all();
-        m_cond_not_full.notify_all();
-    }
-
-    bool empty() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_queue.empty();
-    }
-};
-
-
-class AsyncModelInfer {
+class AsyncModelInfer : public InferenceBackend {
     private:
-        std::unique_ptr<hailort::VDevice> vdevice;
+        std::shared_ptr<hailort::VDevice> vdevice;
 
         std::shared_ptr<hailort::InferModel> infer_model;
         hailort::ConfiguredInferModel configured_infer_model;
@@ -84,14 +35,19 @@ class AsyncModelInfer {
         std::vector<std::shared_ptr<uint8_t>> output_buffer_guards;
         std::map<std::string, hailo_vstream_info_t> output_vstream_info_by_name;
         std::shared_ptr<uint8_t> output_data_holder;
-        std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> output_data_queue;
+        std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> output_data_queue;
 
     public:
         // Constructors
         AsyncModelInfer() = default; // Default constructor
         AsyncModelInfer(std::shared_ptr<hailort::InferModel> infer_model);
         AsyncModelInfer(const std::string &hef_path,
-                    std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> results_queue);
+                    std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue);
+        AsyncModelInfer(std::shared_ptr<hailort::VDevice> shared_vdevice,
+                    const std::string &hef_path,
+                    std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                    uint16_t batch_size,
+                    uint8_t scheduler_priority);
 
         AsyncModelInfer(const AsyncModelInfer&) = delete; // Copy constructor (deleted because of shared_ptr)
         AsyncModelInfer& operator=(const AsyncModelInfer&) = delete; // Copy assignment operator (deleted because of shared_ptr)
@@ -103,16 +59,23 @@ class AsyncModelInfer {
         const std::vector<hailort::InferModel::InferStream>& get_inputs();
         const std::vector<hailort::InferModel::InferStream>& get_outputs();
         const std::shared_ptr<hailort::InferModel> get_infer_model();
-        std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> get_queue();
+        std::shared_ptr<hailort::VDevice> get_vdevice();
+        std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> get_queue() override;
+
+        // InferenceBackend
+        std::string name() const override { return "hailo"; }
+        std::vector<TensorInfo> input_infos() override;
+        std::vector<TensorInfo> output_infos() override;
 
         // Functions
-        void configure(std::shared_ptr<BoundedTSQueue<InferenceOutputItem>> output_data_queue);
-        void infer(std::shared_ptr<cv::Mat> input_data, cv::Mat original_frame);
+        void configure(std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> output_data_queue,
+                       uint8_t scheduler_priority = HAILO_SCHEDULER_PRIORITY_NORMAL);
+        void infer(const PreprocessedFrameItem &frame) override;
 
         //Helpers
         void set_input_buffers(const std::shared_ptr<cv::Mat> &input_data);
         std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> prepare_output_buffers();
-        void wait_and_run_async(cv::Mat original_frame,
+        void wait_and_run_async(const PreprocessedFrameItem &frame,
                                 const std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> &output_data_and_infos);
 };
 
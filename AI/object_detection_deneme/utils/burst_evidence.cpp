@@ -0,0 +1,93 @@
+#include "burst_evidence.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+std::vector<CameraScore> BurstEvidence::add(const FrameEvidence &frame)
+{
+    std::vector<CameraScore> completed;
+
+    // a newer trigger on this camera means the older burst will get no more frames
+    for (auto it = bursts.begin(); it != bursts.end();) {
+        if (it->first.first == frame.cam_id && it->first.second < frame.trigger_id) {
+            CameraScore score;
+            if (fuse(it->first, it->second, score))
+                completed.push_back(score);
+            it = bursts.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    Key key(frame.cam_id, frame.trigger_id);
+    Burst &burst = bursts[key];
+    burst.expected = std::max(1, frame.burst_size);
+    burst.trigger_time = frame.trigger_time;
+    burst.deadline = frame.deadline;
+    burst.frames.push_back(frame);
+
+    if (static_cast<int>(burst.frames.size()) >= burst.expected) {
+        CameraScore score;
+        if (fuse(key, burst, score))
+            completed.push_back(score);
+        bursts.erase(key);
+    }
+    return completed;
+}
+
+void BurstEvidence::drop_expired(std::chrono::steady_clock::time_point now)
+{
+    for (auto it = bursts.begin(); it != bursts.end();) {
+        if (it->second.deadline < now)
+            it = bursts.erase(it);
+        else
+            ++it;
+    }
+}
+
+bool BurstEvidence::fuse(const Key &key, const Burst &burst, CameraScore &score)
+{
+    double max_sharpness = 0.0;
+    for (const auto &f : burst.frames)
+        max_sharpness = std::max(max_sharpness, f.sharpness);
+
+    std::unordered_map<std::string, double> votes;
+    double total_weight = 0.0;
+    double best_frame_weight = -1.0;
+    const FrameEvidence *best_frame = nullptr;
+
+    score.cam_id = key.first;
+    score.trigger_id = key.second;
+    score.trigger_time = burst.trigger_time;
+    score.deadline = burst.deadline;
+    score.frames = static_cast<int>(burst.frames.size());
+    score.detected_frames = 0;
+
+    for (const auto &f : burst.frames) {
+        if (!f.detected)
+            continue;
+        double weight = max_sharpness > 0.0 ? std::max(MIN_FRAME_WEIGHT, f.sharpness / max_sharpness) : 1.0;
+        votes[f.class_name] += weight * f.confidence;
+        total_weight += weight;
+        score.detected_frames++;
+    }
+    if (score.detected_frames == 0)
+        return false;
+
+    auto winner = std::max_element(votes.begin(), votes.end(),
+                                   [](const auto &a, const auto &b) { return a.second < b.second; });
+    score.class_name = winner->first;
+    score.confidence = static_cast<float>(winner->second / total_weight);
+
+    // position of the sharpest frame that saw the winning class
+    for (const auto &f : burst.frames) {
+        if (f.detected && f.class_name == score.class_name && f.sharpness > best_frame_weight) {
+            best_frame_weight = f.sharpness;
+            best_frame = &f;
+        }
+    }
+    score.x = best_frame->x;
+    score.y = best_frame->y;
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef _BURST_EVIDENCE_HPP_
+#define _BURST_EVIDENCE_HPP_
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Top detection of one burst frame, as seen by post-process */
+struct FrameEvidence {
+    int cam_id = -1;
+    unsigned long long trigger_id = 0;      // shared by the frames of one burst, grows with every trigger
+    std::chrono::steady_clock::time_point trigger_time;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    int burst_size = 1;
+    double sharpness = 0.0;
+    bool detected = false;
+    std::string class_name;
+    float confidence = 0.f;     // percent
+    double x = 0.0;
+    double y = 0.0;
+};
+
+/* One camera's verdict for one product, fused over its burst */
+struct CameraScore {
+    int cam_id = -1;
+    unsigned long long trigger_id = 0;
+    std::chrono::steady_clock::time_point trigger_time;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();   // of this burst, not of the frame that completed it
+    std::string class_name;
+    float confidence = 0.f;     // percent
+    double x = 0.0;
+    double y = 0.0;
+    int frames = 0;
+    int detected_frames = 0;
+};
+
+/**
+ * Collects the burst frames each camera sends for a trigger and fuses them
+ * into one score per camera. Every detecting frame votes for its class with
+ * weight proportional to its sharpness; the fused confidence is the winning
+ * class's weighted confidence over the weight of all detecting frames, so
+ * disagreeing frames pull it down. Frames without a detection do not vote.
+ */
+class BurstEvidence {
+    public:
+        static constexpr double MIN_FRAME_WEIGHT = 0.1;   // even the blurriest frame keeps a say
+
+        /**
+         * Adds one frame. Returns the scores of every burst this completes:
+         * the frame's own burst once all its frames are in, and an older,
+         * incomplete burst of the same camera that a newer trigger supersedes
+         * (its missing frames were dropped upstream).
+         * Bursts where no frame detected anything yield no score.
+         */
+        std::vector<CameraScore> add(const FrameEvidence &frame);
+
+        // Forgets bursts whose product already passed the diverter
+        void drop_expired(std::chrono::steady_clock::time_point now);
+
+    private:
+        using Key = std::pair<int, unsigned long long>;   // camera, trigger id
+
+        struct Burst {
+            int expected = 1;
+            std::chrono::steady_clock::time_point trigger_time;
+            std::chrono::steady_clock::time_point deadline;
+            std::vector<FrameEvidence> frames;
+        };
+
+        std::map<Key, Burst> bursts;
+
+        static bool fuse(const Key &key, const Burst &burst, CameraScore &score);
+};
+
+#endif /* _BURST_EVIDENCE_HPP_ */
@@ -0,0 +1,69 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Minimal CBOR (RFC 8949) encoder for the telemetry DTOs.
+ * Appends to a caller-owned buffer, so a batch reuses one allocation.
+ * DTOs are encoded as maps with the same keys as their JSON form, which
+ * lets the backend's Jackson CBOR converter bind them to the same records;
+ * reals are sent as 32-bit floats (the DTOs carry confidences, coordinates
+ * and percentages, well within float precision).
+ */
+class CborWriter {
+public:
+    static constexpr const char* CONTENT_TYPE = "application/cbor";
+
+    explicit CborWriter(std::string& out) : m_out(out) {}
+
+    void array(uint64_t count) { head(4, count); }
+    void map(uint64_t count) { head(5, count); }
+
+    void uint(uint64_t value) { head(0, value); }
+
+    void text(const char* data, size_t size) {
+        head(3, size);
+        m_out.append(data, size);
+    }
+    void text(const std::string& value) { text(value.data(), value.size()); }
+    void key(const char* name) { text(name, std::strlen(name)); }
+
+    void f32(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        m_out += static_cast<char>(0xFA);
+        for (int shift = 24; shift >= 0; shift -= 8)
+            m_out += static_cast<char>((bits >> shift) & 0xFF);
+    }
+
+private:
+    // Major type in the top three bits, the shortest argument encoding after it
+    void head(uint8_t major, uint64_t value) {
+        const uint8_t type = static_cast<uint8_t>(major << 5);
+        if (value < 24) {
+            m_out += static_cast<char>(type | value);
+        } else if (value <= 0xFF) {
+            m_out += static_cast<char>(type | 24);
+            m_out += static_cast<char>(value);
+        } else if (value <= 0xFFFF) {
+            m_out += static_cast<char>(type | 25);
+            m_out += static_cast<char>(value >> 8);
+            m_out += static_cast<char>(value & 0xFF);
+        } else if (value <= 0xFFFFFFFFull) {
+            m_out += static_cast<char>(type | 26);
+            for (int shift = 24; shift >= 0; shift -= 8)
+                m_out += static_cast<char>((value >> shift) & 0xFF);
+        } else {
+            m_out += static_cast<char>(type | 27);
+            for (int shift = 56; shift >= 0; shift -= 8)
+                m_out += static_cast<char>((value >> shift) & 0xFF);
+        }
+    }
+
+    std::string& m_out;
+};
+
+#endif // CBOR_H
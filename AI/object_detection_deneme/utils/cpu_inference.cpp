@@ -0,0 +1,190 @@
+#include "cpu_inference.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static int resolve_thread_count(int requested)
+{
+    if (requested > 0) {
+        return requested;
+    }
+    return static_cast<int>(std::max(2u, std::thread::hardware_concurrency() / 2));
+}
+
+CpuModelInfer::CpuModelInfer(const std::string &onnx_path,
+                             std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                             size_t class_count,
+                             int num_threads,
+                             uint32_t input_width,
+                             uint32_t input_height)
+    : model_path(onnx_path),
+      class_count(class_count),
+      input_width(input_width),
+      input_height(input_height),
+      output_data_queue(std::move(results_queue)),
+      jobs(resolve_thread_count(num_threads) * 2)
+{
+    num_threads = resolve_thread_count(num_threads);
+
+    // Load every net up front so a bad model fails here, not inside a worker
+    std::vector<std::shared_ptr<cv::dnn::Net>> nets;
+    for (int i = 0; i < num_threads; i++) {
+        auto net = std::make_shared<cv::dnn::Net>(cv::dnn::readNetFromONNX(model_path));
+        if (net->empty()) {
+            throw std::runtime_error("Failed to load ONNX model " + model_path);
+        }
+        net->setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net->setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        nets.push_back(net);
+    }
+
+    // One forward pass on a blank frame, so a model with another head is refused here too
+    cv::Mat blank(static_cast<int>(input_height), static_cast<int>(input_width), CV_8UC3, cv::Scalar::all(0));
+    nets.front()->setInput(cv::dnn::blobFromImage(blank, 1.0 / 255.0));
+    size_t frame_size = 0;
+    to_nms_layout(nets.front()->forward(), frame_size);
+
+    for (auto &net : nets) {
+        workers.emplace_back(&CpuModelInfer::worker_loop, this, net);
+    }
+    std::cout << "CPU inference backend: " << model_path << " on " << num_threads << " threads" << std::endl;
+}
+
+CpuModelInfer::~CpuModelInfer()
+{
+    shutdown();
+}
+
+std::vector<TensorInfo> CpuModelInfer::input_infos()
+{
+    return {{"images", input_height, input_width, 3}};
+}
+
+std::vector<TensorInfo> CpuModelInfer::output_infos()
+{
+    return {{"nms", 1, static_cast<uint32_t>(class_count), 5}};
+}
+
+std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> CpuModelInfer::get_queue()
+{
+    return output_data_queue;
+}
+
+void CpuModelInfer::infer(const PreprocessedFrameItem &frame)
+{
+    // Blocks while all workers are busy, like wait_for_async_ready on the accelerator
+    jobs.push(frame);
+}
+
+void CpuModelInfer::shutdown()
+{
+    jobs.stop();
+    for (auto &worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void CpuModelInfer::worker_loop(std::shared_ptr<cv::dnn::Net> net)
+{
+    PreprocessedFrameItem job;
+    while (jobs.pop(job)) {
+        if (std::chrono::steady_clock::now() >= job.deadline) {
+            continue;   // product already passed the diverter, don't spend a forward pass on it
+        }
+
+        InferenceOutputItem item = create_output_item(job);
+        item.infer_start = std::chrono::steady_clock::now();
+
+        // Same pixels and channel order (RGB) the accelerator is fed
+        cv::Mat blob = cv::dnn::blobFromImage(job.resized_for_infer, 1.0 / 255.0,
+                                              cv::Size(input_width, input_height),
+                                              cv::Scalar(), false, false);
+        size_t frame_size = 0;
+        std::shared_ptr<uint8_t> nms;
+        try {
+            net->setInput(blob);
+            nms = to_nms_layout(net->forward(), frame_size);
+        }
+        catch (const std::exception &e) {
+            // an exception escaping this thread would terminate the whole pipeline
+            std::cerr << "CPU inference failed, frame dropped: " << e.what() << std::endl;
+            continue;
+        }
+
+        hailo_vstream_info_t info{};
+        std::strncpy(info.name, "nms", sizeof(info.name) - 1);
+        item.output_data_and_infos.push_back(std::make_pair(nms.get(), info));
+        item.output_guards.push_back(nms);
+        item.infer_done = std::chrono::steady_clock::now();
+
+        output_data_queue->push(std::move(item));
+    }
+}
+
+// YOLOv8 head output [1, 4 + classes, anchors] (or transposed) -> Hailo NMS by-class layout
+std::shared_ptr<uint8_t> CpuModelInfer::to_nms_layout(const cv::Mat &raw_output, size_t &frame_size) const
+{
+    const int attrs = static_cast<int>(class_count) + 4;
+    cv::Mat preds;
+    if (raw_output.dims == 3 && raw_output.size[1] == attrs) {
+        cv::Mat(raw_output.size[1], raw_output.size[2], CV_32F, const_cast<void*>(static_cast<const void*>(raw_output.ptr<float>()))).copyTo(preds);
+        preds = preds.t();
+    }
+    else if (raw_output.dims == 3 && raw_output.size[2] == attrs) {
+        preds = cv::Mat(raw_output.size[1], raw_output.size[2], CV_32F, const_cast<void*>(static_cast<const void*>(raw_output.ptr<float>())));
+    }
+    else {
+        throw std::runtime_error("Unexpected detector output shape, expected YOLOv8 head with "
+                                 + std::to_string(attrs) + " attributes");
+    }
+
+    std::vector<std::vector<cv::Rect2d>> boxes(class_count);
+    std::vector<std::vector<float>> scores(class_count);
+    for (int r = 0; r < preds.rows; r++) {
+        const float *row = preds.ptr<float>(r);
+        const float *best = std::max_element(row + 4, row + attrs);
+        if (*best < SCORE_THRESHOLD) {
+            continue;
+        }
+        size_t cls = static_cast<size_t>(best - (row + 4));
+        boxes[cls].emplace_back(row[0] - row[2] / 2, row[1] - row[3] / 2, row[2], row[3]);
+        scores[cls].push_back(*best);
+    }
+
+    std::vector<std::vector<int>> kept(class_count);
+    size_t total = 0;
+    for (size_t cls = 0; cls < class_count; cls++) {
+        if (!boxes[cls].empty()) {
+            cv::dnn::NMSBoxes(boxes[cls], scores[cls], SCORE_THRESHOLD, IOU_THRESHOLD, kept[cls]);
+        }
+        total += kept[cls].size();
+    }
+
+    frame_size = class_count * sizeof(float32_t) + total * sizeof(hailo_bbox_float32_t);
+    std::shared_ptr<uint8_t> buffer(new uint8_t[frame_size], std::default_delete<uint8_t[]>());
+
+    auto clamp01 = [](double v) { return static_cast<float32_t>(std::min(1.0, std::max(0.0, v))); };
+    size_t offset = 0;
+    for (size_t cls = 0; cls < class_count; cls++) {
+        float32_t count = static_cast<float32_t>(kept[cls].size());
+        std::memcpy(buffer.get() + offset, &count, sizeof(count));
+        offset += sizeof(count);
+
+        for (int idx : kept[cls]) {
+            const cv::Rect2d &b = boxes[cls][idx];
+            hailo_bbox_float32_t bbox;
+            bbox.y_min = clamp01(b.y / input_height);
+            bbox.x_min = clamp01(b.x / input_width);
+            bbox.y_max = clamp01((b.y + b.height) / input_height);
+            bbox.x_max = clamp01((b.x + b.width) / input_width);
+            bbox.score = scores[cls][idx];
+            std::memcpy(buffer.get() + offset, &bbox, sizeof(bbox));
+            offset += sizeof(bbox);
+        }
+    }
+    return buffer;
+}
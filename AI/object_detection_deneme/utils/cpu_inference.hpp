@@ -0,0 +1,58 @@
+#ifndef _CPU_INFERENCE_HPP_
+#define _CPU_INFERENCE_HPP_
+
+#include "inference_backend.hpp"
+#include "ts_queue.hpp"
+
+#include <opencv2/dnn.hpp>
+
+#include <thread>
+#include <vector>
+
+/**
+ * CPU fallback engine: runs an ONNX export of the detector with OpenCV DNN on a
+ * pool of worker threads (one cv::dnn::Net per worker, Net is not thread-safe).
+ * Raw YOLOv8 output is decoded and NMS'ed here, then written in the Hailo NMS
+ * layout - per class a float count followed by hailo_bbox_float32_t entries
+ * with normalized coordinates - so parse_nms_data works unchanged.
+ */
+class CpuModelInfer : public InferenceBackend {
+    public:
+        static constexpr uint32_t DEFAULT_INPUT_SIZE = 640;
+        static constexpr float SCORE_THRESHOLD = 0.25f;
+        static constexpr float IOU_THRESHOLD = 0.45f;
+
+        CpuModelInfer(const std::string &onnx_path,
+                      std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                      size_t class_count,
+                      int num_threads = 0,
+                      uint32_t input_width = DEFAULT_INPUT_SIZE,
+                      uint32_t input_height = DEFAULT_INPUT_SIZE);
+        ~CpuModelInfer() override;
+
+        CpuModelInfer(const CpuModelInfer&) = delete;
+        CpuModelInfer& operator=(const CpuModelInfer&) = delete;
+
+        std::string name() const override { return "cpu"; }
+        std::vector<TensorInfo> input_infos() override;
+        std::vector<TensorInfo> output_infos() override;
+        std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> get_queue() override;
+
+        void infer(const PreprocessedFrameItem &frame) override;
+        void shutdown() override;
+
+    private:
+        std::string model_path;
+        size_t class_count;
+        uint32_t input_width;
+        uint32_t input_height;
+
+        std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> output_data_queue;
+        BoundedTSQueue<PreprocessedFrameItem> jobs;
+        std::vector<std::thread> workers;
+
+        void worker_loop(std::shared_ptr<cv::dnn::Net> net);
+        std::shared_ptr<uint8_t> to_nms_layout(const cv::Mat &raw_output, size_t &frame_size) const;
+};
+
+#endif /* _CPU_INFERENCE_HPP_ */
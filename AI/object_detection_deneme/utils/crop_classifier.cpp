@@ -0,0 +1,135 @@
+#include "crop_classifier.hpp"
+#include "inference_backend.hpp"
+#include "image_interface.h"
+
+#ifdef HAVE_HAILORT
+#include "async_inference.hpp"
+#include "hailo_crop_classifier.hpp"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+cv::Rect bbox_to_rect(const cv::Mat &frame, const hailo_bbox_float32_t &bbox)
+{
+    cv::Rect rect(cv::Point(static_cast<int>(bbox.x_min * frame.cols), static_cast<int>(bbox.y_min * frame.rows)),
+                  cv::Point(static_cast<int>(bbox.x_max * frame.cols), static_cast<int>(bbox.y_max * frame.rows)));
+    return rect & cv::Rect(0, 0, frame.cols, frame.rows);
+}
+
+float defect_probability(const float *scores, size_t count)
+{
+    if (count == 0) {
+        return -1.0f;
+    }
+    if (count == 1) {
+        float v = scores[0];
+        // already a probability, or a logit that still needs the sigmoid
+        return (v >= 0.0f && v <= 1.0f) ? v : 1.0f / (1.0f + std::exp(-v));
+    }
+    // [healthy, defect]: softmax over the two scores
+    float m = std::max(scores[0], scores[1]);
+    float healthy = std::exp(scores[0] - m);
+    float defect = std::exp(scores[1] - m);
+    return defect / (healthy + defect);
+}
+
+std::string refine_class_name(const std::string &detector_class, float defect_score, float &confidence)
+{
+    std::string product = detector_class.substr(0, detector_class.find('_'));
+    bool rotten = defect_score >= 0.5f;
+    confidence = (rotten ? defect_score : 1.0f - defect_score) * 100.f;
+    return product + (rotten ? "_Rotten" : "_Healthy");
+}
+
+std::vector<float> MockCropClassifier::classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes)
+{
+    std::vector<float> scores;
+    scores.reserve(boxes.size());
+    for (const auto &box : boxes) {
+        cv::Rect rect = bbox_to_rect(frame, box.bbox);
+        if (rect.empty()) {
+            scores.push_back(-1.0f);
+            continue;
+        }
+        // rot shows up as dark, brownish patches: low value, warm hue
+        cv::Mat hsv, dark;
+        cv::cvtColor(frame(rect), hsv, cv::COLOR_BGR2HSV);
+        cv::inRange(hsv, cv::Scalar(5, 50, 20), cv::Scalar(30, 255, 110), dark);
+        float share = static_cast<float>(cv::countNonZero(dark)) / dark.total();
+        scores.push_back(std::min(1.0f, share * 4.0f));   // 12.5% rot reads as 50/50
+    }
+    return scores;
+}
+
+OnnxCropClassifier::OnnxCropClassifier(const std::string &onnx_path, int input_size)
+    : net(cv::dnn::readNetFromONNX(onnx_path)), input_size(input_size)
+{
+    if (net.empty()) {
+        throw std::runtime_error("Failed to load defect classifier " + onnx_path);
+    }
+    net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+}
+
+std::vector<float> OnnxCropClassifier::classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes)
+{
+    std::vector<float> scores(boxes.size(), -1.0f);
+    std::vector<cv::Mat> crops;
+    std::vector<size_t> index;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        cv::Rect rect = bbox_to_rect(frame, boxes[i].bbox);
+        if (!rect.empty()) {
+            crops.push_back(frame(rect));   // view, blobFromImages does the only copy
+            index.push_back(i);
+        }
+    }
+    if (crops.empty()) {
+        return scores;
+    }
+
+    // crops are BGR views; swapRB gives the network RGB like the detector gets
+    cv::Mat blob = cv::dnn::blobFromImages(crops, 1.0 / 255.0, cv::Size(input_size, input_size),
+                                           cv::Scalar(), true, false);
+    net.setInput(blob);
+    cv::Mat out = net.forward();
+    out = out.reshape(1, static_cast<int>(crops.size()));
+    for (size_t i = 0; i < index.size(); i++) {
+        scores[index[i]] = defect_probability(out.ptr<float>(static_cast<int>(i)), out.cols);
+    }
+    return scores;
+}
+
+static bool ends_with(const std::string &value, const std::string &suffix)
+{
+    return value.size() >= suffix.size() && 0 == value.compare(value.size() - suffix.size(), suffix.size(), suffix);
+}
+
+std::unique_ptr<CropClassifier> create_crop_classifier(const CommandLineArgs &args, InferenceBackend *detector)
+{
+    if (args.classifier.empty()) {
+        return nullptr;
+    }
+    if (args.classifier == "mock") {
+        return std::make_unique<MockCropClassifier>();
+    }
+    if (ends_with(args.classifier, ".onnx")) {
+        return std::make_unique<OnnxCropClassifier>(args.classifier);
+    }
+    if (ends_with(args.classifier, ".hef")) {
+#ifdef HAVE_HAILORT
+        auto hailo_detector = dynamic_cast<AsyncModelInfer*>(detector);
+        if (hailo_detector == nullptr) {
+            throw std::runtime_error("A .hef classifier needs the hailo detector backend to share its VDevice");
+        }
+        return std::make_unique<HailoCropClassifier>(hailo_detector->get_vdevice(), args.classifier,
+                                                     ImageInterface::CLASSIFIER_BATCH_SIZE,
+                                                     ImageInterface::CLASSIFIER_SCHEDULER_PRIORITY);
+#else
+        (void)detector;
+        throw std::runtime_error("Built without HailoRT, use an .onnx classifier or -classifier=mock");
+#endif
+    }
+    throw std::invalid_argument("Unknown classifier '" + args.classifier + "', use mock, *.onnx or *.hef");
+}
@@ -0,0 +1,78 @@
+#ifndef _CROP_CLASSIFIER_HPP_
+#define _CROP_CLASSIFIER_HPP_
+
+#include "utils.hpp"
+
+#include <opencv2/dnn.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class InferenceBackend;
+
+/**
+ * Second-stage ripeness/defect classifier. Runs only on the boxes the
+ * detector returned; every crop is a cv::Mat view into the original frame,
+ * so no pixels are copied until they are resized into the model input.
+ * classify() returns one defect probability per box (0 = healthy, 1 = rotten).
+ */
+class CropClassifier {
+    public:
+        virtual ~CropClassifier() = default;
+
+        virtual std::string name() const = 0;
+        virtual std::vector<float> classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes) = 0;
+};
+
+/**
+ * Deterministic stand-in that needs neither hardware nor a model file:
+ * the defect probability is the share of dark/brown pixels in the crop.
+ * Meant for bench tests of the two-stage path.
+ */
+class MockCropClassifier : public CropClassifier {
+    public:
+        std::string name() const override { return "mock"; }
+        std::vector<float> classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes) override;
+};
+
+/**
+ * CPU classifier running an ONNX export of the defect model with OpenCV DNN.
+ * All crops of a frame go through the network as one batch.
+ */
+class OnnxCropClassifier : public CropClassifier {
+    public:
+        static constexpr int DEFAULT_INPUT_SIZE = 224;
+
+        explicit OnnxCropClassifier(const std::string &onnx_path, int input_size = DEFAULT_INPUT_SIZE);
+
+        std::string name() const override { return "onnx"; }
+        std::vector<float> classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes) override;
+
+    private:
+        cv::dnn::Net net;
+        int input_size;
+};
+
+// Normalized detector box -> pixel rect inside frame (empty if degenerate)
+cv::Rect bbox_to_rect(const cv::Mat &frame, const hailo_bbox_float32_t &bbox);
+
+// Turns the classifier's raw output (one logit/probability, or [healthy, defect] scores) into P(defect)
+float defect_probability(const float *scores, size_t count);
+
+/**
+ * Rewrites a detector class such as "Apple_Rotten" with the classifier's
+ * verdict ("Apple_Healthy"/"Apple_Rotten") and returns its confidence in percent.
+ */
+std::string refine_class_name(const std::string &detector_class, float defect_score, float &confidence);
+
+/**
+ * Creates the classifier selected by args.classifier:
+ *   ""         - none (detector classes are used as they are)
+ *   "mock"     - MockCropClassifier
+ *   "*.onnx"   - OnnxCropClassifier
+ *   "*.hef"    - Hailo classifier sharing the detector's VDevice
+ */
+std::unique_ptr<CropClassifier> create_crop_classifier(const CommandLineArgs &args, InferenceBackend *detector);
+
+#endif /* _CROP_CLASSIFIER_HPP_ */
@@ -0,0 +1,59 @@
+/**
+ * @file hailo_compat.hpp
+ * HailoRT types shared by every inference backend.
+ *
+ * With HailoRT available (HAVE_HAILORT) this simply pulls in the real headers.
+ * Without it, the few plain types the pipeline passes around (status codes,
+ * the NMS bbox layout, stream info) are defined here with the same layout so
+ * the rest of the pipeline builds and runs on any Linux box.
+ **/
+
+#ifndef _HAILO_COMPAT_HPP_
+#define _HAILO_COMPAT_HPP_
+
+#ifdef HAVE_HAILORT
+
+#include "hailo/infer_model.hpp"
+#include "hailo/hailort.h"
+
+#else
+
+#include <cstdint>
+
+typedef float float32_t;
+
+typedef enum {
+    HAILO_SUCCESS = 0,
+    HAILO_UNINITIALIZED = 1,
+    HAILO_INVALID_ARGUMENT = 2,
+    HAILO_OUT_OF_HOST_MEMORY = 3,
+    HAILO_TIMEOUT = 4,
+    HAILO_INTERNAL_FAILURE = 8,
+    HAILO_NOT_AVAILABLE = 10,
+} hailo_status;
+
+#define HAILO_MAX_STREAM_NAME_SIZE (128)
+
+/* Same field order as HailoRT, NMS output is a packed array of these */
+typedef struct {
+    float32_t y_min;
+    float32_t x_min;
+    float32_t y_max;
+    float32_t x_max;
+    float32_t score;
+} hailo_bbox_float32_t;
+
+typedef struct {
+    uint32_t height;
+    uint32_t width;
+    uint32_t features;
+} hailo_3d_image_shape_t;
+
+typedef struct {
+    char name[HAILO_MAX_STREAM_NAME_SIZE];
+    hailo_3d_image_shape_t shape;
+} hailo_vstream_info_t;
+
+#endif /* HAVE_HAILORT */
+
+#endif /* _HAILO_COMPAT_HPP_ */
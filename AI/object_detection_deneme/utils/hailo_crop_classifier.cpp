@@ -0,0 +1,94 @@
+#include "hailo_crop_classifier.hpp"
+
+#include <sys/mman.h>
+
+using namespace hailort;
+
+static std::shared_ptr<uint8_t> page_aligned_alloc(size_t size) {
+    auto addr = mmap(nullptr, size, PROT_WRITE | PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (MAP_FAILED == addr) throw std::bad_alloc();
+    return std::shared_ptr<uint8_t>(reinterpret_cast<uint8_t*>(addr), [size](void *addr) { munmap(addr, size); });
+}
+
+HailoCropClassifier::HailoCropClassifier(std::shared_ptr<VDevice> shared_vdevice,
+                                         const std::string &hef_path,
+                                         uint16_t batch_size,
+                                         uint8_t scheduler_priority)
+    : vdevice(std::move(shared_vdevice))
+{
+    auto infer_model_exp = vdevice->create_infer_model(hef_path);
+    if (!infer_model_exp) {
+        std::cerr << "Failed to create classifier infer model, status = " << infer_model_exp.status() << std::endl;
+        throw std::runtime_error("Failed to create classifier infer model");
+    }
+    infer_model = infer_model_exp.release();
+    if (infer_model->inputs().size() != 1 || infer_model->outputs().size() != 1) {
+        throw std::runtime_error("Defect classifier must have exactly one input and one output");
+    }
+    infer_model->set_batch_size(batch_size);
+    infer_model->output()->set_format_type(HAILO_FORMAT_TYPE_FLOAT32);
+
+    configured_infer_model = infer_model->configure().expect("Failed to create configured classifier model");
+    auto status = configured_infer_model.set_scheduler_priority(scheduler_priority);
+    if (HAILO_SUCCESS != status) {
+        std::cerr << "Failed to set classifier scheduler priority, status = " << status << std::endl;
+    }
+
+    auto input_shape = infer_model->input()->shape();
+    size_t input_size = infer_model->input()->get_frame_size();
+    size_t output_size = infer_model->output()->get_frame_size();
+    output_count = output_size / sizeof(float32_t);
+
+    for (uint16_t i = 0; i < batch_size; i++) {
+        Slot slot;
+        slot.bindings = configured_infer_model.create_bindings().expect("Failed to create classifier bindings");
+        slot.input = page_aligned_alloc(input_size);
+        slot.output = page_aligned_alloc(output_size);
+        slot.input_view = cv::Mat(input_shape.height, input_shape.width, CV_8UC3, slot.input.get());
+        slot.bindings.input()->set_buffer(MemoryView(slot.input.get(), input_size));
+        slot.bindings.output()->set_buffer(MemoryView(slot.output.get(), output_size));
+        slots.push_back(std::move(slot));
+    }
+}
+
+std::vector<float> HailoCropClassifier::classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes)
+{
+    std::vector<float> scores(boxes.size(), -1.0f);
+
+    // One batch per round: the scheduler sees all requests of a round together
+    for (size_t first = 0; first < boxes.size(); first += slots.size()) {
+        std::vector<std::pair<size_t, AsyncInferJob>> jobs;
+        for (size_t s = 0; s < slots.size() && first + s < boxes.size(); s++) {
+            cv::Rect rect = bbox_to_rect(frame, boxes[first + s].bbox);
+            if (rect.empty()) {
+                continue;
+            }
+            Slot &slot = slots[s];
+            to_model_input(frame(rect), slot.input_view, slot.input_view.size());
+
+            auto status = configured_infer_model.wait_for_async_ready(std::chrono::milliseconds(CLASSIFY_TIMEOUT_MS));
+            if (HAILO_SUCCESS != status) {
+                std::cerr << "Classifier wait_for_async_ready failed, status = " << status << std::endl;
+                break;
+            }
+            auto job = configured_infer_model.run_async(slot.bindings);
+            if (!job) {
+                std::cerr << "Failed to start classifier job, status = " << job.status() << std::endl;
+                continue;
+            }
+            jobs.emplace_back(first + s, job.release());
+        }
+
+        for (size_t j = 0; j < jobs.size(); j++) {
+            auto status = jobs[j].second.wait(std::chrono::milliseconds(CLASSIFY_TIMEOUT_MS));
+            if (HAILO_SUCCESS != status) {
+                std::cerr << "Classifier job failed, status = " << status << std::endl;
+                continue;
+            }
+            size_t box = jobs[j].first;
+            const float *out = reinterpret_cast<const float*>(slots[box - first].output.get());
+            scores[box] = defect_probability(out, output_count);
+        }
+    }
+    return scores;
+}
@@ -0,0 +1,47 @@
+#ifndef _HAILO_CROP_CLASSIFIER_HPP_
+#define _HAILO_CROP_CLASSIFIER_HPP_
+
+#include "hailo/hailort.hpp"
+#include "crop_classifier.hpp"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Defect classifier on the accelerator. Configured on the detector's
+ * VDevice, so the HailoRT scheduler time-shares the device between the two
+ * models. One binding set is preallocated per batch slot; each crop view is
+ * resized and converted to RGB, like the detector input, straight into its
+ * slot's input buffer.
+ */
+class HailoCropClassifier : public CropClassifier {
+    public:
+        static constexpr int CLASSIFY_TIMEOUT_MS = 1000;
+
+        HailoCropClassifier(std::shared_ptr<hailort::VDevice> shared_vdevice,
+                            const std::string &hef_path,
+                            uint16_t batch_size,
+                            uint8_t scheduler_priority);
+
+        HailoCropClassifier(const HailoCropClassifier&) = delete;
+        HailoCropClassifier& operator=(const HailoCropClassifier&) = delete;
+
+        std::string name() const override { return "hailo"; }
+        std::vector<float> classify(const cv::Mat &frame, const std::vector<NamedBbox> &boxes) override;
+
+    private:
+        struct Slot {
+            hailort::ConfiguredInferModel::Bindings bindings;
+            std::shared_ptr<uint8_t> input;
+            std::shared_ptr<uint8_t> output;
+            cv::Mat input_view;     // input buffer seen as an HxWx3 RGB image
+        };
+
+        std::shared_ptr<hailort::VDevice> vdevice;
+        std::shared_ptr<hailort::InferModel> infer_model;
+        hailort::ConfiguredInferModel configured_infer_model;
+        std::vector<Slot> slots;
+        size_t output_count;
+};
+
+#endif /* _HAILO_CROP_CLASSIFIER_HPP_ */
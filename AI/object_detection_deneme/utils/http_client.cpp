@@ -1,6 +1,12 @@
 #include "http_client.h"
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <iostream>
 
+static std::atomic<bool> preferCbor{false};
+static std::atomic<bool> cborRejected{false};
+
 HttpClient::HttpClient() {
     // Constructor
 }
@@ -129,25 +135,92 @@ SocketType HttpClient::connectToServer(const std::string& host, int port) {
     return sock;
 }
 
-std::string HttpClient::scansToJsonArray(const std::vector<ScanRequestDTO>& scans) {
-    std::string result = "[";
-    for (size_t i = 0; i < scans.size(); i++) {
-        if (i > 0) {
-            result += ",";
+void HttpClient::encodeScans(const std::vector<ScanRequestDTO>& scans, Encoding encoding) {
+    m_body.clear();
+    if (encoding == Encoding::Cbor) {
+        CborWriter cbor(m_body);
+        cbor.array(scans.size());
+        for (const auto& scan : scans) {
+            scan.toCbor(cbor);
+        }
+    } else {
+        JsonWriter json(m_body);
+        json.beginArray();
+        for (const auto& scan : scans) {
+            scan.toJson(json);
         }
-        result += scans[i].toJson();
+        json.endArray();
     }
-    result += "]";
-    return result;
+}
+
+void HttpClient::setPreferredEncoding(Encoding encoding) {
+    preferCbor = encoding == Encoding::Cbor;
+}
+
+HttpClient::Encoding HttpClient::activeEncoding() {
+    return preferCbor && !cborRejected ? Encoding::Cbor : Encoding::Json;
 }
 
 bool HttpClient::sendScans(const std::string& host, int port, const std::string& path, 
                           const std::vector<ScanRequestDTO>& scans) {
+    if (activeEncoding() == Encoding::Cbor) {
+        encodeScans(scans, Encoding::Cbor);
+        int status = postBody(host, port, path, CborWriter::CONTENT_TYPE);
+        if (status != 415) {
+            return status >= 200 && status < 300;
+        }
+        // Backend without a CBOR converter: remember it and send this batch as JSON right away
+        cborRejected = true;
+        std::cerr << "Backend does not accept " << CborWriter::CONTENT_TYPE << ", using JSON" << std::endl;
+    }
+
+    encodeScans(scans, Encoding::Json);
+    int status = postBody(host, port, path, JsonWriter::CONTENT_TYPE);
+    return status >= 200 && status < 300;
+}
+
+// Gather-write header and body in as few syscalls as the socket allows
+static bool sendHeaderAndBody(SocketType sock, const std::string& header, const std::string& body) {
+    #ifdef _WIN32
+    return send(sock, header.data(), (int)header.size(), 0) != SOCKET_ERROR_CODE &&
+           send(sock, body.data(), (int)body.size(), 0) != SOCKET_ERROR_CODE;
+    #else
+    iovec iov[2] = {
+        { const_cast<char*>(header.data()), header.size() },
+        { const_cast<char*>(body.data()), body.size() }
+    };
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    while (msg.msg_iovlen > 0) {
+        // sendmsg is writev plus MSG_NOSIGNAL: a backend closing early must not kill us
+        ssize_t sent = sendmsg(sock, &msg, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        while (msg.msg_iovlen > 0 && static_cast<size_t>(sent) >= msg.msg_iov->iov_len) {
+            sent -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = static_cast<char*>(msg.msg_iov->iov_base) + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
+    }
+    return true;
+    #endif
+}
+
+int HttpClient::postBody(const std::string& host, int port, const std::string& path, const char* contentType) {
     // Connect to the server
     SocketType sock = connectToServer(host, port);
     if (sock == INVALID_SOCKET) {
         std::cerr << "Failed to connect to server" << std::endl;
-        return false;
+        return 0;
     }
 
     // Set socket timeout for send and receive operations
@@ -164,110 +237,69 @@ bool HttpClient::sendScans(const std::string& host, int port, const std::string&
     setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     #endif
 
-    // Prepare JSON payload
-    std::string jsonPayload = scansToJsonArray(scans);
-    
-    // Prepare HTTP headers
-    std::ostringstream request;
-    request << "POST " << path << " HTTP/1.1\r\n";
-    request << "Host: " << host << "\r\n";
-    request << "Content-Type: application/json\r\n";
-    request << "Content-Length: " << jsonPayload.length() << "\r\n";
-    request << "Connection: close\r\n";
-    request << "\r\n";
-    request << jsonPayload;
+    // Prepare HTTP headers; the answer is always wanted as JSON
+    char length[24];
+    auto lengthEnd = std::to_chars(length, length + sizeof(length), m_body.size()).ptr;
+    m_header.clear();
+    m_header += "POST ";
+    m_header += path;
+    m_header += " HTTP/1.1\r\nHost: ";
+    m_header += host;
+    m_header += "\r\nContent-Type: ";
+    m_header += contentType;
+    m_header += "\r\nAccept: application/json\r\nContent-Length: ";
+    m_header.append(length, lengthEnd);
+    m_header += "\r\nConnection: close\r\n\r\n";
 
     // Send the request
-    std::string requestStr = request.str();
-    int bytesSent = send(sock, requestStr.c_str(), requestStr.length(), 0);
-    if (bytesSent == SOCKET_ERROR_CODE) {
+    if (!sendHeaderAndBody(sock, m_header, m_body)) {
         std::cerr << "send failed" << std::endl;
         CLOSE_SOCKET(sock);
-        return false;
+        return 0;
     }
 
-    // Receive and check response
-    char buffer[4096];
-    std::string response;
-    bool success = false;
-
-    while (true) {
-        int bytesReceived = recv(sock, buffer, sizeof(buffer) - 1, 0);
+    // Receive until the status line is complete: "HTTP/1.1 201 Created\r\n"
+    char buffer[256];
+    size_t received = 0;
+    while (received < sizeof(buffer) && std::memchr(buffer, '\n', received) == nullptr) {
+        int bytesReceived = recv(sock, buffer + received, (int)(sizeof(buffer) - received), 0);
         if (bytesReceived <= 0) {
             break;
         }
-        buffer[bytesReceived] = '\0';
-        response.append(buffer);
-        
-        // Simple check for success status code (2xx)
-        if (response.find("HTTP/1.1 2") != std::string::npos) {
-            success = true;
-        }
+        received += bytesReceived;
     }
 
     // Close the socket
     CLOSE_SOCKET(sock);
 
-    return success;
+    const char* space = static_cast<const char*>(std::memchr(buffer, ' ', received));
+    if (received < 12 || std::memcmp(buffer, "HTTP/", 5) != 0 || space == nullptr) {
+        return 0;
+    }
+    int status = 0;
+    std::from_chars(space + 1, buffer + received, status);
+    return status;
 }
 
 
 bool HttpClient::sendSystemStatus(const std::string& host, int port, const std::string& path, 
                                  const SystemStatusDTO& status) {
-    // Connect to the server
-    SocketType sock = connectToServer(host, port);
-    if (sock == INVALID_SOCKET) {
-        return false;
-    }
-
-    // Prepare JSON payload
-    std::string jsonPayload = status.toJson();
-    
-    // Prepare HTTP request
-    std::ostringstream request;
-    request << "POST " << path << " HTTP/1.1\r\n";
-    request << "Host: " << host << "\r\n";
-    request << "Content-Type: application/json\r\n";
-    request << "Content-Length: " << jsonPayload.length() << "\r\n";
-    request << "Connection: close\r\n";
-    request << "\r\n";
-    request << jsonPayload;
+    m_body.clear();
+    JsonWriter json(m_body);
+    status.toJson(json);
 
-    // Send request
-    std::string requestStr = request.str();
-    int bytesSent = send(sock, requestStr.c_str(), requestStr.length(), 0);
-    
-    CLOSE_SOCKET(sock);
-    return bytesSent != SOCKET_ERROR_CODE;
+    int code = postBody(host, port, path, JsonWriter::CONTENT_TYPE);
+    return code >= 200 && code < 300;
 }
 
 
 bool HttpClient::sendSystemMessage(const std::string& host, int port, const std::string& path, 
                                  const SystemLogMessageDTO& message) 
 {
-    // Connect to the server
-    SocketType sock = connectToServer(host, port);
-    if (sock == INVALID_SOCKET) {
-        return false;
-    }
-
-    // Prepare JSON payload
-    std::string jsonPayload = message.toJson();
-    
-    // Prepare HTTP request
-    std::ostringstream request;
-    request << "POST " << path << " HTTP/1.1\r\n";
-    request << "Host: " << host << "\r\n";
-    request << "Content-Type: application/json\r\n";
-    request << "Content-Length: " << jsonPayload.length() << "\r\n";
-    request << "Connection: close\r\n";
-    request << "\r\n";
-    request << jsonPayload;
+    m_body.clear();
+    JsonWriter json(m_body);
+    message.toJson(json);
 
-    // Send request
-    std::string requestStr = request.str();
-    int bytesSent = send(sock, requestStr.c_str(), requestStr.length(), 0);
-    
-    CLOSE_SOCKET(sock);
-    return bytesSent != SOCKET_ERROR_CODE;
+    int code = postBody(host, port, path, JsonWriter::CONTENT_TYPE);
+    return code >= 200 && code < 300;
 }
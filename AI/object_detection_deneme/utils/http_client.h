@@ -15,6 +15,7 @@
     #include <netdb.h>
     #include <unistd.h>
     #include <fcntl.h>
+    #include <sys/uio.h>
     typedef int SocketType;
     #define SOCKET_ERROR_CODE -1
     #define INVALID_SOCKET -1
@@ -24,14 +25,18 @@
 #include <string>
 #include <vector>
 #include <cstring>
-#include <sstream>
 #include "scan_request_dto.h"
 #include "system_status_dto.h"
 #include "system_messages_dto.h"
+#include "json_writer.h"
+#include "cbor.h"
 
 
 class HttpClient {
 public:
+    // Body encoding of batched scan uploads
+    enum class Encoding { Json, Cbor };
+
     HttpClient();
     ~HttpClient();
     
@@ -54,12 +59,23 @@ public:
     bool sendScans(const std::string& host, int port, const std::string& path, 
                   const std::vector<ScanRequestDTO>& scans);
 
+    // Process-wide preference; CBOR falls back to JSON for good once the backend answers 415
+    static void setPreferredEncoding(Encoding encoding);
+    static Encoding activeEncoding();
+
 private:
     // Connect to server
     SocketType connectToServer(const std::string& host, int port);
     
-    // Convert vector of ScanRequestDTO to JSON array
-    std::string scansToJsonArray(const std::vector<ScanRequestDTO>& scans);
+    // Encode a batch into m_body
+    void encodeScans(const std::vector<ScanRequestDTO>& scans, Encoding encoding);
+
+    // POST m_body, return the HTTP status code (0 if the exchange failed)
+    int postBody(const std::string& host, int port, const std::string& path, const char* contentType);
+
+    // Reused between requests of this client, so steady-state uploads do not allocate
+    std::string m_header;
+    std::string m_body;
     
     #ifdef _WIN32
     bool wsaInitialized = false;
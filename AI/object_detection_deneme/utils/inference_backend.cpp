@@ -0,0 +1,51 @@
+#include "inference_backend.hpp"
+#include "cpu_inference.hpp"
+#include "image_interface.h"
+
+#ifdef HAVE_HAILORT
+#include "async_inference.hpp"
+#endif
+
+#include <stdexcept>
+
+static std::unique_ptr<InferenceBackend> create_cpu_backend(const CommandLineArgs &args,
+                                                            std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                                                            size_t class_count)
+{
+    if (args.onnx_path.empty()) {
+        throw std::runtime_error("CPU backend needs an exported detector, pass -onnx=<model.onnx>");
+    }
+    return std::make_unique<CpuModelInfer>(args.onnx_path, results_queue, class_count, args.cpu_threads);
+}
+
+std::unique_ptr<InferenceBackend> create_inference_backend(const CommandLineArgs &args,
+                                                           std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                                                           size_t class_count)
+{
+    if (args.backend == "cpu") {
+        return create_cpu_backend(args, results_queue, class_count);
+    }
+    if (args.backend != "hailo" && args.backend != "auto") {
+        throw std::invalid_argument("Unknown backend '" + args.backend + "', use hailo, cpu or auto");
+    }
+
+#ifdef HAVE_HAILORT
+    try {
+        return std::make_unique<AsyncModelInfer>(create_shared_vdevice(), args.detection_hef, results_queue,
+                                                 ImageInterface::DETECTOR_BATCH_SIZE,
+                                                 ImageInterface::DETECTOR_SCHEDULER_PRIORITY);
+    }
+    catch (const std::exception &e) {
+        if (args.backend == "hailo") {
+            throw;
+        }
+        std::cerr << "Hailo backend unavailable (" << e.what() << "), falling back to CPU" << std::endl;
+    }
+#else
+    if (args.backend == "hailo") {
+        throw std::runtime_error("Built without HailoRT, use -backend=cpu");
+    }
+#endif
+
+    return create_cpu_backend(args, results_queue, class_count);
+}
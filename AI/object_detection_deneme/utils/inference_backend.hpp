@@ -0,0 +1,42 @@
+#ifndef _INFERENCE_BACKEND_HPP_
+#define _INFERENCE_BACKEND_HPP_
+
+#include "utils.hpp"
+#include "ts_queue.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Common interface of the detector engines (Hailo accelerator, CPU fallback).
+ * Every backend pushes InferenceOutputItem results into the shared results
+ * queue with its output laid out as Hailo NMS data, so parse_nms_data and
+ * everything after it do not care which engine produced them.
+ */
+class InferenceBackend {
+    public:
+        virtual ~InferenceBackend() = default;
+
+        virtual std::string name() const = 0;
+        virtual std::vector<TensorInfo> input_infos() = 0;
+        virtual std::vector<TensorInfo> output_infos() = 0;
+        virtual std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> get_queue() = 0;
+
+        virtual void infer(const PreprocessedFrameItem &frame) = 0;
+
+        // Finish in-flight work; no results are pushed after this returns
+        virtual void shutdown() {}
+};
+
+/**
+ * Creates the backend selected by args.backend:
+ *   "hailo" - Hailo accelerator only
+ *   "cpu"   - CPU engine running args.onnx_path
+ *   "auto"  - Hailo, falling back to the CPU engine if the device cannot be opened
+ */
+std::unique_ptr<InferenceBackend> create_inference_backend(const CommandLineArgs &args,
+                                                           std::shared_ptr<DeadlineTSQueue<InferenceOutputItem>> results_queue,
+                                                           size_t class_count);
+
+#endif /* _INFERENCE_BACKEND_HPP_ */
@@ -0,0 +1,24 @@
+#ifndef ISO_TIMESTAMP_H
+#define ISO_TIMESTAMP_H
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+
+/**
+ * ISO 8601 UTC timestamp ("2024-05-01T12:00:00Z") of the telemetry DTOs,
+ * formatted into a fixed buffer so the JSON and CBOR writers need no
+ * temporary string. Returns the length written.
+ */
+inline size_t formatIsoTimestamp(const std::chrono::system_clock::time_point& timestamp, char (&buffer)[24]) {
+    std::time_t time = std::chrono::system_clock::to_time_t(timestamp);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &time);
+#else
+    gmtime_r(&time, &utc);
+#endif
+    return std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+}
+
+#endif // ISO_TIMESTAMP_H
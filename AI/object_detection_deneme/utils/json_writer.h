@@ -0,0 +1,132 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Streaming JSON writer for the telemetry DTOs.
+ * Formats straight into a caller-owned buffer (reused between uploads, so
+ * steady state allocates nothing), numbers via std::to_chars in their
+ * shortest round-trip form, strings escaped per RFC 8259. Commas are
+ * tracked per nesting level; the writer does not validate structure.
+ */
+class JsonWriter {
+public:
+    static constexpr const char* CONTENT_TYPE = "application/json";
+
+    explicit JsonWriter(std::string& out) : m_out(out) {}
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    void key(const char* name) {
+        separator();
+        quoted(name, std::strlen(name));
+        m_out += ':';
+        m_afterKey = true;
+    }
+
+    void string(const char* data, size_t size) {
+        separator();
+        quoted(data, size);
+    }
+    void string(const std::string& value) { string(value.data(), value.size()); }
+
+    // NaN and infinities have no JSON form
+    void number(double value) {
+        separator();
+        if (!std::isfinite(value)) {
+            m_out += "null";
+            return;
+        }
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        m_out.append(buffer, result.ptr);
+    }
+
+    void integer(int64_t value) {
+        separator();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        m_out.append(buffer, result.ptr);
+    }
+
+    void boolean(bool value) {
+        separator();
+        m_out += value ? "true" : "false";
+    }
+
+    // Splice an already formatted JSON value
+    void raw(const std::string& json) {
+        separator();
+        m_out += json;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 16;
+
+    void open(char bracket) {
+        separator();
+        m_out += bracket;
+        if (m_depth < MAX_DEPTH)
+            m_hasItem[m_depth] = false;
+        m_depth++;
+    }
+
+    void close(char bracket) {
+        if (m_depth > 0)
+            m_depth--;
+        m_out += bracket;
+    }
+
+    void separator() {
+        if (m_afterKey) {
+            m_afterKey = false;
+            return;
+        }
+        if (m_depth > 0 && m_depth <= MAX_DEPTH) {
+            if (m_hasItem[m_depth - 1])
+                m_out += ',';
+            m_hasItem[m_depth - 1] = true;
+        }
+    }
+
+    void quoted(const char* data, size_t size) {
+        static const char* hex = "0123456789abcdef";
+        m_out += '"';
+        for (size_t i = 0; i < size; ++i) {
+            const unsigned char c = static_cast<unsigned char>(data[i]);
+            switch (c) {
+                case '"':  m_out += "\\\""; break;
+                case '\\': m_out += "\\\\"; break;
+                case '\n': m_out += "\\n"; break;
+                case '\r': m_out += "\\r"; break;
+                case '\t': m_out += "\\t"; break;
+                case '\b': m_out += "\\b"; break;
+                case '\f': m_out += "\\f"; break;
+                default:
+                    if (c < 0x20) {
+                        m_out += "\\u00";
+                        m_out += hex[c >> 4];
+                        m_out += hex[c & 0xF];
+                    } else {
+                        m_out += static_cast<char>(c);
+                    }
+            }
+        }
+        m_out += '"';
+    }
+
+    std::string& m_out;
+    bool m_hasItem[MAX_DEPTH] = {};
+    int m_depth = 0;
+    bool m_afterKey = false;
+};
+
+#endif // JSON_WRITER_H
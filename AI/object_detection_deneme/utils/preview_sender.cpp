@@ -0,0 +1,418 @@
+#include "preview_sender.hpp"
+#include "thread_name.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+void put_be(uint8_t *out, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = static_cast<uint8_t>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+uint64_t wall_clock_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+PreviewSender::PreviewSender(const Config &config)
+    : m_config(config),
+      m_period(1000000 / std::max(1, config.max_fps))
+{
+    m_sock = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    m_dst.sin_family = AF_INET;
+    m_dst.sin_port = htons(config.port);
+
+    if (config.multicast_group.empty()) {
+        ::inet_pton(AF_INET, config.ip.c_str(), &m_dst.sin_addr);
+    } else {
+        // Every viewer joins the group: one encode, one send, however many watch
+        ::inet_pton(AF_INET, config.multicast_group.c_str(), &m_dst.sin_addr);
+        unsigned char ttl = static_cast<unsigned char>(std::clamp(config.multicast_ttl, 1, 255));
+        ::setsockopt(m_sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    }
+
+    m_feedback_sock = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(config.feedback_port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (::bind(m_feedback_sock, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        std::cerr << "Preview feedback port " << config.feedback_port << " unavailable: "
+                  << std::strerror(errno) << std::endl;
+    }
+
+    for (auto &slot : m_slots) {
+        slot.quality = config.max_quality;
+        slot.fps = config.max_fps;
+#ifdef HAVE_TURBOJPEG
+        slot.compressor = tjInitCompress();
+#else
+        slot.params = {cv::IMWRITE_JPEG_QUALITY, config.max_quality};
+#endif
+    }
+
+    m_thread = std::thread(&PreviewSender::send_loop, this);
+}
+
+PreviewSender::~PreviewSender()
+{
+    stop();
+    for (auto &slot : m_slots) {
+#ifdef HAVE_TURBOJPEG
+        if (slot.compressor) {
+            tjDestroy(slot.compressor);
+        }
+        if (slot.jpeg) {
+            tjFree(slot.jpeg);
+        }
+#else
+        (void)slot;
+#endif
+    }
+    if (m_sock >= 0) {
+        ::close(m_sock);
+    }
+    if (m_feedback_sock >= 0) {
+        ::close(m_feedback_sock);
+    }
+}
+
+void PreviewSender::submit(int cam_id, const cv::Mat &frame)
+{
+    if (cam_id < 0 || cam_id >= MAX_CAMERAS || frame.empty()) {
+        return;
+    }
+    if (!(m_subscribed.load(std::memory_order_relaxed) & (1u << cam_id))) {
+        return;                 // nobody is watching this camera
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CameraSlot &slot = m_slots[cam_id];
+    if (slot.fresh) {
+        ++m_frames_replaced;
+    }
+    slot.pending = frame;       // shares the pixels, grabLoop reads into a new Mat every frame
+    slot.capture_us = wall_clock_us();
+    slot.fresh = true;
+}
+
+void PreviewSender::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void PreviewSender::set_shedding(bool shed)
+{
+    m_shedding = shed;
+}
+
+bool PreviewSender::encode(CameraSlot &slot, const cv::Mat &frame, const uint8_t *&data, size_t &size)
+{
+    const int quality = m_shedding ? std::min(slot.quality.load(), m_config.min_quality) : slot.quality.load();
+#ifdef HAVE_TURBOJPEG
+    if (!slot.compressor || frame.type() != CV_8UC3) {
+        return false;
+    }
+    unsigned long needed = tjBufSize(frame.cols, frame.rows, TJSAMP_420);
+    if (needed > slot.capacity) {
+        if (slot.jpeg) {
+            tjFree(slot.jpeg);
+        }
+        slot.jpeg = tjAlloc(static_cast<int>(needed));
+        slot.capacity = slot.jpeg ? needed : 0;
+        if (!slot.jpeg) {
+            return false;
+        }
+    }
+    unsigned long jpeg_size = slot.capacity;
+    int rc = tjCompress2(slot.compressor, frame.data, frame.cols, static_cast<int>(frame.step), frame.rows,
+                         TJPF_BGR, &slot.jpeg, &jpeg_size, TJSAMP_420, quality,
+                         TJFLAG_NOREALLOC | TJFLAG_FASTDCT);
+    if (rc != 0) {
+        return false;
+    }
+    data = slot.jpeg;
+    size = jpeg_size;
+    return true;
+#else
+    slot.jpeg.clear();
+    slot.params[1] = quality;
+    if (!cv::imencode(".jpg", frame, slot.jpeg, slot.params)) {
+        return false;
+    }
+    data = slot.jpeg.data();
+    size = slot.jpeg.size();
+    return true;
+#endif
+}
+
+// Splits one encoded frame into fragments and queues them for this tick's sendmmsg
+void PreviewSender::add_fragments(int cam_id, CameraSlot &slot, uint64_t capture_us, const uint8_t *data, size_t size)
+{
+    const size_t count = (size + FRAGMENT_PAYLOAD - 1) / FRAGMENT_PAYLOAD;
+    const uint32_t frame_id = slot.frame_id++;
+    slot.headers.resize(count);
+    slot.iovs.resize(2 * count);
+
+    for (size_t i = 0; i < count; i++) {
+        const size_t offset = i * FRAGMENT_PAYLOAD;
+        uint8_t *h = slot.headers[i].data();
+        h[0] = MAGIC;
+        h[1] = VERSION;
+        h[2] = static_cast<uint8_t>(cam_id);
+        h[3] = 0;
+        put_be(h + 4, frame_id, 4);
+        put_be(h + 8, i, 2);
+        put_be(h + 10, count, 2);
+        put_be(h + 12, offset, 4);
+        put_be(h + 16, size, 4);
+        put_be(h + 20, capture_us, 8);
+
+        slot.iovs[2 * i] = iovec{h, HEADER_SIZE};
+        slot.iovs[2 * i + 1] = iovec{const_cast<uint8_t*>(data) + offset, std::min(FRAGMENT_PAYLOAD, size - offset)};
+
+        mmsghdr m;
+        std::memset(&m, 0, sizeof(m));
+        m.msg_hdr.msg_name = &m_dst;
+        m.msg_hdr.msg_namelen = sizeof(m_dst);
+        m.msg_hdr.msg_iov = &slot.iovs[2 * i];
+        m.msg_hdr.msg_iovlen = 2;
+        m_msgs.push_back(m);
+    }
+}
+
+// Reads every feedback datagram that arrived since the last tick. Each viewer
+// is tracked by its address; adaptation follows the worst live viewer.
+void PreviewSender::poll_feedback(Clock::time_point now)
+{
+    uint8_t buf[512];
+    bool fresh = false;
+    while (true) {
+        sockaddr_in from{};
+        socklen_t from_len = sizeof(from);
+        ssize_t n = ::recvfrom(m_feedback_sock, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&from), &from_len);
+        if (n < 0) {
+            break;              // EAGAIN: drained (or the port never bound)
+        }
+        if (n < 4 || buf[0] != FEEDBACK_MAGIC || buf[1] != VERSION) {
+            continue;
+        }
+        const int cameras = std::min<int>(buf[3], MAX_CAMERAS);
+        if (n < 4 + 6 * cameras) {
+            continue;
+        }
+
+        auto viewer = std::find_if(m_viewers.begin(), m_viewers.end(), [&](const Viewer &v) {
+            return v.addr.sin_addr.s_addr == from.sin_addr.s_addr && v.addr.sin_port == from.sin_port;
+        });
+        if (viewer == m_viewers.end()) {
+            if (m_viewers.size() >= MAX_VIEWERS) {
+                continue;
+            }
+            m_viewers.push_back(Viewer{});
+            viewer = m_viewers.end() - 1;
+            viewer->addr = from;
+        }
+
+        viewer->last_seen = now;
+        viewer->mask = buf[2];
+        for (int cam = 0; cam < MAX_CAMERAS; cam++) {
+            const uint8_t *entry = buf + 4 + 6 * cam;
+            viewer->shown_fps[cam] = cam < cameras ? ((entry[0] << 8) | entry[1]) / 10.0 : 0.0;
+            viewer->loss[cam] = cam < cameras ? ((entry[2] << 8) | entry[3]) / 1000.0 : 0.0;
+        }
+        ++m_feedback_received;
+        fresh = true;
+    }
+
+    // Viewers closed or unreachable are forgotten; nobody left -> stop encoding
+    const auto timeout = std::chrono::milliseconds(m_config.subscriber_timeout_ms);
+    m_viewers.erase(std::remove_if(m_viewers.begin(), m_viewers.end(),
+                                   [&](const Viewer &v) { return now - v.last_seen > timeout; }),
+                    m_viewers.end());
+
+    uint32_t subscribed = 0;
+    for (const auto &v : m_viewers) {
+        subscribed |= v.mask;
+    }
+    m_subscribed = subscribed;
+    m_viewer_count = m_viewers.size();
+
+    // Viewers report on their own timers; adapt once per feedback period
+    if (!fresh || now - m_last_adapt < ADAPT_INTERVAL) {
+        return;
+    }
+    const double elapsed_s = m_last_adapt == Clock::time_point{}
+        ? 0.0 : std::chrono::duration<double>(now - m_last_adapt).count();
+    m_last_adapt = now;
+
+    for (int cam = 0; cam < MAX_CAMERAS; cam++) {
+        double worst_fps = -1.0, worst_loss = 0.0;
+        for (const auto &v : m_viewers) {
+            if (!(v.mask & (1u << cam))) {
+                continue;
+            }
+            worst_fps = worst_fps < 0.0 ? v.shown_fps[cam] : std::min(worst_fps, v.shown_fps[cam]);
+            worst_loss = std::max(worst_loss, v.loss[cam]);
+        }
+        if (worst_fps >= 0.0) {
+            adapt(m_slots[cam], worst_fps, worst_loss, elapsed_s);
+        }
+        m_slots[cam].sent_since_feedback = 0;
+    }
+}
+
+// Back off on loss or a viewer that can't keep up, creep back up when it is clean
+void PreviewSender::adapt(CameraSlot &slot, double shown_fps, double loss, double elapsed_s)
+{
+    double fps = slot.fps;
+    int quality = slot.quality;
+    double sent_fps = elapsed_s > 0.0 ? slot.sent_since_feedback / elapsed_s : 0.0;
+
+    if (loss > 0.05) {
+        fps *= 0.7;
+        quality -= 10;
+    } else if (sent_fps > 0.0 && shown_fps < 0.8 * sent_fps) {
+        fps = shown_fps * 1.1;  // viewer decodes slower than we send
+    } else if (loss < 0.01) {
+        fps += 2.0;
+        quality += 2;
+    }
+
+    slot.fps = std::clamp(fps, static_cast<double>(m_config.min_fps), static_cast<double>(m_config.max_fps));
+    slot.quality = std::clamp(quality, m_config.min_quality, m_config.max_quality);
+}
+
+void PreviewSender::send_loop()
+{
+    set_thread_name("preview-tx");
+    std::array<cv::Mat, MAX_CAMERAS> frames;
+    std::array<uint64_t, MAX_CAMERAS> captured{};
+    auto next_tick = Clock::now();
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            next_tick += m_period;
+            m_cond.wait_until(lock, next_tick, [this] { return m_stopped; });
+            if (m_stopped) {
+                break;
+            }
+            for (int cam = 0; cam < MAX_CAMERAS; cam++) {
+                if (m_slots[cam].fresh) {
+                    frames[cam] = std::move(m_slots[cam].pending);
+                    m_slots[cam].pending.release();
+                    captured[cam] = m_slots[cam].capture_us;
+                    m_slots[cam].fresh = false;
+                }
+            }
+        }
+        auto now = Clock::now();
+        if (next_tick < now) {
+            next_tick = now;     // fell behind: don't burst to catch up
+        }
+        poll_feedback(now);
+
+        // Encode outside the lock, one compressor per camera
+        m_msgs.clear();
+        unsigned frame_count = 0;
+        for (int cam = 0; cam < MAX_CAMERAS; cam++) {
+            if (frames[cam].empty()) {
+                continue;
+            }
+            CameraSlot &slot = m_slots[cam];
+            if (!(m_subscribed & (1u << cam)) || now + m_period / 2 < slot.next_due) {
+                frames[cam].release();      // unsubscribed, or over this camera's fps budget
+                continue;
+            }
+            const double fps = m_shedding ? std::min<double>(slot.fps, m_config.min_fps) : slot.fps.load();
+            slot.next_due = std::max(slot.next_due, now - m_period) +
+                std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+
+            const uint8_t *data = nullptr;
+            size_t size = 0;
+            bool ok = encode(slot, frames[cam], data, size);
+            frames[cam].release();
+            if (!ok) {
+                ++m_encode_errors;
+                continue;
+            }
+            if (size > MAX_FRAME_BYTES) {
+                ++m_too_large;
+                continue;
+            }
+            add_fragments(cam, slot, captured[cam], data, size);
+            slot.sent_since_feedback++;
+            frame_count++;
+        }
+
+        // Every fragment of every camera in as few syscalls as the kernel allows
+        unsigned sent = 0;
+        const unsigned count = static_cast<unsigned>(m_msgs.size());
+        while (sent < count) {
+            int rc = ::sendmmsg(m_sock, m_msgs.data() + sent, count - sent, 0);
+            ++m_send_calls;
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                m_send_errors += count - sent;
+                break;
+            }
+            sent += static_cast<unsigned>(rc);
+        }
+        m_datagrams_sent += sent;
+        if (sent == count) {
+            m_frames_sent += frame_count;
+        }
+    }
+}
+
+std::string PreviewSender::stats_json() const
+{
+    const uint32_t subscribed = m_subscribed.load();
+    std::ostringstream json;
+    json << "{\"framesSent\":" << m_frames_sent.load()
+         << ",\"datagramsSent\":" << m_datagrams_sent.load()
+         << ",\"framesReplaced\":" << m_frames_replaced.load()
+         << ",\"tooLarge\":" << m_too_large.load()
+         << ",\"encodeErrors\":" << m_encode_errors.load()
+         << ",\"sendErrors\":" << m_send_errors.load()
+         << ",\"sendCalls\":" << m_send_calls.load()
+         << ",\"feedbackReceived\":" << m_feedback_received.load()
+         << ",\"viewers\":" << m_viewer_count.load()
+         << ",\"shedding\":" << (m_shedding.load() ? "true" : "false")
+         << ",\"multicast\":\"" << m_config.multicast_group << "\""
+#ifdef HAVE_TURBOJPEG
+         << ",\"encoder\":\"turbojpeg\""
+#else
+         << ",\"encoder\":\"opencv\""
+#endif
+         << ",\"cameras\":[";
+    for (int cam = 0; cam < MAX_CAMERAS; cam++) {
+        json << (cam ? "," : "") << "{\"subscribed\":" << ((subscribed >> cam) & 1 ? "true" : "false")
+             << ",\"fps\":" << std::fixed << std::setprecision(1) << m_slots[cam].fps.load()
+             << ",\"quality\":" << m_slots[cam].quality.load() << "}";
+    }
+    json << "]}";
+    return json.str();
+}
@@ -0,0 +1,151 @@
+#ifndef _PREVIEW_SENDER_HPP_
+#define _PREVIEW_SENDER_HPP_
+
+#include <opencv2/opencv.hpp>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+/**
+ * Live preview to the desktop viewer, off the capture threads.
+ * grabLoop hands over its latest frame per camera (latest wins, never
+ * blocks); one sender thread wakes once per preview tick, JPEG-encodes the
+ * fresh frames with a persistent per-camera compressor into preallocated
+ * buffers and sends all of them with a single sendmmsg.
+ *
+ * Each JPEG is split into MTU-sized fragments, every one carrying a
+ * 28-byte big-endian header (the desktop Receiver reassembles them):
+ *   [magic:u8 0xB5][version:u8][camId:u8][flags:u8][frameId:u32]
+ *   [fragIdx:u16][fragCount:u16][offset:u32][frameLength:u32][captureUs:u64]
+ * captureUs is wall-clock microseconds when grabLoop submitted the frame.
+ *
+ * The Receiver answers on the feedback port every few hundred ms:
+ *   [magic:u8 0xB6][version:u8][subscribedMask:u8][cameraCount:u8]
+ *   cameraCount x [shownFps x10:u16][lossPermille:u16][latencyMs:u16]
+ * Per-camera fps and JPEG quality follow that feedback (the worst viewer
+ * wins when several watch), and a camera nobody subscribed to is not
+ * encoded at all.
+ *
+ * With a multicast group configured each frame is sent once to the group
+ * instead of to one desktop, so extra viewers cost the edge nothing.
+ */
+class PreviewSender {
+public:
+    static constexpr uint8_t MAGIC = 0xB5;          // legacy datagrams start with camId < 0xB5
+    static constexpr uint8_t FEEDBACK_MAGIC = 0xB6;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 28;
+    static constexpr size_t FRAGMENT_PAYLOAD = 1400;     // header + payload stays below a 1500 byte MTU
+    static constexpr size_t MAX_FRAME_BYTES = 1 << 20;   // receiver reassembly limit
+    static constexpr int MAX_CAMERAS = 4;
+    static constexpr size_t MAX_VIEWERS = 32;
+
+    struct Config {
+        std::string ip;
+        uint16_t port;
+        uint16_t feedback_port;
+        int max_quality;
+        int min_quality;
+        int max_fps;
+        int min_fps;
+        int subscriber_timeout_ms;   // no feedback for this long -> stop encoding
+        std::string multicast_group; // empty: unicast to ip
+        int multicast_ttl;
+    };
+
+    explicit PreviewSender(const Config &config);
+    ~PreviewSender();
+
+    PreviewSender(const PreviewSender&) = delete;
+    PreviewSender& operator=(const PreviewSender&) = delete;
+
+    void submit(int cam_id, const cv::Mat &frame);
+    void set_shedding(bool shed);   // hold every camera at min fps and min quality
+    void stop();
+    std::string stats_json() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds ADAPT_INTERVAL{400};
+
+    struct Viewer {
+        sockaddr_in addr{};
+        uint32_t mask = 0;
+        Clock::time_point last_seen{};
+        std::array<double, MAX_CAMERAS> shown_fps{};
+        std::array<double, MAX_CAMERAS> loss{};
+    };
+
+    struct CameraSlot {
+        cv::Mat pending;                    // guarded by m_mutex
+        bool fresh = false;                 // guarded by m_mutex
+        uint64_t capture_us = 0;            // guarded by m_mutex
+        uint32_t frame_id = 0;
+        std::vector<std::array<uint8_t, HEADER_SIZE>> headers;   // one per fragment, reused
+        std::vector<iovec> iovs;                                  // two per fragment, reused
+
+        // Adaptation state, written by the sender thread only (atomics for stats_json)
+        std::atomic<int> quality{0};
+        std::atomic<double> fps{0};
+        Clock::time_point next_due{};
+        unsigned sent_since_feedback = 0;
+#ifdef HAVE_TURBOJPEG
+        tjhandle compressor = nullptr;
+        unsigned char *jpeg = nullptr;      // tjAlloc'ed, grown only when the frame size grows
+        unsigned long capacity = 0;
+#else
+        std::vector<uchar> jpeg;            // capacity is kept between frames
+        std::vector<int> params;
+#endif
+    };
+
+    Config m_config;
+    int m_sock = -1;
+    int m_feedback_sock = -1;
+    sockaddr_in m_dst{};
+    std::chrono::microseconds m_period;
+
+    std::array<CameraSlot, MAX_CAMERAS> m_slots;
+    std::vector<mmsghdr> m_msgs;            // every fragment of one tick
+
+    std::atomic<bool> m_shedding{false};
+    std::atomic<uint32_t> m_subscribed{0};  // camera bitmask, OR of every live viewer
+    std::atomic<size_t> m_viewer_count{0};
+    std::vector<Viewer> m_viewers;          // sender thread only
+    Clock::time_point m_last_adapt{};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stopped = false;
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_frames_sent{0};
+    std::atomic<uint64_t> m_datagrams_sent{0};
+    std::atomic<uint64_t> m_frames_replaced{0};    // overwritten by a newer frame before the tick
+    std::atomic<uint64_t> m_too_large{0};
+    std::atomic<uint64_t> m_encode_errors{0};
+    std::atomic<uint64_t> m_send_errors{0};
+    std::atomic<uint64_t> m_send_calls{0};
+    std::atomic<uint64_t> m_feedback_received{0};
+
+    bool encode(CameraSlot &slot, const cv::Mat &frame, const uint8_t *&data, size_t &size);
+    void add_fragments(int cam_id, CameraSlot &slot, uint64_t capture_us, const uint8_t *data, size_t size);
+    void poll_feedback(Clock::time_point now);
+    void adapt(CameraSlot &slot, double shown_fps, double loss, double elapsed_s);
+    void send_loop();
+};
+
+#endif /* _PREVIEW_SENDER_HPP_ */
@@ -2,6 +2,8 @@
 #define SCAN_REQUEST_DTO_H
 
 #include <string>
+#include "cbor.h"
+#include "json_writer.h"
 
 /**
  * C++ equivalent of the Spring Boot ScanRequestDTO record
@@ -18,15 +20,39 @@ public:
     double x() const { return m_x; }
     double y() const { return m_y; }
 
+    // Write the JSON form into a (reused) buffer
+    void toJson(JsonWriter& json) const {
+        json.beginObject();
+        json.key("productResult");
+        json.string(m_productResult);
+        json.key("confidence");
+        json.number(m_confidence);
+        json.key("x");
+        json.number(m_x);
+        json.key("y");
+        json.number(m_y);
+        json.endObject();
+    }
+
     // Convert to JSON string representation
     std::string toJson() const {
-        std::string json = "{";
-        json += "\"productResult\":\"" + m_productResult + "\"";
-        json += ",\"confidence\":" + std::to_string(m_confidence);
-        json += ",\"x\":" + std::to_string(m_x);
-        json += ",\"y\":" + std::to_string(m_y);
-        json += "}";
-        return json;
+        std::string out;
+        JsonWriter json(out);
+        toJson(json);
+        return out;
+    }
+
+    // Append the CBOR form: same keys as toJson(), reals as float32
+    void toCbor(CborWriter& cbor) const {
+        cbor.map(4);
+        cbor.key("productResult");
+        cbor.text(m_productResult);
+        cbor.key("confidence");
+        cbor.f32(static_cast<float>(m_confidence));
+        cbor.key("x");
+        cbor.f32(static_cast<float>(m_x));
+        cbor.key("y");
+        cbor.f32(static_cast<float>(m_y));
     }
 
 private:
@@ -0,0 +1,92 @@
+#ifndef _SEQLOCK_HPP_
+#define _SEQLOCK_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+/**
+ * Sequence lock for small, trivially copyable settings/snapshot structs.
+ * Readers never block or allocate: they copy the payload word by word with
+ * relaxed atomic loads and retry if a writer was active meanwhile. Writers
+ * are rare (HTTP handlers, samplers) and serialize on a mutex.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> m_seq{0};
+    std::atomic<uint64_t> m_words[WORDS];
+    std::mutex m_write_mutex;
+
+    T read_words() const {
+        uint64_t buf[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            buf[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        T out;
+        std::memcpy(&out, buf, sizeof(T));
+        return out;
+    }
+
+    // Caller holds m_write_mutex
+    void write_words(const T &value) {
+        uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);     // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            m_words[i].store(buf[i], std::memory_order_relaxed);
+        }
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+public:
+    explicit SeqLock(const T &initial = T{}) {
+        for (auto &word : m_words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(m_write_mutex);
+        write_words(initial);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    T load() const {
+        for (;;) {
+            uint64_t before = m_seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            T out = read_words();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == before) {
+                return out;
+            }
+        }
+    }
+
+    void store(const T &value) {
+        std::lock_guard<std::mutex> lock(m_write_mutex);
+        write_words(value);
+    }
+
+    // Read-modify-write of a single field without losing concurrent updates
+    template<typename F>
+    void update(F &&mutate) {
+        std::lock_guard<std::mutex> lock(m_write_mutex);
+        T value = read_words();    // stable: only writers change it and we hold the lock
+        mutate(value);
+        write_words(value);
+    }
+};
+
+#endif /* _SEQLOCK_HPP_ */
@@ -3,8 +3,9 @@
 
 #include <string>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include "cbor.h"
+#include "iso_timestamp.h"
+#include "json_writer.h"
 
 /**
  * C++ DTO for system log messages, such as "INFO: Camera is opened"
@@ -38,10 +39,8 @@ public:
 
     // Convert timestamp to ISO 8601 format
     std::string timestampAsString() const {
-        auto time_t = std::chrono::system_clock::to_time_t(m_timestamp);
-        std::stringstream ss;
-        ss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%SZ");
-        return ss.str();
+        char buffer[24];
+        return std::string(buffer, formatIsoTimestamp(m_timestamp, buffer));
     }
 
     // Convert log level to string
@@ -60,14 +59,37 @@ public:
         return logLevelToString() + ": " + m_message;
     }
 
+    // Write the JSON form into a (reused) buffer; the message is escaped
+    void toJson(JsonWriter& json) const {
+        char timestamp[24];
+        json.beginObject();
+        json.key("timestamp");
+        json.string(timestamp, formatIsoTimestamp(m_timestamp, timestamp));
+        json.key("level");
+        json.string(logLevelToString());
+        json.key("message");
+        json.string(m_message);
+        json.endObject();
+    }
+
     // Convert to JSON
     std::string toJson() const {
-        std::string json = "{";
-        json += "\"timestamp\":\"" + timestampAsString() + "\"";
-        json += ",\"level\":\"" + logLevelToString() + "\"";
-        json += ",\"message\":\"" + m_message + "\"";
-        json += "}";
-        return json;
+        std::string out;
+        JsonWriter json(out);
+        toJson(json);
+        return out;
+    }
+
+    // Append the CBOR form: same keys as toJson()
+    void toCbor(CborWriter& cbor) const {
+        char timestamp[24];
+        cbor.map(3);
+        cbor.key("timestamp");
+        cbor.text(timestamp, formatIsoTimestamp(m_timestamp, timestamp));
+        cbor.key("level");
+        cbor.text(logLevelToString());
+        cbor.key("message");
+        cbor.text(m_message);
     }
 
 private:
@@ -3,8 +3,9 @@
 
 #include <string>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include "cbor.h"
+#include "iso_timestamp.h"
+#include "json_writer.h"
 
 /**
  * C++ equivalent of the Spring Boot SystemStatus record
@@ -36,21 +37,45 @@ public:
 
     // Get timestamp as ISO string
     std::string timestampAsString() const {
-        auto time_t = std::chrono::system_clock::to_time_t(m_timestamp);
-        std::stringstream ss;
-        ss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%SZ");
-        return ss.str();
+        char buffer[24];
+        return std::string(buffer, formatIsoTimestamp(m_timestamp, buffer));
+    }
+
+    // Write the JSON form into a (reused) buffer
+    void toJson(JsonWriter& json) const {
+        char timestamp[24];
+        json.beginObject();
+        json.key("timestamp");
+        json.string(timestamp, formatIsoTimestamp(m_timestamp, timestamp));
+        json.key("cpuDegree");
+        json.number(m_degree);
+        json.key("cpuUsage");
+        json.number(m_cpuUtilization);
+        json.key("memoryUsage");
+        json.string(m_memoryUsage);
+        json.endObject();
     }
 
     // Convert to JSON string representation
     std::string toJson() const {
-        std::string json = "{";
-        json += "\"timestamp\":\"" + timestampAsString() + "\"";
-        json += ",\"cpuDegree\":" + std::to_string(m_degree);
-        json += ",\"cpuUsage\":" + std::to_string(m_cpuUtilization);
-        json += ",\"memoryUsage\":\"" + m_memoryUsage + "\"";
-        json += "}";
-        return json;
+        std::string out;
+        JsonWriter json(out);
+        toJson(json);
+        return out;
+    }
+
+    // Append the CBOR form: same keys as toJson(), reals as float32
+    void toCbor(CborWriter& cbor) const {
+        char timestamp[24];
+        cbor.map(4);
+        cbor.key("timestamp");
+        cbor.text(timestamp, formatIsoTimestamp(m_timestamp, timestamp));
+        cbor.key("cpuDegree");
+        cbor.f32(static_cast<float>(m_degree));
+        cbor.key("cpuUsage");
+        cbor.f32(static_cast<float>(m_cpuUtilization));
+        cbor.key("memoryUsage");
+        cbor.text(m_memoryUsage);
     }
 
 private:
@@ -0,0 +1,18 @@
+#ifndef THREAD_NAME_HPP
+#define THREAD_NAME_HPP
+
+#include <cstring>
+#include <pthread.h>
+
+/**
+ * Name the calling thread so top -H, /proc/self/task/<tid>/comm and the
+ * system sampler can tell the pipeline stages apart. Linux keeps at most
+ * 15 characters; longer names are cut rather than rejected.
+ */
+inline void set_thread_name(const char* name) {
+    char truncated[16] = {};
+    std::memcpy(truncated, name, strnlen(name, sizeof(truncated) - 1));
+    pthread_setname_np(pthread_self(), truncated);
+}
+
+#endif // THREAD_NAME_HPP
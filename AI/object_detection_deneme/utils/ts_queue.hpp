@@ -0,0 +1,195 @@
+#ifndef _TS_QUEUE_HPP_
+#define _TS_QUEUE_HPP_
+
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+template<typename T>
+class BoundedTSQueue {
+private:
+    std::queue<T> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond_not_empty;
+    std::condition_variable m_cond_not_full;
+    const size_t m_max_size;
+    bool m_stopped;
+
+public:
+    explicit BoundedTSQueue(size_t max_size) : m_max_size(max_size), m_stopped(false) {}
+    ~BoundedTSQueue() { stop(); }
+
+    BoundedTSQueue(const BoundedTSQueue&) = delete;
+    BoundedTSQueue& operator=(const BoundedTSQueue&) = delete;
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond_not_full.wait(lock, [this] { return m_queue.size() < m_max_size || m_stopped; });
+        if (m_stopped) return;
+
+        m_queue.push(std::move(item));
+        m_cond_not_empty.notify_one();
+    }
+
+    // Never blocks: returns false (and drops item) when full or stopped
+    bool try_push(T item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped || m_queue.size() >= m_max_size) {
+            return false;
+        }
+        m_queue.push(std::move(item));
+        m_cond_not_empty.notify_one();
+        return true;
+    }
+
+    bool pop(T &out_item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond_not_empty.wait(lock, [this] { return !m_queue.empty() || m_stopped; });
+        if (m_stopped && m_queue.empty()) {
+            return false;
+        }
+
+        out_item = std::move(m_queue.front());
+        m_queue.pop();
+        m_cond_not_full.notify_one();
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cond_not_empty.notify_all();
+        m_cond_not_full.notify_all();
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.empty();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+};
+
+
+/**
+ * Earliest-deadline-first queue for frames that are worthless after their
+ * product has passed the diverter. T must expose a steady_clock `deadline`.
+ * An item with a deadline never blocks push(): expired items are refused, and
+ * when the queue is full the item with the latest deadline is evicted. An
+ * item without one (time_point::max(), video and image input) is never
+ * dropped; its push() waits for space like BoundedTSQueue. pop() skips
+ * expired items.
+ */
+template<typename T>
+class DeadlineTSQueue {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::deque<T> m_queue;  // kept sorted by deadline, earliest first
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond_not_empty;
+    std::condition_variable m_cond_not_full;
+    const size_t m_max_size;
+    bool m_stopped;
+
+    std::atomic<size_t> m_expired_on_push{0};
+    std::atomic<size_t> m_expired_on_pop{0};
+    std::atomic<size_t> m_overflow{0};
+
+public:
+    explicit DeadlineTSQueue(size_t max_size) : m_max_size(max_size), m_stopped(false) {}
+    ~DeadlineTSQueue() { stop(); }
+
+    DeadlineTSQueue(const DeadlineTSQueue&) = delete;
+    DeadlineTSQueue& operator=(const DeadlineTSQueue&) = delete;
+
+    void push(T item) {
+        auto now = Clock::now();
+        if (item.deadline <= now) {
+            ++m_expired_on_push;
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (item.deadline == Clock::time_point::max()) {
+            // no deadline to miss, so back-pressure instead of a drop
+            m_cond_not_full.wait(lock, [this] { return m_queue.size() < m_max_size || m_stopped; });
+        }
+        if (m_stopped) return;
+
+        while (!m_queue.empty() && m_queue.front().deadline <= now) {
+            m_queue.pop_front();
+            ++m_expired_on_pop;
+        }
+        if (m_queue.size() >= m_max_size) {
+            // only items that carry a deadline are evicted; the rest must be processed
+            ++m_overflow;
+            if (m_queue.back().deadline <= item.deadline || m_queue.back().deadline == Clock::time_point::max()) return;
+            m_queue.pop_back();
+        }
+
+        auto pos = std::upper_bound(m_queue.begin(), m_queue.end(), item.deadline,
+                                    [](const Clock::time_point &d, const T &queued) { return d < queued.deadline; });
+        m_queue.insert(pos, std::move(item));
+        m_cond_not_empty.notify_one();
+    }
+
+    bool pop(T &out_item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cond_not_empty.wait(lock, [this] { return !m_queue.empty() || m_stopped; });
+            if (m_stopped && m_queue.empty()) {
+                return false;
+            }
+
+            auto now = Clock::now();
+            while (!m_queue.empty() && m_queue.front().deadline <= now) {
+                m_queue.pop_front();
+                ++m_expired_on_pop;
+            }
+            if (m_queue.empty()) {
+                m_cond_not_full.notify_all();
+                continue;
+            }
+
+            out_item = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_cond_not_full.notify_one();
+            return true;
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_cond_not_empty.notify_all();
+        m_cond_not_full.notify_all();
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.empty();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+    size_t expired_on_push() const { return m_expired_on_push; }
+    size_t expired_on_pop() const { return m_expired_on_pop; }
+    size_t overflow() const { return m_overflow; }
+};
+
+#endif /* _TS_QUEUE_HPP_ */
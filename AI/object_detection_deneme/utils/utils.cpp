@@ -1,4 +1,5 @@
 #include "utils.hpp"
+#include <stdexcept>
 
 std::vector<cv::Scalar> COLORS = {
     cv::Scalar(255,   0,   0),  // Red
@@ -145,11 +146,35 @@ std::string get_coco_name_from_int(int cls)
 * */
 
 
+static int parse_thread_count(const std::string &value)
+{
+    if (value.empty()) {
+        return 0;
+    }
+    size_t used = 0;
+    int count = -1;
+    try {
+        count = std::stoi(value, &used);
+    }
+    catch (const std::exception &) {
+    }
+    if (used != value.size() || count < 1) {
+        throw std::invalid_argument("-threads= expects a positive whole number, got '" + value + "'");
+    }
+    return count;
+}
+
 CommandLineArgs parse_command_line_arguments(int argc, char** argv) {
+    std::string backend = getCmdOption(argc, argv, "-backend=");
+    int threads = parse_thread_count(getCmdOption(argc, argv, "-threads="));
     return {
         getCmdOption(argc, argv, "-hef="),
         getCmdOption(argc, argv, "-input="),
-        has_flag(argc, argv, "-s")
+        has_flag(argc, argv, "-s"),
+        backend.empty() ? "auto" : backend,
+        getCmdOption(argc, argv, "-onnx="),
+        threads,
+        getCmdOption(argc, argv, "-classifier=")
     };
 }
 
@@ -252,8 +277,8 @@ InputType determine_input_type(const std::string& input_path, cv::VideoCapture &
 
 
 void print_net_banner(const std::string &detection_model_name,
-                      const std::vector<hailort::InferModel::InferStream> &inputs,
-                      const std::vector<hailort::InferModel::InferStream> &outputs)
+                      const std::vector<TensorInfo> &inputs,
+                      const std::vector<TensorInfo> &outputs)
 {
     std::cout << BOLDMAGENTA << "-I-----------------------------------------------" << std::endl << RESET;
     std::cout << BOLDMAGENTA << "-I-  Network Name                               " << std::endl << RESET;
@@ -261,16 +286,14 @@ void print_net_banner(const std::string &detection_model_name,
     std::cout << BOLDMAGENTA << "-I   " << detection_model_name << std::endl << RESET;
     std::cout << BOLDMAGENTA << "-I-----------------------------------------------" << std::endl << RESET;
     for (auto &input : inputs) {
-        auto shape = input.shape();
-        std::cout << MAGENTA << "-I-  Input: " << input.name()
-                  << ", Shape: (" << shape.height << ", " << shape.width << ", " << shape.features << ")"
+        std::cout << MAGENTA << "-I-  Input: " << input.name
+                  << ", Shape: (" << input.height << ", " << input.width << ", " << input.features << ")"
                   << std::endl << RESET;
     }
     std::cout << BOLDMAGENTA << "-I-----------------------------------------------" << std::endl << RESET;
     for (auto &output : outputs) {
-        auto shape = output.shape();
-        std::cout << MAGENTA << "-I-  Output: " << output.name()
-                  << ", Shape: (" << shape.height << ", " << shape.width << ", " << shape.features << ")"
+        std::cout << MAGENTA << "-I-  Output: " << output.name
+                  << ", Shape: (" << output.height << ", " << output.width << ", " << output.features << ")"
                   << std::endl << RESET;
     }
     std::cout << BOLDMAGENTA << "-I-----------------------------------------------\n" << std::endl << RESET;
@@ -289,7 +312,28 @@ PreprocessedFrameItem create_preprocessed_frame_item(const cv::Mat &frame,
 {
     PreprocessedFrameItem item;
     item.org_frame = frame.clone(); 
-    cv::resize(frame, item.resized_for_infer, cv::Size(width, height));
+    to_model_input(frame, item.resized_for_infer, cv::Size(width, height));
+    return item;
+}
+
+void to_model_input(const cv::Mat &bgr, cv::Mat &rgb, const cv::Size &size)
+{
+    cv::Mat resized;
+    cv::resize(bgr, resized, size);
+    cv::cvtColor(resized, rgb, cv::COLOR_BGR2RGB);   // writes in place when rgb already has the size and type
+}
+
+// Carries the frame's bookkeeping over to its result; backends fill in the outputs
+InferenceOutputItem create_output_item(const PreprocessedFrameItem &frame)
+{
+    InferenceOutputItem item;
+    item.org_frame = frame.org_frame;
+    item.trigger_time = frame.trigger_time;
+    item.deadline = frame.deadline;
+    item.trigger_id = frame.trigger_id;
+    item.cam_id = frame.cam_id;
+    item.sharpness = frame.sharpness;
+    item.burst_size = frame.burst_size;
     return item;
 }
 
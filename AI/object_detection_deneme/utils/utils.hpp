@@ -40,8 +40,7 @@
 
 #include <boost/format.hpp>
 
-#include "hailo/infer_model.hpp" 
-#include "hailo/hailort.h"
+#include "hailo_compat.hpp"
 
 
 
@@ -63,16 +62,10 @@ struct CommandLineArgs {
     std::string detection_hef;
     std::string input_path;
     bool save;
-};
-
-struct PreprocessedFrameItem {
-    cv::Mat org_frame;    
-    cv::Mat resized_for_infer; 
-};
-
-struct InferenceOutputItem {
-    cv::Mat org_frame;  
-    std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> output_data_and_infos;
+    std::string backend;        // "hailo", "cpu" or "auto" (hailo, falling back to cpu)
+    std::string onnx_path;      // exported detector for the cpu backend
+    int cpu_threads;            // cpu backend worker threads, 0 = hardware concurrency
+    std::string classifier;     // defect classifier: "", "mock", *.onnx or *.hef
 };
 
 /**
@@ -92,6 +85,41 @@ struct NamedBbox {
     std::string class_name;
 };
 
+struct PreprocessedFrameItem {
+    cv::Mat org_frame;    
+    cv::Mat resized_for_infer; 
+    std::chrono::steady_clock::time_point trigger_time;   // when gating fired for this frame
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); // useless after this
+    unsigned long long trigger_id = 0;  // unique per camera trigger, shared by the frames of a burst
+    int cam_id = -1;
+    double sharpness = 0.0;     // focus measure from grabLoop, weights the frame in burst fusion
+    int burst_size = 1;         // frames the camera sent for this trigger
+};
+
+struct InferenceOutputItem {
+    cv::Mat org_frame;  
+    std::vector<std::pair<uint8_t*, hailo_vstream_info_t>> output_data_and_infos;
+    std::chrono::steady_clock::time_point trigger_time;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::chrono::steady_clock::time_point infer_start;
+    std::chrono::steady_clock::time_point infer_done;
+    std::vector<std::shared_ptr<uint8_t>> output_guards;  // keeps backend-owned output buffers alive
+    unsigned long long trigger_id = 0;
+    int cam_id = -1;
+    double sharpness = 0.0;
+    int burst_size = 1;
+    bool classified = false;            // the crop-classify stage already parsed the boxes below
+    std::vector<NamedBbox> bboxes;
+    std::vector<float> defect_scores;   // one per box, -1 where the crop was unusable
+};
+
+struct TensorInfo {
+    std::string name;
+    uint32_t height;
+    uint32_t width;
+    uint32_t features;
+};
+
 struct InputType {
     bool is_image = false;
     bool is_video = false;
@@ -106,7 +134,7 @@ struct InputType {
 
 std::string getCmdOption(int argc, char *argv[], const std::string &option);
 bool has_flag(int argc, char *argv[], const std::string &flag);
-CommandLineArgs parse_command_line_arguments(int argc, char **argv);
+CommandLineArgs parse_command_line_arguments(int argc, char **argv);   // throws std::invalid_argument on a malformed option
 
 // ─────────────────────────────────────────────────────────────────────────────
 // INPUT DETECTION
@@ -125,8 +153,8 @@ InputType determine_input_type(const std::string &input_path, cv::VideoCapture &
 // ─────────────────────────────────────────────────────────────────────────────
 
 void print_net_banner(const std::string &detection_model_name,
-                      const std::vector<hailort::InferModel::InferStream> &inputs,
-                      const std::vector<hailort::InferModel::InferStream> &outputs);
+                      const std::vector<TensorInfo> &inputs,
+                      const std::vector<TensorInfo> &outputs);
 void show_progress_helper(size_t current, size_t total);
 void show_progress(InputType &input_type, int progress, size_t frame_count);
 void print_inference_statistics(std::chrono::duration<double> inference_time,
@@ -163,7 +191,9 @@ std::string get_hef_name(const std::string &path);
 hailo_status wait_and_check_threads(std::future<hailo_status> &f1, const std::string &name1,
                                     std::future<hailo_status> &f2, const std::string &name2,
                                     std::future<hailo_status> &f3, const std::string &name3);
+InferenceOutputItem create_output_item(const PreprocessedFrameItem &frame);
 PreprocessedFrameItem create_preprocessed_frame_item(const cv::Mat &frame, uint32_t width, uint32_t height);
+void to_model_input(const cv::Mat &bgr, cv::Mat &rgb, const cv::Size &size);   // camera BGR -> resized RGB, the order the models were trained on
 void initialize_class_colors(std::unordered_map<int, cv::Scalar> &class_colors);
 std::string get_coco_name_from_int(int cls);
 
@@ -3,29 +3,59 @@
 Receiver::Receiver(QWidget* parent)
     : QWidget(parent)
 {
-    socket_.bind(5000, QUdpSocket::ShareAddress |
-                           QUdpSocket::ReuseAddressHint);
+    // Multicast: the edge sends every frame once, any number of viewers join
+    group_ = QHostAddress(qEnvironmentVariable("SDBELT_PREVIEW_GROUP", PREVIEW_MULTICAST_GROUP));
+    if (!group_.isNull() && group_.isMulticast())
+    {
+        socket_.bind(QHostAddress::AnyIPv4, CAMERA_UDP_PORT, QUdpSocket::ShareAddress |
+                                                             QUdpSocket::ReuseAddressHint);
+        if (!socket_.joinMulticastGroup(group_))
+            qWarning() << "Could not join preview group" << group_.toString() << socket_.errorString();
+    }
+    else
+    {
+        group_.clear();
+        socket_.bind(CAMERA_UDP_PORT, QUdpSocket::ShareAddress |
+                               QUdpSocket::ReuseAddressHint);
+    }
 
     connect(&socket_, &QUdpSocket::readyRead,
             this, &Receiver::ProcessPending);
 
-    for (int i = 0; i < CAM_COUNT; ++i)
-    {
-        QLabel* NewEntry = new QLabel("No Frame");
-
-        if(NewEntry)
-        {
-            NewEntry->setStyleSheet("color: white;");
-
-            labels_[i] = NewEntry;
-            labels_[i]->setMinimumSize(WIDGET_W, WIDGET_H);
-            labels_[i]->setAlignment(Qt::AlignCenter);
-            layout_.addWidget(labels_[i], 0, i);
-        }
-    }
+    surface_ = PreviewSurface::Create(CAM_COUNT, this);
+    decodeFormat_ = surface_->PreferredFormat();
+    layout_.addWidget(surface_->Widget(), 0, 0);
 
     setLayout(&layout_);
     setWindowTitle("UDP Camera Viewer");
+
+    decodePool_.setMaxThreadCount(QThread::idealThreadCount());
+    EnsureCamera(CAM_COUNT - 1);
+
+    clock_.start();
+    connect(&maintenanceTimer_, &QTimer::timeout,
+            this, &Receiver::ExpirePending);
+    maintenanceTimer_.start(PREVIEW_MAINTENANCE_MS);
+
+    edgeAddress_ = QHostAddress(EDGE_DEVICE_IP);
+    connect(&feedbackTimer_, &QTimer::timeout,
+            this, &Receiver::SendFeedback);
+    feedbackTimer_.start(PREVIEW_FEEDBACK_MS);
+}
+
+// Grows the per-camera state and the tile grid for a camera id seen for the first time
+bool Receiver::EnsureCamera(int camId)
+{
+    if (camId < 0 || camId >= PREVIEW_MAX_CAMERAS)
+        return false;
+
+    while (cameras_.size() <= camId)
+    {
+        cameras_.append(CameraState());
+        mailboxes_.push_back(std::make_unique<DecodeMailbox>());
+    }
+    surface_->SetTileCount(cameras_.size());
+    return true;
 }
 
 void Receiver::ProcessPending()
@@ -35,51 +65,355 @@ void Receiver::ProcessPending()
 
     while (socket_.hasPendingDatagrams())
     {
-        QByteArray datagram;
-        datagram.resize(socket_.pendingDatagramSize());
-        qint64 bytesRead = socket_.readDatagram(datagram.data(), datagram.size());
+        qint64 pendingSize = socket_.pendingDatagramSize();
+        if (pendingSize > readBuffer_.size())
+            readBuffer_.resize(pendingSize);
+
+        QHostAddress sender;
+        qint64 bytesRead = socket_.readDatagram(readBuffer_.data(), readBuffer_.size(), &sender);
 
         // If read failed or mismatch in size
-        if (bytesRead <= 0 || datagram.size() < 5)
+        if (bytesRead < 5)
             continue;
 
-        QDataStream stream(datagram);
-        stream.setByteOrder(QDataStream::BigEndian);
+        edgeAddress_ = sender;
+        datagrams_++;
+        bytes_ += bytesRead;
 
-        quint8 camId = 0;
-        quint32 length = 0;
+        // Legacy senders start with the camera id, which is always below the magic
+        if (static_cast<quint8>(readBuffer_[0]) == PREVIEW_MAGIC)
+            HandleFragment(readBuffer_.constData(), static_cast<int>(bytesRead));
+        else
+            HandleLegacy(readBuffer_.constData(), static_cast<int>(bytesRead));
+    }
+}
 
-        stream >> camId >> length;
+// [camId:u8][length:u32][jpeg], one datagram per frame
+void Receiver::HandleLegacy(const char* data, int size)
+{
+    const uchar* header = reinterpret_cast<const uchar*>(data);
+    const quint8 camId = header[0];
+    const quint32 length = qFromBigEndian<quint32>(header + 1);
 
-        // Validate camId and data size
-        if (camId >= CAM_COUNT || static_cast<int>(length) != datagram.size() - 5)
-            continue;
+    // Validate camId and data size
+    if (static_cast<int>(length) != size - 5 || !EnsureCamera(camId))
+        return;
 
-        // Extract image data
-        QByteArray imageData = datagram.mid(5, length);
-        if (imageData.isEmpty())
-            continue;
+    cameras_[camId].stats.completed++;
+    ShowFrame(camId, QByteArray(data + 5, length));
+}
+
+// [magic:u8][version:u8][camId:u8][flags:u8][frameId:u32][fragIdx:u16][fragCount:u16]
+// [offset:u32][frameLength:u32][captureUs:u64][payload]
+void Receiver::HandleFragment(const char* data, int size)
+{
+    if (size <= PREVIEW_HEADER_SIZE)
+        return;
+
+    const uchar* header = reinterpret_cast<const uchar*>(data);
+    const quint8  version     = header[1];
+    const quint8  camId       = header[2];
+    const quint32 frameId     = qFromBigEndian<quint32>(header + 4);
+    const quint16 fragIdx     = qFromBigEndian<quint16>(header + 8);
+    const quint16 fragCount   = qFromBigEndian<quint16>(header + 10);
+    const quint32 offset      = qFromBigEndian<quint32>(header + 12);
+    const quint32 frameLength = qFromBigEndian<quint32>(header + 16);
+    const quint64 captureUs   = qFromBigEndian<quint64>(header + 20);
+    const quint32 payloadSize = size - PREVIEW_HEADER_SIZE;
+
+    if (version != PREVIEW_VERSION || !EnsureCamera(camId))
+        return;
+
+    CameraState& cam = cameras_[camId];
+
+    if (fragCount == 0 || fragIdx >= fragCount || frameLength == 0 ||
+        frameLength > PREVIEW_MAX_FRAME_BYTES || offset > frameLength ||
+        payloadSize > frameLength - offset)
+    {
+        cam.stats.malformed++;
+        return;
+    }
+
+    // Older than what is on screen: never worth reassembling
+    if (cam.hasShown && !IsNewer(frameId, cam.lastShown))
+    {
+        if (fragIdx == 0)
+            cam.stats.late++;
+        return;
+    }
+
+    if (!cam.hasSeen || IsNewer(frameId, cam.highestSeen))
+    {
+        quint32 gap = cam.hasSeen ? frameId - cam.highestSeen - 1 : 0;
+        if (gap < 1000)                // larger jumps mean the sender restarted
+            cam.stats.missing += gap;
+        cam.highestSeen = frameId;
+        cam.hasSeen = true;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < cam.pending.size(); ++i)
+    {
+        if (cam.pending[i].frameId == frameId)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot < 0)
+    {
+        if (cam.pending.size() >= PREVIEW_PENDING_FRAMES)
+        {
+            cam.pending.removeFirst();
+            cam.stats.incomplete++;
+        }
+
+        PartialFrame frame;
+        frame.frameId = frameId;
+        frame.fragCount = fragCount;
+        frame.captureUs = captureUs;
+        frame.firstArrivalMs = clock_.elapsed();
+        frame.data.resize(frameLength);
+        frame.got.resize(fragCount);
+
+        // keep pending ordered oldest first, fragments of two frames can interleave
+        int pos = cam.pending.size();
+        while (pos > 0 && IsNewer(cam.pending[pos - 1].frameId, frameId))
+            --pos;
+        cam.pending.insert(pos, frame);
+        slot = pos;
+    }
+
+    PartialFrame& frame = cam.pending[slot];
+    if (frame.fragCount != fragCount || frame.data.size() != static_cast<int>(frameLength))
+    {
+        cam.stats.malformed++;
+        return;
+    }
+
+    if (!frame.got.testBit(fragIdx))
+    {
+        memcpy(frame.data.data() + offset, data + PREVIEW_HEADER_SIZE, payloadSize);
+        frame.got.setBit(fragIdx);
+        frame.received++;
+    }
+
+    if (frame.received < frame.fragCount)
+        return;
 
-        QImage img = QImage::fromData(imageData, "JPG");
+    // Complete: everything older is now stale
+    PartialFrame done = frame;
+    cam.stats.incomplete += slot;
+    cam.pending.remove(0, slot + 1);
+
+    CompleteFrame(camId, done);
+}
+
+void Receiver::CompleteFrame(int camId, const PartialFrame& frame)
+{
+    CameraState& cam = cameras_[camId];
+    cam.lastShown = frame.frameId;
+    cam.hasShown = true;
+    cam.stats.completed++;
+
+    // Exponential moving averages, enough to spot a trend on screen
+    const double alpha = 0.1;
+    const qint64 nowUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+    if (frame.captureUs != 0 && nowUs >= static_cast<qint64>(frame.captureUs))
+    {
+        double latency = (nowUs - static_cast<qint64>(frame.captureUs)) / 1000.0;
+        cam.stats.latencyMs += alpha * (latency - cam.stats.latencyMs);
+    }
+    double reassembly = clock_.elapsed() - frame.firstArrivalMs;
+    cam.stats.reassemblyMs += alpha * (reassembly - cam.stats.reassemblyMs);
+
+    ShowFrame(camId, frame.data);
+}
+
+// Runs on the GUI thread: only hands the JPEG over, decoding happens in decodePool_
+void Receiver::ShowFrame(int camId, const QByteArray& jpeg)
+{
+    if (jpeg.isEmpty())
+        return;
+
+    DecodeMailbox* box = mailboxes_[camId].get();
+    QMutexLocker lock(&box->mutex);
+
+    if (box->hasFrame)
+        cameras_[camId].stats.superseded++;
+
+    box->jpeg = jpeg;
+    box->hasFrame = true;
+
+    if (!box->busy)
+    {
+        box->busy = true;
+        decodePool_.start([this, camId, box]() { DecodeLoop(camId, box); });
+    }
+}
+
+// Pool thread: decode whatever is newest until the mailbox is empty. Scaling is
+// left to the preview surface, which does it on the GPU.
+void Receiver::DecodeLoop(int camId, DecodeMailbox* box)
+{
+    while (true)
+    {
+        QByteArray jpeg;
+        {
+            QMutexLocker lock(&box->mutex);
+            if (!box->hasFrame)
+            {
+                box->busy = false;
+                return;
+            }
+            jpeg.swap(box->jpeg);
+            box->hasFrame = false;
+        }
+
+        QImage img = QImage::fromData(jpeg, "JPG");
         if (img.isNull())
             continue;
 
-        if (labels_[camId])
-        {
-            QPixmap pixmap = QPixmap::fromImage(img).scaled(
-                labels_[camId]->size(),
-                Qt::KeepAspectRatio,
-                Qt::SmoothTransformation
-                );
+        QImage frame = img.convertToFormat(decodeFormat_);
+
+        QMetaObject::invokeMethod(this, [this, camId, frame]() {
+            ApplyFrame(camId, frame);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void Receiver::ApplyFrame(int camId, const QImage& image)
+{
+    surface_->SetFrame(camId, image);
+    cameras_[camId].stats.decoded++;
+}
+
+// Drops frames that stopped receiving fragments, then refreshes the stats line
+void Receiver::ExpirePending()
+{
+    const qint64 now = clock_.elapsed();
 
-            labels_[camId]->setPixmap(pixmap);
+    for (CameraState& cam : cameras_)
+    {
+        while (!cam.pending.isEmpty() &&
+               now - cam.pending.first().firstArrivalMs > PREVIEW_REASSEMBLY_TIMEOUT_MS)
+        {
+            cam.pending.removeFirst();
+            cam.stats.incomplete++;
         }
     }
+
+    UpdateCaptions();
+}
+
+// [magic:u8][version:u8][subscribedMask:u8][cameraCount:u8]
+// cameraCount x [shownFps x10:u16][lossPermille:u16][latencyMs:u16]
+void Receiver::SendFeedback()
+{
+    const qint64 now = clock_.elapsed();
+    const double elapsedSec = (now - lastFeedbackMs_) / 1000.0;
+    lastFeedbackMs_ = now;
+
+    // A hidden viewer (other tab, minimized) unsubscribes so the edge stops encoding
+    quint8 subscribed = 0;
+    if (surface_->Widget()->isVisible())
+        subscribed = static_cast<quint8>((1u << cameras_.size()) - 1);
+
+    QByteArray feedback;
+    QDataStream stream(&feedback, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream << quint8(PREVIEW_FEEDBACK_MAGIC) << quint8(PREVIEW_VERSION)
+           << subscribed << quint8(cameras_.size());
+
+    for (CameraState& cam : cameras_)
+    {
+        quint64 lost = cam.stats.incomplete + cam.stats.missing;
+        quint64 shown = cam.stats.decoded - cam.feedbackShown;
+        quint64 newlyLost = lost - cam.feedbackLost;
+        cam.feedbackShown = cam.stats.decoded;
+        cam.feedbackLost = lost;
+
+        double fps = elapsedSec > 0 ? shown / elapsedSec : 0.0;
+        double loss = (shown + newlyLost) ? double(newlyLost) / (shown + newlyLost) : 0.0;
+
+        stream << quint16(qMin(fps * 10.0, 65535.0))
+               << quint16(loss * 1000.0)
+               << quint16(qMin(cam.stats.latencyMs, 65535.0));
+    }
+
+    socket_.writeDatagram(feedback, edgeAddress_, PREVIEW_FEEDBACK_PORT);
+}
+
+void Receiver::UpdateCaptions()
+{
+    GroupStats group = GetGroupStats();
+    QStringList details;
+    details << QString("%1: %2 datagrams, %3 frames, lost %4 (%5%)")
+                   .arg(group.group)
+                   .arg(group.datagrams)
+                   .arg(group.frames)
+                   .arg(group.lost)
+                   .arg(group.lossPercent, 0, 'f', 1);
+
+    for (int i = 0; i < cameras_.size(); ++i)
+    {
+        const CameraStats& s = cameras_[i].stats;
+        quint64 lost = s.incomplete + s.missing;
+        quint64 total = s.completed + lost;
+        double lossPercent = total ? 100.0 * lost / total : 0.0;
+
+        surface_->SetCaption(i, QString("frames %1  lost %2 (%3%)  late %4  latency %5 ms")
+                                    .arg(s.completed)
+                                    .arg(lost)
+                                    .arg(lossPercent, 0, 'f', 1)
+                                    .arg(s.late)
+                                    .arg(s.latencyMs, 0, 'f', 0));
+        details << QString("Cam%1: reassembly %2 ms, malformed %3, shown %4, superseded %5")
+                       .arg(i)
+                       .arg(s.reassemblyMs, 0, 'f', 1)
+                       .arg(s.malformed)
+                       .arg(s.decoded)
+                       .arg(s.superseded);
+    }
+
+    surface_->Widget()->setToolTip(details.join('\n'));
+}
+
+GroupStats Receiver::GetGroupStats() const
+{
+    GroupStats group;
+    group.group = group_.isNull() ? QString("unicast :%1").arg(CAMERA_UDP_PORT)
+                                  : QString("group %1:%2").arg(group_.toString()).arg(CAMERA_UDP_PORT);
+    group.datagrams = datagrams_;
+    group.bytes = bytes_;
+
+    for (const CameraState& cam : cameras_)
+    {
+        group.frames += cam.stats.completed;
+        group.lost += cam.stats.incomplete + cam.stats.missing;
+    }
+
+    quint64 total = group.frames + group.lost;
+    group.lossPercent = total ? 100.0 * group.lost / total : 0.0;
+    return group;
+}
+
+CameraStats Receiver::GetStats(int camId) const
+{
+    if (camId < 0 || camId >= cameras_.size())
+        return CameraStats();
+    return cameras_[camId].stats;
 }
 
 Receiver::~Receiver()
 {
-    // No need to delete labels_ manually; Qt does it because of QObject hierarchy
+    // No need to delete surface_ manually; Qt does it because of QObject hierarchy
+    maintenanceTimer_.stop();
+    feedbackTimer_.stop();
+    decodePool_.waitForDone();     // workers post back to this object
     disconnect(&socket_, nullptr, nullptr, nullptr);
+    if (!group_.isNull())
+        socket_.leaveMulticastGroup(group_);
     socket_.close();
 }
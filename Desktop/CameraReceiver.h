@@ -5,7 +5,34 @@
 #include <QtCore>
 #include <QtNetwork>
 #include <QtWidgets>
+#include <memory>
+#include <vector>
 #include "Globals.h"
+#include "PreviewSurface.h"
+
+struct CameraStats
+{
+    quint64 completed = 0;
+    quint64 incomplete = 0;    // timed out or superseded before every fragment arrived
+    quint64 late = 0;          // arrived after a newer frame was already shown
+    quint64 missing = 0;       // frame ids that never showed up at all
+    quint64 malformed = 0;
+    quint64 decoded = 0;       // frames that reached the screen
+    quint64 superseded = 0;    // replaced in the decode mailbox by a newer frame
+    double latencyMs = 0;      // capture -> shown, smoothed (needs NTP-synced clocks)
+    double reassemblyMs = 0;   // first -> last fragment, smoothed
+};
+
+// Everything received on one preview channel (a multicast group, or unicast)
+struct GroupStats
+{
+    QString group;
+    quint64 datagrams = 0;
+    quint64 bytes = 0;
+    quint64 frames = 0;
+    quint64 lost = 0;
+    double  lossPercent = 0;
+};
 
 class Receiver : public QWidget
 {
@@ -14,13 +41,75 @@ public:
     explicit Receiver(QWidget* parent = nullptr);
     ~Receiver();
 
+    CameraStats GetStats(int camId) const;
+    GroupStats GetGroupStats() const;
+
 private slots:
     void ProcessPending();
+    void ExpirePending();
+    void SendFeedback();
 
 private:
-    QUdpSocket   socket_;
-    QLabel*      labels_[3]{};
-    QGridLayout  layout_;
+    struct PartialFrame
+    {
+        quint32    frameId = 0;
+        quint16    fragCount = 0;
+        quint16    received = 0;
+        quint64    captureUs = 0;
+        qint64     firstArrivalMs = 0;
+        QByteArray data;
+        QBitArray  got;
+    };
+
+    struct CameraState
+    {
+        QVector<PartialFrame> pending;     // at most PREVIEW_PENDING_FRAMES, oldest first
+        bool        hasShown = false;
+        quint32     lastShown = 0;
+        bool        hasSeen = false;
+        quint32     highestSeen = 0;
+        CameraStats stats;
+        quint64     feedbackShown = 0;   // counters at the previous feedback
+        quint64     feedbackLost = 0;
+    };
+
+    // Latest-wins hand-off to the decode pool, one in-flight worker per camera
+    struct DecodeMailbox
+    {
+        QMutex     mutex;
+        QByteArray jpeg;
+        bool       hasFrame = false;
+        bool       busy = false;
+    };
+
+    bool EnsureCamera(int camId);
+    void HandleFragment(const char* data, int size);
+    void HandleLegacy(const char* data, int size);
+    void CompleteFrame(int camId, const PartialFrame& frame);
+    void ShowFrame(int camId, const QByteArray& jpeg);
+    void DecodeLoop(int camId, DecodeMailbox* box);
+    void ApplyFrame(int camId, const QImage& image);
+    void UpdateCaptions();
+
+    // Frame ids wrap around, compare them as serial numbers
+    static bool IsNewer(quint32 a, quint32 b) { return static_cast<qint32>(a - b) > 0; }
+
+    QUdpSocket    socket_;
+    QByteArray    readBuffer_;                 // reused for every datagram
+    QThreadPool   decodePool_;
+    std::vector<std::unique_ptr<DecodeMailbox>> mailboxes_;   // heap: workers keep a pointer while the vector grows
+    PreviewSurface* surface_ = nullptr;
+    QImage::Format  decodeFormat_ = QImage::Format_RGBA8888;
+    QGridLayout   layout_;
+    QTimer        maintenanceTimer_;
+    QTimer        feedbackTimer_;
+    QElapsedTimer clock_;
+    qint64        lastFeedbackMs_ = 0;
+    QHostAddress  edgeAddress_;
+    QHostAddress  group_;                      // null when receiving unicast
+    quint64       datagrams_ = 0;
+    quint64       bytes_ = 0;
+    QVector<CameraState> cameras_;             // grows when a new camera id shows up
 };
 
 
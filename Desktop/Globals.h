@@ -18,7 +18,25 @@
 // Camera Receiver
 #define WIDGET_H 240
 #define WIDGET_W 320
-#define CAM_COUNT 3
+#define CAM_COUNT 3                 // preview tiles shown before any camera reports
+#define PREVIEW_MAX_CAMERAS 8       // the feedback subscription mask is one byte
+#define CAMERA_UDP_PORT 5000
+#define PREVIEW_MULTICAST_GROUP ""           // e.g. "239.255.42.1"; empty = unicast. SDBELT_PREVIEW_GROUP overrides
+
+// Fragmented preview protocol (see PreviewSender on the edge device)
+#define PREVIEW_MAGIC 0xB5
+#define PREVIEW_VERSION 1
+#define PREVIEW_HEADER_SIZE 28
+#define PREVIEW_MAX_FRAME_BYTES (1 << 20)
+#define PREVIEW_PENDING_FRAMES 4            // partially received frames kept per camera
+#define PREVIEW_REASSEMBLY_TIMEOUT_MS 250   // incomplete frames older than this are dropped
+#define PREVIEW_MAINTENANCE_MS 100
+
+// Feedback to the edge sender: no feedback for a few seconds and it stops encoding
+#define EDGE_DEVICE_IP "192.168.91.204"     // used until the first preview datagram names the sender
+#define PREVIEW_FEEDBACK_PORT 5001
+#define PREVIEW_FEEDBACK_MAGIC 0xB6
+#define PREVIEW_FEEDBACK_MS 500
 
 
 // MainWindow
@@ -0,0 +1,237 @@
+#include "PreviewSurface.h"
+
+#include <QDebug>
+#include <QOpenGLContext>
+#include <QPainter>
+#include <QtMath>
+
+static const char* VertexShader =
+    "attribute highp vec2 position;\n"
+    "attribute highp vec2 texCoord;\n"
+    "varying highp vec2 uv;\n"
+    "void main() { uv = texCoord; gl_Position = vec4(position, 0.0, 1.0); }\n";
+
+static const char* FragmentShader =
+    "uniform sampler2D frame;\n"
+    "varying highp vec2 uv;\n"
+    "void main() { gl_FragColor = texture2D(frame, uv); }\n";
+
+PreviewSurface* PreviewSurface::Create(int tiles, QWidget* parent)
+{
+    QOpenGLContext probe;
+    if (!qEnvironmentVariableIsSet("SDBELT_RASTER_PREVIEW") && probe.create())
+        return new GlPreviewSurface(tiles, parent);
+
+    qWarning() << "No OpenGL context available, camera preview uses the raster fallback";
+    return new RasterPreviewSurface(tiles, parent);
+}
+
+QRect PreviewSurface::TileRect(int index, int count, const QSize& area)
+{
+    const int cols = qMax(1, qCeil(qSqrt(count)));
+    const int rows = qMax(1, (count + cols - 1) / cols);
+    const int w = area.width() / cols;
+    const int h = area.height() / rows;
+    return QRect((index % cols) * w, (index / cols) * h, w, h);
+}
+
+QRect PreviewSurface::FitRect(const QSize& image, const QRect& tile)
+{
+    QSize fitted = image.scaled(tile.size(), Qt::KeepAspectRatio);
+    return QRect(tile.x() + (tile.width() - fitted.width()) / 2,
+                 tile.y() + (tile.height() - fitted.height()) / 2,
+                 fitted.width(), fitted.height());
+}
+
+void PreviewSurface::DrawCaptions(QPainter& painter, const QVector<Tile>& tiles, const QSize& area)
+{
+    painter.setPen(Qt::white);
+    for (int i = 0; i < tiles.size(); ++i)
+    {
+        QRect tile = TileRect(i, tiles.size(), area);
+        if (tiles[i].image.isNull())
+            painter.drawText(tile, Qt::AlignCenter, "No Frame");
+
+        painter.setPen(Qt::gray);
+        painter.drawText(tile.adjusted(4, 0, -4, -4), Qt::AlignBottom | Qt::AlignHCenter, tiles[i].caption);
+        painter.setPen(Qt::white);
+    }
+}
+
+/* --- OpenGL ------------------------------------------------------------------ */
+
+GlPreviewSurface::GlPreviewSurface(int tiles, QWidget* parent)
+    : QOpenGLWidget(parent)
+{
+    setMinimumSize(WIDGET_W, WIDGET_H);
+    SetTileCount(tiles);
+}
+
+GlPreviewSurface::~GlPreviewSurface()
+{
+    // Textures belong to our context, release them while it is current
+    makeCurrent();
+    textures_.clear();
+    program_.removeAllShaders();
+    doneCurrent();
+}
+
+void GlPreviewSurface::SetTileCount(int count)
+{
+    if (count <= tiles_.size())
+        return;
+    tiles_.resize(count);
+    textures_.resize(count);
+    update();
+}
+
+void GlPreviewSurface::SetFrame(int camId, const QImage& image)
+{
+    if (camId < 0 || camId >= tiles_.size())
+        return;
+    tiles_[camId].image = image;
+    tiles_[camId].dirty = true;
+    update();
+}
+
+void GlPreviewSurface::SetCaption(int camId, const QString& caption)
+{
+    if (camId < 0 || camId >= tiles_.size() || tiles_[camId].caption == caption)
+        return;
+    tiles_[camId].caption = caption;
+    update();
+}
+
+void GlPreviewSurface::initializeGL()
+{
+    initializeOpenGLFunctions();
+    program_.addShaderFromSourceCode(QOpenGLShader::Vertex, VertexShader);
+    program_.addShaderFromSourceCode(QOpenGLShader::Fragment, FragmentShader);
+    program_.bindAttributeLocation("position", 0);
+    program_.bindAttributeLocation("texCoord", 1);
+    if (!program_.link())
+        qWarning() << "Preview shader failed to link:" << program_.log();
+
+    // Re-upload everything if the context was recreated (widget reparented)
+    textures_.clear();
+    textures_.resize(tiles_.size());
+    for (Tile& tile : tiles_)
+        tile.dirty = !tile.image.isNull();
+}
+
+// One texture per camera, reallocated only when the frame size changes
+void GlPreviewSurface::Upload(int index)
+{
+    Tile& tile = tiles_[index];
+    std::unique_ptr<QOpenGLTexture>& texture = textures_[index];
+
+    if (!texture || texture->width() != tile.image.width() || texture->height() != tile.image.height())
+    {
+        texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+        texture->setSize(tile.image.width(), tile.image.height());
+        texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        texture->setMipLevels(1);
+        texture->allocateStorage();
+        texture->setMinificationFilter(QOpenGLTexture::Linear);
+        texture->setMagnificationFilter(QOpenGLTexture::Linear);
+        texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    }
+
+    texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, tile.image.constBits());
+    tile.dirty = false;
+}
+
+void GlPreviewSurface::paintGL()
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Full-viewport quad, image row 0 at the top
+    static const GLfloat positions[] = { -1, -1,  1, -1,  -1, 1,  1, 1 };
+    static const GLfloat texCoords[] = {  0,  1,  1,  1,   0, 0,  1, 0 };
+
+    const qreal dpr = devicePixelRatioF();
+    const int fbHeight = qRound(height() * dpr);
+
+    program_.bind();
+    program_.setUniformValue("frame", 0);
+    program_.enableAttributeArray(0);
+    program_.enableAttributeArray(1);
+    program_.setAttributeArray(0, GL_FLOAT, positions, 2);
+    program_.setAttributeArray(1, GL_FLOAT, texCoords, 2);
+
+    for (int i = 0; i < tiles_.size(); ++i)
+    {
+        Tile& tile = tiles_[i];
+        if (tile.image.isNull())
+            continue;
+        if (tile.dirty)
+            Upload(i);
+
+        QRect target = FitRect(tile.image.size(), TileRect(i, tiles_.size(), size()));
+        glViewport(qRound(target.x() * dpr),
+                   fbHeight - qRound((target.y() + target.height()) * dpr),
+                   qRound(target.width() * dpr),
+                   qRound(target.height() * dpr));
+
+        textures_[i]->bind(0);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        textures_[i]->release(0);
+    }
+
+    program_.disableAttributeArray(0);
+    program_.disableAttributeArray(1);
+    program_.release();
+
+    QPainter painter(this);
+    DrawCaptions(painter, tiles_, size());
+}
+
+/* --- Raster fallback --------------------------------------------------------- */
+
+RasterPreviewSurface::RasterPreviewSurface(int tiles, QWidget* parent)
+    : QWidget(parent)
+{
+    setMinimumSize(WIDGET_W, WIDGET_H);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    SetTileCount(tiles);
+}
+
+void RasterPreviewSurface::SetTileCount(int count)
+{
+    if (count <= tiles_.size())
+        return;
+    tiles_.resize(count);
+    update();
+}
+
+void RasterPreviewSurface::SetFrame(int camId, const QImage& image)
+{
+    if (camId < 0 || camId >= tiles_.size())
+        return;
+    tiles_[camId].image = image;
+    update(TileRect(camId, tiles_.size(), size()));
+}
+
+void RasterPreviewSurface::SetCaption(int camId, const QString& caption)
+{
+    if (camId < 0 || camId >= tiles_.size() || tiles_[camId].caption == caption)
+        return;
+    tiles_[camId].caption = caption;
+    update(TileRect(camId, tiles_.size(), size()));
+}
+
+void RasterPreviewSurface::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    for (int i = 0; i < tiles_.size(); ++i)
+    {
+        const Tile& tile = tiles_[i];
+        if (!tile.image.isNull())
+            painter.drawImage(FitRect(tile.image.size(), TileRect(i, tiles_.size(), size())), tile.image);
+    }
+
+    DrawCaptions(painter, tiles_, size());
+}
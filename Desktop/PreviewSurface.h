@@ -0,0 +1,90 @@
+#ifndef PREVIEWSURFACE_H
+#define PREVIEWSURFACE_H
+
+#include <QImage>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLWidget>
+#include <QVector>
+#include <QWidget>
+#include <memory>
+#include "Globals.h"
+
+// Tiled N-camera preview. Frames arrive decoded; scaling to the tile is left
+// to the GPU (or to QPainter when no OpenGL context can be created).
+class PreviewSurface
+{
+public:
+    virtual ~PreviewSurface() = default;
+
+    virtual QWidget* Widget() = 0;
+    virtual void SetTileCount(int count) = 0;
+    virtual void SetFrame(int camId, const QImage& image) = 0;
+    virtual void SetCaption(int camId, const QString& caption) = 0;
+
+    // Format decode workers should convert to, so the GUI thread never does
+    virtual QImage::Format PreferredFormat() const = 0;
+
+    // OpenGL (Mesa llvmpipe works without a GPU), raster QPainter otherwise
+    static PreviewSurface* Create(int tiles, QWidget* parent);
+
+protected:
+    struct Tile
+    {
+        QImage  image;
+        QString caption;
+        bool    dirty = false;
+    };
+
+    // Grid close to square: 3 -> 2x2, 4 -> 2x2, 6 -> 3x2
+    static QRect TileRect(int index, int count, const QSize& area);
+    static QRect FitRect(const QSize& image, const QRect& tile);
+    static void DrawCaptions(QPainter& painter, const QVector<Tile>& tiles, const QSize& area);
+};
+
+class GlPreviewSurface : public QOpenGLWidget, protected QOpenGLFunctions, public PreviewSurface
+{
+    Q_OBJECT
+public:
+    explicit GlPreviewSurface(int tiles, QWidget* parent = nullptr);
+    ~GlPreviewSurface();
+
+    QWidget* Widget() override { return this; }
+    void SetTileCount(int count) override;
+    void SetFrame(int camId, const QImage& image) override;
+    void SetCaption(int camId, const QString& caption) override;
+    QImage::Format PreferredFormat() const override { return QImage::Format_RGBA8888; }
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+
+private:
+    void Upload(int index);
+
+    QVector<Tile> tiles_;
+    std::vector<std::unique_ptr<QOpenGLTexture>> textures_;
+    QOpenGLShaderProgram program_;
+};
+
+class RasterPreviewSurface : public QWidget, public PreviewSurface
+{
+    Q_OBJECT
+public:
+    explicit RasterPreviewSurface(int tiles, QWidget* parent = nullptr);
+
+    QWidget* Widget() override { return this; }
+    void SetTileCount(int count) override;
+    void SetFrame(int camId, const QImage& image) override;
+    void SetCaption(int camId, const QString& caption) override;
+    QImage::Format PreferredFormat() const override { return QImage::Format_ARGB32_Premultiplied; }
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    QVector<Tile> tiles_;
+};
+
+#endif // PREVIEWSURFACE_H
@@ -2,6 +2,7 @@ QT       += core gui websockets
 QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 5): QT += opengl openglwidgets
 
 CONFIG += c++17
 
@@ -12,6 +13,7 @@ CONFIG += c++17
 SOURCES += \
     CameraReceiver.cpp \
     Logs.cpp \
+    PreviewSurface.cpp \
     SystemInfoRetriever.cpp \
     SystemLogRetriever.cpp \
     main.cpp \
@@ -21,6 +23,7 @@ HEADERS += \
     CameraReceiver.h \
     Globals.h \
     Logs.h \
+    PreviewSurface.h \
     SystemInfoRetriever.h \
     SystemLogRetriever.h \
     mainwindow.h
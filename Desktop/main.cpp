@@ -3,6 +3,13 @@
 
 int main(int argc, char *argv[])
 {
+    // Workstations without a GPU driver: render the camera preview with the software rasterizer
+    if (qEnvironmentVariableIsSet("SDBELT_SOFTWARE_GL"))
+    {
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");                       // Mesa llvmpipe
+        QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);    // opengl32sw on Windows
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -0,0 +1,28 @@
+package gtu.cse.cse396.sdbelt.scan.domain.model;
+
+import java.util.List;
+
+import com.fasterxml.jackson.databind.JsonNode;
+
+import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
+import gtu.cse.cse396.sdbelt.ws.domain.model.EventType;
+import io.swagger.v3.core.util.Json;
+
+/**
+ * The scans of one product, one per camera, as the edge posts them to
+ * {@code /scans}; streamed over the WebSocket instead.
+ */
+public record ProductScansEvent(
+                List<ScanRequestDTO> data,
+                long timestamp) implements Event<List<ScanRequestDTO>> {
+
+        @Override
+        public EventType type() {
+                return EventType.NEW_PRODUCT_SCANS_EVENT;
+        }
+
+        @Override
+        public JsonNode getContent() {
+                return Json.mapper().convertValue(data, JsonNode.class);
+        }
+}
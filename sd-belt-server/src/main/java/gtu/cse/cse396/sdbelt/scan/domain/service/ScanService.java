@@ -6,6 +6,7 @@ import java.util.List;
 import gtu.cse.cse396.sdbelt.scan.domain.model.GeneralStatistics;
 import gtu.cse.cse396.sdbelt.scan.domain.model.ProductStatistics;
 import gtu.cse.cse396.sdbelt.scan.domain.model.Scan;
+import gtu.cse.cse396.sdbelt.scan.domain.model.ScanRequestDTO;
 import gtu.cse.cse396.sdbelt.scan.infra.model.ScanFilter;
 
 /**
@@ -33,6 +34,19 @@ public interface ScanService {
 
     void create(String productId, Double healthRatio, Boolean isHealthy, String errorMessage, LocalDateTime scanTime);
 
+    /**
+     * Creates one scan record for a product from the scans of all its cameras.
+     * The health of the scans is averaged and compared with the threshold; the
+     * product is the one the scans agree on most.
+     *
+     * @param scans     the scans of one product, one per camera; must not be
+     *                  empty
+     * @param threshold the minimum average health for the product to pass
+     * @throws IllegalArgumentException if there are no scans or a scan is
+     *                                  malformed
+     */
+    void createFromScans(List<ScanRequestDTO> scans, double threshold);
+
     /**
      * Retrieves a list of all scan records in the system.
      *
@@ -3,6 +3,7 @@ package gtu.cse.cse396.sdbelt.scan.infra.adapter;
 import java.time.LocalDateTime;
 import java.time.ZoneOffset;
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
 import java.util.stream.Collectors;
@@ -18,6 +19,7 @@ import org.springframework.transaction.annotation.Transactional;
 import gtu.cse.cse396.sdbelt.scan.domain.model.GeneralStatistics;
 import gtu.cse.cse396.sdbelt.scan.domain.model.ProductStatistics;
 import gtu.cse.cse396.sdbelt.scan.domain.model.Scan;
+import gtu.cse.cse396.sdbelt.scan.domain.model.ScanRequestDTO;
 import gtu.cse.cse396.sdbelt.scan.domain.service.ScanService;
 import gtu.cse.cse396.sdbelt.scan.infra.mapper.ScanMapper;
 import gtu.cse.cse396.sdbelt.shared.model.FilterTime;
@@ -74,6 +76,45 @@ public class ScanAdapter implements ScanService {
         scanRepository.save(ScanMapper.toEntity(scan));
     }
 
+    @Override
+    @Transactional
+    public void createFromScans(List<ScanRequestDTO> scans, double threshold) {
+        if (scans == null || scans.isEmpty()) {
+            throw new IllegalArgumentException("A product needs at least one scan");
+        }
+        int numberOfScans = scans.size();
+        double score = 0.0;
+        Map<String, Double> productConfidenceMap = new HashMap<>();
+        for (ScanRequestDTO scan : scans) {
+            Double confidence = Double.parseDouble(scan.confidence());
+            String productId = scan.productResult().split("_")[0];
+            boolean isSuccess = scan.productResult().split("_")[1].equals("Healthy");
+            double health = isSuccess ? confidence : 100.0 - confidence;
+            score += health / numberOfScans;
+            if (productConfidenceMap.containsKey(productId)) {
+                productConfidenceMap.put(productId, productConfidenceMap.get(productId) + confidence);
+            } else {
+                productConfidenceMap.put(productId, health);
+            }
+        }
+        boolean isSuccess = score >= threshold;
+        String productId = "";
+        Double productIdScore = 0.0;
+        for (Map.Entry<String, Double> entry : productConfidenceMap.entrySet()) {
+            if (entry.getValue() > productIdScore) {
+                productIdScore = entry.getValue();
+                productId = entry.getKey();
+            }
+
+        }
+        if (isSuccess) {
+            create(productId, score, isSuccess, null);
+        } else {
+            create(productId, score, isSuccess,
+                    "Scan of product" + productId + " with score" + score + "failed");
+        }
+    }
+
     /**
      * Retrieves all scan records.
      *
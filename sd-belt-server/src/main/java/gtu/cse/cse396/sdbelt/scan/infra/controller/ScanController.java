@@ -2,9 +2,7 @@ package gtu.cse.cse396.sdbelt.scan.infra.controller;
 
 import java.time.LocalDateTime;
 import java.time.ZoneOffset;
-import java.util.HashMap;
 import java.util.List;
-import java.util.Map;
 
 import org.springdoc.core.annotations.ParameterObject;
 import org.springframework.web.bind.annotation.GetMapping;
@@ -69,39 +67,7 @@ public class ScanController {
         if (systemService.get().threshold() != null) {
             threshold = systemService.get().threshold();
         }
-        int numberOfScans = scans.size();
-        double score = 0.0;
-        Map<String, Double> productConfidenceMap = new HashMap<>();
-        for (ScanRequestDTO scan : scans) {
-            Double confidence = Double.parseDouble(scan.confidence());
-            Double x = Double.parseDouble(scan.x());
-            Double y = Double.parseDouble(scan.y());
-            String productId = scan.productResult().split("_")[0];
-            boolean isSuccess = scan.productResult().split("_")[1].equals("Healthy");
-            double health = isSuccess ? confidence : 100.0 - confidence;
-            score += health / numberOfScans;
-            if (productConfidenceMap.containsKey(productId)) {
-                productConfidenceMap.put(productId, productConfidenceMap.get(productId) + confidence);
-            } else {
-                productConfidenceMap.put(productId, health);
-            }
-        }
-        boolean isSuccess = score >= threshold;
-        String productId = "";
-        Double productIdScore = 0.0;
-        for (Map.Entry<String, Double> entry : productConfidenceMap.entrySet()) {
-            if (entry.getValue() > productIdScore) {
-                productIdScore = entry.getValue();
-                productId = entry.getKey();
-            }
-
-        }
-        if (isSuccess) {
-            service.create(productId, score, isSuccess, null);
-        } else {
-            service.create(productId, score, isSuccess,
-                    "Scan of product" + productId + " with score" + score + "failed");
-        }
+        service.createFromScans(scans, threshold);
         return ResponseBuilder.build(200, null);
     }
 
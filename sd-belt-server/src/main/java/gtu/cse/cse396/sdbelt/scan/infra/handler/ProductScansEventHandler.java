@@ -0,0 +1,33 @@
+package gtu.cse.cse396.sdbelt.scan.infra.handler;
+
+import java.util.List;
+
+import gtu.cse.cse396.sdbelt.scan.domain.model.ScanRequestDTO;
+import gtu.cse.cse396.sdbelt.scan.domain.service.ScanService;
+import gtu.cse.cse396.sdbelt.system.domain.service.SystemService;
+import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
+import gtu.cse.cse396.sdbelt.ws.domain.model.EventHandler;
+import lombok.RequiredArgsConstructor;
+import lombok.extern.slf4j.Slf4j;
+
+/**
+ * Stores a product streamed by the edge exactly like {@code POST /scans}.
+ * An exception fails the event, and the edge then falls back to the POST.
+ */
+@RequiredArgsConstructor
+@Slf4j
+public class ProductScansEventHandler implements EventHandler<List<ScanRequestDTO>> {
+
+    private final ScanService scanService;
+    private final SystemService systemService;
+
+    @Override
+    public void handle(Event<List<ScanRequestDTO>> event) {
+        double threshold = 70.0;
+        if (systemService.get().threshold() != null) {
+            threshold = systemService.get().threshold();
+        }
+        log.info("Saving product from {} scans", event.data() == null ? 0 : event.data().size());
+        scanService.createFromScans(event.data(), threshold);
+    }
+}
@@ -0,0 +1,26 @@
+package gtu.cse.cse396.sdbelt.system.domain.model;
+
+import com.fasterxml.jackson.databind.JsonNode;
+
+import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
+import gtu.cse.cse396.sdbelt.ws.domain.model.EventType;
+import io.swagger.v3.core.util.Json;
+
+/**
+ * A log message, as the edge posts it to {@code /system/logs}; streamed
+ * over the WebSocket instead.
+ */
+public record SystemLogEvent(
+                SystemLatestInfo data,
+                long timestamp) implements Event<SystemLatestInfo> {
+
+        @Override
+        public EventType type() {
+                return EventType.LOG_EVENT;
+        }
+
+        @Override
+        public JsonNode getContent() {
+                return Json.mapper().convertValue(data, JsonNode.class);
+        }
+}
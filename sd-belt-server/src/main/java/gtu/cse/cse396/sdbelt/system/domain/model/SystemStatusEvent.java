@@ -0,0 +1,27 @@
+package gtu.cse.cse396.sdbelt.system.domain.model;
+
+import com.fasterxml.jackson.databind.JsonNode;
+
+import gtu.cse.cse396.sdbelt.system.infra.adapter.SystemStatusInfo;
+import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
+import gtu.cse.cse396.sdbelt.ws.domain.model.EventType;
+import io.swagger.v3.core.util.Json;
+
+/**
+ * A status sample, as the edge posts it to {@code /system/info}; streamed
+ * over the WebSocket instead.
+ */
+public record SystemStatusEvent(
+                SystemStatusInfo data,
+                long timestamp) implements Event<SystemStatusInfo> {
+
+        @Override
+        public EventType type() {
+                return EventType.STATUS_EVENT;
+        }
+
+        @Override
+        public JsonNode getContent() {
+                return Json.mapper().convertValue(data, JsonNode.class);
+        }
+}
@@ -15,7 +15,6 @@ import gtu.cse.cse396.sdbelt.system.infra.mapper.SystemMapper;
 import gtu.cse.cse396.sdbelt.system.infra.model.SystemStatusEntity;
 import gtu.cse.cse396.sdbelt.system.infra.repository.JpaSystemLogRepository;
 import gtu.cse.cse396.sdbelt.system.infra.repository.JpaSystemRepository;
-import gtu.cse.cse396.sdbelt.ws.domain.service.WebSocketService;
 import jakarta.annotation.PostConstruct;
 import jakarta.transaction.Transactional;
 import lombok.RequiredArgsConstructor;
@@ -28,7 +27,6 @@ import lombok.extern.slf4j.Slf4j;
 public class SystemAdapter implements SystemService {
 
     private final DefaultSystemConfig config;
-    private final WebSocketService webSocketService;
     private final JpaSystemRepository jpaSystemRepository;
     private final JpaSystemLogRepository jpaSystemLogRepository;
     private final SystemCommandSender systemCommandSender;
@@ -80,11 +78,6 @@ public class SystemAdapter implements SystemService {
 
     @Override
     public void shutdown() {
-        /*
-         * StartSystemCommand command = new StartSystemCommand();
-         * RawMessage message = RawMessage.ofCommand(command);
-         * webSocketService.send(message);
-         */
         systemCommandSender.sendShutdownCommand();
         System system = get();
         System updatedSystem = system.copyWith(SystemStatus.INACTIVE);
@@ -93,11 +86,6 @@ public class SystemAdapter implements SystemService {
 
     @Override
     public void stop() {
-        /*
-         * StopSystemCommand command = new StopSystemCommand();
-         * RawMessage message = RawMessage.ofCommand(command);
-         * webSocketService.send(message);
-         */
         systemCommandSender.sendStopCommand();
         System system = get();
         System updatedSystem = system.copyWith(SystemStatus.STOPPED);
@@ -106,11 +94,6 @@ public class SystemAdapter implements SystemService {
 
     @Override
     public void restart() {
-        /*
-         * RestartSystemCommand command = new RestartSystemCommand();
-         * RawMessage message = RawMessage.ofCommand(command);
-         * webSocketService.send(message);
-         */
         systemCommandSender.sendRestartCommand();
     }
 
@@ -7,12 +7,22 @@ import org.springframework.http.ResponseEntity;
 import org.springframework.stereotype.Component;
 import org.springframework.web.client.RestTemplate;
 
+import gtu.cse.cse396.sdbelt.ws.domain.model.Command;
+import gtu.cse.cse396.sdbelt.ws.domain.model.RawCommand;
+import gtu.cse.cse396.sdbelt.ws.domain.model.ReverseBeltCommand;
+import gtu.cse.cse396.sdbelt.ws.domain.model.ShutdownSystemCommand;
+import gtu.cse.cse396.sdbelt.ws.domain.model.SpeedCommand;
+import gtu.cse.cse396.sdbelt.ws.domain.model.StopSystemCommand;
+import gtu.cse.cse396.sdbelt.ws.domain.service.WebSocketService;
 import lombok.RequiredArgsConstructor;
 import lombok.extern.slf4j.Slf4j;
 
 /**
- * Abstracted command sender to handle HTTP REST communication
- * Mirrors the Qt NetworkManager POST requests functionality
+ * Abstracted command sender for the edge device.
+ * Commands the edge understands on its WebSocket (speed, reverse, stop,
+ * shutdown) are pushed over the session it keeps open; the HTTP POSTs,
+ * which mirror the Qt NetworkManager requests, are the fallback while no
+ * session is open. Threshold and restart only exist as HTTP endpoints.
  */
 @Component
 @RequiredArgsConstructor
@@ -20,14 +30,18 @@ import lombok.extern.slf4j.Slf4j;
 class SystemCommandSender {
 
     private final RestTemplate restTemplate;
+    private final WebSocketService webSocketService;
 
     @Value("${system.server.url}")
     private String serverUrl;
 
     /**
-     * Send start command via HTTP POST
+     * Send speed command
      */
     public void sendSpeedCommand(int speedPercent) {
+        if (push(new SpeedCommand(speedPercent))) {
+            return;
+        }
         try {
             String url = serverUrl + "/speed";
             HttpEntity<String> request = createTextPlainRequest(String.valueOf(speedPercent));
@@ -54,6 +68,9 @@ class SystemCommandSender {
     }
 
     public void sendReverseCommand() {
+        if (push(new ReverseBeltCommand())) {
+            return;
+        }
         try {
             String url = serverUrl + "/rev";
             HttpEntity<String> request = createTextPlainRequest("REV");
@@ -67,9 +84,12 @@ class SystemCommandSender {
     }
 
     /**
-     * Send shutdown command via HTTP POST
+     * Send shutdown command
      */
     public void sendShutdownCommand() {
+        if (push(new ShutdownSystemCommand())) {
+            return;
+        }
         try {
             String url = serverUrl + "/shutdown";
             HttpEntity<String> request = createTextPlainRequest("SHUTDOWN");
@@ -83,9 +103,12 @@ class SystemCommandSender {
     }
 
     /**
-     * Send stop command via HTTP POST
+     * Send stop command
      */
     public void sendStopCommand() {
+        if (push(new StopSystemCommand())) {
+            return;
+        }
         try {
             String url = serverUrl + "/stop";
             HttpEntity<String> request = createTextPlainRequest("STOP");
@@ -115,10 +138,13 @@ class SystemCommandSender {
     }
 
     /**
-     * Send emergency stop command via HTTP POST
+     * Send emergency stop command
      * Equivalent to Qt OnEmergencyStopClicked() POST request
      */
     public void sendEmergencyStopCommand() {
+        if (push(new StopSystemCommand())) {
+            return;
+        }
         try {
             String url = serverUrl + "/stop";
             HttpEntity<String> request = createTextPlainRequest("STOP\n");
@@ -132,10 +158,13 @@ class SystemCommandSender {
     }
 
     /**
-     * Send speed adjustment command via HTTP POST
+     * Send speed adjustment command
      * Equivalent to Qt OnSpeedAdjusted() POST request
      */
     public void sendSpeedAdjustCommand(int speed) {
+        if (push(new SpeedCommand(speed))) {
+            return;
+        }
         try {
             String url = serverUrl + "/speed";
             HttpEntity<String> request = createTextPlainRequest(String.valueOf(speed));
@@ -148,6 +177,19 @@ class SystemCommandSender {
         }
     }
 
+    /**
+     * Push a command over the edge's WebSocket
+     *
+     * @return false if no edge session is open, then the HTTP POST is used
+     */
+    private boolean push(Command<?> command) {
+        if (!webSocketService.send(RawCommand.of(command))) {
+            return false;
+        }
+        log.debug("[ws] Sent: {}", command.type());
+        return true;
+    }
+
     /**
      * Create HTTP request with text/plain content type
      * Mirrors the Qt QNetworkRequest setup
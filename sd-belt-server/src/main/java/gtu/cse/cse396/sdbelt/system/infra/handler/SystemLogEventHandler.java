@@ -0,0 +1,21 @@
+package gtu.cse.cse396.sdbelt.system.infra.handler;
+
+import gtu.cse.cse396.sdbelt.system.domain.model.SystemLatestInfo;
+import gtu.cse.cse396.sdbelt.system.domain.service.SystemService;
+import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
+import gtu.cse.cse396.sdbelt.ws.domain.model.EventHandler;
+import lombok.RequiredArgsConstructor;
+
+/**
+ * Stores a log message streamed by the edge exactly like {@code POST /system/logs}.
+ */
+@RequiredArgsConstructor
+public class SystemLogEventHandler implements EventHandler<SystemLatestInfo> {
+
+    private final SystemService systemService;
+
+    @Override
+    public void handle(Event<SystemLatestInfo> event) {
+        systemService.saveStatus(event.data());
+    }
+}
@@ -0,0 +1,21 @@
+package gtu.cse.cse396.sdbelt.system.infra.handler;
+
+import gtu.cse.cse396.sdbelt.system.domain.service.SystemService;
+import gtu.cse.cse396.sdbelt.system.infra.adapter.SystemStatusInfo;
+import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
+import gtu.cse.cse396.sdbelt.ws.domain.model.EventHandler;
+import lombok.RequiredArgsConstructor;
+
+/**
+ * Applies a status sample streamed by the edge exactly like {@code POST /system/info}.
+ */
+@RequiredArgsConstructor
+public class SystemStatusEventHandler implements EventHandler<SystemStatusInfo> {
+
+    private final SystemService systemService;
+
+    @Override
+    public void handle(Event<SystemStatusInfo> event) {
+        systemService.updateInfo(event.data());
+    }
+}
@@ -6,6 +6,7 @@ public enum CommandType {
     RESTART_SYSTEM_COMMAND("RESTART_SYSTEM_COMMAND"),
     SHUTDOWN_SYSTEM_COMMAND("SHUTDOWN_SYSTEM_COMMAND"),
     REVERSE_BELT_COMMAND("REVERSE_BELT_COMMAND"),
+    SPEED_COMMAND("SPEED_COMMAND"),
     ;
 
     private final String name;
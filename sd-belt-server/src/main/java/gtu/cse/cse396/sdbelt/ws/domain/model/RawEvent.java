@@ -4,5 +4,7 @@ import com.fasterxml.jackson.databind.JsonNode;
 
 public record RawEvent(
                 EventType type,
-                JsonNode event) {
+                JsonNode event,
+                // set by clients that want a handler-confirmed {"ack":seq} or {"nack":seq}
+                Long seq) {
 }
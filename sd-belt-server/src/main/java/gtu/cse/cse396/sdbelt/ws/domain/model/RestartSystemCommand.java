@@ -14,7 +14,7 @@ public record RestartSystemCommand(
 
     @Override
     public CommandType type() {
-        return CommandType.START_SYSTEM_COMMAND;
+        return CommandType.RESTART_SYSTEM_COMMAND;
     }
 
     @Override
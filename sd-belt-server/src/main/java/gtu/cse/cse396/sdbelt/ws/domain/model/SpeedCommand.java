@@ -0,0 +1,27 @@
+package gtu.cse.cse396.sdbelt.ws.domain.model;
+
+import com.fasterxml.jackson.databind.JsonNode;
+
+import io.swagger.v3.core.util.Json;
+
+/**
+ * Belt speed in percent; the edge reads it from {@code data}.
+ */
+public record SpeedCommand(
+        Integer data,
+        long timestamp) implements Command<Integer> {
+
+    public SpeedCommand(int speedPercent) {
+        this(speedPercent, System.currentTimeMillis());
+    }
+
+    @Override
+    public CommandType type() {
+        return CommandType.SPEED_COMMAND;
+    }
+
+    @Override
+    public JsonNode getContent() {
+        return Json.mapper().convertValue(data, JsonNode.class);
+    }
+}
@@ -14,7 +14,7 @@ public record StopSystemCommand(
 
     @Override
     public CommandType type() {
-        return CommandType.START_SYSTEM_COMMAND;
+        return CommandType.STOP_SYSTEM_COMMAND;
     }
 
     @Override
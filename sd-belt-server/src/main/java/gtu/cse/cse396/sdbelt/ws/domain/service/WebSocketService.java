@@ -2,6 +2,7 @@ package gtu.cse.cse396.sdbelt.ws.domain.service;
 
 import org.springframework.web.socket.WebSocketSession;
 
+import gtu.cse.cse396.sdbelt.ws.domain.model.RawCommand;
 import gtu.cse.cse396.sdbelt.ws.domain.model.RawMessage;
 
 import java.util.Map;
@@ -23,6 +24,13 @@ public interface WebSocketService {
      */
     public boolean send(RawMessage message);
 
+    /**
+     * Push a command to the first open session, as {"type":..., "data":...}
+     *
+     * @return false if no session took it
+     */
+    boolean send(RawCommand command);
+
     /**
      * Get all active session IDs
      */
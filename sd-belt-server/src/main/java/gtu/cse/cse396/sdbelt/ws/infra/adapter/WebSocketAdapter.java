@@ -4,8 +4,10 @@ import org.springframework.stereotype.Service;
 import org.springframework.web.socket.TextMessage;
 import org.springframework.web.socket.WebSocketSession;
 
+import com.fasterxml.jackson.core.JsonProcessingException;
 import com.fasterxml.jackson.databind.ObjectMapper;
 
+import gtu.cse.cse396.sdbelt.ws.domain.model.RawCommand;
 import gtu.cse.cse396.sdbelt.ws.domain.model.RawMessage;
 import gtu.cse.cse396.sdbelt.ws.domain.service.WebSocketService;
 import lombok.RequiredArgsConstructor;
@@ -46,20 +48,37 @@ public class WebSocketAdapter implements WebSocketService {
      */
     @Override
     public boolean send(RawMessage message) {
+        // serialize() already is the JSON text; encoding it again would send a quoted string
+        return sendToFirst(message.serialize());
+    }
+
+    @Override
+    public boolean send(RawCommand command) {
+        try {
+            return sendToFirst(objectMapper.writeValueAsString(command));
+        } catch (JsonProcessingException e) {
+            log.error("Could not serialize command {}: {}", command.type(), e.getMessage(), e);
+            return false;
+        }
+    }
+
+    private boolean sendToFirst(String jsonMessage) {
         for (Map.Entry<String, WebSocketSession> entry : sessions.entrySet()) {
             WebSocketSession session = entry.getValue();
-            if (trySend(session, message.serialize())) {
+            if (trySend(session, jsonMessage)) {
                 return true;
             }
         }
         return false;
     }
 
-    private boolean trySend(WebSocketSession session, Object message) {
+    private boolean trySend(WebSocketSession session, String jsonMessage) {
         if (session != null && session.isOpen()) {
             try {
-                String jsonMessage = objectMapper.writeValueAsString(message);
-                session.sendMessage(new TextMessage(jsonMessage));
+                // the session is not safe for concurrent sends; WebSocketHandler replies on the same lock
+                synchronized (session) {
+                    session.sendMessage(new TextMessage(jsonMessage));
+                }
                 return true;
             } catch (IOException e) {
                 log.error("Error sending message to client {}: {}", session.getId(), e.getMessage(), e);
@@ -9,6 +9,7 @@ import org.springframework.web.socket.handler.TextWebSocketHandler;
 import com.fasterxml.jackson.core.JsonProcessingException;
 import com.fasterxml.jackson.databind.JsonNode;
 import com.fasterxml.jackson.databind.ObjectMapper;
+import com.fasterxml.jackson.databind.node.ObjectNode;
 
 import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
 import gtu.cse.cse396.sdbelt.ws.domain.model.EventHandler;
@@ -45,21 +46,46 @@ public class WebSocketHandler extends TextWebSocketHandler {
             Class<? extends Event<?>> eventClass = eventHandlerRegistry.getDataType(raw.type());
             EventHandler<?> handler = eventHandlerRegistry.getHandler(raw.type());
 
+            String error = null;
             if (eventClass != null && handler != null) {
-                // Parse the payload directly into the specific event class
-                Event<?> event = objectMapper.treeToValue(raw.event(), eventClass);
-                dispatchEvent(event, handler);
+                try {
+                    // Parse the payload directly into the specific event class
+                    Event<?> event = objectMapper.treeToValue(raw.event(), eventClass);
+                    dispatchEvent(event, handler);
+                } catch (Exception e) {
+                    log.error("Handler for {} failed: {}", raw.type(), e.getMessage(), e);
+                    error = String.valueOf(e.getMessage());
+                }
             } else {
                 log.warn("No handler or class found for event type: {}", raw.type());
+                error = "no handler for " + raw.type();
             }
+            reply(session, raw, error == null ? "ack" : "nack", error);
 
             // Echo the message back
-            session.sendMessage(new TextMessage("Server received: " + payload));
+            synchronized (session) {
+                session.sendMessage(new TextMessage("Server received: " + payload));
+            }
         } catch (Exception e) {
             log.error("Error processing message: {}", e.getMessage(), e);
         }
     }
 
+    // Only sent when the client numbered the event; the echo alone does not say it was stored
+    private void reply(WebSocketSession session, RawEvent raw, String kind, String error) throws IOException {
+        if (raw.seq() == null) {
+            return;
+        }
+        ObjectNode reply = objectMapper.createObjectNode();
+        reply.put(kind, raw.seq());
+        if (error != null) {
+            reply.put("error", error);
+        }
+        synchronized (session) {
+            session.sendMessage(new TextMessage(objectMapper.writeValueAsString(reply)));
+        }
+    }
+
     @SuppressWarnings("unchecked")
     private <T> void dispatchEvent(Event<?> event, EventHandler<?> handler) {
         // Safe cast since the registry ensures handler and event type match
@@ -8,12 +8,19 @@ import org.springframework.stereotype.Component;
 import com.fasterxml.jackson.databind.ObjectMapper;
 
 import gtu.cse.cse396.sdbelt.product.domain.service.ProductService;
+import gtu.cse.cse396.sdbelt.scan.domain.model.ProductScansEvent;
 import gtu.cse.cse396.sdbelt.scan.domain.model.ScanEvent;
 import gtu.cse.cse396.sdbelt.scan.domain.service.ScanService;
 import gtu.cse.cse396.sdbelt.scan.infra.handler.NewScanEventHandler;
+import gtu.cse.cse396.sdbelt.scan.infra.handler.ProductScansEventHandler;
 import gtu.cse.cse396.sdbelt.scan.infra.repository.JpaScanRepository;
 import gtu.cse.cse396.sdbelt.system.domain.model.InitializeProductsEvent;
+import gtu.cse.cse396.sdbelt.system.domain.model.SystemLogEvent;
+import gtu.cse.cse396.sdbelt.system.domain.model.SystemStatusEvent;
+import gtu.cse.cse396.sdbelt.system.domain.service.SystemService;
 import gtu.cse.cse396.sdbelt.system.infra.handler.InitializeProductsEventHandler;
+import gtu.cse.cse396.sdbelt.system.infra.handler.SystemLogEventHandler;
+import gtu.cse.cse396.sdbelt.system.infra.handler.SystemStatusEventHandler;
 import gtu.cse.cse396.sdbelt.ws.domain.model.Event;
 import gtu.cse.cse396.sdbelt.ws.domain.model.EventHandler;
 import gtu.cse.cse396.sdbelt.ws.domain.model.EventType;
@@ -25,14 +32,16 @@ public class EventHandlerRegistryImpl implements EventHandlerRegistry {
     private final ObjectMapper objectMapper;
     private final ProductService productService;
     private final ScanService scanService;
+    private final SystemService systemService;
 
     private final Map<EventType, EventHandler<?>> handlers;
     private final Map<EventType, Class<? extends Event<?>>> events = new ConcurrentHashMap<>();
 
     public EventHandlerRegistryImpl(ObjectMapper objectMapper, ScanService scanService,
-            ProductService productService) {
+            ProductService productService, SystemService systemService) {
         this.objectMapper = objectMapper;
         this.scanService = scanService;
+        this.systemService = systemService;
         this.productService = productService;
         this.handlers = new ConcurrentHashMap<>();
         init();
@@ -40,8 +49,12 @@ public class EventHandlerRegistryImpl implements EventHandlerRegistry {
 
     private void init() {
         register(EventType.NEW_SCAN_EVENT, ScanEvent.class, new NewScanEventHandler(scanService, objectMapper));
+        register(EventType.NEW_PRODUCT_SCANS_EVENT, ProductScansEvent.class,
+                new ProductScansEventHandler(scanService, systemService));
         register(EventType.INITIALIZE_EVENT, InitializeProductsEvent.class,
                 new InitializeProductsEventHandler(productService, objectMapper));
+        register(EventType.STATUS_EVENT, SystemStatusEvent.class, new SystemStatusEventHandler(systemService));
+        register(EventType.LOG_EVENT, SystemLogEvent.class, new SystemLogEventHandler(systemService));
     }
 
     @Override